@@ -342,6 +342,7 @@ bool Application::RegisterPermissions(const std::string& extension_name,
         return false;
       // register the permission and api
       name_perm_map_[api] = permission_name;
+      registered_apis_[extension_name].insert(api);
       DLOG(INFO) << "Permission Registered [PERM] " << permission_name
                  << " [API] " << api;
     }
@@ -379,15 +380,19 @@ StoredPermission Application::GetPermission(PermissionType type,
 bool Application::SetPermission(PermissionType type,
                                 const std::string& permission_name,
                                 StoredPermission perm) {
+  bool result = false;
   if (type == SESSION_PERMISSION) {
     permission_map_[permission_name] = perm;
-    return true;
+    result = true;
+  } else if (type == PERSISTENT_PERMISSION) {
+    result = application_data_->SetPermission(permission_name, perm);
+  } else {
+    NOTREACHED();
   }
-  if (type == PERSISTENT_PERMISSION)
-    return application_data_->SetPermission(permission_name, perm);
 
-  NOTREACHED();
-  return false;
+  if (result && observer_)
+    observer_->OnPermissionsChanged(this);
+  return result;
 }
 
 void Application::InitSecurityPolicy() {
@@ -44,6 +44,10 @@ class Application : public Runtime::Observer {
     // are closed.
     virtual void OnApplicationTerminated(Application* app) {}
 
+    // Invoked when a session or persistent permission of the application
+    // is set.
+    virtual void OnPermissionsChanged(Application* app) {}
+
    protected:
     virtual ~Observer() {}
   };
@@ -122,6 +126,10 @@ class Application : public Runtime::Observer {
   std::string GetRegisteredPermissionName(const std::string& extension_name,
                                           const std::string& api_name) const;
 
+  // The names of the APIs registered by each extension.
+  typedef std::map<std::string, std::set<std::string> > RegisteredAPIMap;
+  const RegisteredAPIMap& registered_apis() const { return registered_apis_; }
+
   StoredPermission GetPermission(PermissionType type,
                                  std::string& permission_name) const;
   bool SetPermission(PermissionType type,
@@ -168,6 +176,7 @@ class Application : public Runtime::Observer {
   TerminationMode termination_mode_used_;
   base::WeakPtrFactory<Application> weak_factory_;
   std::map<std::string, std::string> name_perm_map_;
+  RegisteredAPIMap registered_apis_;
   // Application's session permissions.
   StoredPermissionMap permission_map_;
 
@@ -0,0 +1,164 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include "base/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "xwalk/application/common/application_data.h"
+
+namespace xwalk {
+namespace application {
+
+const base::FilePath::CharType ApplicationDataCache::kCacheFileName[] =
+    FILE_PATH_LITERAL("applications.cache");
+
+namespace {
+
+// Bumped when the layout of the cache file changes, or the data saved by
+// ApplicationData or by one of the manifest handlers.
+const int kCacheFormatVersion = 2;
+
+}  // namespace
+
+ApplicationDataCache::ApplicationDataCache(const base::FilePath& cache_path)
+    : cache_path_(cache_path) {
+}
+
+ApplicationDataCache::~ApplicationDataCache() {
+}
+
+bool ApplicationDataCache::Load() {
+  entries_.clear();
+  used_ids_.clear();
+  new_entries_.clear();
+  mapped_file_.reset();
+
+  if (!base::PathExists(cache_path_))
+    return false;
+
+  scoped_ptr<base::MemoryMappedFile> mapped_file(new base::MemoryMappedFile);
+  if (!mapped_file->Initialize(cache_path_)) {
+    LOG(WARNING) << "Couldn't map the application cache: "
+                 << cache_path_.MaybeAsASCII();
+    return false;
+  }
+
+  Pickle pickle(reinterpret_cast<const char*>(mapped_file->data()),
+                static_cast<int>(mapped_file->length()));
+  PickleIterator iter(pickle);
+  int version;
+  int count;
+  if (!iter.ReadInt(&version) || version != kCacheFormatVersion ||
+      !iter.ReadLength(&count)) {
+    LOG(WARNING) << "Ignoring invalid application cache.";
+    return false;
+  }
+
+  EntryMap entries;
+  for (int i = 0; i < count; ++i) {
+    std::string id;
+    Entry entry;
+    if (!iter.ReadString(&id) || !iter.ReadUInt64(&entry.manifest_size) ||
+        !iter.ReadInt64(&entry.modified_time) ||
+        !iter.ReadData(&entry.data, &entry.size)) {
+      LOG(WARNING) << "Ignoring invalid application cache.";
+      return false;
+    }
+    entries[id] = entry;
+  }
+
+  // The entries point in the mapped file, they're decoded when requested.
+  entries_.swap(entries);
+  mapped_file_.reset(mapped_file.release());
+  return true;
+}
+
+scoped_refptr<ApplicationData> ApplicationDataCache::GetApplication(
+    const std::string& id, const base::FilePath& path,
+    size_t manifest_size, const base::Time& modified_time) {
+  EntryMap::const_iterator it = entries_.find(id);
+  if (it == entries_.end() || it->second.manifest_size != manifest_size ||
+      it->second.modified_time != modified_time.ToInternalValue())
+    return NULL;
+
+  Pickle pickle(it->second.data, it->second.size);
+  PickleIterator iter(pickle);
+  scoped_refptr<ApplicationData> application =
+      ApplicationData::CreateFromPickle(path, Manifest::INTERNAL, id, &iter);
+  if (!application || application->ID() != id) {
+    LOG(WARNING) << "Invalid cached data for application " << id;
+    return NULL;
+  }
+
+  used_ids_.insert(id);
+  return application;
+}
+
+void ApplicationDataCache::SetApplication(
+    const ApplicationData* application,
+    size_t manifest_size, const base::Time& modified_time) {
+  const std::string& id = application->ID();
+  used_ids_.erase(id);
+
+  Pickle pickle;
+  if (!application->WriteToPickle(&pickle)) {
+    new_entries_.erase(id);
+    return;
+  }
+
+  Entry& entry = new_entries_[id];
+  entry.manifest_size = manifest_size;
+  entry.modified_time = modified_time.ToInternalValue();
+  entry.encoded_application.assign(static_cast<const char*>(pickle.data()),
+                                   pickle.size());
+  entry.data = entry.encoded_application.data();
+  entry.size = static_cast<int>(entry.encoded_application.size());
+}
+
+bool ApplicationDataCache::Save() {
+  if (new_entries_.empty() && used_ids_.size() == entries_.size())
+    return true;
+
+  EntryMap entries;
+  for (std::set<std::string>::const_iterator it = used_ids_.begin();
+       it != used_ids_.end(); ++it)
+    entries[*it] = entries_[*it];
+  for (EntryMap::const_iterator it = new_entries_.begin();
+       it != new_entries_.end(); ++it)
+    entries[it->first] = it->second;
+
+  Pickle pickle;
+  pickle.WriteInt(kCacheFormatVersion);
+  pickle.WriteInt(static_cast<int>(entries.size()));
+  for (EntryMap::const_iterator it = entries.begin(); it != entries.end();
+       ++it) {
+    pickle.WriteString(it->first);
+    pickle.WriteUInt64(it->second.manifest_size);
+    pickle.WriteInt64(it->second.modified_time);
+    pickle.WriteData(it->second.data, it->second.size);
+  }
+
+  // The written entries are copied, the mapped file isn't needed anymore.
+  entries_.clear();
+  used_ids_.clear();
+  new_entries_.clear();
+  mapped_file_.reset();
+
+  if (!base::ImportantFileWriter::WriteFileAtomically(
+          cache_path_,
+          std::string(static_cast<const char*>(pickle.data()),
+                      pickle.size()))) {
+    LOG(WARNING) << "Couldn't write the application cache: "
+                 << cache_path_.MaybeAsASCII();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,94 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+
+namespace base {
+class MemoryMappedFile;
+}
+
+namespace xwalk {
+namespace application {
+
+class ApplicationData;
+
+// Keeps the installed applications parsed in a previous run in a compact
+// binary form, so that neither their manifest nor the manifest handlers have
+// to be parsed again each time the applications are loaded from the
+// database.
+//
+// The cache file is memory-mapped by Load() and an entry is only decoded
+// when it is requested. An entry is used only while the manifest stored in
+// the database keeps the size and the modification time it was made from.
+// Corrupted entries are ignored, the application is then parsed from its
+// manifest and cached again. Save() writes the entries that were requested
+// or set since Load(), which drops the ones of the uninstalled applications.
+class ApplicationDataCache {
+ public:
+  static const base::FilePath::CharType kCacheFileName[];
+
+  explicit ApplicationDataCache(const base::FilePath& cache_path);
+  ~ApplicationDataCache();
+
+  // Returns false if there's no cache file or it's not valid, the cache is
+  // then empty.
+  bool Load();
+
+  // Returns the application |id| installed in |path|, if it was cached from
+  // a manifest of |manifest_size| bytes written at |modified_time|. Returns
+  // NULL otherwise.
+  scoped_refptr<ApplicationData> GetApplication(
+      const std::string& id, const base::FilePath& path,
+      size_t manifest_size, const base::Time& modified_time);
+
+  // Caches |application|, parsed from a manifest of |manifest_size| bytes
+  // written at |modified_time|, for the next run.
+  void SetApplication(const ApplicationData* application,
+                      size_t manifest_size, const base::Time& modified_time);
+
+  // Rewrites the cache file if the entries changed since Load().
+  bool Save();
+
+ private:
+  struct Entry {
+    Entry() : manifest_size(0), modified_time(0), data(NULL), size(0) {}
+
+    uint64 manifest_size;
+    int64 modified_time;
+    // The encoded application, pointing in |mapped_file_| for the loaded
+    // entries, or in |encoded_application| for the ones that were set.
+    const char* data;
+    int size;
+    std::string encoded_application;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+
+  base::FilePath cache_path_;
+  scoped_ptr<base::MemoryMappedFile> mapped_file_;
+
+  // The entries read from the cache file.
+  EntryMap entries_;
+  // The ids of |entries_| that are still valid.
+  std::set<std::string> used_ids_;
+  // The entries set since Load().
+  EntryMap new_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationDataCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
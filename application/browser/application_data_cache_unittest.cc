@@ -0,0 +1,164 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/pickle.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+
+namespace xwalk {
+
+namespace keys = application_manifest_keys;
+
+namespace application {
+
+namespace {
+
+const size_t kManifestSize = 120;
+
+}  // namespace
+
+class ApplicationDataCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    cache_path_ = temp_dir_.path().Append(ApplicationDataCache::kCacheFileName);
+    install_time_ = base::Time::FromDoubleT(1400000000.5);
+
+    base::DictionaryValue manifest;
+    manifest.SetString(keys::kNameKey, "app");
+    manifest.SetString(keys::kVersionKey, "1.0.2");
+    manifest.SetString(keys::kDescriptionKey, "An application");
+    manifest.SetString(keys::kAppMainSourceKey, "main.html");
+    base::ListValue* permissions = new base::ListValue;
+    permissions->AppendString("geolocation");
+    permissions->AppendString("contacts");
+    manifest.Set(keys::kPermissionsKey, permissions);
+
+    std::string error;
+    application_ = ApplicationData::Create(
+        temp_dir_.path(), Manifest::INTERNAL, manifest, "", &error);
+    ASSERT_TRUE(application_) << error;
+  }
+
+  scoped_refptr<ApplicationData> GetApplication(ApplicationDataCache* cache) {
+    return cache->GetApplication(application_->ID(), temp_dir_.path(),
+                                 kManifestSize, install_time_);
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath cache_path_;
+  base::Time install_time_;
+  scoped_refptr<ApplicationData> application_;
+};
+
+TEST_F(ApplicationDataCacheTest, SaveAndLoad) {
+  ApplicationDataCache cache(cache_path_);
+  EXPECT_FALSE(cache.Load());
+  EXPECT_FALSE(GetApplication(&cache));
+  cache.SetApplication(application_.get(), kManifestSize, install_time_);
+  ASSERT_TRUE(cache.Save());
+
+  ApplicationDataCache loaded_cache(cache_path_);
+  ASSERT_TRUE(loaded_cache.Load());
+  scoped_refptr<ApplicationData> application = GetApplication(&loaded_cache);
+  ASSERT_TRUE(application);
+
+  // The data of the manifest handlers is restored too.
+  EXPECT_EQ(application_->ID(), application->ID());
+  EXPECT_EQ(application_->Path(), application->Path());
+  EXPECT_EQ(application_->URL(), application->URL());
+  EXPECT_EQ(application_->Name(), application->Name());
+  EXPECT_EQ(application_->VersionString(), application->VersionString());
+  EXPECT_EQ(application_->Description(), application->Description());
+  EXPECT_EQ(application_->ManifestVersion(), application->ManifestVersion());
+  EXPECT_TRUE(application_->GetManifest()->Equals(
+      application->GetManifest()));
+  EXPECT_TRUE(application->HasMainDocument());
+  EXPECT_EQ(application_->GetManifestPermissions(),
+            application->GetManifestPermissions());
+}
+
+TEST_F(ApplicationDataCacheTest, ManifestChanged) {
+  ApplicationDataCache cache(cache_path_);
+  cache.SetApplication(application_.get(), kManifestSize, install_time_);
+  ASSERT_TRUE(cache.Save());
+
+  ASSERT_TRUE(cache.Load());
+  EXPECT_FALSE(cache.GetApplication(application_->ID(), temp_dir_.path(),
+                                    kManifestSize + 1, install_time_));
+  EXPECT_FALSE(cache.GetApplication(
+      application_->ID(), temp_dir_.path(), kManifestSize,
+      install_time_ + base::TimeDelta::FromSeconds(1)));
+  EXPECT_FALSE(cache.GetApplication("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb",
+                                    temp_dir_.path(), kManifestSize,
+                                    install_time_));
+}
+
+TEST_F(ApplicationDataCacheTest, UnusedEntriesDropped) {
+  ApplicationDataCache cache(cache_path_);
+  cache.SetApplication(application_.get(), kManifestSize, install_time_);
+  ASSERT_TRUE(cache.Save());
+
+  // The application isn't requested anymore, e.g. it was uninstalled.
+  ASSERT_TRUE(cache.Load());
+  ASSERT_TRUE(cache.Save());
+
+  ASSERT_TRUE(cache.Load());
+  EXPECT_FALSE(GetApplication(&cache));
+}
+
+TEST_F(ApplicationDataCacheTest, InvalidFile) {
+  std::string contents("not a cache file");
+  ASSERT_TRUE(base::WriteFile(cache_path_, contents.data(),
+                              static_cast<int>(contents.size())));
+
+  ApplicationDataCache cache(cache_path_);
+  EXPECT_FALSE(cache.Load());
+  EXPECT_FALSE(GetApplication(&cache));
+
+  // An invalid file is replaced.
+  cache.SetApplication(application_.get(), kManifestSize, install_time_);
+  ASSERT_TRUE(cache.Save());
+  ASSERT_TRUE(cache.Load());
+  EXPECT_TRUE(GetApplication(&cache));
+}
+
+TEST_F(ApplicationDataCacheTest, CorruptedEntry) {
+  ApplicationDataCache cache(cache_path_);
+  cache.SetApplication(application_.get(), kManifestSize, install_time_);
+  ASSERT_TRUE(cache.Save());
+
+  // Breaks the encoded application, the entry keys are still valid.
+  Pickle pickle;
+  ASSERT_TRUE(application_->WriteToPickle(&pickle));
+  std::string encoded_application(static_cast<const char*>(pickle.data()),
+                                  pickle.size());
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(cache_path_, &contents));
+  size_t offset = contents.find(encoded_application);
+  ASSERT_NE(std::string::npos, offset);
+  // The type of the manifest value follows the header of the pickle.
+  contents.replace(offset + sizeof(uint32), sizeof(int), sizeof(int), '\xff');
+  ASSERT_TRUE(base::WriteFile(cache_path_, contents.data(),
+                              static_cast<int>(contents.size())));
+
+  // The application is parsed again from its manifest.
+  ASSERT_TRUE(cache.Load());
+  EXPECT_FALSE(GetApplication(&cache));
+  cache.SetApplication(application_.get(), kManifestSize, install_time_);
+  ASSERT_TRUE(cache.Save());
+  ASSERT_TRUE(cache.Load());
+  EXPECT_TRUE(GetApplication(&cache));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -4,15 +4,21 @@
 
 #include "xwalk/application/browser/application_service.h"
 
+#include <map>
 #include <set>
 #include <string>
 
+#include "base/bind.h"
 #include "base/files/file_enumerator.h"
 #include "base/file_util.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
+#include "base/synchronization/lock.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "base/version.h"
+#include "content/public/browser/browser_thread.h"
 #include "content/public/browser/storage_partition.h"
 #include "content/public/browser/web_contents.h"
 #include "content/public/browser/web_contents_observer.h"
@@ -199,238 +205,604 @@ void RemoveWidgetStorageFiles(const base::FilePath& storage_path,
   }
 }
 
+// Run on the blocking pool by UninstallAsync().
+bool DeleteApplicationFiles(const base::FilePath& resources,
+                            const std::string& app_id) {
+  bool result = true;
+  if (base::DirectoryExists(resources) &&
+      !base::DeleteFile(resources, true)) {
+    LOG(ERROR) << "Error occurred while trying to remove application with id "
+               << app_id << "; Cannot remove all resources.";
+    result = false;
+  }
+
+  base::FilePath path;
+  PathService::Get(xwalk::DIR_WGT_STORAGE_PATH, &path);
+  RemoveWidgetStorageFiles(path, app_id);
+
+  return result;
+}
+
 }  // namespace
 
 const base::FilePath::CharType kApplicationsDir[] =
     FILE_PATH_LITERAL("applications");
 
+// Puts back the files of the jobs interrupted by the last shutdown. It's
+// posted to the file task runner before any job, so that the applications
+// directory is only listed off the UI thread. The synchronous jobs, that
+// move files on the UI thread, run it themselves if it didn't run yet.
+class ApplicationService::FilesRecovery
+    : public base::RefCountedThreadSafe<FilesRecovery> {
+ public:
+  FilesRecovery(const base::FilePath& applications_dir,
+                const std::map<std::string, std::string>& installed_versions)
+      : applications_dir_(applications_dir),
+        installed_versions_(installed_versions),
+        done_(false) {}
+
+  void Run() {
+    base::AutoLock lock(lock_);
+    if (done_)
+      return;
+    done_ = true;
+    if (base::DirectoryExists(applications_dir_))
+      RecoverApplicationsDirectory(applications_dir_, installed_versions_);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<FilesRecovery>;
+  ~FilesRecovery() {}
+
+  const base::FilePath applications_dir_;
+  const std::map<std::string, std::string> installed_versions_;
+  base::Lock lock_;
+  bool done_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilesRecovery);
+};
+
 ApplicationService::ApplicationService(RuntimeContext* runtime_context,
                                        ApplicationStorage* app_storage,
                                        ApplicationEventManager* event_manager)
     : runtime_context_(runtime_context),
       application_storage_(app_storage),
       event_manager_(event_manager),
-      permission_policy_handler_(new PermissionPolicyManager()) {
+      permission_policy_handler_(new PermissionPolicyManager()),
+      weak_factory_(this) {
   AddObserver(event_manager);
+  RecoverApplicationFiles();
 }
 
 ApplicationService::~ApplicationService() {
 }
 
+// The state of an install or an update, passed from one stage to the next.
+// The stages run one after the other, so it's only used by one thread at a
+// time.
+struct ApplicationService::InstallJob
+    : public base::RefCountedThreadSafe<InstallJob> {
+  InstallJob(const base::FilePath& path,
+             const std::string& update_id,
+             const base::FilePath& data_dir,
+             const InstallCallback& callback)
+      : path(path),
+        update_id(update_id),
+        data_dir(data_dir),
+        callback(callback),
+        synchronous(false),
+        holds_app_id(false),
+        files_moved(false),
+        files_rolled_back(false),
+        succeeded(false) {}
+
+  bool is_update() const { return !update_id.empty(); }
+
+  const base::FilePath path;
+  // The application being updated, empty for installs.
+  const std::string update_id;
+  const base::FilePath data_dir;
+  const InstallCallback callback;
+  // Whether the file stages run on the calling thread.
+  bool synchronous;
+
+  scoped_ptr<Package> package;
+  base::FilePath unpacked_dir;
+  std::string app_id;
+  scoped_refptr<ApplicationData> application_data;
+  scoped_refptr<ApplicationData> old_application;
+
+  // Set when |app_id| is in ApplicationService::pending_app_ids_.
+  bool holds_app_id;
+
+  base::FilePath app_dir;
+  // Where the files of the updated application are kept until it succeeds.
+  base::FilePath backup_dir;
+  // Whether |app_dir| was changed, and must be restored on failure.
+  bool files_moved;
+  bool files_rolled_back;
+
+  bool succeeded;
+  // The id given to the caller: the one of the application installed, or of
+  // the one already installed from the same package.
+  std::string result_id;
+
+ private:
+  friend class base::RefCountedThreadSafe<InstallJob>;
+  ~InstallJob() {}
+};
+
 bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
-  // FIXME(leandro): Installation is not robust enough -- should any step
-  // fail, it can't roll back to a consistent state.
-  if (!base::PathExists(path))
+  scoped_refptr<InstallJob> job(new InstallJob(
+      path, std::string(), GetApplicationsDir(), InstallCallback()));
+  job->synchronous = true;
+  StartInstallJob(job);
+
+  if (!job->result_id.empty())
+    *id = job->result_id;
+  return job->succeeded;
+}
+
+bool ApplicationService::Update(const std::string& id,
+                                const base::FilePath& path) {
+  if (id.empty()) {
+    LOG(ERROR) << "The id of the application to update is empty.";
     return false;
+  }
 
-  const base::FilePath data_dir =
-      runtime_context_->GetPath().Append(kApplicationsDir);
+  scoped_refptr<InstallJob> job(new InstallJob(
+      path, id, GetApplicationsDir(), InstallCallback()));
+  job->synchronous = true;
+  StartInstallJob(job);
+  return job->succeeded;
+}
 
-  // Make sure the kApplicationsDir exists under data_path, otherwise,
-  // the installation will always fail because of moving application
-  // resources into an invalid directory.
-  if (!base::DirectoryExists(data_dir) &&
-      !base::CreateDirectory(data_dir))
+bool ApplicationService::Uninstall(const std::string& id) {
+  bool result = true;
+  if (!UnregisterApplication(id, &result))
     return false;
 
-  std::string app_id;
-  base::FilePath unpacked_dir;
-  scoped_ptr<Package> package;
-  if (!base::DirectoryExists(path)) {
-    package = Package::Create(path);
-    package->Extract(&unpacked_dir);
-    app_id = package->Id();
-  } else {
-    unpacked_dir = path;
-  }
+  if (!DeleteApplicationFiles(GetApplicationsDir().AppendASCII(id), id))
+    result = false;
 
-  std::string error;
-  scoped_refptr<ApplicationData> application_data = LoadApplication(
-      unpacked_dir, app_id, Manifest::COMMAND_LINE, &error);
-  if (!application_data) {
-    LOG(ERROR) << "Error during application installation: " << error;
-    return false;
-  }
-  if (!permission_policy_handler_->
-      InitApplicationPermission(application_data)) {
-    LOG(ERROR) << "Application permission data is invalid";
-    return false;
-  }
+  FOR_EACH_OBSERVER(Observer, observers_, OnApplicationUninstalled(id));
 
-  if (application_storage_->Contains(application_data->ID())) {
-    *id = application_data->ID();
-    LOG(INFO) << "Already installed: " << *id;
-    return false;
-  }
+  return result;
+}
 
-  base::FilePath app_dir = data_dir.AppendASCII(application_data->ID());
-  if (base::DirectoryExists(app_dir)) {
-    if (!base::DeleteFile(app_dir, true))
-      return false;
-  }
-  if (!package) {
-    if (!base::CreateDirectory(app_dir))
-      return false;
-    if (!CopyDirectoryContents(unpacked_dir, app_dir))
-      return false;
-  } else {
-    if (!base::Move(unpacked_dir, app_dir))
-      return false;
+void ApplicationService::InstallAsync(const base::FilePath& path,
+                                      const InstallCallback& callback) {
+  StartInstallJob(new InstallJob(
+      path, std::string(), GetApplicationsDir(), callback));
+}
+
+void ApplicationService::UpdateAsync(const std::string& id,
+                                     const base::FilePath& path,
+                                     const InstallCallback& callback) {
+  if (id.empty()) {
+    LOG(ERROR) << "The id of the application to update is empty.";
+    callback.Run(false, std::string());
+    return;
   }
 
-  application_data->SetPath(app_dir);
+  StartInstallJob(new InstallJob(path, id, GetApplicationsDir(), callback));
+}
 
-  if (!application_storage_->AddApplication(application_data)) {
-    LOG(ERROR) << "Application with id " << application_data->ID()
-               << " couldn't be installed.";
-    return false;
+void ApplicationService::UninstallAsync(const std::string& id,
+                                        const InstallCallback& callback) {
+  bool unregistered = true;
+  if (!UnregisterApplication(id, &unregistered)) {
+    callback.Run(false, std::string());
+    return;
   }
 
-#if defined(OS_TIZEN)
-  if (!InstallPackageOnTizen(application_data,
-                             runtime_context_->GetPath())) {
-    application_storage_->RemoveApplication(application_data->ID());
-    return false;
+  FOR_EACH_OBSERVER(Observer, observers_,
+                    OnApplicationInstallProgress(base::FilePath(), id,
+                                                 INSTALL_STAGE_REMOVING));
+
+  base::PostTaskAndReplyWithResult(
+      GetFileTaskRunner(), FROM_HERE,
+      base::Bind(&DeleteApplicationFiles,
+                 GetApplicationsDir().AppendASCII(id), id),
+      base::Bind(&ApplicationService::OnApplicationFilesDeleted,
+                 weak_factory_.GetWeakPtr(), id, unregistered, callback));
+}
+
+void ApplicationService::RecoverApplicationFiles() {
+  // The jobs move the files on the blocking pool, and the shutdown drops
+  // the replies that register them or roll them back. Without the complete
+  // list of the installed applications, their files can't be told apart
+  // from the leftovers.
+  if (!application_storage_->is_loaded())
+    return;
+
+  std::map<std::string, std::string> installed_versions;
+  const ApplicationData::ApplicationDataMap& applications =
+      application_storage_->GetInstalledApplications();
+  ApplicationData::ApplicationDataMap::const_iterator it =
+      applications.begin();
+  for (; it != applications.end(); ++it)
+    installed_versions[it->first] = it->second->VersionString();
+
+  files_recovery_ = new FilesRecovery(GetApplicationsDir(),
+                                      installed_versions);
+  GetFileTaskRunner()->PostTask(
+      FROM_HERE, base::Bind(&FilesRecovery::Run, files_recovery_));
+}
+
+base::FilePath ApplicationService::GetApplicationsDir() const {
+  return runtime_context_->GetPath().Append(kApplicationsDir);
+}
+
+base::SequencedTaskRunner* ApplicationService::GetFileTaskRunner() {
+  if (!file_task_runner_) {
+    // The jobs run one after the other, and don't leave the files of an
+    // application half moved on shutdown.
+    base::SequencedWorkerPool* pool = content::BrowserThread::GetBlockingPool();
+    file_task_runner_ = pool->GetSequencedTaskRunnerWithShutdownBehavior(
+        pool->GetSequenceToken(), base::SequencedWorkerPool::BLOCK_SHUTDOWN);
   }
-#endif
+  return file_task_runner_.get();
+}
 
-  LOG(INFO) << "Application be installed in: " << app_dir.MaybeAsASCII();
-  LOG(INFO) << "Installed application with id: " << application_data->ID()
-            << " successfully.";
-  *id = application_data->ID();
+void ApplicationService::StartInstallJob(scoped_refptr<InstallJob> job) {
+  if (job->synchronous && files_recovery_)
+    files_recovery_->Run();
+  NotifyInstallProgress(job.get(), INSTALL_STAGE_PREPARING);
+  RunFileStep(job, &ApplicationService::ReadPackage,
+              &ApplicationService::OnPackageRead);
+}
 
-  SaveSystemEventsInfo(this, application_data, event_manager_);
+void ApplicationService::RunFileStep(scoped_refptr<InstallJob> job,
+                                     InstallFileStep file_step,
+                                     InstallStep next_step) {
+  if (job->synchronous) {
+    bool success = file_step(job.get());
+    (this->*next_step)(job, success);
+    return;
+  }
 
-  FOR_EACH_OBSERVER(Observer, observers_,
-                    OnApplicationInstalled(application_data->ID()));
+  base::PostTaskAndReplyWithResult(
+      GetFileTaskRunner(), FROM_HERE,
+      base::Bind(file_step, job),
+      base::Bind(next_step, weak_factory_.GetWeakPtr(), job));
+}
 
-  return true;
+void ApplicationService::NotifyInstallProgress(InstallJob* job,
+                                               InstallStage stage) {
+  FOR_EACH_OBSERVER(Observer, observers_,
+                    OnApplicationInstallProgress(job->path, job->app_id,
+                                                 stage));
 }
 
-bool ApplicationService::Update(const std::string& id,
-                                const base::FilePath& path) {
-  if (!base::PathExists(path)) {
-    LOG(ERROR) << "The XPK/WGT package file " << path.value() << " is invalid.";
+// static
+bool ApplicationService::ReadPackage(InstallJob* job) {
+  if (!base::PathExists(job->path)) {
+    LOG(ERROR) << "The XPK/WGT package file " << job->path.value()
+               << " is invalid.";
     return false;
   }
 
-  if (base::DirectoryExists(path)) {
+  bool is_directory = base::DirectoryExists(job->path);
+  if (job->is_update() && is_directory) {
     LOG(WARNING) << "Can not update an unpacked XPK/WGT package.";
     return false;
   }
 
-  base::FilePath unpacked_dir;
-  base::FilePath origin_dir;
-  std::string app_id;
-  scoped_ptr<Package> package = Package::Create(path);
-  if (!package) {
+  // Make sure the kApplicationsDir exists under data_path, otherwise,
+  // the installation will always fail because of moving application
+  // resources into an invalid directory.
+  if (!base::DirectoryExists(job->data_dir) &&
+      !base::CreateDirectory(job->data_dir))
+    return false;
+
+  if (is_directory) {
+    job->unpacked_dir = job->path;
+    return true;
+  }
+
+  // Extracting the package next to the installed applications lets it be
+  // moved to its final directory by a rename.
+  job->package = Package::Create(job->path, job->data_dir);
+  if (!job->package) {
     LOG(ERROR) << "XPK/WGT file is invalid.";
     return false;
   }
+  job->app_id = job->package->Id();
 
-  app_id = package->Id();
+  if (job->is_update()) {
+    if (job->app_id.empty()) {
+      LOG(ERROR) << "XPK/WGT file is invalid, and the application id is empty.";
+      return false;
+    }
+    if (job->app_id != job->update_id) {
+      LOG(ERROR) << "The XPK/WGT file is not the same as expecting.";
+      return false;
+    }
+  }
 
-  if (app_id.empty()) {
-    LOG(ERROR) << "XPK/WGT file is invalid, and the application id is empty.";
-    return false;
+  return true;
+}
+
+void ApplicationService::OnPackageRead(scoped_refptr<InstallJob> job,
+                                       bool success) {
+  if (!success) {
+    FinishInstallJob(job, false);
+    return;
   }
 
-  if (id.empty() ||
-      id.compare(app_id) != 0) {
-    LOG(ERROR) << "The XPK/WGT file is not the same as expecting.";
-    return false;
+  if (job->is_update()) {
+    job->old_application =
+        application_storage_->GetApplicationData(job->app_id);
+    if (!job->old_application) {
+      LOG(INFO) << "Application haven't installed yet: " << job->app_id;
+      FinishInstallJob(job, false);
+      return;
+    }
+  } else if (!job->app_id.empty() &&
+             application_storage_->Contains(job->app_id)) {
+    // The package doesn't need to be extracted to be rejected.
+    job->result_id = job->app_id;
+    LOG(INFO) << "Already installed: " << job->app_id;
+    FinishInstallJob(job, false);
+    return;
   }
 
-  if (!package->Extract(&unpacked_dir))
+  NotifyInstallProgress(job.get(), INSTALL_STAGE_EXTRACTING);
+  RunFileStep(job, &ApplicationService::ExtractPackage,
+              &ApplicationService::OnPackageExtracted);
+}
+
+// static
+bool ApplicationService::ExtractPackage(InstallJob* job) {
+  if (job->package && !job->package->Extract(&job->unpacked_dir))
     return false;
 
   std::string error;
-  scoped_refptr<ApplicationData> new_application =
-      LoadApplication(unpacked_dir,
-                      app_id,
-                      Manifest::COMMAND_LINE,
-                      &error);
-  if (!new_application) {
-    LOG(ERROR) << "An error occurred during application updating: " << error;
+  job->application_data = LoadApplication(
+      job->unpacked_dir, job->app_id, Manifest::COMMAND_LINE, &error);
+  if (!job->application_data) {
+    LOG(ERROR) << "Error during application installation: " << error;
     return false;
   }
 
-  scoped_refptr<ApplicationData> old_application =
-      application_storage_->GetApplicationData(app_id);
-  if (!old_application) {
-    LOG(INFO) << "Application haven't installed yet: " << app_id;
-    return false;
+  return true;
+}
+
+void ApplicationService::OnPackageExtracted(scoped_refptr<InstallJob> job,
+                                            bool success) {
+  if (!success) {
+    FinishInstallJob(job, false);
+    return;
   }
 
-  if (old_application->Version()->CompareTo(
-          *(new_application->Version())) >= 0) {
-    LOG(INFO) << "The version number of new XPK/WGT package "
-                 "should be higher than "
-              << old_application->VersionString();
-    return false;
+  scoped_refptr<ApplicationData> application_data = job->application_data;
+  job->app_id = application_data->ID();
+
+  if (job->is_update()) {
+    if (job->old_application->Version()->CompareTo(
+            *(application_data->Version())) >= 0) {
+      LOG(INFO) << "The version number of new XPK/WGT package "
+                   "should be higher than "
+                << job->old_application->VersionString();
+      FinishInstallJob(job, false);
+      return;
+    }
+
+    job->app_dir = job->old_application->Path();
+    job->backup_dir = base::FilePath(job->app_dir.value() +
+                                     kApplicationBackupDirSuffix);
+  } else {
+    if (!permission_policy_handler_->
+        InitApplicationPermission(application_data)) {
+      LOG(ERROR) << "Application permission data is invalid";
+      FinishInstallJob(job, false);
+      return;
+    }
+
+    if (application_storage_->Contains(job->app_id)) {
+      job->result_id = job->app_id;
+      LOG(INFO) << "Already installed: " << job->app_id;
+      FinishInstallJob(job, false);
+      return;
+    }
+
+    job->app_dir = job->data_dir.AppendASCII(job->app_id);
   }
 
-  const base::FilePath& app_dir = old_application->Path();
-  const base::FilePath tmp_dir(app_dir.value()
-                               + FILE_PATH_LITERAL(".tmp"));
+  // Two jobs can't move the files of the same application.
+  if (!pending_app_ids_.insert(job->app_id).second) {
+    LOG(ERROR) << "The application " << job->app_id
+               << " is already being installed or updated.";
+    FinishInstallJob(job, false);
+    return;
+  }
+  job->holds_app_id = true;
 
-  if (Application* app = GetApplicationByID(app_id)) {
-    LOG(INFO) << "Try to terminate the running application before update.";
-    app->Terminate(Application::Immediate);
+  if (job->is_update()) {
+    if (Application* app = GetApplicationByID(job->app_id)) {
+      LOG(INFO) << "Try to terminate the running application before update.";
+      app->Terminate(Application::Immediate);
+    }
   }
 
-  if (!base::Move(app_dir, tmp_dir) ||
-      !base::Move(unpacked_dir, app_dir))
-    return false;
+  NotifyInstallProgress(job.get(), INSTALL_STAGE_MOVING);
+  RunFileStep(job, &ApplicationService::MoveApplicationFiles,
+              &ApplicationService::OnApplicationFilesMoved);
+}
 
-  new_application = LoadApplication(app_dir,
-                                    app_id,
-                                    Manifest::COMMAND_LINE,
-                                    &error);
-  if (!new_application) {
-    LOG(ERROR) << "Error during loading new package: " << error;
-    base::DeleteFile(app_dir, true);
-    base::Move(tmp_dir, app_dir);
+// static
+bool ApplicationService::MoveApplicationFiles(InstallJob* job) {
+  // Rolls back right away on failure, so the files aren't left half moved
+  // if the shutdown drops the reply.
+  if (!DoMoveApplicationFiles(job)) {
+    RollBackApplicationFiles(job);
     return false;
   }
+  return true;
+}
 
-#if defined(OS_TIZEN)
-  if (!UninstallPackageOnTizen(old_application,
-                               runtime_context_->GetPath())) {
-    base::DeleteFile(app_dir, true);
-    base::Move(tmp_dir, app_dir);
+// static
+bool ApplicationService::DoMoveApplicationFiles(InstallJob* job) {
+  if (job->is_update()) {
+    if (!base::Move(job->app_dir, job->backup_dir))
+      return false;
+    job->files_moved = true;
+    if (!base::Move(job->unpacked_dir, job->app_dir))
+      return false;
+
+    std::string error;
+    job->application_data = LoadApplication(
+        job->app_dir, job->app_id, Manifest::COMMAND_LINE, &error);
+    if (!job->application_data) {
+      LOG(ERROR) << "Error during loading new package: " << error;
+      return false;
+    }
+    return true;
+  }
+
+  if (base::DirectoryExists(job->app_dir) &&
+      !base::DeleteFile(job->app_dir, true))
     return false;
+  job->files_moved = true;
+
+  if (!job->package) {
+    return base::CreateDirectory(job->app_dir) &&
+        CopyDirectoryContents(job->unpacked_dir, job->app_dir);
   }
+
+  return base::Move(job->unpacked_dir, job->app_dir);
+}
+
+void ApplicationService::OnApplicationFilesMoved(
+    scoped_refptr<InstallJob> job, bool success) {
+  if (!success) {
+    FinishInstallJob(job, false);
+    return;
+  }
+
+  NotifyInstallProgress(job.get(), INSTALL_STAGE_REGISTERING);
+
+  scoped_refptr<ApplicationData> application_data = job->application_data;
+  if (job->is_update()) {
+#if defined(OS_TIZEN)
+    if (!UninstallPackageOnTizen(job->old_application,
+                                 runtime_context_->GetPath())) {
+      FinishInstallJob(job, false);
+      return;
+    }
 #endif
 
-  if (!application_storage_->UpdateApplication(new_application)) {
-    LOG(ERROR) << "An Error occurred when updating the application.";
-    base::DeleteFile(app_dir, true);
-    base::Move(tmp_dir, app_dir);
+    if (!application_storage_->UpdateApplication(application_data)) {
+      LOG(ERROR) << "An Error occurred when updating the application.";
 #if defined(OS_TIZEN)
-    InstallPackageOnTizen(old_application,
-                          runtime_context_->GetPath());
+      InstallPackageOnTizen(job->old_application,
+                            runtime_context_->GetPath());
 #endif
-    return false;
-  }
+      FinishInstallJob(job, false);
+      return;
+    }
+
 #if defined(OS_TIZEN)
-  if (!InstallPackageOnTizen(new_application,
-                             runtime_context_->GetPath()))
-    return false;
+    if (!InstallPackageOnTizen(application_data,
+                               runtime_context_->GetPath())) {
+      application_storage_->UpdateApplication(job->old_application);
+      InstallPackageOnTizen(job->old_application,
+                            runtime_context_->GetPath());
+      FinishInstallJob(job, false);
+      return;
+    }
 #endif
-  base::DeleteFile(tmp_dir, true);
+  } else {
+    application_data->SetPath(job->app_dir);
 
-  SaveSystemEventsInfo(this, new_application, event_manager_);
+    if (!application_storage_->AddApplication(application_data)) {
+      LOG(ERROR) << "Application with id " << job->app_id
+                 << " couldn't be installed.";
+      FinishInstallJob(job, false);
+      return;
+    }
 
-  FOR_EACH_OBSERVER(Observer, observers_,
-                    OnApplicationUpdated(app_id));
+#if defined(OS_TIZEN)
+    if (!InstallPackageOnTizen(application_data,
+                               runtime_context_->GetPath())) {
+      application_storage_->RemoveApplication(job->app_id);
+      FinishInstallJob(job, false);
+      return;
+    }
+#endif
+
+    LOG(INFO) << "Application be installed in: "
+              << job->app_dir.MaybeAsASCII();
+    LOG(INFO) << "Installed application with id: " << job->app_id
+              << " successfully.";
+  }
+
+  FinishInstallJob(job, true);
+}
+
+void ApplicationService::FinishInstallJob(scoped_refptr<InstallJob> job,
+                                          bool success) {
+  job->succeeded = success;
+  if (success)
+    job->result_id = job->app_id;
+  else if (job->files_moved || job->files_rolled_back)
+    NotifyInstallProgress(job.get(), INSTALL_STAGE_ROLLING_BACK);
 
+  RunFileStep(job, &ApplicationService::CleanUpApplicationFiles,
+              &ApplicationService::OnInstallJobFinished);
+}
+
+// static
+void ApplicationService::RollBackApplicationFiles(InstallJob* job) {
+  if (!job->files_moved)
+    return;
+
+  // Puts back the application as it was before the job.
+  base::DeleteFile(job->app_dir, true);
+  if (!job->backup_dir.empty())
+    base::Move(job->backup_dir, job->app_dir);
+  job->files_moved = false;
+  job->files_rolled_back = true;
+}
+
+// static
+bool ApplicationService::CleanUpApplicationFiles(InstallJob* job) {
+  if (job->succeeded) {
+    if (!job->backup_dir.empty())
+      base::DeleteFile(job->backup_dir, true);
+  } else {
+    RollBackApplicationFiles(job);
+  }
+
+  // Removes what's left of the extracted package.
+  job->package.reset();
   return true;
 }
 
-bool ApplicationService::Uninstall(const std::string& id) {
-  bool result = true;
+void ApplicationService::OnInstallJobFinished(scoped_refptr<InstallJob> job,
+                                              bool success) {
+  if (job->holds_app_id)
+    pending_app_ids_.erase(job->app_id);
+
+  if (job->succeeded) {
+    SaveSystemEventsInfo(this, job->application_data, event_manager_);
 
+    if (job->is_update()) {
+      FOR_EACH_OBSERVER(Observer, observers_,
+                        OnApplicationUpdated(job->app_id));
+    } else {
+      FOR_EACH_OBSERVER(Observer, observers_,
+                        OnApplicationInstalled(job->app_id));
+    }
+  }
+
+  if (!job->callback.is_null())
+    job->callback.Run(job->succeeded, job->result_id);
+}
+
+bool ApplicationService::UnregisterApplication(const std::string& id,
+                                               bool* result) {
   scoped_refptr<ApplicationData> application =
       application_storage_->GetApplicationData(id);
   if (!application) {
@@ -439,6 +811,12 @@ bool ApplicationService::Uninstall(const std::string& id) {
     return false;
   }
 
+  if (pending_app_ids_.count(id)) {
+    LOG(ERROR) << "Cannot uninstall application with id " << id
+               << "; it is being updated.";
+    return false;
+  }
+
   if (Application* app = GetApplicationByID(id)) {
     LOG(INFO) << "Try to terminate the running application before uninstall.";
     app->Terminate(Application::Immediate);
@@ -447,22 +825,13 @@ bool ApplicationService::Uninstall(const std::string& id) {
 #if defined(OS_TIZEN)
   if (!UninstallPackageOnTizen(application,
                                runtime_context_->GetPath()))
-    result = false;
+    *result = false;
 #endif
 
   if (!application_storage_->RemoveApplication(id)) {
     LOG(ERROR) << "Cannot uninstall application with id " << id
                << "; application is not installed.";
-    result = false;
-  }
-
-  const base::FilePath resources =
-      runtime_context_->GetPath().Append(kApplicationsDir).AppendASCII(id);
-  if (base::DirectoryExists(resources) &&
-      !base::DeleteFile(resources, true)) {
-    LOG(ERROR) << "Error occurred while trying to remove application with id "
-               << id << "; Cannot remove all resources.";
-    result = false;
+    *result = false;
   }
 
   content::StoragePartition* partition =
@@ -474,13 +843,16 @@ bool ApplicationService::Uninstall(const std::string& id) {
       application->URL(),
       partition->GetURLRequestContext());
 
-  base::FilePath path;
-  PathService::Get(xwalk::DIR_WGT_STORAGE_PATH, &path);
-  RemoveWidgetStorageFiles(path, id);
+  return true;
+}
 
+void ApplicationService::OnApplicationFilesDeleted(
+    const std::string& id, bool unregistered,
+    const InstallCallback& callback, bool deleted) {
   FOR_EACH_OBSERVER(Observer, observers_, OnApplicationUninstalled(id));
 
-  return result;
+  if (!callback.is_null())
+    callback.Run(unregistered && deleted, id);
 }
 
 Application* ApplicationService::Launch(
@@ -617,6 +989,11 @@ void ApplicationService::OnApplicationTerminated(
   }
 }
 
+void ApplicationService::OnPermissionsChanged(Application* app) {
+  FOR_EACH_OBSERVER(Observer, observers_,
+                    OnApplicationPermissionsChanged(app));
+}
+
 void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
     const std::string& extension_name,
     const std::string& api_name, const PermissionCallback& callback) {
@@ -627,12 +1004,40 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
     callback.Run(UNDEFINED_RUNTIME_PERM);
     return;
   }
+  callback.Run(GetAPIPermission(app, extension_name, api_name));
+}
+
+void ApplicationService::GetSessionAPIPermissions(const std::string& app_id,
+    const std::string& extension_name,
+    APIPermissionMap* permissions) {
+  Application* app = GetApplicationByID(app_id);
+  if (!app)
+    return;
+
+  const Application::RegisteredAPIMap& apis = app->registered_apis();
+  Application::RegisteredAPIMap::const_iterator it = apis.begin();
+  for (; it != apis.end(); ++it) {
+    if (!extension_name.empty() && it->first != extension_name)
+      continue;
+
+    std::set<std::string>::const_iterator api = it->second.begin();
+    for (; api != it->second.end(); ++api) {
+      RuntimePermission perm = GetAPIPermission(app, it->first, *api);
+      if (perm == ALLOW_SESSION || perm == ALLOW_ALWAYS ||
+          perm == DENY_SESSION || perm == DENY_ALWAYS)
+        (*permissions)[std::make_pair(it->first, *api)] = perm;
+    }
+  }
+}
+
+RuntimePermission ApplicationService::GetAPIPermission(Application* app,
+    const std::string& extension_name,
+    const std::string& api_name) {
   if (!app->UseExtension(extension_name)) {
     LOG(ERROR) << "Can not find extension: "
       << extension_name << " of Application with ID: "
-      << app_id;
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
+      << app->id();
+    return UNDEFINED_RUNTIME_PERM;
   }
   // Permission name should have been registered at extension initialization.
   std::string permission_name =
@@ -640,8 +1045,7 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
   if (permission_name.empty()) {
     LOG(ERROR) << "API: " << api_name << " of extension: "
       << extension_name << " not registered!";
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
+    return UNDEFINED_RUNTIME_PERM;
   }
   // Okay, since we have the permission name, let's get down to the policies.
   // First, find out whether the permission is stored for the current session.
@@ -651,12 +1055,10 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
     // "PROMPT" should not be in the session storage.
     DCHECK(perm != PROMPT);
     if (perm == ALLOW) {
-      callback.Run(ALLOW_SESSION);
-      return;
+      return ALLOW_SESSION;
     }
     if (perm == DENY) {
-      callback.Run(DENY_SESSION);
-      return;
+      return DENY_SESSION;
     }
     NOTREACHED();
   }
@@ -667,25 +1069,22 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
   // contained in its manifest, so it also means that the application is asking
   // for something wasn't allowed.
   if (perm == UNDEFINED_STORED_PERM) {
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
+    return UNDEFINED_RUNTIME_PERM;
   }
   if (perm == PROMPT) {
     // TODO(Bai): We needed to pop-up a dialog asking user to chose one from
     // either allow/deny for session/one shot/forever. Then, we need to update
     // the session and persistent policy accordingly.
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
+    return UNDEFINED_RUNTIME_PERM;
   }
   if (perm == ALLOW) {
-    callback.Run(ALLOW_ALWAYS);
-    return;
+    return ALLOW_ALWAYS;
   }
   if (perm == DENY) {
-    callback.Run(DENY_ALWAYS);
-    return;
+    return DENY_ALWAYS;
   }
   NOTREACHED();
+  return UNDEFINED_RUNTIME_PERM;
 }
 
 bool ApplicationService::RegisterPermissions(const std::string& app_id,
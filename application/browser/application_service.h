@@ -5,16 +5,26 @@
 #ifndef XWALK_APPLICATION_BROWSER_APPLICATION_SERVICE_H_
 #define XWALK_APPLICATION_BROWSER_APPLICATION_SERVICE_H_
 
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
+#include "base/callback.h"
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
 #include "base/observer_list.h"
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/common/permission_policy_manager.h"
 #include "xwalk/runtime/browser/runtime_context.h"
 #include "xwalk/application/common/application_data.h"
 
+namespace base {
+class SequencedTaskRunner;
+}
+
 namespace xwalk {
 
 class RuntimeContext;
@@ -28,6 +38,22 @@ class ApplicationEventManager;
 // applications.
 class ApplicationService : public Application::Observer {
  public:
+  // The stages of the asynchronous installs, updates and uninstalls.
+  enum InstallStage {
+    INSTALL_STAGE_PREPARING,
+    INSTALL_STAGE_EXTRACTING,
+    INSTALL_STAGE_MOVING,
+    INSTALL_STAGE_REGISTERING,
+    INSTALL_STAGE_ROLLING_BACK,
+    INSTALL_STAGE_REMOVING
+  };
+
+  // |app_id| is the one of the installed application on success. On failure
+  // it's only given if the application is already installed, as Install()
+  // does, so the caller can try to update it instead.
+  typedef base::Callback<void(bool success, const std::string& app_id)>
+      InstallCallback;
+
   // Client code may use this class (and register with AddObserver below) to
   // keep track of [un]installation of applications.
   class Observer {
@@ -36,8 +62,16 @@ class ApplicationService : public Application::Observer {
     virtual void OnApplicationUninstalled(const std::string& app_id) {}
     virtual void OnApplicationUpdated(const std::string& app_id) {}
 
+    // |package_path| is empty for uninstalls, and |app_id| until the package
+    // has been read.
+    virtual void OnApplicationInstallProgress(
+        const base::FilePath& package_path, const std::string& app_id,
+        InstallStage stage) {}
+
     virtual void DidLaunchApplication(Application* app) {}
     virtual void WillDestroyApplication(Application* app) {}
+
+    virtual void OnApplicationPermissionsChanged(Application* app) {}
    protected:
     virtual ~Observer() {}
   };
@@ -51,6 +85,15 @@ class ApplicationService : public Application::Observer {
   bool Uninstall(const std::string& id);
   bool Update(const std::string& id, const base::FilePath& path);
 
+  // Same as above, but the package extraction, manifest parsing and file
+  // moves run on the blocking pool, and |callback| is called when done. The
+  // files are rolled back if a later stage fails.
+  void InstallAsync(const base::FilePath& path,
+                    const InstallCallback& callback);
+  void UninstallAsync(const std::string& id, const InstallCallback& callback);
+  void UpdateAsync(const std::string& id, const base::FilePath& path,
+                   const InstallCallback& callback);
+
   Application* Launch(scoped_refptr<ApplicationData> application_data,
                       const Application::LaunchParams& launch_params);
   // Launch an installed application using application id.
@@ -76,6 +119,15 @@ class ApplicationService : public Application::Observer {
   void CheckAPIAccessControl(const std::string& app_id,
       const std::string& extension_name,
       const std::string& api_name, const PermissionCallback& callback);
+  // Fills |permissions| with the session and persistent permissions of the
+  // APIs registered by |extension_name|, or by all the extensions if it is
+  // empty. These hold until OnApplicationPermissionsChanged() is called, so
+  // they can be cached.
+  typedef std::map<std::pair<std::string, std::string>, RuntimePermission>
+      APIPermissionMap;
+  void GetSessionAPIPermissions(const std::string& app_id,
+      const std::string& extension_name,
+      APIPermissionMap* permissions);
   // Register APIs implemented by extension. This method will be called
   // when application register extensions.
   // Parameter perm_table is a string which is a map between extension
@@ -88,6 +140,52 @@ class ApplicationService : public Application::Observer {
  private:
   // Implementation of Application::Observer.
   virtual void OnApplicationTerminated(Application* app) OVERRIDE;
+  virtual void OnPermissionsChanged(Application* app) OVERRIDE;
+
+  RuntimePermission GetAPIPermission(Application* app,
+      const std::string& extension_name,
+      const std::string& api_name);
+
+  struct InstallJob;
+  // Run on the blocking pool, unless the job is synchronous.
+  typedef bool (*InstallFileStep)(InstallJob* job);
+  typedef void (ApplicationService::*InstallStep)(
+      scoped_refptr<InstallJob> job, bool success);
+
+  // Puts back the files of the jobs interrupted by the last shutdown, see
+  // RecoverApplicationsDirectory().
+  class FilesRecovery;
+  void RecoverApplicationFiles();
+
+  base::FilePath GetApplicationsDir() const;
+  base::SequencedTaskRunner* GetFileTaskRunner();
+
+  void StartInstallJob(scoped_refptr<InstallJob> job);
+  void RunFileStep(scoped_refptr<InstallJob> job,
+                   InstallFileStep file_step,
+                   InstallStep next_step);
+  void NotifyInstallProgress(InstallJob* job, InstallStage stage);
+
+  // The stages of an install or update job, in order.
+  static bool ReadPackage(InstallJob* job);
+  void OnPackageRead(scoped_refptr<InstallJob> job, bool success);
+  static bool ExtractPackage(InstallJob* job);
+  void OnPackageExtracted(scoped_refptr<InstallJob> job, bool success);
+  static bool MoveApplicationFiles(InstallJob* job);
+  static bool DoMoveApplicationFiles(InstallJob* job);
+  static void RollBackApplicationFiles(InstallJob* job);
+  void OnApplicationFilesMoved(scoped_refptr<InstallJob> job, bool success);
+  void FinishInstallJob(scoped_refptr<InstallJob> job, bool success);
+  static bool CleanUpApplicationFiles(InstallJob* job);
+  void OnInstallJobFinished(scoped_refptr<InstallJob> job, bool success);
+
+  // Removes the application from the storage, but not its files. Returns
+  // false if it isn't installed, and sets |result| to false if it's only
+  // partly removed.
+  bool UnregisterApplication(const std::string& id, bool* result);
+  void OnApplicationFilesDeleted(const std::string& id, bool unregistered,
+                                 const InstallCallback& callback,
+                                 bool deleted);
 
 
   xwalk::RuntimeContext* runtime_context_;
@@ -97,6 +195,13 @@ class ApplicationService : public Application::Observer {
   ObserverList<Observer> observers_;
   scoped_ptr<PermissionPolicyManager> permission_policy_handler_;
 
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+  scoped_refptr<FilesRecovery> files_recovery_;
+  // The applications whose files are being moved by a job.
+  std::set<std::string> pending_app_ids_;
+
+  base::WeakPtrFactory<ApplicationService> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(ApplicationService);
 };
 
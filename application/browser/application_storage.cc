@@ -16,7 +16,7 @@ namespace application {
 ApplicationStorage::ApplicationStorage(const base::FilePath& path)
     : data_path_(path),
       impl_(new ApplicationStorageImpl(path)) {
-  impl_->Init(applications_);
+  is_loaded_ = impl_->Init(applications_);
 }
 
 ApplicationStorage::~ApplicationStorage() {
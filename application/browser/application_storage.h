@@ -34,11 +34,16 @@ class ApplicationStorage {
 
   const ApplicationData::ApplicationDataMap& GetInstalledApplications() const;
 
+  // Whether all the installed applications could be loaded from the
+  // database.
+  bool is_loaded() const { return is_loaded_; }
+
  private:
   bool Insert(scoped_refptr<ApplicationData> app_data);
   base::FilePath data_path_;
   scoped_ptr<class ApplicationStorageImpl> impl_;
   ApplicationData::ApplicationDataMap applications_;
+  bool is_loaded_;
   DISALLOW_COPY_AND_ASSIGN(ApplicationStorage);
 };
 
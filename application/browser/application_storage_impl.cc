@@ -15,6 +15,7 @@
 #include "base/json/json_string_value_serializer.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
+#include "xwalk/application/browser/application_data_cache.h"
 #include "xwalk/application/browser/application_storage.h"
 #include "xwalk/application/common/application_storage_constants.h"
 
@@ -260,42 +261,54 @@ bool ApplicationStorageImpl::GetInstalledApplications(
   if (!smt.is_valid())
     return false;
 
+  // The applications parsed in a previous run are restored from the cache,
+  // without parsing their manifest again. Each write of a manifest in the
+  // database also sets the install time of its row.
+  ApplicationDataCache cache(
+      data_path_.Append(ApplicationDataCache::kCacheFileName));
+  cache.Load();
+
   std::string error_msg;
   while (smt.Step()) {
     std::string id = smt.ColumnString(0);
-
-    int error_code;
     std::string manifest_str = smt.ColumnString(1);
-    JSONStringValueSerializer serializer(&manifest_str);
-    scoped_ptr<base::DictionaryValue> manifest(
-        static_cast<base::DictionaryValue*>(
-            serializer.Deserialize(&error_code, &error_msg)));
-
-    if (!manifest) {
-      LOG(ERROR) << "An error occured when deserializing the manifest, "
-                    "the error message is: "
-                 << error_msg;
-      return false;
-    }
-    std::string path = smt.ColumnString(2);
-    double install_time = smt.ColumnDouble(3);
+    base::FilePath path = base::FilePath::FromUTF8Unsafe(smt.ColumnString(2));
+    base::Time install_time = base::Time::FromDoubleT(smt.ColumnDouble(3));
     std::vector<std::string> events;
     base::SplitString(smt.ColumnString(4), kEventSeparator, &events);
 
-    std::string error;
     scoped_refptr<ApplicationData> application =
-        ApplicationData::Create(
-            base::FilePath::FromUTF8Unsafe(path),
-            Manifest::INTERNAL,
-            *manifest,
-            id,
-            &error);
+        cache.GetApplication(id, path, manifest_str.size(), install_time);
     if (!application) {
-      LOG(ERROR) << "Load appliation error: " << error;
-      return false;
+      int error_code;
+      JSONStringValueSerializer serializer(&manifest_str);
+      scoped_ptr<base::DictionaryValue> manifest(
+          static_cast<base::DictionaryValue*>(
+              serializer.Deserialize(&error_code, &error_msg)));
+
+      if (!manifest) {
+        LOG(ERROR) << "An error occured when deserializing the manifest, "
+                      "the error message is: "
+                   << error_msg;
+        return false;
+      }
+
+      std::string error;
+      application = ApplicationData::Create(
+          path,
+          Manifest::INTERNAL,
+          *manifest,
+          id,
+          &error);
+      if (!application) {
+        LOG(ERROR) << "Load appliation error: " << error;
+        return false;
+      }
+      cache.SetApplication(application.get(), manifest_str.size(),
+                           install_time);
     }
 
-    application->install_time_ = base::Time::FromDoubleT(install_time);
+    application->install_time_ = install_time;
 
     if (!events.empty()) {
       application->events_ =
@@ -311,6 +324,8 @@ bool ApplicationStorageImpl::GetInstalledApplications(
     }
   }
 
+  // The applications are loaded even if the cache can't be written.
+  cache.Save();
   return true;
 }
 
@@ -10,6 +10,7 @@
 #include "base/logging.h"
 #include "base/path_service.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/browser/application_data_cache.h"
 #include "xwalk/application/browser/application_storage.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 
@@ -163,5 +164,58 @@ TEST_F(ApplicationStorageImplTest, DBUpdate) {
       new_application->GetManifest()->value()));
 }
 
+
+TEST_F(ApplicationStorageImplTest, DBUpdateCachedApplication) {
+  TestInit();
+  base::DictionaryValue manifest;
+  manifest.SetString(keys::kNameKey, "no name");
+  manifest.SetString(keys::kVersionKey, "0");
+  manifest.SetString("a", "b");
+  std::string error;
+  scoped_refptr<ApplicationData> application =
+      ApplicationData::Create(base::FilePath(),
+                              Manifest::INTERNAL,
+                              manifest,
+                              "",
+                              &error);
+  ASSERT_TRUE(application);
+  EXPECT_TRUE(app_storage_impl_->AddApplication(application.get(),
+                                                base::Time::FromDoubleT(1)));
+
+  // Loading the applications caches them.
+  ApplicationData::ApplicationDataMap applications;
+  ASSERT_TRUE(app_storage_impl_->GetInstalledApplications(applications));
+  EXPECT_TRUE(base::PathExists(
+      temp_dir_.path().Append(ApplicationDataCache::kCacheFileName)));
+
+  // The cached application isn't used once its manifest is updated.
+  manifest.SetString("a", "c");
+  scoped_refptr<ApplicationData> new_application =
+      ApplicationData::Create(base::FilePath(),
+                              Manifest::INTERNAL,
+                              manifest,
+                              "",
+                              &error);
+  ASSERT_TRUE(new_application);
+  EXPECT_TRUE(app_storage_impl_->UpdateApplication(new_application.get(),
+                                                   base::Time::FromDoubleT(2)));
+  applications.clear();
+  ASSERT_TRUE(app_storage_impl_->GetInstalledApplications(applications));
+  scoped_refptr<ApplicationData> saved_application =
+      applications[new_application->ID()];
+  ASSERT_TRUE(saved_application);
+  EXPECT_TRUE(saved_application->GetManifest()->value()->Equals(
+      new_application->GetManifest()->value()));
+
+  // The updated application is restored from the cache.
+  applications.clear();
+  ASSERT_TRUE(app_storage_impl_->GetInstalledApplications(applications));
+  saved_application = applications[new_application->ID()];
+  ASSERT_TRUE(saved_application);
+  EXPECT_TRUE(saved_application->GetManifest()->value()->Equals(
+      new_application->GetManifest()->value()));
+  EXPECT_EQ(base::Time::FromDoubleT(2), saved_application->install_time());
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -8,16 +8,19 @@
 #include "base/files/file_path.h"
 #include "base/logging.h"
 #include "base/path_service.h"
-#include "third_party/zlib/google/zip.h"
+#include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/id_util.h"
+#include "xwalk/application/browser/installer/parallel_zip_extractor.h"
 #include "xwalk/application/browser/installer/wgt_package.h"
 #include "xwalk/application/browser/installer/xpk_package.h"
 
 namespace xwalk {
 namespace application {
 
-Package::Package(const base::FilePath& source_path)
+Package::Package(const base::FilePath& source_path,
+                 const base::FilePath& temp_root)
     : source_path_(source_path),
+      temp_root_(temp_root),
       is_extracted_(false),
       is_valid_(false) {
 }
@@ -27,13 +30,19 @@ Package::~Package() {
 
 // static
 scoped_ptr<Package> Package::Create(const base::FilePath& source_path) {
+  return Create(source_path, base::FilePath());
+}
+
+// static
+scoped_ptr<Package> Package::Create(const base::FilePath& source_path,
+                                    const base::FilePath& temp_root) {
   if (source_path.MatchesExtension(FILE_PATH_LITERAL(".xpk"))) {
-      scoped_ptr<Package> package(new XPKPackage(source_path));
+      scoped_ptr<Package> package(new XPKPackage(source_path, temp_root));
       if (!package->IsValid())
         LOG(ERROR) << "Package not valid";
       return package.Pass();
   } else if (source_path.MatchesExtension(FILE_PATH_LITERAL(".wgt"))) {
-     scoped_ptr<Package> package(new WGTPackage(source_path));
+     scoped_ptr<Package> package(new WGTPackage(source_path, temp_root));
      return package.Pass();
   }
 
@@ -53,7 +62,8 @@ bool Package::Extract(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.path())) {
+  ParallelZipExtractor extractor(source_path_, temp_dir_.path());
+  if (!extractor.Extract()) {
     LOG(ERROR) << "An error occurred during package extraction";
     return false;
   }
@@ -68,13 +78,18 @@ bool Package::Extract(base::FilePath* target_path) {
 // As the package information might already exists under data_path,
 // it's safer to extract the XPK/WGT file into a temporary directory first.
 bool Package::CreateTempDirectory() {
-  base::FilePath tmp;
-  PathService::Get(base::DIR_TEMP, &tmp);
+  base::FilePath tmp = temp_root_;
+  if (tmp.empty())
+    PathService::Get(base::DIR_TEMP, &tmp);
   if (tmp.empty())
     return false;
-  if (!temp_dir_.CreateUniqueTempDirUnderPath(tmp))
+  // The name tells the leftovers of an interrupted install apart from the
+  // installed applications, see RecoverApplicationsDirectory().
+  base::FilePath temp_path;
+  if (!base::CreateTemporaryDirInDir(tmp, kPackageExtractDirPrefix,
+                                     &temp_path))
     return false;
-  return true;
+  return temp_dir_.Set(temp_path);
 }
 
 }  // namespace application
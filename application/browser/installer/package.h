@@ -27,17 +27,24 @@ class Package {
   const std::string& Id() const { return id_; }
   // Factory method for creating a package
   static scoped_ptr<Package> Create(const base::FilePath& path);
+  // Same as above, but the package is extracted under |temp_root|. Using a
+  // directory on the same file system as the installed applications lets
+  // them be moved in place by a rename.
+  static scoped_ptr<Package> Create(const base::FilePath& path,
+                                    const base::FilePath& temp_root);
   // The function will unzip the XPK/WGT file and return the target path where
   // to decompress by the parameter |target_path|.
   virtual bool Extract(base::FilePath* target_path);
  protected:
-  explicit Package(const base::FilePath& source_path);
+  Package(const base::FilePath& source_path, const base::FilePath& temp_root);
   scoped_ptr<ScopedStdioHandle> file_;
   bool is_valid_;
   std::string id_;
   // Unzipping of the zipped file happens in a temporary directory
   bool CreateTempDirectory();
   base::FilePath source_path_;
+  // Where the temporary directory is created, the system one when empty.
+  base::FilePath temp_root_;
   // Temporary directory for unpacking.
   base::ScopedTempDir temp_dir_;
   // Represent if the package has been extracted.
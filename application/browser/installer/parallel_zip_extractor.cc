@@ -0,0 +1,251 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/parallel_zip_extractor.h"
+
+#if defined(OS_POSIX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <utility>
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_handle.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/sys_info.h"
+
+#if defined(OS_POSIX)
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const size_t kMaxEntryNameLength = 1024;
+const size_t kBufferSize = 64 * 1024;
+
+// Files smaller than this aren't worth preallocating.
+const uint64 kPreallocationThreshold = 1024 * 1024;
+
+bool IsUnsafeEntryPath(const std::string& name,
+                       const base::FilePath& relative_path) {
+  return name.empty() || relative_path.IsAbsolute() ||
+      relative_path.ReferencesParent();
+}
+
+}  // namespace
+
+ParallelZipExtractor::ParallelZipExtractor(const base::FilePath& zip_path,
+                                           const base::FilePath& target_dir)
+    : zip_path_(zip_path),
+      target_dir_(target_dir),
+      max_threads_(base::SysInfo::NumberOfProcessors()),
+      next_entry_(0),
+      failed_(false) {
+}
+
+ParallelZipExtractor::~ParallelZipExtractor() {
+}
+
+bool ParallelZipExtractor::Extract() {
+  if (!ReadEntries())
+    return false;
+
+  int threads = std::min(std::max(max_threads_, 1),
+                         static_cast<int>(entries_.size()));
+  if (threads <= 1) {
+    Run();
+  } else {
+    base::DelegateSimpleThreadPool pool("XWalkZipExtractor", threads);
+    pool.AddWork(this, threads);
+    pool.Start();
+    pool.JoinAll();
+  }
+
+  if (failed_) {
+    LOG(ERROR) << "An error occurred while extracting "
+               << zip_path_.MaybeAsASCII();
+    return false;
+  }
+
+  return SyncFiles();
+}
+
+bool ParallelZipExtractor::ReadEntries() {
+  unzFile zip_file = unzOpen(zip_path_.AsUTF8Unsafe().c_str());
+  if (!zip_file) {
+    LOG(ERROR) << "Couldn't open the zip file " << zip_path_.MaybeAsASCII();
+    return false;
+  }
+
+  std::set<base::FilePath> directories;
+  int result;
+  for (result = unzGoToFirstFile(zip_file); result == UNZ_OK;
+       result = unzGoToNextFile(zip_file)) {
+    unz_file_info info;
+    char name[kMaxEntryNameLength + 1];
+    if (unzGetCurrentFileInfo(zip_file, &info, name, sizeof(name),
+                              NULL, 0, NULL, 0) != UNZ_OK ||
+        info.size_filename > kMaxEntryNameLength)
+      break;
+
+    std::string entry_name(name, info.size_filename);
+    base::FilePath relative_path = base::FilePath::FromUTF8Unsafe(entry_name);
+    if (IsUnsafeEntryPath(entry_name, relative_path)) {
+      LOG(ERROR) << "Unsafe zip entry path: " << entry_name;
+      break;
+    }
+
+    base::FilePath path = target_dir_.Append(relative_path);
+    if (entry_name[entry_name.size() - 1] == '/') {
+      directories.insert(path);
+      continue;
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.size = info.uncompressed_size;
+    if (unzGetFilePos(zip_file, &entry.position) != UNZ_OK)
+      break;
+    entries_.push_back(entry);
+    directories.insert(path.DirName());
+  }
+  unzClose(zip_file);
+
+  if (result != UNZ_END_OF_LIST_OF_FILE) {
+    LOG(ERROR) << "Couldn't read the entries of " << zip_path_.MaybeAsASCII();
+    return false;
+  }
+
+  // The directories are created before the threads write into them.
+  for (std::set<base::FilePath>::const_iterator it = directories.begin();
+       it != directories.end(); ++it) {
+    if (!base::CreateDirectory(*it)) {
+      LOG(ERROR) << "Couldn't create directory: " << it->MaybeAsASCII();
+      return false;
+    }
+  }
+
+  // Starting with the biggest files keeps the threads busy until the end.
+  std::vector<std::pair<uint64, size_t> > sizes;
+  for (size_t i = 0; i < entries_.size(); ++i)
+    sizes.push_back(std::make_pair(entries_[i].size, i));
+  std::stable_sort(sizes.begin(), sizes.end(),
+                   std::greater<std::pair<uint64, size_t> >());
+  extraction_order_.clear();
+  for (size_t i = 0; i < sizes.size(); ++i)
+    extraction_order_.push_back(sizes[i].second);
+
+  return true;
+}
+
+void ParallelZipExtractor::Run() {
+  // The minizip handles can't be shared between threads.
+  unzFile zip_file = unzOpen(zip_path_.AsUTF8Unsafe().c_str());
+  if (!zip_file) {
+    SetFailed();
+    return;
+  }
+
+  scoped_ptr<char[]> buffer(new char[kBufferSize]);
+  while (const Entry* entry = NextEntry()) {
+    if (!ExtractEntry(zip_file, *entry, buffer.get())) {
+      LOG(ERROR) << "Couldn't extract " << entry->path.MaybeAsASCII();
+      SetFailed();
+      break;
+    }
+  }
+
+  unzClose(zip_file);
+}
+
+const ParallelZipExtractor::Entry* ParallelZipExtractor::NextEntry() {
+  base::AutoLock l(lock_);
+  if (failed_ || next_entry_ >= extraction_order_.size())
+    return NULL;
+  return &entries_[extraction_order_[next_entry_++]];
+}
+
+void ParallelZipExtractor::SetFailed() {
+  base::AutoLock l(lock_);
+  failed_ = true;
+}
+
+bool ParallelZipExtractor::ExtractEntry(unzFile zip_file, const Entry& entry,
+                                        char* buffer) {
+  unz_file_pos position = entry.position;
+  if (unzGoToFilePos(zip_file, &position) != UNZ_OK ||
+      unzOpenCurrentFile(zip_file) != UNZ_OK)
+    return false;
+
+  ScopedStdioHandle file(base::OpenFile(entry.path, "wb"));
+  if (!file.get()) {
+    unzCloseCurrentFile(zip_file);
+    return false;
+  }
+
+#if defined(OS_LINUX)
+  // Lets the file system allocate the big files in one go. It's only a
+  // hint, the files are written the same way if it fails. The size of the
+  // file is kept, so it never ends with zeros the entry doesn't have.
+  if (entry.size >= kPreallocationThreshold) {
+    fallocate(fileno(file.get()), FALLOC_FL_KEEP_SIZE, 0,
+              static_cast<off_t>(entry.size));
+  }
+#endif
+
+  bool success = true;
+  uint64 written = 0;
+  int size;
+  while ((size = unzReadCurrentFile(zip_file, buffer, kBufferSize)) > 0) {
+    if (fwrite(buffer, 1, size, file.get()) != static_cast<size_t>(size)) {
+      success = false;
+      break;
+    }
+    written += size;
+  }
+  if (size < 0 || fflush(file.get()) != 0)
+    success = false;
+
+  // The CRC only covers the data that was read, a truncated entry must not
+  // pass for a complete file.
+  if (success && written != entry.size) {
+    LOG(ERROR) << "Extracted " << written << " bytes instead of "
+               << entry.size;
+    success = false;
+  }
+
+  // Checks the CRC when the entry was read entirely.
+  if (unzCloseCurrentFile(zip_file) != UNZ_OK)
+    success = false;
+
+  return success;
+}
+
+bool ParallelZipExtractor::SyncFiles() {
+#if defined(OS_POSIX)
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    int fd = HANDLE_EINTR(open(entries_[i].path.value().c_str(), O_RDONLY));
+    if (fd < 0)
+      return false;
+    bool synced = fsync(fd) == 0;
+    IGNORE_EINTR(close(fd));
+    if (!synced) {
+      LOG(ERROR) << "Couldn't sync " << entries_[i].path.MaybeAsASCII();
+      return false;
+    }
+  }
+#endif
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,82 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_INSTALLER_PARALLEL_ZIP_EXTRACTOR_H_
+#define XWALK_APPLICATION_BROWSER_INSTALLER_PARALLEL_ZIP_EXTRACTOR_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+
+#if defined(USE_SYSTEM_MINIZIP)
+#include <minizip/unzip.h>
+#else
+#include "third_party/zlib/contrib/minizip/unzip.h"
+#endif
+
+namespace xwalk {
+namespace application {
+
+// Extracts a zip archive into |target_dir| with one thread per core. The
+// entries are listed from the central directory of the archive, then the
+// threads inflate and write them, the biggest ones first, each reading the
+// archive through its own handle.
+//
+// Extract() blocks until all the files are written and synced to disk, in
+// the order of the archive, so the extracted directory can be moved in place
+// right after.
+class ParallelZipExtractor : public base::DelegateSimpleThread::Delegate {
+ public:
+  ParallelZipExtractor(const base::FilePath& zip_path,
+                       const base::FilePath& target_dir);
+  virtual ~ParallelZipExtractor();
+
+  bool Extract();
+
+  // Defaults to the number of processors.
+  void set_max_threads(int max_threads) { max_threads_ = max_threads; }
+
+ private:
+  struct Entry {
+    base::FilePath path;
+    uint64 size;
+    unz_file_pos position;
+  };
+
+  // Lists the entries and creates the directories.
+  bool ReadEntries();
+
+  // base::DelegateSimpleThread::Delegate implementation, run by each thread.
+  virtual void Run() OVERRIDE;
+
+  const Entry* NextEntry();
+  void SetFailed();
+  bool ExtractEntry(unzFile zip_file, const Entry& entry, char* buffer);
+  bool SyncFiles();
+
+  base::FilePath zip_path_;
+  base::FilePath target_dir_;
+  int max_threads_;
+
+  // The files, in the order of the archive.
+  std::vector<Entry> entries_;
+  // The indexes of |entries_| in the order they are extracted.
+  std::vector<size_t> extraction_order_;
+
+  // Protects |next_entry_| and |failed_|.
+  base::Lock lock_;
+  size_t next_entry_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelZipExtractor);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_INSTALLER_PARALLEL_ZIP_EXTRACTOR_H_
@@ -0,0 +1,113 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/parallel_zip_extractor.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kFileCount = 20;
+
+std::string GetFileContents(int index) {
+  // Files of different sizes, some of them big enough to be preallocated.
+  return std::string((index % 4) * 512 * 1024 + index, 'a' + index);
+}
+
+}  // namespace
+
+class ParallelZipExtractorTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    target_dir_ = temp_dir_.path().AppendASCII("target");
+    ASSERT_TRUE(base::CreateDirectory(target_dir_));
+  }
+
+  base::FilePath GetRelativePath(int index) {
+    return base::FilePath().AppendASCII(base::IntToString(index % 3))
+        .AppendASCII(base::IntToString(index));
+  }
+
+  void CreateZipFile(const base::FilePath& zip_path) {
+    base::FilePath source_dir = temp_dir_.path().AppendASCII("source");
+    ASSERT_TRUE(base::CreateDirectory(source_dir.AppendASCII("empty")));
+    for (int i = 0; i < kFileCount; ++i) {
+      base::FilePath path = source_dir.Append(GetRelativePath(i));
+      std::string contents = GetFileContents(i);
+      ASSERT_TRUE(base::CreateDirectory(path.DirName()));
+      ASSERT_EQ(static_cast<int>(contents.size()),
+                base::WriteFile(path, contents.data(), contents.size()));
+    }
+    ASSERT_TRUE(zip::Zip(source_dir, zip_path, false));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath target_dir_;
+};
+
+TEST_F(ParallelZipExtractorTest, Extract) {
+  base::FilePath zip_path = temp_dir_.path().AppendASCII("test.zip");
+  CreateZipFile(zip_path);
+
+  ParallelZipExtractor extractor(zip_path, target_dir_);
+  extractor.set_max_threads(4);
+  ASSERT_TRUE(extractor.Extract());
+
+  EXPECT_TRUE(base::DirectoryExists(target_dir_.AppendASCII("empty")));
+  for (int i = 0; i < kFileCount; ++i) {
+    std::string contents;
+    EXPECT_TRUE(base::ReadFileToString(target_dir_.Append(GetRelativePath(i)),
+                                       &contents));
+    EXPECT_EQ(GetFileContents(i), contents);
+  }
+}
+
+TEST_F(ParallelZipExtractorTest, NotAZipFile) {
+  base::FilePath path = temp_dir_.path().AppendASCII("test.zip");
+  std::string contents = GetFileContents(1);
+  ASSERT_TRUE(base::WriteFile(path, contents.data(), contents.size()));
+
+  ParallelZipExtractor extractor(path, target_dir_);
+  EXPECT_FALSE(extractor.Extract());
+}
+
+TEST_F(ParallelZipExtractorTest, CorruptedEntry) {
+  // A single file which doesn't compress, so the middle of the archive is
+  // in its data.
+  base::FilePath source_dir = temp_dir_.path().AppendASCII("source");
+  ASSERT_TRUE(base::CreateDirectory(source_dir));
+  std::string contents(256 * 1024, '\0');
+  uint32 value = 1;
+  for (size_t i = 0; i < contents.size(); ++i) {
+    value = value * 1103515245 + 12345;
+    contents[i] = static_cast<char>(value >> 24);
+  }
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(source_dir.AppendASCII("data"), contents.data(),
+                            contents.size()));
+  base::FilePath zip_path = temp_dir_.path().AppendASCII("test.zip");
+  ASSERT_TRUE(zip::Zip(source_dir, zip_path, false));
+
+  std::string zip_data;
+  ASSERT_TRUE(base::ReadFileToString(zip_path, &zip_data));
+  zip_data[zip_data.size() / 2] ^= 0xff;
+  ASSERT_EQ(static_cast<int>(zip_data.size()),
+            base::WriteFile(zip_path, zip_data.data(), zip_data.size()));
+
+  ParallelZipExtractor extractor(zip_path, target_dir_);
+  EXPECT_FALSE(extractor.Extract());
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -6,6 +6,7 @@
 
 #include "base/file_util.h"
 #include "third_party/libxml/chromium/libxml_utils.h"
+#include "xwalk/application/browser/installer/zip_entry_reader.h"
 #include "xwalk/application/common/id_util.h"
 
 namespace xwalk {
@@ -16,22 +17,31 @@ const char kIdNodeName[] = "application";
 #else
 const char kIdNodeName[] = "widget";
 #endif
+const char kConfigFileName[] = "config.xml";
+const size_t kMaxConfigFileSize = 1024 * 1024;
 }
 
 WGTPackage::~WGTPackage() {
 }
 
-WGTPackage::WGTPackage(const base::FilePath& path)
-  : Package(path) {
+WGTPackage::WGTPackage(const base::FilePath& path,
+                       const base::FilePath& temp_root)
+  : Package(path, temp_root) {
   if (!base::PathExists(path))
     return;
-  base::FilePath extracted_path;
-  if (!Extract(&extracted_path))
+
+  // Only config.xml is needed to identify the widget, the package is
+  // extracted when it's installed.
+  ZipEntryReader reader;
+  std::string config;
+  if (!reader.Open(path) ||
+      !reader.ReadEntry(kConfigFileName, kMaxConfigFileSize, &config)) {
+    LOG(ERROR) << "Unable to read WGT package config.xml file.";
     return;
+  }
 
   XmlReader xml;
-  if (!xml.LoadFile(extracted_path.Append(FILE_PATH_LITERAL("config.xml"))
-                    .MaybeAsASCII())) {
+  if (!xml.Load(config)) {
     LOG(ERROR) << "Unable to load WGT package config.xml file.";
     return;
   }
@@ -18,7 +18,7 @@ namespace application {
 
 class WGTPackage : public Package {
  public:
-  explicit WGTPackage(const base::FilePath& path);
+  WGTPackage(const base::FilePath& path, const base::FilePath& temp_root);
   virtual ~WGTPackage();
 };
 
@@ -6,6 +6,8 @@
 
 #include "base/file_util.h"
 #include "crypto/signature_verifier.h"
+#include "xwalk/application/browser/installer/parallel_zip_extractor.h"
+#include "xwalk/application/browser/installer/zip_stream_extractor.h"
 #include "xwalk/application/common/id_util.h"
 
 namespace xwalk {
@@ -16,13 +18,16 @@ const uint8 kSignatureAlgorithm[15] = {
   0xf7, 0x0d, 0x01, 0x01, 0x05, 0x05, 0x00
 };
 
+const size_t kReadBufferSize = 64 * 1024;
+
 const char XPKPackage::kXPKPackageHeaderMagic[] = "CrWk";
 
 XPKPackage::~XPKPackage() {
 }
 
-XPKPackage::XPKPackage(const base::FilePath& path)
-  : Package(path) {
+XPKPackage::XPKPackage(const base::FilePath& path,
+                       const base::FilePath& temp_root)
+  : Package(path, temp_root) {
   if (!base::PathExists(path))
     return;
   scoped_ptr<ScopedStdioHandle> file(
@@ -56,9 +61,6 @@ XPKPackage::XPKPackage(const base::FilePath& path)
         if (len < header_.signature_size)
           is_valid_ = false;
 
-        if (!VerifySignature())
-          is_valid_ = false;
-
         std::string public_key =
             std::string(reinterpret_cast<char*>(&key_.front()), key_.size());
         id_ = GenerateId(public_key);
@@ -66,9 +68,9 @@ XPKPackage::XPKPackage(const base::FilePath& path)
   return;
 }
 
-bool XPKPackage::VerifySignature() {
-// Set the file read position to the beginning of compressed resource file,
-// which is behind the magic header, public key and signature key.
+bool XPKPackage::VerifyAndExtract(const base::FilePath& target_dir) {
+  // Set the file read position to the beginning of compressed resource file,
+  // which is behind the magic header, public key and signature key.
   fseek(file_->get(), zip_addr_, SEEK_SET);
   crypto::SignatureVerifier verifier;
   if (!verifier.VerifyInit(kSignatureAlgorithm,
@@ -78,14 +80,34 @@ bool XPKPackage::VerifySignature() {
                            &key_.front(),
                            key_.size()))
     return false;
-  unsigned char buf[1 << 12];
+
+  // The files are extracted before the signature is verified, Extract()
+  // removes them with the temporary directory if it doesn't match.
+  ZipStreamExtractor extractor(target_dir);
+  bool streaming = true;
+  scoped_ptr<char[]> buf(new char[kReadBufferSize]);
   size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, len);
-  if (!verifier.VerifyFinal())
+  while ((len = fread(buf.get(), 1, kReadBufferSize, file_->get())) > 0) {
+    verifier.VerifyUpdate(reinterpret_cast<uint8*>(buf.get()), len);
+    if (streaming && !extractor.Write(buf.get(), len)) {
+      if (!extractor.is_unsupported())
+        return false;
+      streaming = false;
+    }
+  }
+  if (ferror(file_->get()) || !verifier.VerifyFinal()) {
+    LOG(ERROR) << "The XPK signature is invalid.";
     return false;
+  }
 
-  return true;
+  if (streaming)
+    return extractor.Finish();
+
+  if (!base::DeleteFile(target_dir, true) ||
+      !base::CreateDirectory(target_dir))
+    return false;
+  ParallelZipExtractor parallel_extractor(source_path_, target_dir);
+  return parallel_extractor.Extract();
 }
 
 bool XPKPackage::Extract(base::FilePath* target_path) {
@@ -99,7 +121,23 @@ bool XPKPackage::Extract(base::FilePath* target_path) {
     return false;
   }
 
-  return Package::Extract(target_path);
+  if (!CreateTempDirectory()) {
+    LOG(ERROR) << "Can't create a temporary"
+                  "directory for extracting the package content.";
+    return false;
+  }
+
+  if (!VerifyAndExtract(temp_dir_.path())) {
+    LOG(ERROR) << "An error occurred during package extraction";
+    ignore_result(temp_dir_.Delete());
+    is_valid_ = false;
+    return false;
+  }
+
+  is_extracted_ = true;
+
+  *target_path = temp_dir_.path();
+  return true;
 }
 
 }  // namespace application
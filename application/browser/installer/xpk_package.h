@@ -29,12 +29,15 @@ class XPKPackage : public Package {
     uint32 signature_size;
   };
   virtual ~XPKPackage();
-  explicit XPKPackage(const base::FilePath& path);
+  XPKPackage(const base::FilePath& path, const base::FilePath& temp_root);
+  // The signature is verified while the package is extracted, the package
+  // isn't extracted if it doesn't match.
   virtual bool Extract(base::FilePath* target_path) OVERRIDE;
 
  private:
-  // verify the signature in the xpk package
-  virtual bool VerifySignature();
+  // Reads the zip file once to verify the signature of the package and to
+  // extract it into |target_dir|.
+  bool VerifyAndExtract(const base::FilePath& target_dir);
 
   Header header_;
   std::vector<uint8> signature_;
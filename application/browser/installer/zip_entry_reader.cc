@@ -0,0 +1,88 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/zip_entry_reader.h"
+
+#include "base/logging.h"
+
+#if defined(USE_SYSTEM_MINIZIP)
+#include <minizip/unzip.h>
+#else
+#include "third_party/zlib/contrib/minizip/unzip.h"
+#endif
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kCaseSensitive = 1;
+
+}  // namespace
+
+ZipEntryReader::ZipEntryReader()
+    : zip_file_(NULL) {
+}
+
+ZipEntryReader::~ZipEntryReader() {
+  Close();
+}
+
+bool ZipEntryReader::Open(const base::FilePath& zip_path) {
+  Close();
+  zip_file_ = unzOpen(zip_path.AsUTF8Unsafe().c_str());
+  return zip_file_ != NULL;
+}
+
+void ZipEntryReader::Close() {
+  if (zip_file_)
+    unzClose(zip_file_);
+  zip_file_ = NULL;
+}
+
+bool ZipEntryReader::HasEntry(const std::string& name) {
+  return zip_file_ &&
+      unzLocateFile(zip_file_, name.c_str(), kCaseSensitive) == UNZ_OK;
+}
+
+bool ZipEntryReader::ReadEntry(const std::string& name, size_t max_size,
+                               std::string* contents) {
+  if (!HasEntry(name))
+    return false;
+
+  unz_file_info info;
+  if (unzGetCurrentFileInfo(zip_file_, &info, NULL, 0, NULL, 0, NULL, 0)
+      != UNZ_OK)
+    return false;
+
+  if (info.uncompressed_size > max_size) {
+    LOG(WARNING) << "The zip entry " << name << " is too big.";
+    return false;
+  }
+
+  if (unzOpenCurrentFile(zip_file_) != UNZ_OK)
+    return false;
+
+  std::string data(info.uncompressed_size, '\0');
+  bool success = true;
+  if (!data.empty()) {
+    int size = unzReadCurrentFile(zip_file_, &data[0], data.size());
+    success = size == static_cast<int>(data.size());
+  }
+
+  // Checks the CRC of the entry, which was read entirely.
+  if (unzCloseCurrentFile(zip_file_) != UNZ_OK)
+    success = false;
+
+  if (!success) {
+    LOG(WARNING) << "Couldn't read the zip entry " << name;
+    return false;
+  }
+
+  contents->swap(data);
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
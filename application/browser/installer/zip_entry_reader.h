@@ -0,0 +1,44 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_INSTALLER_ZIP_ENTRY_READER_H_
+#define XWALK_APPLICATION_BROWSER_INSTALLER_ZIP_ENTRY_READER_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+
+namespace xwalk {
+namespace application {
+
+// Reads single entries of a zip archive, e.g. the config.xml of a widget,
+// without extracting the others. The entries are found from the central
+// directory of the archive, only the ones read are inflated.
+class ZipEntryReader {
+ public:
+  ZipEntryReader();
+  ~ZipEntryReader();
+
+  bool Open(const base::FilePath& zip_path);
+  void Close();
+
+  bool HasEntry(const std::string& name);
+
+  // Inflates the entry |name| into |contents|. Fails if there's no such
+  // entry, or if it's bigger than |max_size| bytes.
+  bool ReadEntry(const std::string& name, size_t max_size,
+                 std::string* contents);
+
+ private:
+  // The minizip handle of the archive.
+  void* zip_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(ZipEntryReader);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_INSTALLER_ZIP_ENTRY_READER_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/zip_entry_reader.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace xwalk {
+namespace application {
+
+class ZipEntryReaderTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+
+    base::FilePath source_dir = temp_dir_.path().AppendASCII("source");
+    ASSERT_TRUE(base::CreateDirectory(source_dir.AppendASCII("icons")));
+
+    config_ = "<widget id=\"http://example.com/widget\"/>";
+    std::string icon(64 * 1024, 'i');
+    ASSERT_TRUE(base::WriteFile(source_dir.AppendASCII("config.xml"),
+                                config_.data(),
+                                static_cast<int>(config_.size())));
+    ASSERT_TRUE(base::WriteFile(
+        source_dir.AppendASCII("icons").AppendASCII("icon.png"),
+        icon.data(), static_cast<int>(icon.size())));
+
+    zip_path_ = temp_dir_.path().AppendASCII("test.wgt");
+    ASSERT_TRUE(zip::Zip(source_dir, zip_path_, false));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath zip_path_;
+  std::string config_;
+};
+
+TEST_F(ZipEntryReaderTest, ReadEntry) {
+  ZipEntryReader reader;
+  ASSERT_TRUE(reader.Open(zip_path_));
+
+  std::string contents;
+  EXPECT_TRUE(reader.ReadEntry("config.xml", 1024, &contents));
+  EXPECT_EQ(config_, contents);
+
+  EXPECT_TRUE(reader.HasEntry("icons/icon.png"));
+  EXPECT_TRUE(reader.ReadEntry("icons/icon.png", 64 * 1024, &contents));
+  EXPECT_EQ(64u * 1024, contents.size());
+}
+
+TEST_F(ZipEntryReaderTest, MissingEntry) {
+  ZipEntryReader reader;
+  ASSERT_TRUE(reader.Open(zip_path_));
+
+  std::string contents;
+  EXPECT_FALSE(reader.HasEntry("CONFIG.XML"));
+  EXPECT_FALSE(reader.ReadEntry("manifest.json", 1024, &contents));
+}
+
+TEST_F(ZipEntryReaderTest, EntryTooBig) {
+  ZipEntryReader reader;
+  ASSERT_TRUE(reader.Open(zip_path_));
+
+  std::string contents;
+  EXPECT_FALSE(reader.ReadEntry("icons/icon.png", 1024, &contents));
+  EXPECT_TRUE(contents.empty());
+}
+
+TEST_F(ZipEntryReaderTest, NotAZipFile) {
+  base::FilePath path = temp_dir_.path().AppendASCII("config.xml");
+  ASSERT_TRUE(base::WriteFile(path, config_.data(),
+                              static_cast<int>(config_.size())));
+
+  ZipEntryReader reader;
+  EXPECT_FALSE(reader.Open(path));
+  EXPECT_FALSE(reader.HasEntry("config.xml"));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,300 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/zip_stream_extractor.h"
+
+#include <algorithm>
+
+#include "base/file_util.h"
+#include "base/logging.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const uint32 kLocalFileHeaderSignature = 0x04034b50;
+const uint32 kDataDescriptorSignature = 0x08074b50;
+const uint32 kCentralDirectorySignature = 0x02014b50;
+const uint32 kEndOfCentralDirectorySignature = 0x06054b50;
+
+const size_t kLocalFileHeaderSize = 30;
+const size_t kSignatureSize = 4;
+
+const uint16 kEncryptedFlag = 1 << 0;
+const uint16 kDataDescriptorFlag = 1 << 3;
+
+const uint16 kStoredMethod = 0;
+const uint16 kDeflatedMethod = 8;
+
+const uint32 kZip64Size = 0xffffffff;
+
+const size_t kInflateBufferSize = 64 * 1024;
+
+uint16 ReadUInt16(const char* data) {
+  const uint8* bytes = reinterpret_cast<const uint8*>(data);
+  return bytes[0] | (bytes[1] << 8);
+}
+
+uint32 ReadUInt32(const char* data) {
+  const uint8* bytes = reinterpret_cast<const uint8*>(data);
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+      (static_cast<uint32>(bytes[3]) << 24);
+}
+
+}  // namespace
+
+ZipStreamExtractor::ZipStreamExtractor(const base::FilePath& target_dir)
+    : target_dir_(target_dir),
+      state_(STATE_HEADER),
+      unsupported_(false),
+      offset_(0),
+      method_(kStoredMethod),
+      has_descriptor_(false),
+      remaining_size_(0),
+      expected_crc_(0),
+      crc_(0),
+      inflate_buffer_(new char[kInflateBufferSize]) {
+  memset(&inflate_stream_, 0, sizeof(inflate_stream_));
+  // Negative window bits for the raw deflate data of the zip entries.
+  if (inflateInit2(&inflate_stream_, -MAX_WBITS) != Z_OK)
+    Fail("Couldn't initialize zlib.");
+}
+
+ZipStreamExtractor::~ZipStreamExtractor() {
+  inflateEnd(&inflate_stream_);
+}
+
+bool ZipStreamExtractor::Write(const char* data, size_t size) {
+  if (state_ == STATE_ERROR)
+    return false;
+  // Nothing after the central directory is needed.
+  if (state_ == STATE_DONE)
+    return true;
+
+  buffer_.append(data, size);
+
+  bool can_continue = true;
+  while (can_continue) {
+    switch (state_) {
+      case STATE_HEADER:
+        can_continue = ReadHeader();
+        break;
+      case STATE_DATA:
+        can_continue = ReadData();
+        break;
+      case STATE_DESCRIPTOR:
+        can_continue = ReadDescriptor();
+        break;
+      case STATE_DONE:
+      case STATE_ERROR:
+        can_continue = false;
+        break;
+    }
+  }
+
+  buffer_.erase(0, offset_);
+  offset_ = 0;
+  return state_ != STATE_ERROR;
+}
+
+bool ZipStreamExtractor::Finish() {
+  if (state_ != STATE_DONE && state_ != STATE_ERROR)
+    Fail("The zip archive is truncated.");
+  return state_ == STATE_DONE;
+}
+
+bool ZipStreamExtractor::ReadHeader() {
+  if (available() < kSignatureSize)
+    return false;
+
+  const char* header = current();
+  uint32 signature = ReadUInt32(header);
+  if (signature == kCentralDirectorySignature ||
+      signature == kEndOfCentralDirectorySignature) {
+    state_ = STATE_DONE;
+    return false;
+  }
+  if (signature != kLocalFileHeaderSignature)
+    return Fail("Invalid zip entry header.");
+
+  if (available() < kLocalFileHeaderSize)
+    return false;
+
+  uint16 flags = ReadUInt16(header + 6);
+  uint16 method = ReadUInt16(header + 8);
+  uint32 crc = ReadUInt32(header + 14);
+  uint32 compressed_size = ReadUInt32(header + 18);
+  uint32 size = ReadUInt32(header + 22);
+  uint16 name_length = ReadUInt16(header + 26);
+  uint16 extra_length = ReadUInt16(header + 28);
+
+  size_t header_size = kLocalFileHeaderSize + name_length + extra_length;
+  if (available() < header_size)
+    return false;
+
+  std::string name(header + kLocalFileHeaderSize, name_length);
+  offset_ += header_size;
+
+  if (flags & kEncryptedFlag)
+    return FailUnsupported("Encrypted zip entry: " + name);
+  if (compressed_size == kZip64Size || size == kZip64Size)
+    return FailUnsupported("ZIP64 entry: " + name);
+  if (method != kStoredMethod && method != kDeflatedMethod)
+    return FailUnsupported("Unsupported compression method: " + name);
+  // The end of a stored entry can't be found without its size.
+  if (method == kStoredMethod && (flags & kDataDescriptorFlag))
+    return FailUnsupported("Stored zip entry without size: " + name);
+
+  method_ = method;
+  has_descriptor_ = (flags & kDataDescriptorFlag) != 0;
+  remaining_size_ = compressed_size;
+  expected_crc_ = crc;
+  crc_ = crc32(0L, Z_NULL, 0);
+  if (method_ == kDeflatedMethod && inflateReset(&inflate_stream_) != Z_OK)
+    return Fail("Couldn't reset zlib.");
+
+  if (!StartEntry(name))
+    return false;
+
+  state_ = STATE_DATA;
+  return true;
+}
+
+bool ZipStreamExtractor::ReadData() {
+  if (method_ == kStoredMethod) {
+    size_t size = std::min(available(), static_cast<size_t>(remaining_size_));
+    if (!WriteEntryData(current(), size))
+      return false;
+    offset_ += size;
+    remaining_size_ -= size;
+    return remaining_size_ == 0 && FinishEntry(expected_crc_);
+  }
+
+  // The size of the deflated data isn't known when it's followed by a data
+  // descriptor, it ends with the deflate stream.
+  size_t size = available();
+  if (!has_descriptor_) {
+    if (remaining_size_ == 0)
+      return Fail("Invalid compressed data: " + entry_name_);
+    size = std::min(size, static_cast<size_t>(remaining_size_));
+  }
+  if (size == 0)
+    return false;
+
+  inflate_stream_.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(current()));
+  inflate_stream_.avail_in = size;
+
+  int result;
+  do {
+    inflate_stream_.next_out =
+        reinterpret_cast<Bytef*>(inflate_buffer_.get());
+    inflate_stream_.avail_out = kInflateBufferSize;
+    result = inflate(&inflate_stream_, Z_NO_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+      return Fail("Invalid compressed data: " + entry_name_);
+
+    size_t inflated_size = kInflateBufferSize - inflate_stream_.avail_out;
+    if (!WriteEntryData(inflate_buffer_.get(), inflated_size))
+      return false;
+  } while (result == Z_OK &&
+           (inflate_stream_.avail_in > 0 || inflate_stream_.avail_out == 0));
+
+  size_t consumed = size - inflate_stream_.avail_in;
+  offset_ += consumed;
+  if (!has_descriptor_)
+    remaining_size_ -= consumed;
+
+  if (result != Z_STREAM_END)
+    return false;
+
+  if (has_descriptor_) {
+    state_ = STATE_DESCRIPTOR;
+    return true;
+  }
+
+  if (remaining_size_ != 0)
+    return Fail("Invalid compressed data: " + entry_name_);
+  return FinishEntry(expected_crc_);
+}
+
+bool ZipStreamExtractor::ReadDescriptor() {
+  if (available() < kSignatureSize)
+    return false;
+
+  // The signature of the descriptor is optional.
+  size_t crc_offset =
+      ReadUInt32(current()) == kDataDescriptorSignature ? kSignatureSize : 0;
+  size_t descriptor_size = crc_offset + 12;
+  if (available() < descriptor_size)
+    return false;
+
+  uint32 crc = ReadUInt32(current() + crc_offset);
+  offset_ += descriptor_size;
+  return FinishEntry(crc);
+}
+
+bool ZipStreamExtractor::StartEntry(const std::string& name) {
+  entry_name_ = name;
+
+  base::FilePath relative_path = base::FilePath::FromUTF8Unsafe(name);
+  if (name.empty() || relative_path.IsAbsolute() ||
+      relative_path.ReferencesParent())
+    return Fail("Unsafe zip entry path: " + name);
+
+  base::FilePath path = target_dir_.Append(relative_path);
+  if (name[name.size() - 1] == '/') {
+    if (!base::CreateDirectory(path))
+      return Fail("Couldn't create directory: " + path.MaybeAsASCII());
+    return true;
+  }
+
+  if (!base::CreateDirectory(path.DirName()))
+    return Fail("Couldn't create directory: " + path.MaybeAsASCII());
+
+  file_.reset(new ScopedStdioHandle(base::OpenFile(path, "wb")));
+  if (!file_->get())
+    return Fail("Couldn't create file: " + path.MaybeAsASCII());
+
+  return true;
+}
+
+bool ZipStreamExtractor::WriteEntryData(const char* data, size_t size) {
+  if (size == 0)
+    return true;
+
+  crc_ = crc32(crc_, reinterpret_cast<const Bytef*>(data), size);
+  if (file_ && fwrite(data, 1, size, file_->get()) != size)
+    return Fail("Couldn't write file: " + entry_name_);
+
+  return true;
+}
+
+bool ZipStreamExtractor::FinishEntry(uint32 expected_crc) {
+  file_.reset();
+  if (crc_ != expected_crc)
+    return Fail("CRC mismatch: " + entry_name_);
+
+  state_ = STATE_HEADER;
+  return true;
+}
+
+bool ZipStreamExtractor::Fail(const std::string& error) {
+  LOG(ERROR) << "Failed to extract the zip archive. " << error;
+  file_.reset();
+  state_ = STATE_ERROR;
+  return false;
+}
+
+bool ZipStreamExtractor::FailUnsupported(const std::string& error) {
+  LOG(WARNING) << "The zip archive can't be extracted as it's read. " << error;
+  unsupported_ = true;
+  file_.reset();
+  state_ = STATE_ERROR;
+  return false;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,95 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_INSTALLER_ZIP_STREAM_EXTRACTOR_H_
+#define XWALK_APPLICATION_BROWSER_INSTALLER_ZIP_STREAM_EXTRACTOR_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/memory/scoped_handle.h"
+#include "base/memory/scoped_ptr.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+// Extracts a zip archive into |target_dir| while it is being read, from the
+// local headers of its entries, so the archive doesn't need to be read again
+// once it has been, e.g. to verify its signature.
+//
+// Only the stored and deflated entries are supported, and stored entries
+// must have their size in their local header. Encrypted and ZIP64 archives
+// aren't supported either: Write() fails and is_unsupported() returns true,
+// and the archive should be extracted with ParallelZipExtractor instead.
+//
+// The files already written are left in |target_dir| after a failure.
+class ZipStreamExtractor {
+ public:
+  explicit ZipStreamExtractor(const base::FilePath& target_dir);
+  ~ZipStreamExtractor();
+
+  // Passes the next |size| bytes of the archive. Returns false if the
+  // archive is invalid or not supported, or if a file couldn't be written.
+  bool Write(const char* data, size_t size);
+
+  // Returns true if all the entries were extracted, i.e. the central
+  // directory of the archive was reached.
+  bool Finish();
+
+  bool is_unsupported() const { return unsupported_; }
+
+ private:
+  enum State {
+    STATE_HEADER,
+    STATE_DATA,
+    STATE_DESCRIPTOR,
+    STATE_DONE,
+    STATE_ERROR
+  };
+
+  // Each step returns true if it consumed its part of the archive and the
+  // next one can be read, false if it needs more data or failed.
+  bool ReadHeader();
+  bool ReadData();
+  bool ReadDescriptor();
+
+  bool StartEntry(const std::string& name);
+  bool WriteEntryData(const char* data, size_t size);
+  bool FinishEntry(uint32 expected_crc);
+
+  bool Fail(const std::string& error);
+  bool FailUnsupported(const std::string& error);
+
+  size_t available() const { return buffer_.size() - offset_; }
+  const char* current() const { return buffer_.data() + offset_; }
+
+  base::FilePath target_dir_;
+  State state_;
+  bool unsupported_;
+
+  // The data that was written but not consumed yet starts at |offset_|.
+  std::string buffer_;
+  size_t offset_;
+
+  // The entry being extracted. |file_| is NULL for the directories.
+  std::string entry_name_;
+  scoped_ptr<ScopedStdioHandle> file_;
+  uint16 method_;
+  bool has_descriptor_;
+  uint32 remaining_size_;
+  uint32 expected_crc_;
+  uint32 crc_;
+
+  z_stream inflate_stream_;
+  scoped_ptr<char[]> inflate_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ZipStreamExtractor);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_INSTALLER_ZIP_STREAM_EXTRACTOR_H_
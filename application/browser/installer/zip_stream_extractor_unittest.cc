@@ -0,0 +1,156 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/zip_stream_extractor.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+void AppendUInt16(std::string* data, uint16 value) {
+  data->push_back(value & 0xff);
+  data->push_back(value >> 8);
+}
+
+void AppendUInt32(std::string* data, uint32 value) {
+  AppendUInt16(data, value & 0xffff);
+  AppendUInt16(data, value >> 16);
+}
+
+// Returns a local header followed by the content of a stored entry.
+std::string CreateStoredEntry(const std::string& name,
+                              const std::string& content,
+                              uint16 flags) {
+  std::string entry;
+  AppendUInt32(&entry, 0x04034b50);
+  AppendUInt16(&entry, 10);  // Version needed to extract.
+  AppendUInt16(&entry, flags);
+  AppendUInt16(&entry, 0);  // Stored.
+  AppendUInt32(&entry, 0);  // Modification time and date.
+  AppendUInt32(&entry, crc32(crc32(0L, Z_NULL, 0),
+                             reinterpret_cast<const Bytef*>(content.data()),
+                             content.size()));
+  AppendUInt32(&entry, content.size());
+  AppendUInt32(&entry, content.size());
+  AppendUInt16(&entry, name.size());
+  AppendUInt16(&entry, 0);  // Extra field length.
+  entry += name;
+  entry += content;
+  return entry;
+}
+
+std::string CreateEndOfCentralDirectory() {
+  std::string data;
+  AppendUInt32(&data, 0x06054b50);
+  data.append(18, '\0');
+  return data;
+}
+
+}  // namespace
+
+class ZipStreamExtractorTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    target_dir_ = temp_dir_.path().AppendASCII("target");
+    ASSERT_TRUE(base::CreateDirectory(target_dir_));
+  }
+
+  // Writes |data| in chunks of |chunk_size| bytes.
+  bool WriteInChunks(ZipStreamExtractor* extractor, const std::string& data,
+                     size_t chunk_size) {
+    for (size_t i = 0; i < data.size(); i += chunk_size) {
+      size_t size = std::min(chunk_size, data.size() - i);
+      if (!extractor->Write(data.data() + i, size))
+        return false;
+    }
+    return true;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath target_dir_;
+};
+
+TEST_F(ZipStreamExtractorTest, ExtractInChunks) {
+  base::FilePath source_dir = temp_dir_.path().AppendASCII("source");
+  ASSERT_TRUE(base::CreateDirectory(source_dir.AppendASCII("dir")));
+
+  std::string text = "manifest";
+  std::string large(300 * 1024, '\0');
+  for (size_t i = 0; i < large.size(); ++i)
+    large[i] = static_cast<char>((i * 7) % 251);
+  ASSERT_TRUE(base::WriteFile(source_dir.AppendASCII("manifest.json"),
+                              text.data(), static_cast<int>(text.size())));
+  ASSERT_TRUE(base::WriteFile(source_dir.AppendASCII("dir").AppendASCII("a"),
+                              large.data(),
+                              static_cast<int>(large.size())));
+
+  base::FilePath zip_path = temp_dir_.path().AppendASCII("test.zip");
+  ASSERT_TRUE(zip::Zip(source_dir, zip_path, false));
+  std::string zip_data;
+  ASSERT_TRUE(base::ReadFileToString(zip_path, &zip_data));
+
+  ZipStreamExtractor extractor(target_dir_);
+  EXPECT_TRUE(WriteInChunks(&extractor, zip_data, 7));
+  EXPECT_TRUE(extractor.Finish());
+
+  std::string contents;
+  EXPECT_TRUE(base::ReadFileToString(target_dir_.AppendASCII("manifest.json"),
+                                     &contents));
+  EXPECT_EQ(text, contents);
+  EXPECT_TRUE(base::ReadFileToString(
+      target_dir_.AppendASCII("dir").AppendASCII("a"), &contents));
+  EXPECT_EQ(large, contents);
+}
+
+TEST_F(ZipStreamExtractorTest, Truncated) {
+  std::string zip_data = CreateStoredEntry("a", "content", 0);
+
+  ZipStreamExtractor extractor(target_dir_);
+  EXPECT_TRUE(WriteInChunks(&extractor, zip_data, zip_data.size() - 2));
+  EXPECT_FALSE(extractor.Finish());
+  EXPECT_FALSE(extractor.is_unsupported());
+}
+
+TEST_F(ZipStreamExtractorTest, BadCRC) {
+  std::string zip_data = CreateStoredEntry("a", "content", 0);
+  zip_data[zip_data.size() - 1] = 'x';
+  zip_data += CreateEndOfCentralDirectory();
+
+  ZipStreamExtractor extractor(target_dir_);
+  EXPECT_FALSE(extractor.Write(zip_data.data(), zip_data.size()));
+  EXPECT_FALSE(extractor.Finish());
+}
+
+TEST_F(ZipStreamExtractorTest, UnsafePath) {
+  std::string zip_data = CreateStoredEntry("../a", "content", 0) +
+      CreateEndOfCentralDirectory();
+
+  ZipStreamExtractor extractor(target_dir_);
+  EXPECT_FALSE(extractor.Write(zip_data.data(), zip_data.size()));
+  EXPECT_FALSE(extractor.is_unsupported());
+  EXPECT_FALSE(base::PathExists(temp_dir_.path().AppendASCII("a")));
+}
+
+TEST_F(ZipStreamExtractorTest, StoredEntryWithDataDescriptor) {
+  // The size of the stored entry is in a data descriptor.
+  std::string zip_data = CreateStoredEntry("a", "content", 1 << 3) +
+      CreateEndOfCentralDirectory();
+
+  ZipStreamExtractor extractor(target_dir_);
+  EXPECT_FALSE(extractor.Write(zip_data.data(), zip_data.size()));
+  EXPECT_TRUE(extractor.is_unsupported());
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -22,6 +22,14 @@ namespace {
 //     Will install application at "path", that should be an absolute path to
 //     the package file. If installation is successful, returns the ObjectPath
 //     of the InstalledApplication object that represents it.
+//
+// Signals:
+//
+//   InstallProgress(string path, string app_id, string stage)
+//     Emitted as an Install() or Uninstall() call goes through its stages:
+//     "preparing", "extracting", "moving", "registering", "rolling-back" and
+//     "removing". "path" is the package being installed, empty for
+//     uninstalls, and "app_id" is empty until the package has been read.
 const char kInstalledManagerDBusInterface[] =
     "org.crosswalkproject.Installed.Manager1";
 
@@ -34,6 +42,27 @@ dbus::ObjectPath GetInstalledPathForAppID(const std::string& app_id) {
   return dbus::ObjectPath(kInstalledManagerDBusPath.value() + "/" + app_id);
 }
 
+const char* GetInstallStageName(
+    xwalk::application::ApplicationService::InstallStage stage) {
+  typedef xwalk::application::ApplicationService Service;
+  switch (stage) {
+    case Service::INSTALL_STAGE_PREPARING:
+      return "preparing";
+    case Service::INSTALL_STAGE_EXTRACTING:
+      return "extracting";
+    case Service::INSTALL_STAGE_MOVING:
+      return "moving";
+    case Service::INSTALL_STAGE_REGISTERING:
+      return "registering";
+    case Service::INSTALL_STAGE_ROLLING_BACK:
+      return "rolling-back";
+    case Service::INSTALL_STAGE_REMOVING:
+      return "removing";
+  }
+  NOTREACHED();
+  return "";
+}
+
 }  // namespace
 
 namespace xwalk {
@@ -72,6 +101,17 @@ void InstalledApplicationsManager::OnApplicationUninstalled(
   adaptor_.RemoveManagedObject(GetInstalledPathForAppID(app_id));
 }
 
+void InstalledApplicationsManager::OnApplicationInstallProgress(
+    const base::FilePath& package_path, const std::string& app_id,
+    ApplicationService::InstallStage stage) {
+  dbus::Signal signal(kInstalledManagerDBusInterface, "InstallProgress");
+  dbus::MessageWriter writer(&signal);
+  writer.AppendString(package_path.value());
+  writer.AppendString(app_id);
+  writer.AppendString(GetInstallStageName(stage));
+  adaptor_.manager_object()->SendSignal(&signal);
+}
+
 void InstalledApplicationsManager::AddInitialObjects() {
   const ApplicationData::ApplicationDataMap& apps =
       app_storage_->GetInstalledApplications();
@@ -129,13 +169,41 @@ void InstalledApplicationsManager::OnInstall(
     return;
   }
 
-  std::string app_id;
-  if (!application_service_->Install(file_path, &app_id) &&
-      (app_id.empty() || !application_service_->Update(app_id, file_path))) {
+  application_service_->InstallAsync(
+      file_path,
+      base::Bind(&InstalledApplicationsManager::OnInstallDone,
+                 weak_factory_.GetWeakPtr(), file_path, method_call,
+                 response_sender));
+}
+
+void InstalledApplicationsManager::OnInstallDone(
+    const base::FilePath& file_path,
+    dbus::MethodCall* method_call,
+    dbus::ExportedObject::ResponseSender response_sender,
+    bool success, const std::string& app_id) {
+  // Installing an application already installed updates it.
+  if (!success && !app_id.empty()) {
+    application_service_->UpdateAsync(
+        app_id, file_path,
+        base::Bind(&InstalledApplicationsManager::OnUpdateDone,
+                   weak_factory_.GetWeakPtr(), file_path, method_call,
+                   response_sender));
+    return;
+  }
+
+  OnUpdateDone(file_path, method_call, response_sender, success, app_id);
+}
+
+void InstalledApplicationsManager::OnUpdateDone(
+    const base::FilePath& file_path,
+    dbus::MethodCall* method_call,
+    dbus::ExportedObject::ResponseSender response_sender,
+    bool success, const std::string& app_id) {
+  if (!success) {
     scoped_ptr<dbus::Response> response =
         CreateError(method_call,
                     "Error installing/updating application with path: "
-                    + file_path_str);
+                    + file_path.value());
     response_sender.Run(response.Pass());
     return;
   }
@@ -161,12 +229,27 @@ void InstalledApplicationsManager::OnUninstall(
     InstalledApplicationObject* installed_app_object,
     dbus::MethodCall* method_call,
     dbus::ExportedObject::ResponseSender response_sender) {
-  if (!application_service_->Uninstall(installed_app_object->app_id())) {
+  // The object is destroyed once the application is uninstalled, so only its
+  // id is kept.
+  const std::string app_id = installed_app_object->app_id();
+  application_service_->UninstallAsync(
+      app_id,
+      base::Bind(&InstalledApplicationsManager::OnUninstallDone,
+                 weak_factory_.GetWeakPtr(), app_id, method_call,
+                 response_sender));
+}
+
+void InstalledApplicationsManager::OnUninstallDone(
+    const std::string& requested_app_id,
+    dbus::MethodCall* method_call,
+    dbus::ExportedObject::ResponseSender response_sender,
+    bool success, const std::string& app_id) {
+  if (!success) {
     scoped_ptr<dbus::ErrorResponse> error_response =
         dbus::ErrorResponse::FromMethodCall(
             method_call, kInstalledApplicationDBusError,
             "Error trying to uninstall application with id "
-            + installed_app_object->app_id());
+            + requested_app_id);
     response_sender.Run(error_response.PassAs<dbus::Response>());
     return;
   }
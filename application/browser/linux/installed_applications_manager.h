@@ -34,6 +34,9 @@ class InstalledApplicationsManager : public ApplicationService::Observer {
   // ApplicationService::Observer implementation.
   void virtual OnApplicationInstalled(const std::string& app_id) OVERRIDE;
   void virtual OnApplicationUninstalled(const std::string& app_id) OVERRIDE;
+  void virtual OnApplicationInstallProgress(
+      const base::FilePath& package_path, const std::string& app_id,
+      ApplicationService::InstallStage stage) OVERRIDE;
 
   void AddInitialObjects();
   void AddObject(scoped_refptr<const ApplicationData> app);
@@ -41,10 +44,25 @@ class InstalledApplicationsManager : public ApplicationService::Observer {
   void OnInstall(
       dbus::MethodCall* method_call,
       dbus::ExportedObject::ResponseSender response_sender);
+  void OnInstallDone(
+      const base::FilePath& file_path,
+      dbus::MethodCall* method_call,
+      dbus::ExportedObject::ResponseSender response_sender,
+      bool success, const std::string& app_id);
+  void OnUpdateDone(
+      const base::FilePath& file_path,
+      dbus::MethodCall* method_call,
+      dbus::ExportedObject::ResponseSender response_sender,
+      bool success, const std::string& app_id);
   void OnUninstall(
       InstalledApplicationObject* installed_app_object,
       dbus::MethodCall* method_call,
       dbus::ExportedObject::ResponseSender response_sender);
+  void OnUninstallDone(
+      const std::string& requested_app_id,
+      dbus::MethodCall* method_call,
+      dbus::ExportedObject::ResponseSender response_sender,
+      bool success, const std::string& app_id);
 
   void OnExported(const std::string& interface_name,
                   const std::string& method_name,
@@ -12,6 +12,7 @@
 #include "base/i18n/rtl.h"
 #include "base/logging.h"
 #include "base/memory/singleton.h"
+#include "base/pickle.h"
 #include "base/stl_util.h"
 #include "base/strings/string16.h"
 #include "base/strings/string_util.h"
@@ -29,6 +30,7 @@
 #include "xwalk/application/common/manifest_handlers/main_document_handler.h"
 #include "xwalk/application/common/manifest_handlers/permissions_handler.h"
 #include "xwalk/application/common/permission_policy_manager.h"
+#include "xwalk/application/common/value_pickle_util.h"
 #include "content/public/common/url_constants.h"
 #include "url/url_util.h"
 #include "ui/base/l10n/l10n_util.h"
@@ -75,6 +77,47 @@ scoped_refptr<ApplicationData> ApplicationData::Create(
   return application;
 }
 
+// static
+scoped_refptr<ApplicationData> ApplicationData::CreateFromPickle(
+    const base::FilePath& path,
+    Manifest::SourceType source_type,
+    const std::string& explicit_id,
+    PickleIterator* iterator) {
+  scoped_ptr<base::Value> value = ReadValueFromPickle(iterator);
+  if (!value || !value->IsType(base::Value::TYPE_DICTIONARY))
+    return NULL;
+
+  scoped_ptr<xwalk::application::Manifest> manifest(
+      new xwalk::application::Manifest(source_type,
+          make_scoped_ptr(static_cast<base::DictionaryValue*>(
+              value.release()))));
+  base::string16 error;
+  if (!InitApplicationID(manifest.get(), path, explicit_id, &error))
+    return NULL;
+
+  scoped_refptr<ApplicationData> application =
+      new ApplicationData(path, manifest.Pass());
+  if (!application->InitFromPickle(iterator))
+    return NULL;
+
+  return application;
+}
+
+bool ApplicationData::WriteToPickle(Pickle* pickle) const {
+  DCHECK(finished_parsing_manifest_);
+  // The name is adjusted to the locale when the application is restored.
+  if (!WriteValueToPickle(*manifest_->value(), pickle) ||
+      !pickle->WriteString(non_localized_name_) ||
+      !pickle->WriteString(VersionString()) ||
+      !pickle->WriteString(description_) ||
+      !pickle->WriteInt(manifest_version_))
+    return false;
+
+  ManifestHandlerRegistry* registry =
+      ManifestHandlerRegistry::GetInstance(GetPackageType());
+  return registry->SaveAppManifestData(this, pickle);
+}
+
 // static
 bool ApplicationData::IsIDValid(const std::string& id) {
   std::string temp = StringToLowerASCII(id);
@@ -256,6 +299,29 @@ bool ApplicationData::Init(base::string16* error) {
   return true;
 }
 
+bool ApplicationData::InitFromPickle(PickleIterator* iterator) {
+  std::string version_str;
+  if (!iterator->ReadString(&non_localized_name_) ||
+      !iterator->ReadString(&version_str) ||
+      !iterator->ReadString(&description_) ||
+      !iterator->ReadInt(&manifest_version_))
+    return false;
+
+  base::string16 localized_name = base::UTF8ToUTF16(non_localized_name_);
+  base::i18n::AdjustStringForLocaleDirection(&localized_name);
+  name_ = base::UTF16ToUTF8(localized_name);
+  version_.reset(new base::Version(version_str));
+  application_url_ = ApplicationData::GetBaseURLFromApplicationId(ID());
+
+  ManifestHandlerRegistry* registry =
+      ManifestHandlerRegistry::GetInstance(GetPackageType());
+  if (!registry->LoadAppManifestData(iterator, this))
+    return false;
+
+  finished_parsing_manifest_ = true;
+  return true;
+}
+
 bool ApplicationData::LoadName(base::string16* error) {
   DCHECK(error);
   base::string16 localized_name;
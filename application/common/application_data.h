@@ -26,6 +26,9 @@
 #include "xwalk/application/common/manifest.h"
 #include "xwalk/application/common/permission_types.h"
 
+class Pickle;
+class PickleIterator;
+
 namespace base {
 class DictionaryValue;
 class ListValue;
@@ -65,6 +68,20 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
       const std::string& explicit_id,
       std::string* error_message);
 
+  // Creates the application written by WriteToPickle() without parsing its
+  // manifest again. Returns NULL if |iterator| doesn't point to a valid
+  // application.
+  static scoped_refptr<ApplicationData> CreateFromPickle(
+      const base::FilePath& path,
+      Manifest::SourceType source_type,
+      const std::string& explicit_id,
+      PickleIterator* iterator);
+
+  // Writes the manifest of the application and the data parsed from it to
+  // |pickle|. Returns false if one of the manifest handlers can't save its
+  // data, |pickle| may be changed anyway.
+  bool WriteToPickle(Pickle* pickle) const;
+
   // Checks to see if the application has a valid ID.
   static bool IsIDValid(const std::string& id);
 
@@ -156,6 +173,9 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
   // Initialize the application from a parsed manifest.
   bool Init(base::string16* error);
 
+  // Initialize the application from the data written by WriteToPickle().
+  bool InitFromPickle(PickleIterator* iterator);
+
   // The following are helpers for InitFromValue to load various features of the
   // application from the manifest.
   bool LoadName(base::string16* error);
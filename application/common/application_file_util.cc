@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/command_line.h"
+#include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/file_util.h"
@@ -297,5 +298,75 @@ base::FilePath ApplicationURLToRelativeFilePath(const GURL& url) {
   return path;
 }
 
+const base::FilePath::CharType kApplicationBackupDirSuffix[] =
+    FILE_PATH_LITERAL(".tmp");
+
+const base::FilePath::CharType kPackageExtractDirPrefix[] =
+    FILE_PATH_LITERAL("xwalk_package_");
+
+void RecoverApplicationsDirectory(
+    const base::FilePath& applications_dir,
+    const std::map<std::string, std::string>& installed_versions) {
+  const base::FilePath::StringType suffix(kApplicationBackupDirSuffix);
+  std::vector<base::FilePath> backup_dirs;
+  base::FileEnumerator backups(applications_dir, false,
+                               base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = backups.Next(); !path.empty();
+       path = backups.Next()) {
+    const base::FilePath::StringType& name = path.value();
+    if (name.size() > suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+      backup_dirs.push_back(path);
+  }
+
+  for (size_t i = 0; i < backup_dirs.size(); ++i) {
+    const base::FilePath& backup_dir = backup_dirs[i];
+    base::FilePath app_dir(backup_dir.value().substr(
+        0, backup_dir.value().size() - suffix.size()));
+    std::string app_id = app_dir.BaseName().MaybeAsASCII();
+
+    // The update is registered if the version of the installed application
+    // is the one of its new files, updates always raise it. The backups of
+    // the applications that aren't installed anymore are just deleted.
+    std::map<std::string, std::string>::const_iterator it =
+        installed_versions.find(app_id);
+    bool is_registered = it == installed_versions.end();
+    if (!is_registered && base::DirectoryExists(app_dir)) {
+      std::string error;
+      scoped_refptr<ApplicationData> application = LoadApplication(
+          app_dir, app_id, Manifest::COMMAND_LINE, &error);
+      is_registered =
+          application && application->VersionString() == it->second;
+    }
+
+    if (is_registered) {
+      base::DeleteFile(backup_dir, true);
+      continue;
+    }
+
+    LOG(WARNING) << "Rolling back the interrupted update of " << app_id;
+    if (!base::DeleteFile(app_dir, true) || !base::Move(backup_dir, app_dir))
+      LOG(ERROR) << "Can't restore the files of " << app_id;
+  }
+
+  // Only the directories left by the jobs are removed: the packages being
+  // extracted, and the applications whose install wasn't registered.
+  const base::FilePath::StringType prefix(kPackageExtractDirPrefix);
+  base::FileEnumerator dirs(applications_dir, false,
+                            base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = dirs.Next(); !path.empty(); path = dirs.Next()) {
+    const base::FilePath::StringType& name = path.BaseName().value();
+    std::string app_id = path.BaseName().MaybeAsASCII();
+    bool is_extract_dir = name.compare(0, prefix.size(), prefix) == 0;
+    bool is_unregistered_app = ApplicationData::IsIDValid(app_id) &&
+        !installed_versions.count(app_id);
+    if (!is_extract_dir && !is_unregistered_app)
+      continue;
+    LOG(WARNING) << "Removing the files of an interrupted install: "
+                 << path.MaybeAsASCII();
+    base::DeleteFile(path, true);
+  }
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -8,6 +8,7 @@
 #include <string>
 #include <map>
 
+#include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
 #include "xwalk/application/common/manifest.h"
 
@@ -16,7 +17,6 @@ class GURL;
 
 namespace base {
 class DictionaryValue;
-class FilePath;
 }
 
 // Utilities for manipulating the on-disk storage of applications.
@@ -47,6 +47,26 @@ base::DictionaryValue* LoadManifest(const base::FilePath& application_root,
 // Get a relative file path from an app:// URL.
 base::FilePath ApplicationURLToRelativeFilePath(const GURL& url);
 
+// Appended to the directory of an application to name the one keeping its
+// files while it's being updated.
+extern const base::FilePath::CharType kApplicationBackupDirSuffix[];
+
+// Starts the name of the directories the packages are extracted to before
+// being installed.
+extern const base::FilePath::CharType kPackageExtractDirPrefix[];
+
+// Brings |applications_dir| back in line with the installed applications
+// after install or update jobs were cut short by a shutdown, before their
+// files could be rolled back. |installed_versions| maps the id of each
+// installed application to its version. An update that wasn't registered is
+// rolled back from its backup, the backups of the other updates are deleted,
+// and so are the extracted packages and the directories named after an
+// application that isn't installed. Other directories are left alone.
+// Must not run while a job is using the directory.
+void RecoverApplicationsDirectory(
+    const base::FilePath& applications_dir,
+    const std::map<std::string, std::string>& installed_versions);
+
 }  // namespace application
 }  // namespace xwalk
 
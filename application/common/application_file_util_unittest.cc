@@ -4,6 +4,9 @@
 
 #include "xwalk/application/common/application_file_util.h"
 
+#include <map>
+#include <string>
+
 #include "base/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/json/json_string_value_serializer.h"
@@ -26,6 +29,28 @@ namespace xwalk {
 namespace application {
 
 class ApplicationFileUtilTest : public testing::Test {
+ protected:
+  // Writes the files of version |version| of an application in |app_dir|.
+  static bool WriteApplication(const base::FilePath& app_dir,
+                               const std::string& version) {
+    std::string manifest = base::StringPrintf(
+        "{ \"name\": \"app\", \"version\": \"%s\" }", version.c_str());
+    return base::CreateDirectory(app_dir) &&
+        base::WriteFile(app_dir.AppendASCII("manifest.json"),
+                        manifest.data(), manifest.size()) ==
+            static_cast<int>(manifest.size());
+  }
+
+  static std::string GetVersion(const base::FilePath& app_dir) {
+    std::string error;
+    scoped_refptr<ApplicationData> application = LoadApplication(
+        app_dir, Manifest::COMMAND_LINE, &error);
+    return application ? application->VersionString() : std::string();
+  }
+
+  static base::FilePath GetBackupDir(const base::FilePath& app_dir) {
+    return base::FilePath(app_dir.value() + kApplicationBackupDirSuffix);
+  }
 };
 
 TEST_F(ApplicationFileUtilTest, LoadApplicationWithValidPath) {
@@ -139,5 +164,81 @@ TEST_F(ApplicationFileUtilTest, ValidateThemeUTF8) {
   ASSERT_TRUE(application.get()) << error;
 }
 
+TEST_F(ApplicationFileUtilTest, RecoverUnregisteredUpdate) {
+  base::ScopedTempDir temp;
+  ASSERT_TRUE(temp.CreateUniqueTempDir());
+  base::FilePath app_dir = temp.path().AppendASCII("aaa");
+  ASSERT_TRUE(WriteApplication(GetBackupDir(app_dir), "1.0"));
+  ASSERT_TRUE(WriteApplication(app_dir, "2.0"));
+
+  // The new files were moved but the update wasn't registered.
+  std::map<std::string, std::string> installed_versions;
+  installed_versions["aaa"] = "1.0";
+  RecoverApplicationsDirectory(temp.path(), installed_versions);
+
+  EXPECT_EQ("1.0", GetVersion(app_dir));
+  EXPECT_FALSE(base::DirectoryExists(GetBackupDir(app_dir)));
+}
+
+TEST_F(ApplicationFileUtilTest, RecoverRegisteredUpdate) {
+  base::ScopedTempDir temp;
+  ASSERT_TRUE(temp.CreateUniqueTempDir());
+  base::FilePath app_dir = temp.path().AppendASCII("aaa");
+  ASSERT_TRUE(WriteApplication(GetBackupDir(app_dir), "1.0"));
+  ASSERT_TRUE(WriteApplication(app_dir, "2.0"));
+
+  // Only the deletion of the old files was missed.
+  std::map<std::string, std::string> installed_versions;
+  installed_versions["aaa"] = "2.0";
+  RecoverApplicationsDirectory(temp.path(), installed_versions);
+
+  EXPECT_EQ("2.0", GetVersion(app_dir));
+  EXPECT_FALSE(base::DirectoryExists(GetBackupDir(app_dir)));
+}
+
+TEST_F(ApplicationFileUtilTest, RecoverUpdateBeforeMove) {
+  base::ScopedTempDir temp;
+  ASSERT_TRUE(temp.CreateUniqueTempDir());
+  base::FilePath app_dir = temp.path().AppendASCII("aaa");
+  ASSERT_TRUE(WriteApplication(GetBackupDir(app_dir), "1.0"));
+
+  // The old files were backed up but the new ones weren't moved yet.
+  std::map<std::string, std::string> installed_versions;
+  installed_versions["aaa"] = "1.0";
+  RecoverApplicationsDirectory(temp.path(), installed_versions);
+
+  EXPECT_EQ("1.0", GetVersion(app_dir));
+  EXPECT_FALSE(base::DirectoryExists(GetBackupDir(app_dir)));
+}
+
+TEST_F(ApplicationFileUtilTest, RemoveUnregisteredApplications) {
+  const std::string kInstalledId("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+  const std::string kOrphanId("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
+  base::ScopedTempDir temp;
+  ASSERT_TRUE(temp.CreateUniqueTempDir());
+  base::FilePath installed_dir = temp.path().AppendASCII(kInstalledId);
+  base::FilePath orphan_dir = temp.path().AppendASCII(kOrphanId);
+  base::FilePath extract_dir = temp.path().Append(
+      base::FilePath::StringType(kPackageExtractDirPrefix) +
+      FILE_PATH_LITERAL("123"));
+  base::FilePath other_dir = temp.path().AppendASCII("other");
+  ASSERT_TRUE(WriteApplication(installed_dir, "1.0"));
+  ASSERT_TRUE(WriteApplication(orphan_dir, "1.0"));
+  ASSERT_TRUE(WriteApplication(GetBackupDir(orphan_dir), "0.9"));
+  ASSERT_TRUE(WriteApplication(extract_dir, "1.0"));
+  ASSERT_TRUE(base::CreateDirectory(other_dir));
+
+  std::map<std::string, std::string> installed_versions;
+  installed_versions[kInstalledId] = "1.0";
+  RecoverApplicationsDirectory(temp.path(), installed_versions);
+
+  EXPECT_EQ("1.0", GetVersion(installed_dir));
+  EXPECT_FALSE(base::DirectoryExists(orphan_dir));
+  EXPECT_FALSE(base::DirectoryExists(GetBackupDir(orphan_dir)));
+  EXPECT_FALSE(base::DirectoryExists(extract_dir));
+  // The directories that weren't made by a job are kept.
+  EXPECT_TRUE(base::DirectoryExists(other_dir));
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -42,6 +42,16 @@ std::vector<std::string> ManifestHandler::PrerequisiteKeys() const {
   return std::vector<std::string>();
 }
 
+bool ManifestHandler::SaveManifestData(const ApplicationData* application,
+                                       Pickle* pickle) const {
+  return false;
+}
+
+bool ManifestHandler::LoadManifestData(PickleIterator* iterator,
+                                       ApplicationData* application) const {
+  return false;
+}
+
 ManifestHandlerRegistry* ManifestHandlerRegistry::xpk_registry_ = NULL;
 ManifestHandlerRegistry* ManifestHandlerRegistry::widget_registry_ = NULL;
 
@@ -108,6 +118,40 @@ void ManifestHandlerRegistry::Register(ManifestHandler* handler) {
 
 bool ManifestHandlerRegistry::ParseAppManifest(
     scoped_refptr<ApplicationData> application, base::string16* error) {
+  const std::vector<ManifestHandler*>& handlers =
+      GetHandlersForApplication(application.get());
+  for (size_t i = 0; i < handlers.size(); ++i) {
+    if (!handlers[i]->Parse(application, error))
+      return false;
+  }
+  return true;
+}
+
+bool ManifestHandlerRegistry::SaveAppManifestData(
+    const ApplicationData* application, Pickle* pickle) {
+  const std::vector<ManifestHandler*>& handlers =
+      GetHandlersForApplication(application);
+  for (size_t i = 0; i < handlers.size(); ++i) {
+    if (!handlers[i]->SaveManifestData(application, pickle))
+      return false;
+  }
+  return true;
+}
+
+bool ManifestHandlerRegistry::LoadAppManifestData(
+    PickleIterator* iterator, ApplicationData* application) {
+  const std::vector<ManifestHandler*>& handlers =
+      GetHandlersForApplication(application);
+  for (size_t i = 0; i < handlers.size(); ++i) {
+    if (!handlers[i]->LoadManifestData(iterator, application))
+      return false;
+  }
+  return true;
+}
+
+std::vector<ManifestHandler*>
+ManifestHandlerRegistry::GetHandlersForApplication(
+    const ApplicationData* application) {
   std::map<int, ManifestHandler*> handlers_by_order;
   for (ManifestHandlerMap::iterator iter = handlers_.begin();
        iter != handlers_.end(); ++iter) {
@@ -117,13 +161,13 @@ bool ManifestHandlerRegistry::ParseAppManifest(
       handlers_by_order[order_map_[handler]] = handler;
     }
   }
+
+  std::vector<ManifestHandler*> handlers;
   for (std::map<int, ManifestHandler*>::iterator iter =
            handlers_by_order.begin();
-       iter != handlers_by_order.end(); ++iter) {
-    if (!(iter->second)->Parse(application, error))
-      return false;
-  }
-  return true;
+       iter != handlers_by_order.end(); ++iter)
+    handlers.push_back(iter->second);
+  return handlers;
 }
 
 bool ManifestHandlerRegistry::ValidateAppManifest(
@@ -14,6 +14,9 @@
 #include "xwalk/application/common/application_data.h"
 #include "xwalk/application/common/manifest.h"
 
+class Pickle;
+class PickleIterator;
+
 namespace xwalk {
 namespace application {
 
@@ -49,6 +52,17 @@ class ManifestHandler {
 
   // The keys to register handler for (in Register).
   virtual std::vector<std::string> Keys() const = 0;
+
+  // Writes the data stored by Parse() on |application| to |pickle|, so it
+  // can be restored by LoadManifestData() instead of parsing the manifest
+  // again. Returns false if the data can't be saved, which is the default.
+  virtual bool SaveManifestData(const ApplicationData* application,
+                                Pickle* pickle) const;
+
+  // Stores the data written by SaveManifestData() on |application|. Returns
+  // false if |iterator| doesn't point to valid data.
+  virtual bool LoadManifestData(PickleIterator* iterator,
+                                ApplicationData* application) const;
 };
 
 class ManifestHandlerRegistry {
@@ -64,6 +78,13 @@ class ManifestHandlerRegistry {
                            std::string* error,
                            std::vector<InstallWarning>* warnings);
 
+  // Saves and restores the data of the handlers that ParseAppManifest()
+  // runs for |application|, see ManifestHandler::SaveManifestData().
+  bool SaveAppManifestData(const ApplicationData* application,
+                           Pickle* pickle);
+  bool LoadAppManifestData(PickleIterator* iterator,
+                           ApplicationData* application);
+
  private:
   friend class ScopedTestingManifestHandlerRegistry;
   explicit ManifestHandlerRegistry(
@@ -75,6 +96,10 @@ class ManifestHandlerRegistry {
 
   void ReorderHandlersGivenDependencies();
 
+  // Returns the handlers parsing the manifest of |application|, in order.
+  std::vector<ManifestHandler*> GetHandlersForApplication(
+      const ApplicationData* application);
+
   // Sets a new global registry, for testing purposes.
   static void SetInstanceForTesting(ManifestHandlerRegistry* registry,
                                     Manifest::PackageType package_type);
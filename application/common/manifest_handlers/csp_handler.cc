@@ -4,9 +4,11 @@
 
 #include "xwalk/application/common/manifest_handlers/csp_handler.h"
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/strings/string_split.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/value_pickle_util.h"
 
 namespace xwalk {
 namespace application {
@@ -69,5 +71,44 @@ std::vector<std::string> CSPHandler::Keys() const {
   return std::vector<std::string>(1, GetCSPKey(package_type_));
 }
 
+bool CSPHandler::SaveManifestData(const ApplicationData* application,
+                                  Pickle* pickle) const {
+  const CSPInfo* csp_info = static_cast<CSPInfo*>(
+      application->GetManifestData(GetCSPKey(package_type_)));
+  if (!csp_info)
+    return false;
+
+  const std::map<std::string, std::vector<std::string> >& directives =
+      csp_info->GetDirectives();
+  if (!pickle->WriteInt(static_cast<int>(directives.size())))
+    return false;
+  for (std::map<std::string, std::vector<std::string> >::const_iterator it =
+           directives.begin(); it != directives.end(); ++it) {
+    if (!pickle->WriteString(it->first) ||
+        !WriteStringsToPickle(it->second, pickle))
+      return false;
+  }
+  return true;
+}
+
+bool CSPHandler::LoadManifestData(PickleIterator* iterator,
+                                  ApplicationData* application) const {
+  int size;
+  if (!iterator->ReadLength(&size))
+    return false;
+
+  scoped_ptr<CSPInfo> csp_info(new CSPInfo);
+  for (int i = 0; i < size; ++i) {
+    std::string directive_name;
+    std::vector<std::string> directive_value;
+    if (!iterator->ReadString(&directive_name) ||
+        !ReadStringsFromPickle(iterator, &directive_value))
+      return false;
+    csp_info->SetDirective(directive_name, directive_value);
+  }
+  application->SetManifestData(GetCSPKey(package_type_), csp_info.release());
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -39,6 +39,10 @@ class CSPHandler : public ManifestHandler {
                      base::string16* error) OVERRIDE;
   virtual bool AlwaysParseForType(Manifest::Type type) const OVERRIDE;
   virtual std::vector<std::string> Keys() const OVERRIDE;
+  virtual bool SaveManifestData(const ApplicationData* application,
+                                Pickle* pickle) const OVERRIDE;
+  virtual bool LoadManifestData(PickleIterator* iterator,
+                                ApplicationData* application) const OVERRIDE;
 
  private:
   Manifest::PackageType package_type_;
@@ -4,9 +4,11 @@
 
 #include "xwalk/application/common/manifest_handlers/main_document_handler.h"
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/constants.h"
+#include "xwalk/application/common/value_pickle_util.h"
 
 namespace xwalk {
 
@@ -52,6 +54,34 @@ std::vector<std::string> MainDocumentHandler::Keys() const {
   return std::vector<std::string>(1, keys::kAppMainKey);
 }
 
+bool MainDocumentHandler::SaveManifestData(
+    const ApplicationData* application, Pickle* pickle) const {
+  const MainDocumentInfo* main_doc_info = ToMainDocumentInfo(
+      application->GetManifestData(keys::kAppMainKey));
+  if (!main_doc_info)
+    return false;
+
+  return pickle->WriteString(main_doc_info->GetMainURL().spec()) &&
+      WriteStringsToPickle(main_doc_info->GetMainScripts(), pickle);
+}
+
+bool MainDocumentHandler::LoadManifestData(
+    PickleIterator* iterator, ApplicationData* application) const {
+  std::string main_url;
+  std::vector<std::string> main_scripts;
+  if (!iterator->ReadString(&main_url) ||
+      !ReadStringsFromPickle(iterator, &main_scripts))
+    return false;
+
+  scoped_ptr<MainDocumentInfo> main_doc_info(new MainDocumentInfo);
+  main_doc_info->SetMainURL(GURL(main_url));
+  if (!main_doc_info->GetMainURL().is_valid())
+    return false;
+  main_doc_info->SetMainScripts(main_scripts);
+  application->SetManifestData(keys::kAppMainKey, main_doc_info.release());
+  return true;
+}
+
 bool MainDocumentHandler::ParseMainSource(MainDocumentInfo* info,
                                           const ApplicationData* application,
                                           base::string16* error) {
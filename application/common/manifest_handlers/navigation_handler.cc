@@ -4,8 +4,11 @@
 
 #include "xwalk/application/common/manifest_handlers/navigation_handler.h"
 
+#include "base/pickle.h"
+#include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/value_pickle_util.h"
 
 namespace xwalk {
 
@@ -52,5 +55,32 @@ std::vector<std::string> NavigationHandler::Keys() const {
   return std::vector<std::string>(1, keys::kAllowNavigationKey);
 }
 
+bool NavigationHandler::SaveManifestData(
+    const ApplicationData* application, Pickle* pickle) const {
+  // Nothing is stored for an empty list of domains.
+  const NavigationInfo* info = static_cast<NavigationInfo*>(
+      application->GetManifestData(keys::kAllowNavigationKey));
+  if (!pickle->WriteBool(info != NULL))
+    return false;
+  return !info || WriteStringsToPickle(info->GetAllowedDomains(), pickle);
+}
+
+bool NavigationHandler::LoadManifestData(
+    PickleIterator* iterator, ApplicationData* application) const {
+  bool has_info;
+  if (!iterator->ReadBool(&has_info))
+    return false;
+  if (!has_info)
+    return true;
+
+  std::vector<std::string> allowed_domains;
+  if (!ReadStringsFromPickle(iterator, &allowed_domains))
+    return false;
+  application->SetManifestData(
+      keys::kAllowNavigationKey,
+      new NavigationInfo(JoinString(allowed_domains, navigation_separator)));
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
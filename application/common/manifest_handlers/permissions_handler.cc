@@ -4,8 +4,10 @@
 
 #include "xwalk/application/common/manifest_handlers/permissions_handler.h"
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/value_pickle_util.h"
 
 namespace xwalk {
 
@@ -70,5 +72,34 @@ std::vector<std::string> PermissionsHandler::Keys() const {
   return std::vector<std::string>(1, keys::kPermissionsKey);
 }
 
+bool PermissionsHandler::SaveManifestData(
+    const ApplicationData* application, Pickle* pickle) const {
+  const PermissionsInfo* permissions_info = static_cast<PermissionsInfo*>(
+      application->GetManifestData(keys::kPermissionsKey));
+  if (!permissions_info)
+    return false;
+
+  const PermissionSet& api_permissions =
+      permissions_info->GetAPIPermissions();
+  return WriteStringsToPickle(
+      std::vector<std::string>(api_permissions.begin(),
+                               api_permissions.end()),
+      pickle);
+}
+
+bool PermissionsHandler::LoadManifestData(
+    PickleIterator* iterator, ApplicationData* application) const {
+  std::vector<std::string> api_permissions;
+  if (!ReadStringsFromPickle(iterator, &api_permissions))
+    return false;
+
+  scoped_ptr<PermissionsInfo> permissions_info(new PermissionsInfo);
+  permissions_info->SetAPIPermissions(
+      PermissionSet(api_permissions.begin(), api_permissions.end()));
+  application->SetManifestData(keys::kPermissionsKey,
+                               permissions_info.release());
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -7,6 +7,7 @@
 #include <map>
 #include <utility>
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/strings/string_split.h"
 #include "third_party/re2/re2/re2.h"
@@ -115,5 +116,36 @@ std::vector<std::string> TizenApplicationHandler::Keys() const {
   return std::vector<std::string>(1, keys::kTizenApplicationKey);
 }
 
+bool TizenApplicationHandler::SaveManifestData(
+    const ApplicationData* application, Pickle* pickle) const {
+  const TizenApplicationInfo* app_info =
+      static_cast<const TizenApplicationInfo*>(
+          application->GetManifestData(keys::kTizenApplicationKey));
+  if (!app_info)
+    return false;
+
+  return pickle->WriteString(app_info->id()) &&
+      pickle->WriteString(app_info->package()) &&
+      pickle->WriteString(app_info->required_version());
+}
+
+bool TizenApplicationHandler::LoadManifestData(
+    PickleIterator* iterator, ApplicationData* application) const {
+  std::string id;
+  std::string package;
+  std::string required_version;
+  if (!iterator->ReadString(&id) || !iterator->ReadString(&package) ||
+      !iterator->ReadString(&required_version))
+    return false;
+
+  scoped_ptr<TizenApplicationInfo> app_info(new TizenApplicationInfo);
+  app_info->set_id(id);
+  app_info->set_package(package);
+  app_info->set_required_version(required_version);
+  application->SetManifestData(keys::kTizenApplicationKey,
+                               app_info.release());
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
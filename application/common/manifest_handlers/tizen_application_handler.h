@@ -57,6 +57,10 @@ class TizenApplicationHandler : public ManifestHandler {
                         std::string* error,
                         std::vector<InstallWarning>* warnings) const OVERRIDE;
   virtual std::vector<std::string> Keys() const OVERRIDE;
+  virtual bool SaveManifestData(const ApplicationData* application,
+                                Pickle* pickle) const OVERRIDE;
+  virtual bool LoadManifestData(PickleIterator* iterator,
+                                ApplicationData* application) const OVERRIDE;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(TizenApplicationHandler);
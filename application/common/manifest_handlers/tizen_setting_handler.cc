@@ -7,6 +7,7 @@
 #include <map>
 #include <utility>
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 
@@ -60,5 +61,25 @@ std::vector<std::string> TizenSettingHandler::Keys() const {
   return std::vector<std::string>(1, keys::kTizenSettingKey);
 }
 
+bool TizenSettingHandler::SaveManifestData(
+    const ApplicationData* application, Pickle* pickle) const {
+  const TizenSettingInfo* app_info = static_cast<const TizenSettingInfo*>(
+      application->GetManifestData(keys::kTizenSettingKey));
+  return app_info && pickle->WriteBool(app_info->hwkey_enabled());
+}
+
+bool TizenSettingHandler::LoadManifestData(
+    PickleIterator* iterator, ApplicationData* application) const {
+  bool hwkey_enabled;
+  if (!iterator->ReadBool(&hwkey_enabled))
+    return false;
+
+  scoped_ptr<TizenSettingInfo> app_info(new TizenSettingInfo);
+  app_info->set_hwkey_enabled(hwkey_enabled);
+  application->SetManifestData(keys::kTizenSettingKey,
+                               app_info.release());
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
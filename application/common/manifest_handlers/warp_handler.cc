@@ -4,8 +4,11 @@
 
 #include "xwalk/application/common/manifest_handlers/warp_handler.h"
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/value_pickle_util.h"
 
 namespace xwalk {
 
@@ -64,5 +67,24 @@ std::vector<std::string> WARPHandler::Keys() const {
   return std::vector<std::string>(1, keys::kAccessKey);
 }
 
+bool WARPHandler::SaveManifestData(const ApplicationData* application,
+                                   Pickle* pickle) const {
+  const WARPInfo* warp_info = static_cast<WARPInfo*>(
+      application->GetManifestData(keys::kAccessKey));
+  return warp_info && WriteValueToPickle(*warp_info->GetWARP(), pickle);
+}
+
+bool WARPHandler::LoadManifestData(PickleIterator* iterator,
+                                   ApplicationData* application) const {
+  scoped_ptr<base::Value> value = ReadValueFromPickle(iterator);
+  if (!value || !value->IsType(base::Value::TYPE_LIST))
+    return false;
+
+  scoped_ptr<WARPInfo> warp_info(new WARPInfo);
+  warp_info->SetWARP(static_cast<base::ListValue*>(value.release()));
+  application->SetManifestData(keys::kAccessKey, warp_info.release());
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -36,6 +36,10 @@ class WARPHandler : public ManifestHandler {
   virtual bool Parse(scoped_refptr<ApplicationData> application,
                      base::string16* error) OVERRIDE;
   virtual std::vector<std::string> Keys() const OVERRIDE;
+  virtual bool SaveManifestData(const ApplicationData* application,
+                                Pickle* pickle) const OVERRIDE;
+  virtual bool LoadManifestData(PickleIterator* iterator,
+                                ApplicationData* application) const OVERRIDE;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(WARPHandler);
@@ -8,10 +8,12 @@
 #include <utility>
 #include <vector>
 
+#include "base/pickle.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_split.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/value_pickle_util.h"
 
 namespace xwalk {
 
@@ -148,5 +150,26 @@ std::vector<std::string> WidgetHandler::Keys() const {
   return std::vector<std::string>(1, keys::kWidgetKey);
 }
 
+bool WidgetHandler::SaveManifestData(const ApplicationData* application,
+                                     Pickle* pickle) const {
+  WidgetInfo* widget_info = static_cast<WidgetInfo*>(
+      application->GetManifestData(keys::kWidgetKey));
+  return widget_info &&
+      WriteValueToPickle(*widget_info->GetWidgetInfo(), pickle);
+}
+
+bool WidgetHandler::LoadManifestData(PickleIterator* iterator,
+                                     ApplicationData* application) const {
+  scoped_ptr<base::Value> value = ReadValueFromPickle(iterator);
+  base::DictionaryValue* dictionary;
+  if (!value || !value->GetAsDictionary(&dictionary))
+    return false;
+
+  scoped_ptr<WidgetInfo> widget_info(new WidgetInfo);
+  widget_info->GetWidgetInfo()->Swap(dictionary);
+  application->SetManifestData(keys::kWidgetKey, widget_info.release());
+  return true;
+}
+
 }  // namespace application
 }  // namespace xwalk
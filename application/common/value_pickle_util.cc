@@ -0,0 +1,182 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/value_pickle_util.h"
+
+#include "base/pickle.h"
+#include "base/values.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Manifests aren't nested this deep, don't follow corrupted data further.
+const int kMaxValueDepth = 100;
+
+bool WriteValue(const base::Value& value, int depth, Pickle* pickle) {
+  if (depth > kMaxValueDepth)
+    return false;
+
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      return true;
+    case base::Value::TYPE_BOOLEAN: {
+      bool bool_value = false;
+      value.GetAsBoolean(&bool_value);
+      return pickle->WriteBool(bool_value);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int int_value = 0;
+      value.GetAsInteger(&int_value);
+      return pickle->WriteInt(int_value);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double double_value = 0;
+      value.GetAsDouble(&double_value);
+      return pickle->WriteBytes(&double_value, sizeof(double_value));
+    }
+    case base::Value::TYPE_STRING: {
+      std::string string_value;
+      value.GetAsString(&string_value);
+      return pickle->WriteString(string_value);
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dictionary =
+          static_cast<const base::DictionaryValue*>(&value);
+      pickle->WriteInt(static_cast<int>(dictionary->size()));
+      for (base::DictionaryValue::Iterator it(*dictionary); !it.IsAtEnd();
+           it.Advance()) {
+        if (!pickle->WriteString(it.key()) ||
+            !WriteValue(it.value(), depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list = static_cast<const base::ListValue*>(&value);
+      pickle->WriteInt(static_cast<int>(list->GetSize()));
+      for (base::ListValue::const_iterator it = list->begin();
+           it != list->end(); ++it) {
+        if (!WriteValue(**it, depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    default:
+      // The manifests are parsed from JSON or XML, they have no binary
+      // values.
+      return false;
+  }
+}
+
+base::Value* ReadValue(PickleIterator* iterator, int depth) {
+  int type;
+  if (depth > kMaxValueDepth || !iterator->ReadInt(&type))
+    return NULL;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool bool_value;
+      if (!iterator->ReadBool(&bool_value))
+        return NULL;
+      return new base::FundamentalValue(bool_value);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int int_value;
+      if (!iterator->ReadInt(&int_value))
+        return NULL;
+      return new base::FundamentalValue(int_value);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      const char* data;
+      if (!iterator->ReadBytes(&data, sizeof(double)))
+        return NULL;
+      double double_value;
+      memcpy(&double_value, data, sizeof(double_value));
+      return new base::FundamentalValue(double_value);
+    }
+    case base::Value::TYPE_STRING: {
+      std::string string_value;
+      if (!iterator->ReadString(&string_value))
+        return NULL;
+      return new base::StringValue(string_value);
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!iterator->ReadLength(&size))
+        return NULL;
+      scoped_ptr<base::DictionaryValue> dictionary(new base::DictionaryValue);
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        if (!iterator->ReadString(&key))
+          return NULL;
+        base::Value* child = ReadValue(iterator, depth + 1);
+        if (!child)
+          return NULL;
+        dictionary->SetWithoutPathExpansion(key, child);
+      }
+      return dictionary.release();
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!iterator->ReadLength(&size))
+        return NULL;
+      scoped_ptr<base::ListValue> list(new base::ListValue);
+      for (int i = 0; i < size; ++i) {
+        base::Value* child = ReadValue(iterator, depth + 1);
+        if (!child)
+          return NULL;
+        list->Append(child);
+      }
+      return list.release();
+    }
+    default:
+      return NULL;
+  }
+}
+
+}  // namespace
+
+bool WriteValueToPickle(const base::Value& value, Pickle* pickle) {
+  return WriteValue(value, 0, pickle);
+}
+
+scoped_ptr<base::Value> ReadValueFromPickle(PickleIterator* iterator) {
+  return make_scoped_ptr(ReadValue(iterator, 0));
+}
+
+bool WriteStringsToPickle(const std::vector<std::string>& strings,
+                          Pickle* pickle) {
+  if (!pickle->WriteInt(static_cast<int>(strings.size())))
+    return false;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    if (!pickle->WriteString(strings[i]))
+      return false;
+  }
+  return true;
+}
+
+bool ReadStringsFromPickle(PickleIterator* iterator,
+                           std::vector<std::string>* strings) {
+  int size;
+  if (!iterator->ReadLength(&size))
+    return false;
+  // |size| isn't trusted, the strings are read before being stored.
+  std::vector<std::string> result;
+  for (int i = 0; i < size; ++i) {
+    std::string string;
+    if (!iterator->ReadString(&string))
+      return false;
+    result.push_back(string);
+  }
+  strings->swap(result);
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
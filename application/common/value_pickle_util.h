@@ -0,0 +1,43 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_VALUE_PICKLE_UTIL_H_
+#define XWALK_APPLICATION_COMMON_VALUE_PICKLE_UTIL_H_
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/memory/scoped_ptr.h"
+
+class Pickle;
+class PickleIterator;
+
+namespace base {
+class Value;
+}
+
+namespace xwalk {
+namespace application {
+
+// Writes |value| to |pickle|. Binary values and trees nested too deeply
+// aren't supported, |pickle| may be changed even if false is returned.
+bool WriteValueToPickle(const base::Value& value,
+                        Pickle* pickle) WARN_UNUSED_RESULT;
+
+// Reads a value written by WriteValueToPickle(). Returns NULL if |iterator|
+// doesn't point to a valid value.
+scoped_ptr<base::Value> ReadValueFromPickle(PickleIterator* iterator);
+
+bool WriteStringsToPickle(const std::vector<std::string>& strings,
+                          Pickle* pickle) WARN_UNUSED_RESULT;
+
+bool ReadStringsFromPickle(PickleIterator* iterator,
+                           std::vector<std::string>* strings)
+    WARN_UNUSED_RESULT;
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_VALUE_PICKLE_UTIL_H_
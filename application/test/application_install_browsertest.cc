@@ -0,0 +1,165 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "content/public/test/test_utils.h"
+#include "xwalk/application/browser/application_service.h"
+#include "xwalk/application/browser/application_storage.h"
+#include "xwalk/application/browser/application_system.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/test/application_browsertest.h"
+#include "xwalk/runtime/browser/xwalk_runner.h"
+
+using xwalk::application::ApplicationData;
+using xwalk::application::ApplicationService;
+
+namespace {
+
+class InstallProgressObserver : public ApplicationService::Observer {
+ public:
+  virtual void OnApplicationInstalled(const std::string& app_id) OVERRIDE {
+    installed_ids_.push_back(app_id);
+  }
+
+  virtual void OnApplicationUninstalled(const std::string& app_id) OVERRIDE {
+    uninstalled_ids_.push_back(app_id);
+  }
+
+  virtual void OnApplicationInstallProgress(
+      const base::FilePath& package_path, const std::string& app_id,
+      ApplicationService::InstallStage stage) OVERRIDE {
+    stages_.push_back(stage);
+  }
+
+  std::vector<std::string> installed_ids_;
+  std::vector<std::string> uninstalled_ids_;
+  std::vector<ApplicationService::InstallStage> stages_;
+};
+
+void StoreResult(content::MessageLoopRunner* runner,
+                 bool* success_result, std::string* id_result,
+                 bool success, const std::string& app_id) {
+  *success_result = success;
+  *id_result = app_id;
+  runner->Quit();
+}
+
+}  // namespace
+
+class ApplicationInstallTest : public ApplicationBrowserTest {
+ protected:
+  virtual void SetUpOnMainThread() OVERRIDE {
+    package_path_ = test_data_dir_.DirName()
+        .Append(FILE_PATH_LITERAL("unpacker"))
+        .Append(FILE_PATH_LITERAL("good.xpk"));
+    application_sevice()->AddObserver(&observer_);
+  }
+
+  virtual void ProperMainThreadCleanup() OVERRIDE {
+    application_sevice()->RemoveObserver(&observer_);
+    ApplicationBrowserTest::ProperMainThreadCleanup();
+  }
+
+  // Runs the message loop until the job started by |start| is done.
+  bool RunJob(const base::Callback<void(
+                  const ApplicationService::InstallCallback&)>& start,
+              std::string* app_id) {
+    scoped_refptr<content::MessageLoopRunner> runner =
+        new content::MessageLoopRunner;
+    bool success = false;
+    start.Run(base::Bind(&StoreResult, runner, &success, app_id));
+    runner->Run();
+    return success;
+  }
+
+  bool InstallAsync(std::string* app_id) {
+    return RunJob(base::Bind(&ApplicationService::InstallAsync,
+                             base::Unretained(application_sevice()),
+                             package_path_),
+                  app_id);
+  }
+
+  bool UpdateAsync(const std::string& id) {
+    std::string app_id;
+    return RunJob(base::Bind(&ApplicationService::UpdateAsync,
+                             base::Unretained(application_sevice()),
+                             id, package_path_),
+                  &app_id);
+  }
+
+  bool UninstallAsync(const std::string& id) {
+    std::string app_id;
+    return RunJob(base::Bind(&ApplicationService::UninstallAsync,
+                             base::Unretained(application_sevice()), id),
+                  &app_id);
+  }
+
+  scoped_refptr<ApplicationData> GetApplicationData(const std::string& id) {
+    return xwalk::XWalkRunner::GetInstance()->app_system()
+        ->application_storage()->GetApplicationData(id);
+  }
+
+  base::FilePath package_path_;
+  InstallProgressObserver observer_;
+};
+
+IN_PROC_BROWSER_TEST_F(ApplicationInstallTest, InstallAndUninstallAsync) {
+  std::string app_id;
+  ASSERT_TRUE(InstallAsync(&app_id));
+  ASSERT_FALSE(app_id.empty());
+
+  ASSERT_EQ(4u, observer_.stages_.size());
+  EXPECT_EQ(ApplicationService::INSTALL_STAGE_PREPARING, observer_.stages_[0]);
+  EXPECT_EQ(ApplicationService::INSTALL_STAGE_EXTRACTING,
+            observer_.stages_[1]);
+  EXPECT_EQ(ApplicationService::INSTALL_STAGE_MOVING, observer_.stages_[2]);
+  EXPECT_EQ(ApplicationService::INSTALL_STAGE_REGISTERING,
+            observer_.stages_[3]);
+  ASSERT_EQ(1u, observer_.installed_ids_.size());
+  EXPECT_EQ(app_id, observer_.installed_ids_[0]);
+
+  scoped_refptr<ApplicationData> application = GetApplicationData(app_id);
+  ASSERT_TRUE(application);
+  base::FilePath app_dir = application->Path();
+  EXPECT_TRUE(base::DirectoryExists(app_dir));
+
+  observer_.stages_.clear();
+  ASSERT_TRUE(UninstallAsync(app_id));
+  ASSERT_EQ(1u, observer_.stages_.size());
+  EXPECT_EQ(ApplicationService::INSTALL_STAGE_REMOVING, observer_.stages_[0]);
+  ASSERT_EQ(1u, observer_.uninstalled_ids_.size());
+  EXPECT_FALSE(base::DirectoryExists(app_dir));
+}
+
+IN_PROC_BROWSER_TEST_F(ApplicationInstallTest, FailedJobsKeepTheFiles) {
+  std::string app_id;
+  ASSERT_TRUE(InstallAsync(&app_id));
+  scoped_refptr<ApplicationData> application = GetApplicationData(app_id);
+  ASSERT_TRUE(application);
+  base::FilePath app_dir = application->Path();
+
+  // The package is already installed, its id is given back.
+  observer_.stages_.clear();
+  std::string existing_id;
+  EXPECT_FALSE(InstallAsync(&existing_id));
+  EXPECT_EQ(app_id, existing_id);
+
+  // An update needs a higher version, it fails before moving any file.
+  EXPECT_FALSE(UpdateAsync(app_id));
+  for (size_t i = 0; i < observer_.stages_.size(); ++i) {
+    EXPECT_NE(ApplicationService::INSTALL_STAGE_MOVING, observer_.stages_[i]);
+    EXPECT_NE(ApplicationService::INSTALL_STAGE_ROLLING_BACK,
+              observer_.stages_[i]);
+  }
+  EXPECT_EQ(1u, observer_.installed_ids_.size());
+  EXPECT_TRUE(base::DirectoryExists(app_dir));
+  EXPECT_FALSE(base::DirectoryExists(
+      base::FilePath(app_dir.value() + FILE_PATH_LITERAL(".tmp"))));
+
+  ASSERT_TRUE(UninstallAsync(app_id));
+}
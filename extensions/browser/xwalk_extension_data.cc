@@ -5,6 +5,9 @@
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 
 #include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_process_host.h"
+#include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_direct_channel.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
@@ -15,8 +18,10 @@ namespace extensions {
 
 XWalkExtensionData::XWalkExtensionData()
     : in_process_message_filter_(NULL),
+      shared_extension_process_host_(NULL),
       extension_thread_(NULL),
-      render_process_host_(NULL) {}
+      render_process_host_(NULL),
+      direct_channel_token_(0) {}
 
 XWalkExtensionData::~XWalkExtensionData() {
   DCHECK(in_process_extension_thread_server_);
@@ -26,6 +31,9 @@ XWalkExtensionData::~XWalkExtensionData() {
   in_process_extension_thread_server_->Invalidate();
   in_process_ui_thread_server_->Invalidate();
 
+  if (direct_channel_)
+    direct_channel_->Disconnect(XWalkExtensionDirectChannel::SERVER_SIDE);
+
   extension_thread_->message_loop()->DeleteSoon(
       FROM_HERE, in_process_extension_thread_server_.release());
 
@@ -33,6 +41,23 @@ XWalkExtensionData::~XWalkExtensionData() {
     BrowserThread::DeleteSoon(
         BrowserThread::IO, FROM_HERE, extension_process_host_.release());
   }
+
+  if (shared_extension_process_host_) {
+    DCHECK(render_process_host_);
+    shared_extension_process_host_->RemoveRenderProcess(
+        render_process_host_->GetID());
+  }
+}
+
+void XWalkExtensionData::set_direct_channel(
+    XWalkExtensionDirectChannel* channel, int token) {
+  direct_channel_ = channel;
+  direct_channel_token_ = token;
+}
+
+void XWalkExtensionData::set_direct_channel_sender(
+    scoped_ptr<IPC::Sender> sender) {
+  direct_channel_sender_ = sender.Pass();
 }
 
 }  // namespace extensions
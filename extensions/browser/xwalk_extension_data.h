@@ -5,12 +5,17 @@
 #ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_DATA_H_
 #define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_DATA_H_
 
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 
 namespace base {
 class Thread;
 }
 
+namespace IPC {
+class Sender;
+}
+
 namespace content {
 class RenderProcessHost;
 }
@@ -19,6 +24,7 @@ namespace xwalk {
 namespace extensions {
 
 class ExtensionServerMessageFilter;
+class XWalkExtensionDirectChannel;
 class XWalkExtensionProcessHost;
 class XWalkExtensionServer;
 
@@ -47,6 +53,30 @@ class XWalkExtensionData {
     return render_process_host_;
   }
 
+  XWalkExtensionProcessHost* shared_extension_process_host() {
+    return shared_extension_process_host_;
+  }
+
+  // The extension process serving the render process, either its own or a
+  // shared one, if any. The ownership is kept.
+  XWalkExtensionProcessHost* serving_extension_process_host() {
+    if (extension_process_host_)
+      return extension_process_host_.get();
+    return shared_extension_process_host_;
+  }
+
+  base::Thread* extension_thread() {
+    return extension_thread_;
+  }
+
+  XWalkExtensionDirectChannel* direct_channel() {
+    return direct_channel_.get();
+  }
+
+  int direct_channel_token() const {
+    return direct_channel_token_;
+  }
+
   void set_in_process_extension_thread_server(
       scoped_ptr<XWalkExtensionServer> server) {
     in_process_extension_thread_server_.reset(server.release());
@@ -67,6 +97,12 @@ class XWalkExtensionData {
     extension_process_host_.reset(host.release());
   }
 
+  // The shared extension process is owned by XWalkExtensionService. The
+  // render process is removed from it when this object is destroyed.
+  void set_shared_extension_process_host(XWalkExtensionProcessHost* host) {
+    shared_extension_process_host_ = host;
+  }
+
   void set_extension_thread(base::Thread* thread) {
     extension_thread_ = thread;
   }
@@ -75,6 +111,13 @@ class XWalkExtensionData {
     render_process_host_ = rph;
   }
 
+  // Only in single process mode. The channel is published with |token|.
+  void set_direct_channel(XWalkExtensionDirectChannel* channel, int token);
+
+  // Used by the in-process servers to send their messages, it must outlive
+  // them.
+  void set_direct_channel_sender(scoped_ptr<IPC::Sender> sender);
+
  private:
   // Extension servers living on their respective threads.
   scoped_ptr<XWalkExtensionServer> in_process_extension_thread_server_;
@@ -86,9 +129,15 @@ class XWalkExtensionData {
   // This object lives on the IO-thread.
   scoped_ptr<XWalkExtensionProcessHost> extension_process_host_;
 
+  XWalkExtensionProcessHost* shared_extension_process_host_;
+
   base::Thread* extension_thread_;
 
   content::RenderProcessHost* render_process_host_;
+
+  scoped_refptr<XWalkExtensionDirectChannel> direct_channel_;
+  int direct_channel_token_;
+  scoped_ptr<IPC::Sender> direct_channel_sender_;
 };
 
 }  // namespace extensions
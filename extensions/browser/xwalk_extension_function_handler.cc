@@ -4,12 +4,48 @@
 
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 
+#include "base/lazy_instance.h"
 #include "base/location.h"
+#include "base/stl_util.h"
+#include "base/synchronization/lock.h"
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
 namespace xwalk {
 namespace extensions {
 
+const char kGetFunctionIdsName[] = "internal.getFunctionIds";
+
+namespace {
+
+// Callback id of the compact calls that don't expect a result.
+const int kNoCallbackId = -1;
+
+class FunctionIdTable {
+ public:
+  int GetId(const std::string& function_name) {
+    base::AutoLock l(lock_);
+    std::pair<IdMap::iterator, bool> result = ids_.insert(
+        std::make_pair(function_name, static_cast<int>(ids_.size())));
+    return result.first->second;
+  }
+
+  int FindId(const std::string& function_name) {
+    base::AutoLock l(lock_);
+    IdMap::const_iterator it = ids_.find(function_name);
+    return it == ids_.end() ? -1 : it->second;
+  }
+
+ private:
+  base::Lock lock_;
+
+  typedef std::map<std::string, int> IdMap;
+  IdMap ids_;
+};
+
+base::LazyInstance<FunctionIdTable> g_function_ids = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
 XWalkExtensionFunctionInfo::XWalkExtensionFunctionInfo(
     const std::string& name,
     scoped_ptr<base::ListValue> arguments,
@@ -23,7 +59,15 @@ XWalkExtensionFunctionInfo::~XWalkExtensionFunctionInfo() {}
 XWalkExtensionFunctionHandler::XWalkExtensionFunctionHandler(
     XWalkExtensionInstance* instance)
   : instance_(instance),
-    weak_factory_(this) {}
+    weak_factory_(this) {
+  // The ids are asked through the handler of the instance, not through the
+  // ones of the objects it passes the calls to.
+  if (instance_) {
+    Register(kGetFunctionIdsName,
+             base::Bind(&XWalkExtensionFunctionHandler::OnGetFunctionIds,
+                        base::Unretained(this)));
+  }
+}
 
 XWalkExtensionFunctionHandler::~XWalkExtensionFunctionHandler() {}
 
@@ -37,6 +81,12 @@ void XWalkExtensionFunctionHandler::HandleMessage(scoped_ptr<base::Value> msg) {
     return;
   }
 
+  int function_id;
+  if (args->GetInteger(0, &function_id)) {
+    HandleCompactMessage(function_id, args);
+    return;
+  }
+
   // The first parameter stands for the function signature.
   std::string function_name;
   if (!args->GetString(0, &function_name)) {
@@ -72,6 +122,69 @@ void XWalkExtensionFunctionHandler::HandleMessage(scoped_ptr<base::Value> msg) {
   }
 }
 
+void XWalkExtensionFunctionHandler::HandleCompactMessage(
+    int function_id, base::ListValue* args) {
+  int callback_id;
+  if (args->GetSize() != 3 || !args->GetInteger(1, &callback_id)) {
+    LOG(WARNING) << "Malformed call of the function with the id "
+                 << function_id << ".";
+    return;
+  }
+
+  // The arguments are the last element, so taking them out of the message
+  // doesn't move anything.
+  scoped_ptr<base::Value> arguments;
+  args->Remove(2, &arguments);
+  if (!arguments->IsType(base::Value::TYPE_LIST)) {
+    LOG(WARNING) << "The arguments of the function with the id "
+                 << function_id << " are not a list.";
+    return;
+  }
+
+  if (!HandleFunction(
+          function_id,
+          make_scoped_ptr(static_cast<base::ListValue*>(arguments.release())),
+          base::Bind(&XWalkExtensionFunctionHandler::DispatchCompactResult,
+                     weak_factory_.GetWeakPtr(),
+                     base::MessageLoopProxy::current(),
+                     callback_id))) {
+    DLOG(WARNING) << "Function not registered for the id: " << function_id;
+    return;
+  }
+}
+
+void XWalkExtensionFunctionHandler::OnGetFunctionIds(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  base::ListValue* names;
+  if (!info->arguments()->GetList(0, &names)) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  // Besides the names of |handlers_|, the ones registered by other handlers
+  // are resolved too, for the BindingObjects of sysapps that get their calls
+  // through this one. Unknown names are never added to the table.
+  scoped_ptr<base::ListValue> ids(new base::ListValue);
+  for (size_t i = 0; i < names->GetSize(); ++i) {
+    std::string name;
+    int id = -1;
+    if (names->GetString(i, &name))
+      id = FindFunctionId(name);
+    ids->AppendInteger(id);
+  }
+
+  scoped_ptr<base::ListValue> result(new base::ListValue);
+  result->Append(ids.release());
+  info->PostResult(result.Pass());
+}
+
+void XWalkExtensionFunctionHandler::Register(const std::string& function_name,
+                                             FunctionHandler callback) {
+  handlers_[function_name] = callback;
+  handlers_by_id_[GetFunctionId(function_name)] =
+      handlers_.find(function_name);
+}
+
 bool XWalkExtensionFunctionHandler::HandleFunction(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
   FunctionHandlerMap::iterator iter = handlers_.find(info->name());
@@ -83,6 +196,33 @@ bool XWalkExtensionFunctionHandler::HandleFunction(
   return true;
 }
 
+bool XWalkExtensionFunctionHandler::HandleFunction(
+    int function_id,
+    scoped_ptr<base::ListValue> arguments,
+    const XWalkExtensionFunctionInfo::PostResultCallback& post_result_cb) {
+  FunctionIdMap::const_iterator iter = handlers_by_id_.find(function_id);
+  if (iter == handlers_by_id_.end())
+    return false;
+
+  const FunctionHandlerMap::const_iterator& handler = iter->second;
+  handler->second.Run(make_scoped_ptr(new XWalkExtensionFunctionInfo(
+      handler->first, arguments.Pass(), post_result_cb)));
+
+  return true;
+}
+
+// static
+int XWalkExtensionFunctionHandler::GetFunctionId(
+    const std::string& function_name) {
+  return g_function_ids.Get().GetId(function_name);
+}
+
+// static
+int XWalkExtensionFunctionHandler::FindFunctionId(
+    const std::string& function_name) {
+  return g_function_ids.Get().FindId(function_name);
+}
+
 // static
 void XWalkExtensionFunctionHandler::DispatchResult(
     const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
@@ -116,6 +256,34 @@ void XWalkExtensionFunctionHandler::DispatchResult(
     handler->PostMessageToInstance(result.PassAs<base::Value>());
 }
 
+// static
+void XWalkExtensionFunctionHandler::DispatchCompactResult(
+    const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
+    scoped_refptr<base::MessageLoopProxy> client_task_runner,
+    int callback_id,
+    scoped_ptr<base::ListValue> result) {
+  DCHECK(result);
+
+  if (client_task_runner != base::MessageLoopProxy::current()) {
+    client_task_runner->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionFunctionHandler::DispatchCompactResult,
+                   handler,
+                   client_task_runner,
+                   callback_id,
+                   base::Passed(&result)));
+    return;
+  }
+
+  if (callback_id == kNoCallbackId || !handler)
+    return;
+
+  // The results are wrapped instead of shifted to make room for the id.
+  scoped_ptr<base::ListValue> msg(new base::ListValue);
+  msg->AppendInteger(callback_id);
+  msg->Append(result.release());
+  handler->PostMessageToInstance(msg.PassAs<base::Value>());
+}
+
 void XWalkExtensionFunctionHandler::PostMessageToInstance(
     scoped_ptr<base::Value> msg) {
   instance_->PostMessageToJS(msg.Pass());
@@ -8,6 +8,7 @@
 #include <map>
 #include <string>
 #include "base/bind.h"
+#include "base/containers/hash_tables.h"
 #include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_loop_proxy.h"
 #include "base/values.h"
@@ -17,6 +18,10 @@ namespace extensions {
 
 class XWalkExtensionInstance;
 
+// Name of the function answering the ids of the functions of a
+// XWalkExtensionFunctionHandler, see HandleMessage().
+extern const char kGetFunctionIdsName[];
+
 // This struct is passed to the function handler, usually assigned to the
 // signature of a method in JavaScript. The struct can be safely passed around.
 class XWalkExtensionFunctionInfo {
@@ -69,17 +74,44 @@ class XWalkExtensionFunctionHandler {
   typedef base::Callback<void(
       scoped_ptr<XWalkExtensionFunctionInfo> info)> FunctionHandler;
 
+  // |instance| is NULL for the handlers of the objects that get their calls
+  // through the handler of an instance, like the BindingObjects of sysapps.
+  // Only the handlers of an instance answer kGetFunctionIdsName.
   explicit XWalkExtensionFunctionHandler(XWalkExtensionInstance* instance);
   ~XWalkExtensionFunctionHandler();
 
   // Converts a raw message from the renderer to a XWalkExtensionFunctionInfo
-  // data structure and invokes HandleFunction().
+  // data structure and invokes HandleFunction(). Messages are either
+  // [function_name, callback_id, arguments...] with a string callback id, or
+  // the compact [function_id, callback_id, [arguments...]] with an integer
+  // callback id, used by the "internal" JavaScript module once it knows the
+  // id of the function. The ids are requested by calling the function
+  // named kGetFunctionIdsName with a list of names, which replies with the
+  // list of ids, -1 for the names no handler of the process registered. The
+  // results of compact calls are posted as [callback_id, [results...]].
   void HandleMessage(scoped_ptr<base::Value> msg);
 
   // Executes the handler associated to the |name| tag of the |info| argument
   // passed as parameter.
   bool HandleFunction(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
+  // Same as above, but looks up the handler by the id of its function name,
+  // see GetFunctionId(). Returns false if there's no handler for it.
+  bool HandleFunction(
+      int function_id,
+      scoped_ptr<base::ListValue> arguments,
+      const XWalkExtensionFunctionInfo::PostResultCallback& post_result_cb);
+
+  // Function names are interned into small integers shared by all the
+  // handlers of the process, so callers that resolved a name once can
+  // dispatch without comparing strings. Can be called from any thread.
+  static int GetFunctionId(const std::string& function_name);
+
+  // Returns the id of |function_name| if a handler registered it, -1
+  // otherwise. Unlike GetFunctionId(), never adds names to the table, so it
+  // is the one to use for names coming from JavaScript.
+  static int FindFunctionId(const std::string& function_name);
+
   // This method will register a callback to handle a message tagged as
   // |function_name|. When invoked, the handler will get a
   // XWalkExtensionFunctionInfo struct with the function |name| (which can be
@@ -98,22 +130,33 @@ class XWalkExtensionFunctionHandler {
   //   Register("show", base::Bind(&Foobar::OnShow, base::Unretained(this)));
   //   Register("getStuff", base::Bind(&Foobar::OnGetStuff)); // Static method.
   //   ...
-  void Register(const std::string& function_name, FunctionHandler callback) {
-    handlers_[function_name] = callback;
-  }
+  void Register(const std::string& function_name, FunctionHandler callback);
 
  private:
+  void HandleCompactMessage(int function_id, base::ListValue* args);
+  void OnGetFunctionIds(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
   static void DispatchResult(
       const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
       scoped_refptr<base::MessageLoopProxy> client_task_runner,
       const std::string& callback_id,
       scoped_ptr<base::ListValue> result);
+  static void DispatchCompactResult(
+      const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
+      scoped_refptr<base::MessageLoopProxy> client_task_runner,
+      int callback_id,
+      scoped_ptr<base::ListValue> result);
 
   void PostMessageToInstance(scoped_ptr<base::Value> msg);
 
   typedef std::map<std::string, FunctionHandler> FunctionHandlerMap;
   FunctionHandlerMap handlers_;
 
+  // Points to the entries of |handlers_|, indexed by their function id.
+  typedef base::hash_map<int, FunctionHandlerMap::const_iterator>
+      FunctionIdMap;
+  FunctionIdMap handlers_by_id_;
+
   XWalkExtensionInstance* instance_;
   base::WeakPtrFactory<XWalkExtensionFunctionHandler> weak_factory_;
 
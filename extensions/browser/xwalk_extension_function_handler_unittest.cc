@@ -4,10 +4,13 @@
 
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 
+#include "base/memory/scoped_vector.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
 
 using xwalk::extensions::XWalkExtensionFunctionHandler;
 using xwalk::extensions::XWalkExtensionFunctionInfo;
+using xwalk::extensions::XWalkExtensionInstance;
 
 namespace {
 
@@ -39,6 +42,25 @@ void ResetCounter(int* counter, scoped_ptr<XWalkExtensionFunctionInfo> info) {
   *counter = 0;
 }
 
+class TestExtensionInstance : public XWalkExtensionInstance {
+ public:
+  TestExtensionInstance() {
+    SetPostMessageCallback(base::Bind(&TestExtensionInstance::StoreMessage,
+                                      base::Unretained(this)));
+  }
+
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {}
+
+  ScopedVector<base::Value>& messages() { return messages_; }
+
+ private:
+  void StoreMessage(scoped_ptr<base::Value> msg) {
+    messages_.push_back(msg.release());
+  }
+
+  ScopedVector<base::Value> messages_;
+};
+
 }  // namespace
 
 TEST(XWalkExtensionFunctionHandlerTest, PostResult) {
@@ -103,6 +125,44 @@ TEST(XWalkExtensionFunctionHandlerTest, RegisterAndHandleFunction) {
   handler.HandleFunction(info3.Pass());
 }
 
+TEST(XWalkExtensionFunctionHandlerTest, HandleFunctionById) {
+  XWalkExtensionFunctionHandler handler(NULL);
+
+  int counter = 0;
+  handler.Register("echoData", base::Bind(&EchoData, &counter));
+
+  int echo_data_id = XWalkExtensionFunctionHandler::GetFunctionId("echoData");
+  EXPECT_EQ(echo_data_id,
+            XWalkExtensionFunctionHandler::GetFunctionId("echoData"));
+  EXPECT_NE(echo_data_id,
+            XWalkExtensionFunctionHandler::GetFunctionId("reset"));
+
+  for (unsigned i = 0; i < 1000; ++i) {
+    std::string str;
+    scoped_ptr<base::ListValue> data(new base::ListValue());
+    data->AppendString(kTestString);
+
+    EXPECT_TRUE(handler.HandleFunction(
+        echo_data_id, data.Pass(), base::Bind(&DispatchResult, &str)));
+    EXPECT_EQ(counter, i + 1);
+    EXPECT_EQ(str, kTestString);
+  }
+
+  // Known name, but not registered in this handler.
+  std::string str;
+  EXPECT_FALSE(handler.HandleFunction(
+      XWalkExtensionFunctionHandler::GetFunctionId("reset"),
+      make_scoped_ptr(new base::ListValue()),
+      base::Bind(&DispatchResult, &str)));
+
+  // Only the handlers of an instance answer the ids.
+  EXPECT_FALSE(handler.HandleFunction(
+      XWalkExtensionFunctionHandler::GetFunctionId(
+          xwalk::extensions::kGetFunctionIdsName),
+      make_scoped_ptr(new base::ListValue()),
+      base::Bind(&DispatchResult, &str)));
+}
+
 TEST(XWalkExtensionFunctionHandlerTest, PostingResultAfterDeletingTheHandler) {
   scoped_ptr<XWalkExtensionFunctionHandler> handler(
       new XWalkExtensionFunctionHandler(NULL));
@@ -123,3 +183,75 @@ TEST(XWalkExtensionFunctionHandlerTest, PostingResultAfterDeletingTheHandler) {
   info->PostResult(make_scoped_ptr(new base::ListValue));
   delete info;
 }
+
+TEST(XWalkExtensionFunctionHandlerTest, HandleCompactMessage) {
+  TestExtensionInstance instance;
+  XWalkExtensionFunctionHandler handler(&instance);
+
+  int counter = 0;
+  handler.Register("echoData", base::Bind(&EchoData, &counter));
+
+  // Resolve the function ids, the same way the internal JS module does.
+  scoped_ptr<base::ListValue> names(new base::ListValue);
+  names->AppendString("echoData");
+  names->AppendString("unknown");
+
+  scoped_ptr<base::ListValue> msg(new base::ListValue);
+  msg->AppendString(xwalk::extensions::kGetFunctionIdsName);
+  msg->AppendString("7");
+  msg->Append(names.release());
+  handler.HandleMessage(msg.PassAs<base::Value>());
+
+  ASSERT_EQ(1u, instance.messages().size());
+  base::ListValue* reply;
+  base::ListValue* ids;
+  std::string callback_id;
+  ASSERT_TRUE(instance.messages()[0]->GetAsList(&reply));
+  ASSERT_TRUE(reply->GetString(0, &callback_id));
+  EXPECT_EQ("7", callback_id);
+  ASSERT_TRUE(reply->GetList(1, &ids));
+  ASSERT_EQ(2u, ids->GetSize());
+
+  int echo_data_id;
+  int unknown_id;
+  ASSERT_TRUE(ids->GetInteger(0, &echo_data_id));
+  ASSERT_TRUE(ids->GetInteger(1, &unknown_id));
+  EXPECT_EQ(XWalkExtensionFunctionHandler::GetFunctionId("echoData"),
+            echo_data_id);
+  EXPECT_EQ(-1, unknown_id);
+
+  // Call it by id, the results are wrapped in a list after the callback id.
+  scoped_ptr<base::ListValue> args(new base::ListValue);
+  args->AppendString(kTestString);
+  msg.reset(new base::ListValue);
+  msg->AppendInteger(echo_data_id);
+  msg->AppendInteger(42);
+  msg->Append(args.release());
+  handler.HandleMessage(msg.PassAs<base::Value>());
+
+  EXPECT_EQ(1, counter);
+  ASSERT_EQ(2u, instance.messages().size());
+  ASSERT_TRUE(instance.messages()[1]->GetAsList(&reply));
+  ASSERT_EQ(2u, reply->GetSize());
+
+  int compact_callback_id;
+  base::ListValue* results;
+  std::string str;
+  ASSERT_TRUE(reply->GetInteger(0, &compact_callback_id));
+  EXPECT_EQ(42, compact_callback_id);
+  ASSERT_TRUE(reply->GetList(1, &results));
+  ASSERT_TRUE(results->GetString(0, &str));
+  EXPECT_EQ(kTestString, str);
+
+  // Calls without a callback don't post their results.
+  args.reset(new base::ListValue);
+  args->AppendString(kTestString);
+  msg.reset(new base::ListValue);
+  msg->AppendInteger(echo_data_id);
+  msg->AppendInteger(-1);
+  msg->Append(args.release());
+  handler.HandleMessage(msg.PassAs<base::Value>());
+
+  EXPECT_EQ(2, counter);
+  EXPECT_EQ(2u, instance.messages().size());
+}
@@ -9,6 +9,7 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/files/file_path.h"
+#include "base/stl_util.h"
 #include "content/public/browser/browser_child_process_host.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_process_host.h"
@@ -32,15 +33,17 @@ namespace extensions {
 class XWalkExtensionProcessHost::RenderProcessMessageFilter
     : public IPC::ChannelProxy::MessageFilter {
  public:
-  explicit RenderProcessMessageFilter(XWalkExtensionProcessHost* eph)
-      : eph_(eph) {}
+  RenderProcessMessageFilter(XWalkExtensionProcessHost* eph,
+                             content::RenderProcessHost* render_process_host)
+      : eph_(eph),
+        render_process_host_(render_process_host) {}
 
   // This exists to fulfill the requirement for delayed reply handling, since it
   // needs to send a message back if the parameters couldn't be correctly read
   // from the original message received. See DispatchDealyReplyWithSendParams().
   bool Send(IPC::Message* message) {
     if (eph_)
-      return eph_->render_process_host_->Send(message);
+      return render_process_host_->Send(message);
     delete message;
     return false;
   }
@@ -64,13 +67,16 @@ class XWalkExtensionProcessHost::RenderProcessMessageFilter
 
   void OnGetExtensionProcessChannel(IPC::Message* reply) {
     scoped_ptr<IPC::Message> scoped_reply(reply);
-    if (eph_)
-      eph_->OnGetExtensionProcessChannel(scoped_reply.Pass());
+    if (eph_) {
+      eph_->OnGetExtensionProcessChannel(render_process_host_->GetID(),
+                                         scoped_reply.Pass());
+    }
   }
 
   virtual ~RenderProcessMessageFilter() {}
 
   XWalkExtensionProcessHost* eph_;
+  content::RenderProcessHost* render_process_host_;
 };
 
 class ExtensionSandboxedProcessLauncherDelegate
@@ -108,19 +114,44 @@ bool XWalkExtensionProcessHost::Delegate::OnRegisterPermissions(
   return false;
 }
 
+XWalkExtensionProcessHost::RenderProcessData::RenderProcessData(
+    content::RenderProcessHost* host, RenderProcessMessageFilter* filter)
+    : host(host),
+      filter(filter),
+      channel_handle(""),
+      is_channel_ready(false) {}
+
+XWalkExtensionProcessHost::RenderProcessData::~RenderProcessData() {
+  filter->Invalidate();
+}
+
 XWalkExtensionProcessHost::XWalkExtensionProcessHost(
     content::RenderProcessHost* render_process_host,
     const base::FilePath& external_extensions_path,
     XWalkExtensionProcessHost::Delegate* delegate,
     const base::ValueMap& runtime_variables)
-    : ep_rp_channel_handle_(""),
-      render_process_host_(render_process_host),
-      render_process_message_filter_(new RenderProcessMessageFilter(this)),
+    : render_process_host_(render_process_host),
+      is_shared_(false),
       external_extensions_path_(external_extensions_path),
-      is_extension_process_channel_ready_(false),
       delegate_(delegate),
       runtime_variables_(runtime_variables) {
-  render_process_host_->GetChannel()->AddFilter(render_process_message_filter_);
+  RenderProcessMessageFilter* filter =
+      new RenderProcessMessageFilter(this, render_process_host_);
+  render_processes_[render_process_host_->GetID()] =
+      new RenderProcessData(render_process_host_, filter);
+  render_process_host_->GetChannel()->AddFilter(filter);
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::StartProcess,
+      base::Unretained(this)));
+}
+
+XWalkExtensionProcessHost::XWalkExtensionProcessHost(
+    const base::FilePath& external_extensions_path,
+    XWalkExtensionProcessHost::Delegate* delegate)
+    : render_process_host_(NULL),
+      is_shared_(true),
+      external_extensions_path_(external_extensions_path),
+      delegate_(delegate) {
   BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
       base::Bind(&XWalkExtensionProcessHost::StartProcess,
       base::Unretained(this)));
@@ -128,7 +159,7 @@ XWalkExtensionProcessHost::XWalkExtensionProcessHost(
 
 XWalkExtensionProcessHost::~XWalkExtensionProcessHost() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
-  render_process_message_filter_->Invalidate();
+  STLDeleteValues(&render_processes_);
   StopProcess();
 }
 
@@ -146,12 +177,67 @@ void ToListValue(base::ValueMap* vm, base::ListValue* lv) {
 
 }  // namespace
 
+void XWalkExtensionProcessHost::AddRenderProcess(
+    content::RenderProcessHost* render_process_host,
+    const base::ValueMap& runtime_variables) {
+  DCHECK(is_shared_);
+
+  RenderProcessMessageFilter* filter =
+      new RenderProcessMessageFilter(this, render_process_host);
+  scoped_ptr<RenderProcessData> data(
+      new RenderProcessData(render_process_host, filter));
+  render_process_host->GetChannel()->AddFilter(filter);
+
+  scoped_ptr<base::ListValue> runtime_variables_lv(new base::ListValue);
+  ToListValue(&const_cast<base::ValueMap&>(runtime_variables),
+      runtime_variables_lv.get());
+
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::AddRenderProcessOnIOThread,
+                 base::Unretained(this), render_process_host->GetID(),
+                 base::Passed(&data), base::Passed(&runtime_variables_lv)));
+}
+
+void XWalkExtensionProcessHost::AddRenderProcessOnIOThread(
+    int render_process_id, scoped_ptr<RenderProcessData> data,
+    scoped_ptr<base::ListValue> runtime_variables) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(!ContainsKey(render_processes_, render_process_id));
+
+  render_processes_[render_process_id] = data.release();
+  Send(new XWalkExtensionProcessMsg_CreateRenderProcessChannel(
+      render_process_id, *runtime_variables));
+}
+
+void XWalkExtensionProcessHost::RemoveRenderProcess(int render_process_id) {
+  DCHECK(is_shared_);
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::RemoveRenderProcessOnIOThread,
+                 base::Unretained(this), render_process_id));
+}
+
+void XWalkExtensionProcessHost::RemoveRenderProcessOnIOThread(
+    int render_process_id) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  RenderProcessDataMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+
+  delete it->second;
+  render_processes_.erase(it);
+  Send(new XWalkExtensionProcessMsg_CloseRenderProcessChannel(
+      render_process_id));
+}
+
 void XWalkExtensionProcessHost::StartProcess() {
   CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   CHECK(!process_ || !channel_);
 
+  // The launcher of an application in service mode runs the extensions of
+  // that application only, so a shared process is always a child process.
   CommandLine* cmd_line = CommandLine::ForCurrentProcess();
-  if (cmd_line->HasSwitch(switches::kXWalkRunAsService)) {
+  if (!is_shared_ && cmd_line->HasSwitch(switches::kXWalkRunAsService)) {
 #if defined(OS_LINUX)
     std::string channel_id =
         IPC::Channel::GenerateVerifiedChannelID(std::string());
@@ -200,6 +286,8 @@ void XWalkExtensionProcessHost::StartProcess() {
     cmd_line->AppendSwitchASCII(switches::kProcessType,
                                 switches::kXWalkExtensionProcess);
     cmd_line->AppendSwitchASCII(switches::kProcessChannelID, channel_id);
+    if (is_shared_)
+      cmd_line->AppendSwitch(switches::kXWalkExtensionProcessPool);
     if (!extension_cmd_prefix.empty())
       cmd_line->PrependWrapper(extension_cmd_prefix);
 
@@ -208,6 +296,8 @@ void XWalkExtensionProcessHost::StartProcess() {
         cmd_line.release());
   }
 
+  // The runtime variables of a shared process are sent for each render
+  // process instead.
   base::ListValue runtime_variables_lv;
   ToListValue(&const_cast<base::ValueMap&>(runtime_variables_),
       &runtime_variables_lv);
@@ -223,9 +313,13 @@ void XWalkExtensionProcessHost::StopProcess() {
 }
 
 void XWalkExtensionProcessHost::OnGetExtensionProcessChannel(
-    scoped_ptr<IPC::Message> reply) {
-  pending_reply_for_render_process_ = reply.Pass();
-  ReplyChannelHandleToRenderProcess();
+    int render_process_id, scoped_ptr<IPC::Message> reply) {
+  RenderProcessDataMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+
+  it->second->pending_reply = reply.Pass();
+  ReplyChannelHandleToRenderProcess(it->second);
 }
 
 bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
@@ -240,6 +334,15 @@ bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
     IPC_MESSAGE_HANDLER(
         XWalkExtensionProcessHostMsg_RegisterPermissions,
         OnRegisterPermissions)
+    IPC_MESSAGE_HANDLER(
+        XWalkExtensionProcessHostMsg_SharedRenderProcessChannelCreated,
+        OnRenderChannelCreatedForRenderProcess)
+    IPC_MESSAGE_HANDLER_DELAY_REPLY(
+        XWalkExtensionProcessHostMsg_CheckAPIAccessControlForRenderProcess,
+        OnCheckAPIAccessControlForRenderProcess)
+    IPC_MESSAGE_HANDLER(
+        XWalkExtensionProcessHostMsg_RegisterPermissionsForRenderProcess,
+        OnRegisterPermissionsForRenderProcess)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -255,8 +358,19 @@ void XWalkExtensionProcessHost::OnChannelError() {
   // most likely have a pointer to us that needs to be invalidated.
 
   VLOG(1) << "\n\nExtensionProcess crashed";
-  if (delegate_)
+  if (!delegate_)
+    return;
+
+  if (!is_shared_) {
     delegate_->OnExtensionProcessDied(this, render_process_host_->GetID());
+    return;
+  }
+
+  std::vector<int> render_process_ids;
+  RenderProcessDataMap::const_iterator it = render_processes_.begin();
+  for (; it != render_processes_.end(); ++it)
+    render_process_ids.push_back(it->first);
+  delegate_->OnSharedExtensionProcessDied(this, render_process_ids);
 }
 
 void XWalkExtensionProcessHost::OnProcessLaunched() {
@@ -265,26 +379,38 @@ void XWalkExtensionProcessHost::OnProcessLaunched() {
 
 void XWalkExtensionProcessHost::OnRenderChannelCreated(
     const IPC::ChannelHandle& handle) {
-  is_extension_process_channel_ready_ = true;
-  ep_rp_channel_handle_ = handle;
-  ReplyChannelHandleToRenderProcess();
+  if (is_shared_)
+    return;
+  OnRenderChannelCreatedForRenderProcess(render_process_host_->GetID(), handle);
+}
+
+void XWalkExtensionProcessHost::OnRenderChannelCreatedForRenderProcess(
+    int render_process_id, const IPC::ChannelHandle& handle) {
+  RenderProcessDataMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+
+  RenderProcessData* data = it->second;
+  data->is_channel_ready = true;
+  data->channel_handle = handle;
+  ReplyChannelHandleToRenderProcess(data);
 }
 
-void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
+void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess(
+    RenderProcessData* data) {
   // Replying the channel handle to RP depends on two events:
   // - EP already notified EPH that new channel was created (for RP<->EP).
   // - RP already asked for the channel handle.
   //
   // The order for this events is not determined, so we call this function from
   // both, and the second execution will send the reply.
-  if (!is_extension_process_channel_ready_
-      || !pending_reply_for_render_process_)
+  if (!data->is_channel_ready || !data->pending_reply)
     return;
 
   XWalkExtensionProcessHostMsg_GetExtensionProcessChannel::WriteReplyParams(
-      pending_reply_for_render_process_.get(), ep_rp_channel_handle_);
+      data->pending_reply.get(), data->channel_handle);
 
-  render_process_host_->Send(pending_reply_for_render_process_.release());
+  data->host->Send(data->pending_reply.release());
 }
 
 void XWalkExtensionProcessHost::ReplyAccessControlToExtension(
@@ -312,6 +438,72 @@ void XWalkExtensionProcessHost::OnRegisterPermissions(
   CHECK(delegate_);
   *result = delegate_->OnRegisterPermissions(
       render_process_host_->GetID(), extension_name, perm_table);
+  if (*result)
+    RequestPermissionDecisions(render_process_host_->GetID(), extension_name);
+}
+
+void XWalkExtensionProcessHost::ReplySharedAccessControlToExtension(
+    IPC::Message* reply_msg,
+    RuntimePermission perm) {
+  XWalkExtensionProcessHostMsg_CheckAPIAccessControlForRenderProcess
+      ::WriteReplyParams(reply_msg, perm);
+  Send(reply_msg);
+}
+
+void XWalkExtensionProcessHost::OnCheckAPIAccessControlForRenderProcess(
+    int render_process_id, const std::string& extension_name,
+    const std::string& api_name, IPC::Message* reply_msg) {
+  CHECK(delegate_);
+  if (!ContainsKey(render_processes_, render_process_id)) {
+    ReplySharedAccessControlToExtension(reply_msg, DENY_ONCE);
+    return;
+  }
+
+  delegate_->OnCheckAPIAccessControl(render_process_id,
+                                     extension_name, api_name,
+      base::Bind(
+          &XWalkExtensionProcessHost::ReplySharedAccessControlToExtension,
+          base::Unretained(this),
+          reply_msg));
+}
+
+void XWalkExtensionProcessHost::OnRegisterPermissionsForRenderProcess(
+    int render_process_id, const std::string& extension_name,
+    const std::string& perm_table, bool* result) {
+  CHECK(delegate_);
+  *result = ContainsKey(render_processes_, render_process_id) &&
+      delegate_->OnRegisterPermissions(render_process_id, extension_name,
+                                       perm_table);
+  if (*result)
+    RequestPermissionDecisions(render_process_id, extension_name);
+}
+
+void XWalkExtensionProcessHost::RequestPermissionDecisions(
+    int render_process_id, const std::string& extension_name) {
+  // The permissions of the applications live in the UI thread.
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(
+          &XWalkExtensionProcessHost::Delegate::OnPermissionsRegistered,
+          base::Unretained(delegate_), base::Unretained(this),
+          render_process_id, extension_name));
+}
+
+void XWalkExtensionProcessHost::UpdatePermissions(
+    int render_process_id, const PermissionDecisions& decisions) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  Send(new XWalkExtensionProcessMsg_ClearPermissionCache(render_process_id));
+  if (!decisions.empty())
+    Send(new XWalkExtensionProcessMsg_CachePermissions(render_process_id,
+                                                       decisions));
+}
+
+void XWalkExtensionProcessHost::CachePermissions(
+    int render_process_id, const PermissionDecisions& decisions) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!decisions.empty() && ContainsKey(render_processes_, render_process_id))
+    Send(new XWalkExtensionProcessMsg_CachePermissions(render_process_id,
+                                                       decisions));
 }
 
 bool XWalkExtensionProcessHost::Send(IPC::Message* msg) {
@@ -5,7 +5,9 @@
 #ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 #define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
@@ -28,6 +30,12 @@ namespace extensions {
 // This class represents the browser side of the browser <-> extension process
 // communication channel. It has to run some operations in IO thread for
 // creating the extra process.
+//
+// An extension process is either dedicated to one render process, or shared
+// by the render processes added with AddRenderProcess(), see
+// switches::kXWalkExtensionProcessPool. A shared process can also be launched
+// in advance and handed to a single render process later on, see
+// switches::kXWalkPrelaunchExtensionProcess.
 class XWalkExtensionProcessHost
     : public content::BrowserChildProcessHostDelegate,
       public IPC::Sender {
@@ -36,6 +44,8 @@ class XWalkExtensionProcessHost
    public:
     virtual void OnExtensionProcessDied(XWalkExtensionProcessHost* eph,
         int render_process_id) {}
+    virtual void OnSharedExtensionProcessDied(XWalkExtensionProcessHost* eph,
+        const std::vector<int>& render_process_ids) {}
     virtual void OnExtensionProcessCreated(int render_process_id,
                                            const IPC::ChannelHandle handle) {}
     virtual void OnCheckAPIAccessControl(int render_process_id,
@@ -45,6 +55,12 @@ class XWalkExtensionProcessHost
     virtual bool OnRegisterPermissions(int render_process_id,
                                        const std::string& extension_name,
                                        const std::string& perm_table);
+    // Called in the UI thread once |extension_name| registered its
+    // permissions for |render_process_id|. The cacheable decisions are sent
+    // back to |eph| in the IO thread with CachePermissions().
+    virtual void OnPermissionsRegistered(XWalkExtensionProcessHost* eph,
+                                         int render_process_id,
+                                         const std::string& extension_name) {}
    protected:
     ~Delegate() {}
   };
@@ -53,20 +69,73 @@ class XWalkExtensionProcessHost
                             const base::FilePath& external_extensions_path,
                             XWalkExtensionProcessHost::Delegate* delegate,
                             const base::ValueMap& runtime_variables);
+
+  // Creates a shared extension process, serving no render process yet.
+  XWalkExtensionProcessHost(const base::FilePath& external_extensions_path,
+                            XWalkExtensionProcessHost::Delegate* delegate);
+
   virtual ~XWalkExtensionProcessHost();
 
+  // Only for shared extension processes, called in the UI thread. The
+  // render process gets its own channel to the extension process, and
+  // |runtime_variables| are used for the instances of its extensions.
+  void AddRenderProcess(content::RenderProcessHost* render_process_host,
+                        const base::ValueMap& runtime_variables);
+  void RemoveRenderProcess(int render_process_id);
+
+  bool is_shared() const { return is_shared_; }
+
+  // Called in the IO thread when the permissions of the application of
+  // |render_process_id| change. The extension process drops the decisions it
+  // cached and gets |decisions| instead.
+  void UpdatePermissions(int render_process_id,
+                         const PermissionDecisions& decisions);
+
+  // Called in the IO thread with the decisions for the APIs that an
+  // extension just registered, see Delegate::OnPermissionsRegistered().
+  void CachePermissions(int render_process_id,
+                        const PermissionDecisions& decisions);
+
   // IPC::Sender implementation
   virtual bool Send(IPC::Message* msg) OVERRIDE;
 
  private:
   class RenderProcessMessageFilter;
 
+  // The state of the channel between a render process and the extension
+  // process. Lives in the IO thread.
+  struct RenderProcessData {
+    RenderProcessData(content::RenderProcessHost* host,
+                      RenderProcessMessageFilter* filter);
+    ~RenderProcessData();
+
+    content::RenderProcessHost* host;
+
+    // We use this filter to know when RP asked for the extension process
+    // channel. We keep the reference to invalidate the filter once we don't
+    // need it anymore.
+    //
+    // TODO(cmarcelo): Avoid having an extra filter, see if we can embed this
+    // handling in the existing filter we have in ExtensionData struct.
+    scoped_refptr<RenderProcessMessageFilter> filter;
+
+    IPC::ChannelHandle channel_handle;
+    bool is_channel_ready;
+    scoped_ptr<IPC::Message> pending_reply;
+  };
+
   void StartProcess();
   void StopProcess();
 
+  void AddRenderProcessOnIOThread(
+      int render_process_id, scoped_ptr<RenderProcessData> data,
+      scoped_ptr<base::ListValue> runtime_variables);
+  void RemoveRenderProcessOnIOThread(int render_process_id);
+
   // Handler for message from Render Process host, it is a synchronous message,
   // that will be replied only when the extension process channel is created.
-  void OnGetExtensionProcessChannel(scoped_ptr<IPC::Message> reply);
+  void OnGetExtensionProcessChannel(int render_process_id,
+                                    scoped_ptr<IPC::Message> reply);
 
   // content::BrowserChildProcessHostDelegate implementation.
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
@@ -75,8 +144,10 @@ class XWalkExtensionProcessHost
 
   // Message Handlers.
   void OnRenderChannelCreated(const IPC::ChannelHandle& channel_id);
+  void OnRenderChannelCreatedForRenderProcess(
+      int render_process_id, const IPC::ChannelHandle& channel_id);
 
-  void ReplyChannelHandleToRenderProcess();
+  void ReplyChannelHandleToRenderProcess(RenderProcessData* data);
 
   void OnCheckAPIAccessControl(const std::string& extension_name,
       const std::string& api_name, IPC::Message* reply_msg);
@@ -85,22 +156,31 @@ class XWalkExtensionProcessHost
   void OnRegisterPermissions(const std::string& extension_name,
       const std::string& perm_table, bool* result);
 
+  // Has the delegate send the decisions for the APIs just registered by
+  // |extension_name|, usually before they are checked.
+  void RequestPermissionDecisions(int render_process_id,
+                                  const std::string& extension_name);
+
+  void OnCheckAPIAccessControlForRenderProcess(int render_process_id,
+      const std::string& extension_name, const std::string& api_name,
+      IPC::Message* reply_msg);
+  void ReplySharedAccessControlToExtension(IPC::Message* reply_msg,
+      RuntimePermission perm);
+  void OnRegisterPermissionsForRenderProcess(int render_process_id,
+      const std::string& extension_name, const std::string& perm_table,
+      bool* result);
+
   scoped_ptr<content::BrowserChildProcessHost> process_;
-  IPC::ChannelHandle ep_rp_channel_handle_;
+
+  // The render process of a dedicated extension process, NULL if shared.
   content::RenderProcessHost* render_process_host_;
-  scoped_ptr<IPC::Message> pending_reply_for_render_process_;
 
-  // We use this filter to know when RP asked for the extension process channel.
-  // We keep the reference to invalidate the filter once we don't need it
-  // anymore.
-  //
-  // TODO(cmarcelo): Avoid having an extra filter, see if we can embed this
-  // handling in the existing filter we have in ExtensionData struct.
-  scoped_refptr<RenderProcessMessageFilter> render_process_message_filter_;
+  bool is_shared_;
 
-  base::FilePath external_extensions_path_;
+  typedef std::map<int, RenderProcessData*> RenderProcessDataMap;
+  RenderProcessDataMap render_processes_;
 
-  bool is_extension_process_channel_ready_;
+  base::FilePath external_extensions_path_;
 
   XWalkExtensionProcessHost::Delegate* delegate_;
 
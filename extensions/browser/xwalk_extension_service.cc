@@ -4,13 +4,17 @@
 
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 #include "base/callback.h"
 #include "base/command_line.h"
 #include "base/pickle.h"
 #include "base/scoped_native_library.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
 #include "base/synchronization/lock.h"
+#include "base/sys_info.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_types.h"
 #include "content/public/browser/notification_service.h"
@@ -19,9 +23,11 @@
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_direct_channel.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
 
 using content::BrowserThread;
 
@@ -46,8 +52,14 @@ base::FilePath g_external_extensions_path_for_testing_;
 //
 // In the case of in process extensions, we will pass the task runner of the
 // extension thread.
-class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
-                                     public IPC::Sender {
+//
+// In single process mode the filter is also the server side of the direct
+// channel, and routes the messages received through it the same way, in the
+// thread of the client.
+class ExtensionServerMessageFilter
+    : public IPC::ChannelProxy::MessageFilter,
+      public IPC::Sender,
+      public XWalkExtensionDirectChannel::Listener {
  public:
   ExtensionServerMessageFilter(
       scoped_refptr<base::SequencedTaskRunner> task_runner,
@@ -56,7 +68,13 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
       : sender_(NULL),
         task_runner_(task_runner),
         extension_thread_server_(extension_thread_server),
-        ui_thread_server_(ui_thread_server) {}
+        ui_thread_server_(ui_thread_server),
+        direct_channel_token_(0) {}
+
+  void set_direct_channel_token(int token) {
+    base::AutoLock l(lock_);
+    direct_channel_token_ = token;
+  }
 
   // Tells the filter to stop dispatching messages to the server.
   void Invalidate() {
@@ -95,23 +113,26 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
     return instance_id;
   }
 
+  // Returns the server of the instance |id| and the task runner of its
+  // thread.
+  XWalkExtensionServer* GetServerForInstance(
+      int64_t id, scoped_refptr<base::TaskRunner>* task_runner) {
+    if (ContainsKey(extension_thread_instances_ids_, id)) {
+      *task_runner = task_runner_;
+      return extension_thread_server_;
+    }
+
+    *task_runner =
+        BrowserThread::GetMessageLoopProxyForThread(BrowserThread::UI);
+    return ui_thread_server_;
+  }
+
   void RouteMessageToServer(const IPC::Message& message) {
     int64_t id = GetInstanceIDFromMessage(message);
     DCHECK_NE(id, -1);
 
-    XWalkExtensionServer* server;
-    base::TaskRunner* task_runner;
-    scoped_refptr<base::TaskRunner> task_runner_ref;
-
-    if (ContainsKey(extension_thread_instances_ids_, id)) {
-      server = extension_thread_server_;
-      task_runner = task_runner_;
-    } else {
-      server = ui_thread_server_;
-      task_runner_ref =
-          BrowserThread::GetMessageLoopProxyForThread(BrowserThread::UI);
-      task_runner = task_runner_ref.get();
-    }
+    scoped_refptr<base::TaskRunner> task_runner;
+    XWalkExtensionServer* server = GetServerForInstance(id, &task_runner);
 
     base::Closure closure = base::Bind(
         base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
@@ -149,6 +170,20 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
     ui_thread_server_->OnGetExtensions(reply);
   }
 
+  void OnGetDirectChannel(int* token) {
+    *token = direct_channel_token_;
+  }
+
+  XWalkExtensionServer* GetServerForExtension(const std::string& name) {
+    if (extension_thread_server_->ContainsExtension(name))
+      return extension_thread_server_;
+    return ui_thread_server_;
+  }
+
+  void OnGetExtensionAPI(const std::string& name, std::string* js_api) {
+    GetServerForExtension(name)->OnGetExtensionAPI(name, js_api);
+  }
+
   // IPC::ChannelProxy::MessageFilter implementation.
   virtual void OnFilterAdded(IPC::Channel* channel) OVERRIDE {
     sender_ = channel;
@@ -181,6 +216,10 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
                           OnCreateInstance)
       IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensions,
                           OnGetExtensions)
+      IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensionAPI,
+                          OnGetExtensionAPI)
+      IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetDirectChannel,
+                          OnGetDirectChannel)
       IPC_MESSAGE_UNHANDLED(handled = false)
     IPC_END_MESSAGE_MAP()
 
@@ -190,6 +229,27 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
     return true;
   }
 
+  // XWalkExtensionDirectChannel::Listener implementation.
+  virtual void OnDirectMessage(const IPC::Message& message) OVERRIDE {
+    OnMessageReceived(message);
+  }
+
+  virtual void OnDirectPostMessages(
+      int64_t instance_id, scoped_ptr<base::ListValue> msgs) OVERRIDE {
+    base::AutoLock l(lock_);
+
+    if (!extension_thread_server_ || !ui_thread_server_)
+      return;
+
+    scoped_refptr<base::TaskRunner> task_runner;
+    XWalkExtensionServer* server =
+        GetServerForInstance(instance_id, &task_runner);
+
+    task_runner->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionServer::PostMessagesToNative,
+                   server->AsWeakPtr(), instance_id, base::Passed(&msgs)));
+  }
+
   // This lock is used to protect access to filter members.
   base::Lock lock_;
 
@@ -198,8 +258,37 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter,
   XWalkExtensionServer* extension_thread_server_;
   XWalkExtensionServer* ui_thread_server_;
   std::set<int64_t> extension_thread_instances_ids_;
+  int direct_channel_token_;
 };
 
+namespace {
+
+// Sends the messages of the in-process servers through the direct channel
+// once the client is connected to it. The replies to sync messages always
+// take the IPC channel, where the client is blocked waiting for them.
+class DirectChannelSender : public IPC::Sender {
+ public:
+  DirectChannelSender(XWalkExtensionDirectChannel* channel,
+                      IPC::Sender* ipc_sender)
+      : channel_(channel),
+        ipc_sender_(ipc_sender) {}
+
+  virtual bool Send(IPC::Message* msg) OVERRIDE {
+    if (!msg->is_reply() &&
+        channel_->Send(XWalkExtensionDirectChannel::SERVER_SIDE, msg))
+      return true;
+    return ipc_sender_->Send(msg);
+  }
+
+ private:
+  scoped_refptr<XWalkExtensionDirectChannel> channel_;
+  IPC::Sender* ipc_sender_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirectChannelSender);
+};
+
+}  // namespace
+
 bool XWalkExtensionService::Delegate::RegisterPermissions(
     int render_process_id,
     const std::string& extension_name,
@@ -208,16 +297,29 @@ bool XWalkExtensionService::Delegate::RegisterPermissions(
 }
 
 XWalkExtensionService::XWalkExtensionService(Delegate* delegate)
-    : extension_thread_("XWalkExtensionThread"),
-      delegate_(delegate) {
+    : delegate_(delegate),
+      extension_process_pool_size_(0),
+      prelaunched_extension_process_host_(NULL) {
   if (!g_external_extensions_path_for_testing_.empty())
     external_extensions_path_ = g_external_extensions_path_for_testing_;
+
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(switches::kXWalkExtensionProcessPool)) {
+    int pool_size;
+    std::string value =
+        cmd_line->GetSwitchValueASCII(switches::kXWalkExtensionProcessPool);
+    if (!base::StringToInt(value, &pool_size) || pool_size < 1)
+      pool_size = 1;
+    extension_process_pool_size_ = pool_size;
+  }
+
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_TERMINATED,
                  content::NotificationService::AllBrowserContextsAndSources());
 
-  // IO main loop is needed by extensions watching file descriptors events.
-  base::Thread::Options options(base::MessageLoop::TYPE_IO, 0);
-  extension_thread_.StartWithOptions(options);
+  StartExtensionThreads();
+
+  if (!external_extensions_path_.empty())
+    PrelaunchExtensionProcesses();
 }
 
 XWalkExtensionService::~XWalkExtensionService() {
@@ -225,11 +327,126 @@ XWalkExtensionService::~XWalkExtensionService() {
   // extension thread.
   if (!extension_data_map_.empty())
     VLOG(1) << "The ExtensionData map is not empty!";
+
+  std::vector<XWalkExtensionProcessHost*>::iterator it =
+      extension_process_pool_.begin();
+  for (; it != extension_process_pool_.end(); ++it)
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE, *it);
+  for (it = retired_extension_process_hosts_.begin();
+       it != retired_extension_process_hosts_.end(); ++it)
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE, *it);
+
+  if (prelaunched_extension_process_host_) {
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                              prelaunched_extension_process_host_);
+  }
+}
+
+void XWalkExtensionService::StartExtensionThreads() {
+  int pool_size = 1;
+
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(switches::kXWalkExtensionThreadPool)) {
+    std::string value =
+        cmd_line->GetSwitchValueASCII(switches::kXWalkExtensionThreadPool);
+    if (!base::StringToInt(value, &pool_size) || pool_size < 1)
+      pool_size = base::SysInfo::NumberOfProcessors();
+  }
+
+  // IO main loop is needed by extensions watching file descriptors events.
+  base::Thread::Options options(base::MessageLoop::TYPE_IO, 0);
+  for (int i = 0; i < pool_size; ++i) {
+    std::string name = "XWalkExtensionThread";
+    if (pool_size > 1)
+      name += base::StringPrintf("_%d", i);
+    base::Thread* thread = new base::Thread(name);
+    thread->StartWithOptions(options);
+    extension_threads_.push_back(thread);
+  }
+}
+
+base::Thread* XWalkExtensionService::GetExtensionThreadForNewServer() {
+  if (extension_threads_.size() == 1)
+    return extension_threads_[0];
+
+  std::map<base::Thread*, int> servers_per_thread;
+  RenderProcessToExtensionDataMap::const_iterator it =
+      extension_data_map_.begin();
+  for (; it != extension_data_map_.end(); ++it)
+    servers_per_thread[it->second->extension_thread()]++;
+
+  base::Thread* thread = extension_threads_[0];
+  for (size_t i = 1; i < extension_threads_.size(); ++i) {
+    if (servers_per_thread[extension_threads_[i]] <
+        servers_per_thread[thread])
+      thread = extension_threads_[i];
+  }
+  return thread;
 }
 
 void XWalkExtensionService::RegisterExternalExtensionsForPath(
     const base::FilePath& path) {
+  if (path == external_extensions_path_)
+    return;
   external_extensions_path_ = path;
+
+  // The processes launched until now loaded the extensions of another path,
+  // they must not be handed to new render processes.
+  if (prelaunched_extension_process_host_) {
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                              prelaunched_extension_process_host_);
+    prelaunched_extension_process_host_ = NULL;
+  }
+
+  // The shared processes keep serving their render processes, and are
+  // deleted with the last of them.
+  std::map<XWalkExtensionProcessHost*, int> render_processes_per_host =
+      CountRenderProcessesPerSharedHost();
+  std::vector<XWalkExtensionProcessHost*>::iterator it =
+      extension_process_pool_.begin();
+  for (; it != extension_process_pool_.end(); ++it) {
+    if (render_processes_per_host[*it])
+      retired_extension_process_hosts_.push_back(*it);
+    else
+      BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE, *it);
+  }
+  extension_process_pool_.clear();
+
+  PrelaunchExtensionProcesses();
+}
+
+void XWalkExtensionService::PrelaunchExtensionProcesses() {
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  if (!cmd_line->HasSwitch(switches::kXWalkPrelaunchExtensionProcess) ||
+      cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess))
+    return;
+
+  if (extension_process_pool_size_) {
+    while (extension_process_pool_.size() < extension_process_pool_size_) {
+      extension_process_pool_.push_back(
+          new XWalkExtensionProcessHost(external_extensions_path_, this));
+    }
+    return;
+  }
+
+  // In service mode the extension process of an application is provided by
+  // its launcher.
+  if (cmd_line->HasSwitch(switches::kXWalkRunAsService))
+    return;
+
+  if (!prelaunched_extension_process_host_) {
+    prelaunched_extension_process_host_ =
+        new XWalkExtensionProcessHost(external_extensions_path_, this);
+  }
+}
+
+XWalkExtensionProcessHost*
+XWalkExtensionService::TakePrelaunchedExtensionProcessHost() {
+  XWalkExtensionProcessHost* eph = prelaunched_extension_process_host_;
+  prelaunched_extension_process_host_ = NULL;
+  if (eph)
+    PrelaunchExtensionProcesses();
+  return eph;
 }
 
 void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
@@ -319,6 +536,7 @@ void XWalkExtensionService::OnRenderProcessHostClosed(
     return;
 
   XWalkExtensionData* data = it->second;
+  XWalkExtensionProcessHost* shared_eph = data->shared_extension_process_host();
 
   // Invalidate the objects in the different threads so they stop posting
   // messages to each other. This is important because we'll schedule the
@@ -329,11 +547,22 @@ void XWalkExtensionService::OnRenderProcessHostClosed(
 
   message_filter->Invalidate();
 
+  // The filter is the server side of the direct channel. The channel is
+  // unpublished in case the renderer went away before taking it.
+  if (data->direct_channel()) {
+    data->direct_channel()->Disconnect(
+        XWalkExtensionDirectChannel::SERVER_SIDE);
+    XWalkExtensionDirectChannel::Unpublish(data->direct_channel_token());
+  }
+
   // This will cause the filter to be deleted in the IO-thread.
   host->GetChannel()->RemoveFilter(message_filter);
 
   extension_data_map_.erase(it);
   delete data;
+
+  if (shared_eph)
+    DeleteRetiredExtensionProcessHostIfUnused(shared_eph);
 }
 
 namespace {
@@ -364,9 +593,23 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
       new XWalkExtensionServer);
 
   IPC::ChannelProxy* channel = host->GetChannel();
+  IPC::Sender* sender = channel;
+
+  // The renderer lives in the browser process in single process mode.
+  scoped_refptr<XWalkExtensionDirectChannel> direct_channel;
+  if (content::RenderProcessHost::run_renderer_in_process()) {
+    direct_channel = new XWalkExtensionDirectChannel;
+    scoped_ptr<IPC::Sender> direct_sender(
+        new DirectChannelSender(direct_channel.get(), channel));
+    sender = direct_sender.get();
+    data->set_direct_channel_sender(direct_sender.Pass());
+
+    extension_thread_server->SetDirectChannel(direct_channel.get());
+    ui_thread_server->SetDirectChannel(direct_channel.get());
+  }
 
-  extension_thread_server->Initialize(channel);
-  ui_thread_server->Initialize(channel);
+  extension_thread_server->Initialize(sender);
+  ui_thread_server->Initialize(sender);
 
   RegisterExtensionsIntoServer(extension_thread_extensions,
                                extension_thread_server.get());
@@ -384,8 +627,10 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
     RegisterExtensionsIntoServer(&extensions, extension_thread_server.get());
   }
 
+  base::Thread* extension_thread = GetExtensionThreadForNewServer();
+
   ExtensionServerMessageFilter* message_filter =
-      new ExtensionServerMessageFilter(extension_thread_.message_loop_proxy(),
+      new ExtensionServerMessageFilter(extension_thread->message_loop_proxy(),
                                        extension_thread_server.get(),
                                        ui_thread_server.get());
 
@@ -394,20 +639,90 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
   data->set_in_process_message_filter(message_filter);
   channel->AddFilter(message_filter);
 
+  if (direct_channel) {
+    direct_channel->Connect(XWalkExtensionDirectChannel::SERVER_SIDE,
+                            message_filter, NULL);
+    int token = XWalkExtensionDirectChannel::Publish(direct_channel.get());
+    message_filter->set_direct_channel_token(token);
+    data->set_direct_channel(direct_channel.get(), token);
+  }
+
   data->set_in_process_extension_thread_server(extension_thread_server.Pass());
   data->set_in_process_ui_thread_server(ui_thread_server.Pass());
 
-  data->set_extension_thread(&extension_thread_);
+  data->set_extension_thread(extension_thread);
 }
 
 void XWalkExtensionService::CreateExtensionProcessHost(
     content::RenderProcessHost* host, XWalkExtensionData* data,
     const base::ValueMap& runtime_variables) {
+  if (extension_process_pool_size_) {
+    XWalkExtensionProcessHost* eph = GetSharedExtensionProcessHost();
+    eph->AddRenderProcess(host, runtime_variables);
+    data->set_shared_extension_process_host(eph);
+    return;
+  }
+
+  // The prelaunched process already loaded the extensions, it only has to
+  // create the channel to this render process.
+  XWalkExtensionProcessHost* eph = TakePrelaunchedExtensionProcessHost();
+  if (eph) {
+    eph->AddRenderProcess(host, runtime_variables);
+    data->set_extension_process_host(make_scoped_ptr(eph));
+    return;
+  }
+
   data->set_extension_process_host(make_scoped_ptr(
       new XWalkExtensionProcessHost(host, external_extensions_path_, this,
                                     runtime_variables)));
 }
 
+XWalkExtensionProcessHost*
+XWalkExtensionService::GetSharedExtensionProcessHost() {
+  if (extension_process_pool_.size() < extension_process_pool_size_) {
+    XWalkExtensionProcessHost* eph =
+        new XWalkExtensionProcessHost(external_extensions_path_, this);
+    extension_process_pool_.push_back(eph);
+    return eph;
+  }
+
+  std::map<XWalkExtensionProcessHost*, int> render_processes_per_host =
+      CountRenderProcessesPerSharedHost();
+  XWalkExtensionProcessHost* eph = extension_process_pool_[0];
+  for (size_t i = 1; i < extension_process_pool_.size(); ++i) {
+    if (render_processes_per_host[extension_process_pool_[i]] <
+        render_processes_per_host[eph])
+      eph = extension_process_pool_[i];
+  }
+  return eph;
+}
+
+std::map<XWalkExtensionProcessHost*, int>
+XWalkExtensionService::CountRenderProcessesPerSharedHost() const {
+  std::map<XWalkExtensionProcessHost*, int> render_processes_per_host;
+  RenderProcessToExtensionDataMap::const_iterator it =
+      extension_data_map_.begin();
+  for (; it != extension_data_map_.end(); ++it) {
+    if (it->second->shared_extension_process_host())
+      render_processes_per_host[it->second->shared_extension_process_host()]++;
+  }
+  return render_processes_per_host;
+}
+
+void XWalkExtensionService::DeleteRetiredExtensionProcessHostIfUnused(
+    XWalkExtensionProcessHost* eph) {
+  std::vector<XWalkExtensionProcessHost*>::iterator it = std::find(
+      retired_extension_process_hosts_.begin(),
+      retired_extension_process_hosts_.end(), eph);
+  if (it == retired_extension_process_hosts_.end() ||
+      CountRenderProcessesPerSharedHost()[eph])
+    return;
+
+  retired_extension_process_hosts_.erase(it);
+  // Runs after the removal of its last render process, posted before.
+  BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE, eph);
+}
+
 void XWalkExtensionService::OnExtensionProcessDied(
     XWalkExtensionProcessHost* eph, int render_process_id) {
   // When this is called it means that XWalkExtensionProcessHost is about
@@ -427,6 +742,50 @@ void XWalkExtensionService::OnExtensionProcessDied(
       data->extension_process_host().release();
   CHECK_EQ(stored_eph, eph);
 
+  ShutdownRenderProcessWithoutExtensions(it);
+}
+
+void XWalkExtensionService::OnSharedExtensionProcessDied(
+    XWalkExtensionProcessHost* eph,
+    const std::vector<int>& render_process_ids) {
+  // Like above, |eph| is about to be deleted. All the render processes it
+  // served lost their extensions.
+  std::vector<XWalkExtensionProcessHost*>::iterator pool_it = std::find(
+      extension_process_pool_.begin(), extension_process_pool_.end(), eph);
+  if (pool_it != extension_process_pool_.end())
+    extension_process_pool_.erase(pool_it);
+  pool_it = std::find(retired_extension_process_hosts_.begin(),
+                      retired_extension_process_hosts_.end(), eph);
+  if (pool_it != retired_extension_process_hosts_.end())
+    retired_extension_process_hosts_.erase(pool_it);
+  if (prelaunched_extension_process_host_ == eph)
+    prelaunched_extension_process_host_ = NULL;
+
+  std::vector<int>::const_iterator id_it = render_process_ids.begin();
+  for (; id_it != render_process_ids.end(); ++id_it) {
+    RenderProcessToExtensionDataMap::iterator it =
+        extension_data_map_.find(*id_it);
+    if (it == extension_data_map_.end())
+      continue;
+
+    // A prelaunched process is owned by the render process it was handed to.
+    XWalkExtensionData* data = it->second;
+    if (data->shared_extension_process_host() == eph) {
+      data->set_shared_extension_process_host(NULL);
+    } else {
+      XWalkExtensionProcessHost* stored_eph =
+          data->extension_process_host().release();
+      CHECK_EQ(stored_eph, eph);
+    }
+
+    ShutdownRenderProcessWithoutExtensions(it);
+  }
+}
+
+void XWalkExtensionService::ShutdownRenderProcessWithoutExtensions(
+    RenderProcessToExtensionDataMap::iterator it) {
+  XWalkExtensionData* data = it->second;
+
   content::RenderProcessHost* rph = data->render_process_host();
   if (rph) {
     BrowserThread::PostTask(BrowserThread::UI, FROM_HERE, base::Bind(
@@ -447,9 +806,35 @@ void XWalkExtensionService::OnRenderProcessDied(
     return;
 
   XWalkExtensionData* data = it->second;
+  XWalkExtensionProcessHost* shared_eph = data->shared_extension_process_host();
 
   extension_data_map_.erase(it);
   delete data;
+
+  if (shared_eph)
+    DeleteRetiredExtensionProcessHostIfUnused(shared_eph);
+}
+
+void XWalkExtensionService::OnPermissionsChanged(int render_process_id) {
+  CHECK(delegate_);
+  RenderProcessToExtensionDataMap::iterator it =
+      extension_data_map_.find(render_process_id);
+  if (it == extension_data_map_.end())
+    return;
+
+  XWalkExtensionProcessHost* eph =
+      it->second->serving_extension_process_host();
+  if (!eph)
+    return;
+
+  PermissionDecisions decisions;
+  delegate_->GetPermissionDecisions(render_process_id, std::string(),
+                                    &decisions);
+
+  // Hosts are only deleted in the IO thread, after this task.
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::UpdatePermissions,
+                 base::Unretained(eph), render_process_id, decisions));
 }
 
 void XWalkExtensionService::OnExtensionProcessCreated(
@@ -478,5 +863,30 @@ bool XWalkExtensionService::OnRegisterPermissions(
                                         extension_name, perm_table);
 }
 
+void XWalkExtensionService::OnPermissionsRegistered(
+    XWalkExtensionProcessHost* eph,
+    int render_process_id,
+    const std::string& extension_name) {
+  CHECK(delegate_);
+  // |eph| may be gone already if it doesn't serve the render process
+  // anymore.
+  RenderProcessToExtensionDataMap::iterator it =
+      extension_data_map_.find(render_process_id);
+  if (it == extension_data_map_.end() ||
+      it->second->serving_extension_process_host() != eph)
+    return;
+
+  PermissionDecisions decisions;
+  delegate_->GetPermissionDecisions(render_process_id, extension_name,
+                                    &decisions);
+  if (decisions.empty())
+    return;
+
+  // Hosts are only deleted in the IO thread, after this task.
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::CachePermissions,
+                 base::Unretained(eph), render_process_id, decisions));
+}
+
 }  // namespace extensions
 }  // namespace xwalk
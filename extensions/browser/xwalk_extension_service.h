@@ -13,6 +13,7 @@
 #include "base/containers/scoped_ptr_hash_map.h"
 #include "base/files/file_path.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/threading/thread.h"
 #include "base/values.h"
 #include "content/public/browser/notification_observer.h"
@@ -48,6 +49,13 @@ class XWalkExtensionService : public content::NotificationObserver,
         int render_process_id,
         const std::string& extension_name,
         const std::string& perm_table);
+    // Fills |decisions| with the session and persistent permissions of the
+    // APIs registered by |extension_name|, or by all the extensions if it's
+    // empty. Called in the UI thread.
+    virtual void GetPermissionDecisions(
+        int render_process_id,
+        const std::string& extension_name,
+        PermissionDecisions* decisions) {}
     virtual void ExtensionProcessCreated(
         int render_process_id,
         const IPC::ChannelHandle& channel_handle) {}
@@ -79,6 +87,11 @@ class XWalkExtensionService : public content::NotificationObserver,
   // XWalkContentBrowserClient::RenderProcessHostGone().
   void OnRenderProcessDied(content::RenderProcessHost* host);
 
+  // To be called in the UI thread when the permissions of the application
+  // running in |render_process_id| change. The decisions cached by its
+  // extension process are replaced by the ones of the delegate.
+  void OnPermissionsChanged(int render_process_id);
+
   typedef base::Callback<void(XWalkExtensionVector* extensions)>
       CreateExtensionsCallback;
 
@@ -100,6 +113,10 @@ class XWalkExtensionService : public content::NotificationObserver,
   virtual void OnExtensionProcessDied(XWalkExtensionProcessHost* eph,
       int render_process_id) OVERRIDE;
 
+  virtual void OnSharedExtensionProcessDied(
+      XWalkExtensionProcessHost* eph,
+      const std::vector<int>& render_process_ids) OVERRIDE;
+
   virtual void OnExtensionProcessCreated(
       int render_process_id,
       const IPC::ChannelHandle handle) OVERRIDE;
@@ -112,6 +129,10 @@ class XWalkExtensionService : public content::NotificationObserver,
   virtual bool OnRegisterPermissions(int render_process_id,
                                      const std::string& extension_name,
                                      const std::string& perm_table) OVERRIDE;
+  virtual void OnPermissionsRegistered(
+      XWalkExtensionProcessHost* eph,
+      int render_process_id,
+      const std::string& extension_name) OVERRIDE;
 
   // NotificationObserver implementation.
   virtual void Observe(int type, const content::NotificationSource& source,
@@ -128,9 +149,40 @@ class XWalkExtensionService : public content::NotificationObserver,
   void CreateExtensionProcessHost(content::RenderProcessHost* host,
       XWalkExtensionData* data, const base::ValueMap& runtime_variables);
 
-  // The server that handles in process extensions will live in the
-  // extension_thread_.
-  base::Thread extension_thread_;
+  // Launches the extension processes ahead of the render processes needing
+  // them, see switches::kXWalkPrelaunchExtensionProcess.
+  void PrelaunchExtensionProcesses();
+
+  // Returns the prelaunched extension process, if any, and launches the next
+  // one.
+  XWalkExtensionProcessHost* TakePrelaunchedExtensionProcessHost();
+
+  // Returns the shared extension process serving the fewest render
+  // processes, starting a new one while the pool isn't full.
+  XWalkExtensionProcessHost* GetSharedExtensionProcessHost();
+
+  std::map<XWalkExtensionProcessHost*, int>
+      CountRenderProcessesPerSharedHost() const;
+
+  // Deletes |eph| if it was retired from the pool and serves no render
+  // process anymore.
+  void DeleteRetiredExtensionProcessHostIfUnused(
+      XWalkExtensionProcessHost* eph);
+
+  // Shuts down the render process of |it|, which lost its extension process.
+  void ShutdownRenderProcessWithoutExtensions(
+      std::map<int, XWalkExtensionData*>::iterator it);
+
+  void StartExtensionThreads();
+
+  // Returns the extension thread serving the fewest render processes.
+  base::Thread* GetExtensionThreadForNewServer();
+
+  // The servers that handle in process extensions will live in one of the
+  // extension_threads_. There's only one thread unless the
+  // kXWalkExtensionThreadPool switch is used. Each server stays in the same
+  // thread for its whole life, so the extensions run sequentially.
+  ScopedVector<base::Thread> extension_threads_;
 
   content::NotificationRegistrar registrar_;
 
@@ -138,6 +190,19 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   base::FilePath external_extensions_path_;
 
+  // Shared extension processes, used with kXWalkExtensionProcessPool instead
+  // of one extension process per render process. They live in the IO thread.
+  size_t extension_process_pool_size_;
+  std::vector<XWalkExtensionProcessHost*> extension_process_pool_;
+
+  // Shared extension processes loaded from a previous external extensions
+  // path. They only serve their remaining render processes.
+  std::vector<XWalkExtensionProcessHost*> retired_extension_process_hosts_;
+
+  // A shared extension process serving no render process yet, handed to the
+  // next render process when not using the pool. Lives in the IO thread.
+  XWalkExtensionProcessHost* prelaunched_extension_process_host_;
+
   typedef std::map<int, XWalkExtensionData*> RenderProcessToExtensionDataMap;
   RenderProcessToExtensionDataMap extension_data_map_;
 
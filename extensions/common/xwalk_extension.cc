@@ -52,11 +52,44 @@ void XWalkExtensionInstance::SetPostMessageCallback(
   post_message_ = callback;
 }
 
+void XWalkExtensionInstance::SetPostBinaryMessageCallback(
+    const PostBinaryMessageCallback& callback) {
+  post_binary_message_ = callback;
+}
+
+void XWalkExtensionInstance::PostBinaryMessageToJS(const char* data,
+                                                   size_t size) {
+  if (post_binary_message_.is_null()) {
+    PostMessageToJS(scoped_ptr<base::Value>(
+        base::BinaryValue::CreateWithCopiedBuffer(data, size)));
+    return;
+  }
+  post_binary_message_.Run(data, size);
+}
+
 void XWalkExtensionInstance::SetSendSyncReplyCallback(
     const SendSyncReplyCallback& callback) {
   send_sync_reply_ = callback;
 }
 
+void XWalkExtensionInstance::SetSendAsyncReplyCallback(
+    const SendAsyncReplyCallback& callback) {
+  send_async_reply_ = callback;
+}
+
+void XWalkExtensionInstance::HandleAsyncRequest(
+    int request_id, scoped_ptr<base::Value> msg) {
+  LOG(WARNING) << "Sending async request to extension which doesn't support "
+               << "it, rejecting.";
+  SendAsyncReplyToJS(request_id, scoped_ptr<base::Value>());
+}
+
+void XWalkExtensionInstance::HandleBinaryMessage(const char* data,
+                                                 size_t size) {
+  HandleMessage(scoped_ptr<base::Value>(
+      base::BinaryValue::CreateWithCopiedBuffer(data, size)));
+}
+
 void XWalkExtensionInstance::HandleSyncMessage(
     scoped_ptr<base::Value> msg) {
   LOG(FATAL) << "Sending sync message to extension which doesn't support it!";
@@ -111,15 +111,35 @@ class XWalkExtensionInstance {
   // can be sent after HandleSyncMessage() function returns.
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg);
 
+  // Allow to handle asynchronous requests sent from JavaScript code with
+  // extension.sendAsyncRequest(), which returns a Promise. The reply is sent
+  // by calling SendAsyncReplyToJS() with the same |request_id|, from any
+  // thread, during or after this call. Many requests can be pending at the
+  // same time and they can be replied in any order. The default
+  // implementation rejects the request.
+  virtual void HandleAsyncRequest(int request_id,
+                                  scoped_ptr<base::Value> msg);
+
+  // Allow to handle messages posted with an ArrayBuffer or ArrayBufferView
+  // from JavaScript. |data| is only valid during the call. The default
+  // implementation copies it to a base::BinaryValue passed to HandleMessage().
+  virtual void HandleBinaryMessage(const char* data, size_t size);
+
   // Callbacks used by extension instance to communicate back to JS. These are
   // set by the extension system. Callbacks will take the ownership of the
   // message.
   typedef base::Callback<void(scoped_ptr<base::Value> msg)> PostMessageCallback;
   typedef base::Callback<void(scoped_ptr<base::Value> msg)>
       SendSyncReplyCallback;
+  typedef base::Callback<void(int request_id, scoped_ptr<base::Value> reply)>
+      SendAsyncReplyCallback;
+  typedef base::Callback<void(const char* data, size_t size)>
+      PostBinaryMessageCallback;
 
   void SetPostMessageCallback(const PostMessageCallback& callback);
+  void SetPostBinaryMessageCallback(const PostBinaryMessageCallback& callback);
   void SetSendSyncReplyCallback(const SendSyncReplyCallback& callback);
+  void SetSendAsyncReplyCallback(const SendAsyncReplyCallback& callback);
 
   // Function to be used by extensions Instances to post messages back to
   // JavaScript in the renderer process. This function will take the ownership
@@ -128,6 +148,10 @@ class XWalkExtensionInstance {
     post_message_.Run(msg.Pass());
   }
 
+  // Posts |size| bytes starting at |data|, received as an ArrayBuffer by
+  // JavaScript. The data is copied before this returns.
+  void PostBinaryMessageToJS(const char* data, size_t size);
+
  protected:
   XWalkExtensionInstance();
 
@@ -136,9 +160,17 @@ class XWalkExtensionInstance {
     send_sync_reply_.Run(reply.Pass());
   }
 
+  // Settles the Promise of the request |request_id|. A NULL |reply| rejects
+  // the Promise, otherwise it is resolved with the |reply| value.
+  void SendAsyncReplyToJS(int request_id, scoped_ptr<base::Value> reply) {
+    send_async_reply_.Run(request_id, reply.Pass());
+  }
+
  private:
   PostMessageCallback post_message_;
+  PostBinaryMessageCallback post_binary_message_;
   SendSyncReplyCallback send_sync_reply_;
+  SendAsyncReplyCallback send_async_reply_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionInstance);
 };
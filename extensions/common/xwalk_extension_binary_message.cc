@@ -0,0 +1,34 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+
+#include "ipc/ipc_message.h"
+
+namespace xwalk {
+namespace extensions {
+
+// The layout is the same as the one of a message with (int64_t, std::string)
+// parameters, Pickle::WriteData() writes the length followed by the bytes.
+IPC::Message* CreateBinaryMessage(uint32 type, int64_t instance_id,
+                                  const char* data, size_t size) {
+  IPC::Message* message = new IPC::Message(
+      MSG_ROUTING_CONTROL, type, IPC::Message::PRIORITY_NORMAL);
+  message->WriteInt64(instance_id);
+  message->WriteData(data, static_cast<int>(size));
+  return message;
+}
+
+bool ReadBinaryMessage(const IPC::Message& message, int64_t* instance_id,
+                       const char** data, size_t* size) {
+  PickleIterator iter(message);
+  int length;
+  if (!iter.ReadInt64(instance_id) || !iter.ReadData(data, &length))
+    return false;
+  *size = length;
+  return true;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
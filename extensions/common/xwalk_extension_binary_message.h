@@ -0,0 +1,35 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/basictypes.h"
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Binary messages carry the bytes of an ArrayBuffer right after the instance
+// id, instead of a base::BinaryValue wrapped in a base::ListValue. They are
+// written straight from the sender's buffer and read in place, so the data is
+// copied once on each side of the channel. |type| is the id of one of the
+// binary messages declared in xwalk_extension_messages.h.
+IPC::Message* CreateBinaryMessage(uint32 type, int64_t instance_id,
+                                  const char* data, size_t size);
+
+// |data| points inside |message|, it is only valid during its lifetime.
+bool ReadBinaryMessage(const IPC::Message& message, int64_t* instance_id,
+                       const char** data, size_t* size);
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
@@ -0,0 +1,193 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_direct_channel.h"
+
+#include <map>
+
+#include "base/bind.h"
+#include "base/lazy_instance.h"
+#include "base/location.h"
+#include "base/single_thread_task_runner.h"
+#include "ipc/ipc_message.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+class PublishedChannels {
+ public:
+  PublishedChannels() : next_token_(1) {}
+
+  int Add(XWalkExtensionDirectChannel* channel) {
+    base::AutoLock l(lock_);
+    int token = next_token_++;
+    channels_[token] = channel;
+    return token;
+  }
+
+  scoped_refptr<XWalkExtensionDirectChannel> Take(int token) {
+    base::AutoLock l(lock_);
+    ChannelMap::iterator it = channels_.find(token);
+    if (it == channels_.end())
+      return NULL;
+
+    scoped_refptr<XWalkExtensionDirectChannel> channel = it->second;
+    channels_.erase(it);
+    return channel;
+  }
+
+  void Remove(int token) {
+    base::AutoLock l(lock_);
+    channels_.erase(token);
+  }
+
+ private:
+  base::Lock lock_;
+  int next_token_;
+
+  typedef std::map<int, scoped_refptr<XWalkExtensionDirectChannel> >
+      ChannelMap;
+  ChannelMap channels_;
+};
+
+base::LazyInstance<PublishedChannels> g_published_channels =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+XWalkExtensionDirectChannel::End::End()
+    : listener(NULL),
+      pending_calls(0) {}
+
+XWalkExtensionDirectChannel::End::~End() {}
+
+XWalkExtensionDirectChannel::XWalkExtensionDirectChannel()
+    : calls_done_(&lock_) {}
+
+XWalkExtensionDirectChannel::~XWalkExtensionDirectChannel() {}
+
+// static
+int XWalkExtensionDirectChannel::Publish(
+    XWalkExtensionDirectChannel* channel) {
+  return g_published_channels.Get().Add(channel);
+}
+
+// static
+scoped_refptr<XWalkExtensionDirectChannel> XWalkExtensionDirectChannel::Take(
+    int token) {
+  return g_published_channels.Get().Take(token);
+}
+
+// static
+void XWalkExtensionDirectChannel::Unpublish(int token) {
+  g_published_channels.Get().Remove(token);
+}
+
+void XWalkExtensionDirectChannel::Connect(
+    Side side, Listener* listener,
+    const scoped_refptr<base::SingleThreadTaskRunner>& task_runner) {
+  base::AutoLock l(lock_);
+  ends_[side].listener = listener;
+  ends_[side].task_runner = task_runner;
+}
+
+void XWalkExtensionDirectChannel::Disconnect(Side side) {
+  base::AutoLock l(lock_);
+  ends_[side].listener = NULL;
+  ends_[side].task_runner = NULL;
+
+  // The listener may still be called from the sending threads.
+  while (ends_[side].pending_calls > 0)
+    calls_done_.Wait();
+}
+
+bool XWalkExtensionDirectChannel::IsConnected(Side side) {
+  base::AutoLock l(lock_);
+  return ends_[side].listener != NULL;
+}
+
+bool XWalkExtensionDirectChannel::Send(Side from, IPC::Message* message) {
+  Side to = OtherSide(from);
+  scoped_ptr<IPC::Message> owned_message;
+  Listener* listener;
+  {
+    base::AutoLock l(lock_);
+    End& end = ends_[to];
+    if (!end.listener)
+      return false;
+
+    owned_message.reset(message);
+    if (end.task_runner) {
+      end.task_runner->PostTask(FROM_HERE,
+          base::Bind(&XWalkExtensionDirectChannel::DeliverMessage, this, to,
+                     base::Passed(&owned_message)));
+      return true;
+    }
+
+    listener = end.listener;
+    ++end.pending_calls;
+  }
+
+  // Called without the lock, the listener may send messages back.
+  listener->OnDirectMessage(*owned_message);
+  FinishCall(to);
+  return true;
+}
+
+bool XWalkExtensionDirectChannel::PostMessages(
+    Side from, int64_t instance_id, scoped_ptr<base::ListValue>* msgs) {
+  Side to = OtherSide(from);
+  Listener* listener;
+  {
+    base::AutoLock l(lock_);
+    End& end = ends_[to];
+    if (!end.listener)
+      return false;
+
+    if (end.task_runner) {
+      end.task_runner->PostTask(FROM_HERE,
+          base::Bind(&XWalkExtensionDirectChannel::DeliverPostMessages, this,
+                     to, instance_id, base::Passed(msgs)));
+      return true;
+    }
+
+    listener = end.listener;
+    ++end.pending_calls;
+  }
+
+  listener->OnDirectPostMessages(instance_id, msgs->Pass());
+  FinishCall(to);
+  return true;
+}
+
+void XWalkExtensionDirectChannel::FinishCall(Side side) {
+  base::AutoLock l(lock_);
+  if (--ends_[side].pending_calls == 0)
+    calls_done_.Broadcast();
+}
+
+void XWalkExtensionDirectChannel::DeliverMessage(
+    Side to, scoped_ptr<IPC::Message> message) {
+  Listener* listener = GetListener(to);
+  if (listener)
+    listener->OnDirectMessage(*message);
+}
+
+void XWalkExtensionDirectChannel::DeliverPostMessages(
+    Side to, int64_t instance_id, scoped_ptr<base::ListValue> msgs) {
+  Listener* listener = GetListener(to);
+  if (listener)
+    listener->OnDirectPostMessages(instance_id, msgs.Pass());
+}
+
+XWalkExtensionDirectChannel::Listener* XWalkExtensionDirectChannel::GetListener(
+    Side side) {
+  base::AutoLock l(lock_);
+  return ends_[side].listener;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
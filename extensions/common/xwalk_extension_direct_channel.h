@@ -0,0 +1,130 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_DIRECT_CHANNEL_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_DIRECT_CHANNEL_H_
+
+#include <stdint.h>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/values.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Passes the messages between a XWalkExtensionClient and the in-process
+// XWalkExtensionServers when both live in the same process, which is the
+// case in single process mode. The messages don't go through the IPC
+// channel, and the messages posted to the instances are moved as they are,
+// without being serialized.
+//
+// Only asynchronous messages can take this channel. The sync messages, and
+// their replies, keep using IPC so the client can block on them. Since this
+// channel is never slower than IPC, a sync message can't overtake the
+// asynchronous ones sent before it.
+//
+// The server side creates the channel and publishes it; the client finds it
+// with the token of the publication, which it asks the server for.
+class XWalkExtensionDirectChannel
+    : public base::RefCountedThreadSafe<XWalkExtensionDirectChannel> {
+ public:
+  enum Side {
+    SERVER_SIDE,
+    CLIENT_SIDE
+  };
+
+  class Listener {
+   public:
+    virtual void OnDirectMessage(const IPC::Message& message) = 0;
+    virtual void OnDirectPostMessages(int64_t instance_id,
+                                      scoped_ptr<base::ListValue> msgs) = 0;
+
+   protected:
+    virtual ~Listener() {}
+  };
+
+  XWalkExtensionDirectChannel();
+
+  // Returns a token, never 0, that Take() exchanges for |channel| once.
+  static int Publish(XWalkExtensionDirectChannel* channel);
+  static scoped_refptr<XWalkExtensionDirectChannel> Take(int token);
+  // Drops the publication of |token| if it wasn't taken, e.g. because the
+  // render process that was to take it went away.
+  static void Unpublish(int token);
+
+  // The messages for |side| are passed to |listener| in |task_runner|, or
+  // right away in the sending thread when |task_runner| is NULL. In the
+  // latter case the listener must be thread safe.
+  void Connect(Side side, Listener* listener,
+               const scoped_refptr<base::SingleThreadTaskRunner>& task_runner);
+
+  // No message is passed to the listener of |side| after this returns, if
+  // called in the task runner of the listener. Waits for the calls made to
+  // a listener without task runner, so it must not be called by the listener
+  // itself.
+  void Disconnect(Side side);
+
+  bool IsConnected(Side side);
+
+  // Passes |message| to the other side and takes it, or returns false and
+  // leaves it to the caller if the other side isn't connected.
+  bool Send(Side from, IPC::Message* message);
+
+  // Same as above, for the messages posted to the instance |instance_id|.
+  bool PostMessages(Side from, int64_t instance_id,
+                    scoped_ptr<base::ListValue>* msgs);
+
+ private:
+  friend class base::RefCountedThreadSafe<XWalkExtensionDirectChannel>;
+  ~XWalkExtensionDirectChannel();
+
+  struct End {
+    End();
+    ~End();
+
+    Listener* listener;
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner;
+    // Calls to |listener| running in the sending threads.
+    int pending_calls;
+  };
+
+  static Side OtherSide(Side side) {
+    return side == SERVER_SIDE ? CLIENT_SIDE : SERVER_SIDE;
+  }
+
+  // Run in the task runner of |to|.
+  void DeliverMessage(Side to, scoped_ptr<IPC::Message> message);
+  void DeliverPostMessages(Side to, int64_t instance_id,
+                           scoped_ptr<base::ListValue> msgs);
+
+  // Ends a call to the listener of |side| made in the sending thread.
+  void FinishCall(Side side);
+
+  Listener* GetListener(Side side);
+
+  // Protects |ends_|. The listeners are called without it.
+  base::Lock lock_;
+  End ends_[2];
+  // Signaled when the calls to a listener are done, Disconnect() waits for
+  // them.
+  base::ConditionVariable calls_done_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionDirectChannel);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_DIRECT_CHANNEL_H_
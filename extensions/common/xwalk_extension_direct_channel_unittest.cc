@@ -0,0 +1,166 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_direct_channel.h"
+
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "ipc/ipc_message.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+using xwalk::extensions::XWalkExtensionDirectChannel;
+
+namespace {
+
+class TestListener : public XWalkExtensionDirectChannel::Listener {
+ public:
+  TestListener()
+      : message_count_(0),
+        last_instance_id_(0),
+        value_count_(0) {}
+
+  virtual void OnDirectMessage(const IPC::Message& message) OVERRIDE {
+    ++message_count_;
+    last_message_type_ = message.type();
+  }
+
+  virtual void OnDirectPostMessages(int64_t instance_id,
+                                    scoped_ptr<base::ListValue> msgs) OVERRIDE {
+    last_instance_id_ = instance_id;
+    value_count_ += msgs->GetSize();
+  }
+
+  int message_count_;
+  uint32 last_message_type_;
+  int64_t last_instance_id_;
+  size_t value_count_;
+};
+
+// Answers each message of the client on the same channel.
+class ReplyingListener : public TestListener {
+ public:
+  explicit ReplyingListener(XWalkExtensionDirectChannel* channel)
+      : channel_(channel) {}
+
+  virtual void OnDirectMessage(const IPC::Message& message) OVERRIDE {
+    TestListener::OnDirectMessage(message);
+    channel_->Send(XWalkExtensionDirectChannel::SERVER_SIDE,
+                   new XWalkExtensionClientMsg_InstanceDestroyed(1));
+  }
+
+ private:
+  XWalkExtensionDirectChannel* channel_;
+};
+
+scoped_ptr<base::ListValue> CreateMessages(size_t count) {
+  scoped_ptr<base::ListValue> msgs(new base::ListValue);
+  for (size_t i = 0; i < count; ++i)
+    msgs->AppendInteger(static_cast<int>(i));
+  return msgs.Pass();
+}
+
+}  // namespace
+
+TEST(XWalkExtensionDirectChannelTest, PublishAndTake) {
+  scoped_refptr<XWalkExtensionDirectChannel> channel(
+      new XWalkExtensionDirectChannel);
+
+  int token = XWalkExtensionDirectChannel::Publish(channel.get());
+  EXPECT_NE(0, token);
+  EXPECT_EQ(channel.get(), XWalkExtensionDirectChannel::Take(token).get());
+
+  // A channel can only be taken once.
+  EXPECT_FALSE(XWalkExtensionDirectChannel::Take(token).get());
+  EXPECT_FALSE(XWalkExtensionDirectChannel::Take(0).get());
+}
+
+TEST(XWalkExtensionDirectChannelTest, Unpublish) {
+  scoped_refptr<XWalkExtensionDirectChannel> channel(
+      new XWalkExtensionDirectChannel);
+
+  int token = XWalkExtensionDirectChannel::Publish(channel.get());
+  XWalkExtensionDirectChannel::Unpublish(token);
+  EXPECT_TRUE(channel->HasOneRef());
+  EXPECT_FALSE(XWalkExtensionDirectChannel::Take(token).get());
+}
+
+TEST(XWalkExtensionDirectChannelTest, PassMessages) {
+  base::MessageLoop loop;
+  scoped_refptr<XWalkExtensionDirectChannel> channel(
+      new XWalkExtensionDirectChannel);
+
+  // Nothing is taken while the other side isn't connected.
+  IPC::Message* message = new XWalkExtensionServerMsg_DestroyInstance(1);
+  EXPECT_FALSE(channel->Send(XWalkExtensionDirectChannel::CLIENT_SIDE,
+                             message));
+  delete message;
+
+  scoped_ptr<base::ListValue> msgs = CreateMessages(3);
+  EXPECT_FALSE(channel->PostMessages(XWalkExtensionDirectChannel::CLIENT_SIDE,
+                                     1, &msgs));
+  EXPECT_TRUE(msgs);
+
+  // The server side is called right away, the client side in its loop.
+  TestListener server;
+  TestListener client;
+  channel->Connect(XWalkExtensionDirectChannel::SERVER_SIDE, &server, NULL);
+  channel->Connect(XWalkExtensionDirectChannel::CLIENT_SIDE, &client,
+                   base::MessageLoopProxy::current());
+
+  EXPECT_TRUE(channel->Send(XWalkExtensionDirectChannel::CLIENT_SIDE,
+      new XWalkExtensionServerMsg_DestroyInstance(1)));
+  EXPECT_TRUE(channel->PostMessages(XWalkExtensionDirectChannel::CLIENT_SIDE,
+                                    42, &msgs));
+  EXPECT_FALSE(msgs);
+  EXPECT_EQ(1, server.message_count_);
+  EXPECT_EQ(static_cast<uint32>(XWalkExtensionServerMsg_DestroyInstance::ID),
+            server.last_message_type_);
+  EXPECT_EQ(42, server.last_instance_id_);
+  EXPECT_EQ(3u, server.value_count_);
+
+  EXPECT_TRUE(channel->Send(XWalkExtensionDirectChannel::SERVER_SIDE,
+      new XWalkExtensionClientMsg_InstanceDestroyed(1)));
+  msgs = CreateMessages(2);
+  EXPECT_TRUE(channel->PostMessages(XWalkExtensionDirectChannel::SERVER_SIDE,
+                                    7, &msgs));
+  EXPECT_EQ(0, client.message_count_);
+
+  loop.RunUntilIdle();
+  EXPECT_EQ(1, client.message_count_);
+  EXPECT_EQ(7, client.last_instance_id_);
+  EXPECT_EQ(2u, client.value_count_);
+
+  // The messages waiting in the loop are dropped after disconnecting.
+  EXPECT_TRUE(channel->Send(XWalkExtensionDirectChannel::SERVER_SIDE,
+      new XWalkExtensionClientMsg_InstanceDestroyed(1)));
+  channel->Disconnect(XWalkExtensionDirectChannel::CLIENT_SIDE);
+  loop.RunUntilIdle();
+  EXPECT_EQ(1, client.message_count_);
+  EXPECT_FALSE(channel->IsConnected(XWalkExtensionDirectChannel::CLIENT_SIDE));
+}
+
+TEST(XWalkExtensionDirectChannelTest, ListenerSendsBack) {
+  base::MessageLoop loop;
+  scoped_refptr<XWalkExtensionDirectChannel> channel(
+      new XWalkExtensionDirectChannel);
+
+  // The server side is called without the lock of the channel, it can
+  // answer right away.
+  ReplyingListener server(channel.get());
+  TestListener client;
+  channel->Connect(XWalkExtensionDirectChannel::SERVER_SIDE, &server, NULL);
+  channel->Connect(XWalkExtensionDirectChannel::CLIENT_SIDE, &client,
+                   base::MessageLoopProxy::current());
+
+  EXPECT_TRUE(channel->Send(XWalkExtensionDirectChannel::CLIENT_SIDE,
+      new XWalkExtensionServerMsg_DestroyInstance(1)));
+  EXPECT_EQ(1, server.message_count_);
+
+  loop.RunUntilIdle();
+  EXPECT_EQ(1, client.message_count_);
+
+  channel->Disconnect(XWalkExtensionDirectChannel::SERVER_SIDE);
+  channel->Disconnect(XWalkExtensionDirectChannel::CLIENT_SIDE);
+}
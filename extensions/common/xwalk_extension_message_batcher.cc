@@ -0,0 +1,155 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+
+#include <algorithm>
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/stl_util.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+namespace xwalk {
+namespace extensions {
+
+XWalkExtensionMessageBatcher::XWalkExtensionMessageBatcher(
+    Direction direction, const SendCallback& send_callback)
+    : direction_(direction),
+      send_callback_(send_callback),
+      flush_scheduled_(false),
+      flushing_(false),
+      flushing_thread_(base::kInvalidThreadId),
+      flush_done_(&lock_) {}
+
+XWalkExtensionMessageBatcher::~XWalkExtensionMessageBatcher() {
+  STLDeleteValues(&pending_);
+}
+
+void XWalkExtensionMessageBatcher::SetPostCallback(
+    const PostCallback& post_callback) {
+  base::AutoLock l(lock_);
+  post_callback_ = post_callback;
+}
+
+void XWalkExtensionMessageBatcher::Post(int64_t instance_id,
+                                        scoped_ptr<base::Value> msg) {
+  scoped_refptr<base::MessageLoopProxy> loop =
+      base::MessageLoopProxy::current();
+
+  base::AutoLock l(lock_);
+  if (send_callback_.is_null())
+    return;
+
+  base::ListValue*& contents = pending_[instance_id];
+  if (!contents) {
+    contents = new base::ListValue;
+    pending_order_.push_back(instance_id);
+  }
+  contents->Append(msg.release());
+
+  if (!loop) {
+    FlushLocked();
+    return;
+  }
+
+  if (flush_scheduled_)
+    return;
+
+  flush_scheduled_ = true;
+  loop->PostTask(FROM_HERE,
+                 base::Bind(&XWalkExtensionMessageBatcher::Flush, this));
+}
+
+void XWalkExtensionMessageBatcher::Flush() {
+  base::AutoLock l(lock_);
+  FlushLocked();
+}
+
+void XWalkExtensionMessageBatcher::Discard(int64_t instance_id) {
+  base::AutoLock l(lock_);
+  PendingMap::iterator it = pending_.find(instance_id);
+  if (it == pending_.end())
+    return;
+
+  delete it->second;
+  pending_.erase(it);
+  pending_order_.erase(std::find(pending_order_.begin(), pending_order_.end(),
+                                 instance_id));
+}
+
+void XWalkExtensionMessageBatcher::Invalidate() {
+  base::AutoLock l(lock_);
+  send_callback_.Reset();
+  post_callback_.Reset();
+  STLDeleteValues(&pending_);
+  pending_order_.clear();
+
+  // The callbacks may still be running on another thread.
+  while (flushing_ && flushing_thread_ != base::PlatformThread::CurrentId())
+    flush_done_.Wait();
+}
+
+void XWalkExtensionMessageBatcher::FlushLocked() {
+  lock_.AssertAcquired();
+  flush_scheduled_ = false;
+
+  // Only one thread sends at a time, so concurrent flushes can't reorder
+  // messages of the same instance. The messages queued meanwhile are sent by
+  // the running flush, wait for it unless its callbacks are posting them.
+  if (flushing_) {
+    if (flushing_thread_ == base::PlatformThread::CurrentId())
+      return;
+    while (flushing_)
+      flush_done_.Wait();
+    return;
+  }
+
+  flushing_ = true;
+  flushing_thread_ = base::PlatformThread::CurrentId();
+  while (!pending_order_.empty()) {
+    PendingMap pending;
+    std::vector<int64_t> pending_order;
+    pending.swap(pending_);
+    pending_order.swap(pending_order_);
+    SendCallback send_callback = send_callback_;
+    PostCallback post_callback = post_callback_;
+
+    // The callbacks run without the lock, they may post messages or reach
+    // back to the owner of the batcher.
+    base::AutoUnlock unlock(lock_);
+    std::vector<int64_t>::const_iterator it = pending_order.begin();
+    for (; it != pending_order.end(); ++it) {
+      scoped_ptr<base::ListValue> contents(pending[*it]);
+      if (!post_callback.is_null() && post_callback.Run(*it, &contents))
+        continue;
+      if (!send_callback.is_null())
+        send_callback.Run(CreateMessage(*it, *contents));
+    }
+  }
+
+  flushing_ = false;
+  flushing_thread_ = base::kInvalidThreadId;
+  flush_done_.Broadcast();
+}
+
+IPC::Message* XWalkExtensionMessageBatcher::CreateMessage(
+    int64_t instance_id, const base::ListValue& contents) const {
+  // A single message is sent as a regular message, since its ListValue
+  // wrapper has exactly the same layout.
+  if (contents.GetSize() == 1) {
+    if (direction_ == TO_NATIVE)
+      return new XWalkExtensionServerMsg_PostMessageToNative(instance_id,
+                                                             contents);
+    return new XWalkExtensionClientMsg_PostMessageToJS(instance_id, contents);
+  }
+
+  if (direction_ == TO_NATIVE)
+    return new XWalkExtensionServerMsg_PostMessagesToNative(instance_id,
+                                                            contents);
+  return new XWalkExtensionClientMsg_PostMessagesToJS(instance_id, contents);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
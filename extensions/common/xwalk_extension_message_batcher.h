@@ -0,0 +1,111 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/values.h"
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Coalesces the asynchronous messages posted to extension instances during
+// a task into a single IPC message per instance. Messages are queued by
+// Post() and sent when the task that posted them returns to the message
+// loop, or earlier if Flush() is called explicitly. Messages for the same
+// instance are always delivered in the order they were posted.
+//
+// Post() and Flush() can be called from any thread. Threads without a
+// message loop can't defer the flush, so their messages are sent right
+// away, after the ones already queued.
+class XWalkExtensionMessageBatcher
+    : public base::RefCountedThreadSafe<XWalkExtensionMessageBatcher> {
+ public:
+  enum Direction {
+    // Renderer to extension instance, used by XWalkExtensionClient.
+    TO_NATIVE,
+    // Extension instance to renderer, used by XWalkExtensionServer.
+    TO_JS
+  };
+
+  typedef base::Callback<bool(IPC::Message* msg)> SendCallback;
+
+  // Takes the messages queued for |instance_id| out of |msgs| and returns
+  // true if it could deliver them without an IPC message.
+  typedef base::Callback<bool(int64_t instance_id,
+                              scoped_ptr<base::ListValue>* msgs)> PostCallback;
+
+  XWalkExtensionMessageBatcher(Direction direction,
+                               const SendCallback& send_callback);
+
+  // When set, the queued messages are given to |post_callback| first, and
+  // only sent as IPC messages if it doesn't take them.
+  void SetPostCallback(const PostCallback& post_callback);
+
+  void Post(int64_t instance_id, scoped_ptr<base::Value> msg);
+
+  // Sends all the queued messages. Used before sending a message that must
+  // not overtake the queued ones.
+  void Flush();
+
+  // Drops the messages queued for |instance_id|, which is being destroyed.
+  void Discard(int64_t instance_id);
+
+  // After this call messages are silently dropped, the send callback is
+  // never run again. Must be called before the owner of the send callback
+  // is destroyed.
+  void Invalidate();
+
+ private:
+  friend class base::RefCountedThreadSafe<XWalkExtensionMessageBatcher>;
+  ~XWalkExtensionMessageBatcher();
+
+  // Called with |lock_| held, which is released while the callbacks run.
+  void FlushLocked();
+  IPC::Message* CreateMessage(int64_t instance_id,
+                              const base::ListValue& contents) const;
+
+  Direction direction_;
+
+  // Protects all the members below.
+  base::Lock lock_;
+
+  SendCallback send_callback_;
+  PostCallback post_callback_;
+
+  typedef std::map<int64_t, base::ListValue*> PendingMap;
+  PendingMap pending_;
+
+  // Instances with queued messages, in the order of their first message.
+  std::vector<int64_t> pending_order_;
+
+  bool flush_scheduled_;
+
+  // Set while a flush runs the callbacks, on |flushing_thread_|.
+  bool flushing_;
+  base::PlatformThreadId flushing_thread_;
+  // Signaled when a flush is done.
+  base::ConditionVariable flush_done_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageBatcher);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
@@ -0,0 +1,91 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "ipc/ipc_message.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+using xwalk::extensions::XWalkExtensionMessageBatcher;
+
+namespace {
+
+bool StoreMessage(ScopedVector<IPC::Message>* messages, IPC::Message* msg) {
+  messages->push_back(msg);
+  return true;
+}
+
+scoped_ptr<base::Value> CreateIntegerValue(int value) {
+  return scoped_ptr<base::Value>(new base::FundamentalValue(value));
+}
+
+}  // namespace
+
+TEST(XWalkExtensionMessageBatcherTest, CoalescesMessagesPostedInATask) {
+  base::MessageLoop loop;
+  ScopedVector<IPC::Message> messages;
+  scoped_refptr<XWalkExtensionMessageBatcher> batcher(
+      new XWalkExtensionMessageBatcher(XWalkExtensionMessageBatcher::TO_JS,
+                                       base::Bind(&StoreMessage, &messages)));
+
+  for (int i = 0; i < 10; ++i)
+    batcher->Post(1, CreateIntegerValue(i));
+  batcher->Post(2, CreateIntegerValue(42));
+  EXPECT_TRUE(messages.empty());
+
+  loop.RunUntilIdle();
+  ASSERT_EQ(2u, messages.size());
+
+  // Messages for the first instance are sent in one batch, in order.
+  XWalkExtensionClientMsg_PostMessagesToJS::Param batch;
+  ASSERT_EQ(static_cast<uint32>(XWalkExtensionClientMsg_PostMessagesToJS::ID),
+            messages[0]->type());
+  ASSERT_TRUE(XWalkExtensionClientMsg_PostMessagesToJS::Read(messages[0],
+                                                             &batch));
+  EXPECT_EQ(1, batch.a);
+  ASSERT_EQ(10u, batch.b.GetSize());
+  for (int i = 0; i < 10; ++i) {
+    int value;
+    ASSERT_TRUE(batch.b.GetInteger(i, &value));
+    EXPECT_EQ(i, value);
+  }
+
+  // A single message uses the regular message.
+  XWalkExtensionClientMsg_PostMessageToJS::Param single;
+  ASSERT_EQ(static_cast<uint32>(XWalkExtensionClientMsg_PostMessageToJS::ID),
+            messages[1]->type());
+  ASSERT_TRUE(XWalkExtensionClientMsg_PostMessageToJS::Read(messages[1],
+                                                            &single));
+  EXPECT_EQ(2, single.a);
+  EXPECT_EQ(1u, single.b.GetSize());
+}
+
+TEST(XWalkExtensionMessageBatcherTest, FlushAndDiscard) {
+  base::MessageLoop loop;
+  ScopedVector<IPC::Message> messages;
+  scoped_refptr<XWalkExtensionMessageBatcher> batcher(
+      new XWalkExtensionMessageBatcher(XWalkExtensionMessageBatcher::TO_NATIVE,
+                                       base::Bind(&StoreMessage, &messages)));
+
+  batcher->Post(1, CreateIntegerValue(1));
+  batcher->Post(2, CreateIntegerValue(2));
+  batcher->Discard(2);
+  batcher->Flush();
+  ASSERT_EQ(1u, messages.size());
+  EXPECT_EQ(static_cast<uint32>(XWalkExtensionServerMsg_PostMessageToNative::ID),
+            messages[0]->type());
+
+  // The scheduled flush has nothing left to send.
+  loop.RunUntilIdle();
+  EXPECT_EQ(1u, messages.size());
+
+  batcher->Post(1, CreateIntegerValue(3));
+  batcher->Invalidate();
+  loop.RunUntilIdle();
+  EXPECT_EQ(1u, messages.size());
+}
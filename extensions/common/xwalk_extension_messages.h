@@ -52,14 +52,59 @@ IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionProcessHostMsg_RegisterPermissions, //
                             std::string,
                             bool)
 
+// Messages used by a shared extension process, which serves several render
+// processes (see switches::kXWalkExtensionProcessPool). Each render process
+// has its own channel and server in the extension process, so the instance ids
+// of different render processes never clash.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_CreateRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */,
+                     base::ListValue /* runtime variables */)
+
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_CloseRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessHostMsg_SharedRenderProcessChannelCreated, // NOLINT(*)
+                     int /* render process id */,
+                     IPC::ChannelHandle /* channel id */)
+
+IPC_SYNC_MESSAGE_CONTROL3_1(XWalkExtensionProcessHostMsg_CheckAPIAccessControlForRenderProcess, // NOLINT(*)
+                            int /* render process id */,
+                            std::string,
+                            std::string,
+                            xwalk::extensions::RuntimePermission)
+IPC_SYNC_MESSAGE_CONTROL3_1(XWalkExtensionProcessHostMsg_RegisterPermissionsForRenderProcess, // NOLINT(*)
+                            int /* render process id */,
+                            std::string,
+                            std::string,
+                            bool)
+
+// Messages from Browser Process to Extension Process keeping its cache of
+// permissions up to date. The render process id is ignored by an extension
+// process that isn't shared.
+IPC_STRUCT_TRAITS_BEGIN(xwalk::extensions::PermissionDecision)
+  IPC_STRUCT_TRAITS_MEMBER(extension_name)
+  IPC_STRUCT_TRAITS_MEMBER(api_name)
+  IPC_STRUCT_TRAITS_MEMBER(permission)
+IPC_STRUCT_TRAITS_END()
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_CachePermissions,  // NOLINT(*)
+                     int /* render process id */,
+                     xwalk::extensions::PermissionDecisions)
+
+// Sent when the permissions of the application change, before caching the
+// new ones.
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_ClearPermissionCache,  // NOLINT(*)
+                     int /* render process id */)
+
 // We use a separated message class for Client<->Server communication
 // to ease filtering.
 #undef IPC_MESSAGE_START
 #define IPC_MESSAGE_START XWalkExtensionClientServerMsgStart
 
+// The JavaScript API code is not included, the client fetches it with
+// XWalkExtensionServerMsg_GetExtensionAPI when the extension is first used.
 IPC_STRUCT_BEGIN(XWalkExtensionServerMsg_ExtensionRegisterParams)
   IPC_STRUCT_MEMBER(std::string, name)
-  IPC_STRUCT_MEMBER(std::string, js_api)
   IPC_STRUCT_MEMBER(std::vector<std::string>, entry_points)
 IPC_STRUCT_END()
 
@@ -88,3 +133,50 @@ IPC_MESSAGE_CONTROL1(XWalkExtensionServerMsg_DestroyInstance,  // NOLINT(*)
 
 IPC_MESSAGE_CONTROL1(XWalkExtensionClientMsg_InstanceDestroyed,  // NOLINT(*)
                      int64_t /* instance id */)
+
+// Several messages posted to the same instance, coalesced by
+// XWalkExtensionMessageBatcher. Each element of the list is the contents of
+// one message, in the order they were posted.
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostMessagesToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::ListValue /* list of contents */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessagesToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::ListValue /* list of contents */)
+
+// Asynchronous request sent with extension.sendAsyncRequest(). Several
+// requests can be pending for the same instance, the reply carries the
+// |request id| so they can be replied in any order.
+IPC_MESSAGE_CONTROL3(XWalkExtensionServerMsg_SendAsyncRequestToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* request id */,
+                     base::ListValue /* contents */)
+
+IPC_MESSAGE_CONTROL4(XWalkExtensionClientMsg_AsyncReplyToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* request id */,
+                     bool /* succeeded */,
+                     base::ListValue /* contents */)
+
+IPC_SYNC_MESSAGE_CONTROL1_1(XWalkExtensionServerMsg_GetExtensionAPI,  // NOLINT(*)
+                            std::string /* extension name */,
+                            std::string /* JavaScript API code */)
+
+// Returns the token of the XWalkExtensionDirectChannel published for the
+// in-process servers, or 0 if there's none. Only used in single process mode.
+IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionServerMsg_GetDirectChannel,  // NOLINT(*)
+                            int /* token */)
+
+// Messages posted with an ArrayBuffer or ArrayBufferView on the JavaScript
+// side, and with a base::BinaryValue or XW_BinaryMessagingInterface on the
+// native side. They're created and read with the functions from
+// xwalk_extension_binary_message.h, without copying the data to a
+// std::string.
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostBinaryMessageToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::string /* data */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostBinaryMessageToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::string /* data */)
@@ -0,0 +1,43 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_permission_cache.h"
+
+namespace xwalk {
+namespace extensions {
+
+XWalkExtensionPermissionCache::XWalkExtensionPermissionCache() {}
+
+XWalkExtensionPermissionCache::~XWalkExtensionPermissionCache() {}
+
+bool XWalkExtensionPermissionCache::Lookup(
+    const std::string& extension_name, const std::string& api_name,
+    RuntimePermission* permission) const {
+  PermissionMap::const_iterator it =
+      permissions_.find(std::make_pair(extension_name, api_name));
+  if (it == permissions_.end())
+    return false;
+  *permission = it->second;
+  return true;
+}
+
+void XWalkExtensionPermissionCache::Set(const std::string& extension_name,
+                                        const std::string& api_name,
+                                        RuntimePermission permission) {
+  if (IsCacheablePermission(permission))
+    permissions_[std::make_pair(extension_name, api_name)] = permission;
+}
+
+void XWalkExtensionPermissionCache::Add(const PermissionDecisions& decisions) {
+  PermissionDecisions::const_iterator it = decisions.begin();
+  for (; it != decisions.end(); ++it)
+    Set(it->extension_name, it->api_name, it->permission);
+}
+
+void XWalkExtensionPermissionCache::Clear() {
+  permissions_.clear();
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,50 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_CACHE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_CACHE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "xwalk/extensions/common/xwalk_extension_permission_types.h"
+
+namespace xwalk {
+namespace extensions {
+
+// The session and persistent permissions of the APIs used by an application,
+// kept by the extension process so it doesn't ask the browser process on every
+// call. The browser process pushes the decisions it knows with Add(), and
+// invalidates them with Clear() when the permissions of the application
+// change.
+class XWalkExtensionPermissionCache {
+ public:
+  XWalkExtensionPermissionCache();
+  ~XWalkExtensionPermissionCache();
+
+  // Returns false if there's no decision for the API.
+  bool Lookup(const std::string& extension_name, const std::string& api_name,
+              RuntimePermission* permission) const;
+
+  // Only cacheable permissions are kept, the others are ignored.
+  void Set(const std::string& extension_name, const std::string& api_name,
+           RuntimePermission permission);
+  void Add(const PermissionDecisions& decisions);
+
+  void Clear();
+
+ private:
+  typedef std::map<std::pair<std::string, std::string>, RuntimePermission>
+      PermissionMap;
+  PermissionMap permissions_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionPermissionCache);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_CACHE_H_
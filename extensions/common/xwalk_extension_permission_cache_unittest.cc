@@ -0,0 +1,63 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_permission_cache.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+PermissionDecision CreateDecision(const std::string& api_name,
+                                  RuntimePermission permission) {
+  PermissionDecision decision;
+  decision.extension_name = "test";
+  decision.api_name = api_name;
+  decision.permission = permission;
+  return decision;
+}
+
+}  // namespace
+
+TEST(XWalkExtensionPermissionCacheTest, PushedDecisions) {
+  PermissionDecisions decisions;
+  decisions.push_back(CreateDecision("allowed", ALLOW_ALWAYS));
+  decisions.push_back(CreateDecision("denied", DENY_SESSION));
+  decisions.push_back(CreateDecision("once", ALLOW_ONCE));
+
+  XWalkExtensionPermissionCache cache;
+  cache.Add(decisions);
+
+  RuntimePermission permission;
+  ASSERT_TRUE(cache.Lookup("test", "allowed", &permission));
+  EXPECT_EQ(ALLOW_ALWAYS, permission);
+  ASSERT_TRUE(cache.Lookup("test", "denied", &permission));
+  EXPECT_EQ(DENY_SESSION, permission);
+
+  // Decisions that only hold for one call are never cached.
+  EXPECT_FALSE(cache.Lookup("test", "once", &permission));
+  EXPECT_FALSE(cache.Lookup("other", "allowed", &permission));
+}
+
+TEST(XWalkExtensionPermissionCacheTest, ClearInvalidatesDecisions) {
+  XWalkExtensionPermissionCache cache;
+  cache.Set("test", "api", ALLOW_SESSION);
+
+  // The permissions of the application changed, the browser process clears
+  // the cache and pushes the new decisions.
+  cache.Clear();
+  RuntimePermission permission;
+  EXPECT_FALSE(cache.Lookup("test", "api", &permission));
+
+  PermissionDecisions decisions;
+  decisions.push_back(CreateDecision("api", DENY_ALWAYS));
+  cache.Add(decisions);
+  ASSERT_TRUE(cache.Lookup("test", "api", &permission));
+  EXPECT_EQ(DENY_ALWAYS, permission);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
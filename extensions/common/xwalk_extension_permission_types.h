@@ -5,6 +5,11 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_TYPES_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_TYPES_H_
 
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+
 namespace xwalk {
 namespace extensions {
 
@@ -24,6 +29,23 @@ enum RuntimePermission {
 
 typedef base::Callback<void(RuntimePermission)> PermissionCallback;
 
+// The session or persistent permission of an API, sent in advance to the
+// extension process so it doesn't ask the browser process on every call.
+struct PermissionDecision {
+  std::string extension_name;
+  std::string api_name;
+  RuntimePermission permission;
+};
+
+typedef std::vector<PermissionDecision> PermissionDecisions;
+
+// Whether |permission| holds until the permissions of the application change,
+// so it can be cached.
+inline bool IsCacheablePermission(RuntimePermission permission) {
+  return permission == ALLOW_SESSION || permission == ALLOW_ALWAYS ||
+      permission == DENY_SESSION || permission == DENY_ALWAYS;
+}
+
 }  // namespace extensions
 }  // namespace xwalk
 
@@ -7,11 +7,16 @@
 #include "base/file_util.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop_proxy.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+#include "xwalk/extensions/common/xwalk_extension_direct_channel.h"
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
@@ -20,9 +25,14 @@ namespace extensions {
 
 XWalkExtensionServer::XWalkExtensionServer()
     : sender_(NULL),
-      permissions_delegate_(NULL) {}
+      permissions_delegate_(NULL) {
+  post_message_batcher_ = new XWalkExtensionMessageBatcher(
+      XWalkExtensionMessageBatcher::TO_JS,
+      base::Bind(&XWalkExtensionServer::Send, base::Unretained(this)));
+}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
+  post_message_batcher_->Invalidate();
   DeleteInstanceMap();
   STLDeleteValues(&extensions_);
 }
@@ -36,11 +46,20 @@ bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
         OnDestroyInstance)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostMessageToNative,
         OnPostMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostMessagesToNative,
+        OnPostMessagesToNative)
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionServerMsg_SendSyncMessageToNative,
         OnSendSyncMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_SendAsyncRequestToNative,
+        OnSendAsyncRequestToNative)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensions,
         OnGetExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensionAPI,
+        OnGetExtensionAPI)
+    IPC_MESSAGE_HANDLER_GENERIC(
+        XWalkExtensionServerMsg_PostBinaryMessageToNative,
+        OnPostBinaryMessageToNative(message))
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -62,10 +81,20 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
       base::Bind(&XWalkExtensionServer::PostMessageToJSCallback,
                  base::Unretained(this), instance_id));
 
+  instance->SetPostBinaryMessageCallback(
+      base::Bind(&XWalkExtensionServer::PostBinaryMessageToJSCallback,
+                 base::Unretained(this), instance_id));
+
   instance->SetSendSyncReplyCallback(
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
                  base::Unretained(this), instance_id));
 
+  // Async replies may be sent from any thread, they're posted back to the
+  // thread of the server, which may be gone by then.
+  instance->SetSendAsyncReplyCallback(
+      base::Bind(&XWalkExtensionServer::PostAsyncReplyToJSCallback,
+                 base::MessageLoopProxy::current(), AsWeakPtr(), instance_id));
+
   InstanceExecutionData data;
   data.instance = instance;
   data.pending_reply = NULL;
@@ -95,6 +124,60 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
   data.instance->HandleMessage(value.Pass());
 }
 
+void XWalkExtensionServer::OnPostBinaryMessageToNative(
+    const IPC::Message& message) {
+  int64_t instance_id;
+  const char* data;
+  size_t size;
+  if (!ReadBinaryMessage(message, &instance_id, &data, &size)) {
+    LOG(WARNING) << "Invalid binary message received.";
+    return;
+  }
+
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end()) {
+    LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  it->second.instance->HandleBinaryMessage(data, size);
+}
+
+void XWalkExtensionServer::OnPostMessagesToNative(int64_t instance_id,
+    const base::ListValue& msgs) {
+  // Same as in OnPostMessageToNative(), the const_cast allows us to pass the
+  // ownership of each message to HandleMessage() without a DeepCopy(). The
+  // values are taken from the back of the list to avoid shifting it.
+  base::ListValue* list = const_cast<base::ListValue*>(&msgs);
+  ScopedVector<base::Value> values;
+  while (!list->empty()) {
+    scoped_ptr<base::Value> value;
+    list->Remove(list->GetSize() - 1, &value);
+    values.push_back(value.release());
+  }
+
+  for (size_t i = values.size(); i > 0; --i) {
+    // The instance is looked up for every message because handling one of
+    // them may end up destroying it.
+    InstanceMap::const_iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
+
+    scoped_ptr<base::Value> value(values[i - 1]);
+    values[i - 1] = NULL;
+    it->second.instance->HandleMessage(value.Pass());
+  }
+}
+
+void XWalkExtensionServer::PostMessagesToNative(
+    int64_t instance_id, scoped_ptr<base::ListValue> msgs) {
+  OnPostMessagesToNative(instance_id, *msgs);
+}
+
 void XWalkExtensionServer::Initialize(IPC::Sender* sender) {
   base::AutoLock l(sender_lock_);
   DCHECK(!sender_);
@@ -108,6 +191,14 @@ bool XWalkExtensionServer::Send(IPC::Message* msg) {
   return sender_->Send(msg);
 }
 
+void XWalkExtensionServer::SetDirectChannel(
+    XWalkExtensionDirectChannel* channel) {
+  post_message_batcher_->SetPostCallback(
+      base::Bind(&XWalkExtensionDirectChannel::PostMessages,
+                 make_scoped_refptr(channel),
+                 XWalkExtensionDirectChannel::SERVER_SIDE));
+}
+
 namespace {
 
 bool ValidateExtensionIdentifier(const std::string& name) {
@@ -183,9 +274,15 @@ bool XWalkExtensionServer::ContainsExtension(
 
 void XWalkExtensionServer::PostMessageToJSCallback(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
-  base::ListValue wrapped_msg;
-  wrapped_msg.Append(msg.release());
-  Send(new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
+  post_message_batcher_->Post(instance_id, msg.Pass());
+}
+
+void XWalkExtensionServer::PostBinaryMessageToJSCallback(
+    int64_t instance_id, const char* data, size_t size) {
+  // Keep the order with the messages already queued.
+  post_message_batcher_->Flush();
+  Send(CreateBinaryMessage(XWalkExtensionClientMsg_PostBinaryMessageToJS::ID,
+                           instance_id, data, size));
 }
 
 void XWalkExtensionServer::SendSyncReplyToJSCallback(
@@ -214,11 +311,52 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
   XWalkExtensionServerMsg_SendSyncMessageToNative::ReplyParam
       reply_param(wrapped_reply);
   IPC::WriteParam(data.pending_reply, reply_param);
+
+  // Keep the messages posted before the reply ahead of it.
+  post_message_batcher_->Flush();
   Send(data.pending_reply);
 
   data.pending_reply = NULL;
 }
 
+// static
+void XWalkExtensionServer::PostAsyncReplyToJSCallback(
+    scoped_refptr<base::MessageLoopProxy> task_runner,
+    base::WeakPtr<XWalkExtensionServer> server,
+    int64_t instance_id, int request_id, scoped_ptr<base::Value> reply) {
+  if (!task_runner->BelongsToCurrentThread()) {
+    task_runner->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionServer::SendAsyncReplyToJSCallback, server,
+                   instance_id, request_id, base::Passed(&reply)));
+    return;
+  }
+
+  if (server)
+    server->SendAsyncReplyToJSCallback(instance_id, request_id, reply.Pass());
+}
+
+void XWalkExtensionServer::SendAsyncReplyToJSCallback(
+    int64_t instance_id, int request_id, scoped_ptr<base::Value> reply) {
+  // Unlike sync replies we don't look at the instance map, replies for
+  // destroyed instances are ignored by the client.
+  base::ListValue wrapped_reply;
+  bool succeeded = reply.get() != NULL;
+  if (reply)
+    wrapped_reply.Append(reply.release());
+
+  // Keep the messages posted before the reply ahead of it.
+  post_message_batcher_->Flush();
+  Send(new XWalkExtensionClientMsg_AsyncReplyToJS(instance_id, request_id,
+                                                  succeeded, wrapped_reply));
+}
+
+void XWalkExtensionServer::SendSyncReplyError(IPC::Message* ipc_reply) {
+  // Unblock the renderer, that would otherwise wait forever for a reply. It
+  // gets a NULL reply in this case.
+  ipc_reply->set_reply_error();
+  Send(ipc_reply);
+}
+
 void XWalkExtensionServer::DeleteInstanceMap() {
   InstanceMap::iterator it = instances_.begin();
   int pending_replies_left = 0;
@@ -267,13 +405,16 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   if (it == instances_.end()) {
     LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
                  << instance_id;
+    SendSyncReplyError(ipc_reply);
     return;
   }
 
   InstanceExecutionData& data = it->second;
   if (data.pending_reply) {
     LOG(WARNING) << "There's already a pending Sync Message for "
-                 << "Extension instance id: " << instance_id;
+                 << "Extension instance id: " << instance_id
+                 << ". Consider using extension.sendAsyncRequest() instead.";
+    SendSyncReplyError(ipc_reply);
     return;
   }
 
@@ -292,6 +433,24 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   instance->HandleSyncMessage(value.Pass());
 }
 
+void XWalkExtensionServer::OnSendAsyncRequestToNative(int64_t instance_id,
+    int request_id, const base::ListValue& msg) {
+  InstanceMap::iterator it = instances_.find(instance_id);
+  if (it == instances_.end()) {
+    LOG(WARNING) << "Can't SendAsyncRequest to invalid Extension instance id: "
+                 << instance_id;
+    // Rejects the request, the client would otherwise wait for it forever.
+    SendAsyncReplyToJSCallback(instance_id, request_id,
+                               scoped_ptr<base::Value>());
+    return;
+  }
+
+  // See OnPostMessageToNative() for why the const_cast is safe.
+  scoped_ptr<base::Value> value;
+  const_cast<base::ListValue*>(&msg)->Remove(0, &value);
+  it->second.instance->HandleAsyncRequest(request_id, value.Pass());
+}
+
 void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
   InstanceMap::iterator it = instances_.find(instance_id);
   if (it == instances_.end()) {
@@ -304,6 +463,10 @@ void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
   delete data.instance;
   instances_.erase(it);
 
+  // The client already stopped listening to this instance, so there's no
+  // point in delivering what it posted before being destroyed.
+  post_message_batcher_->Discard(instance_id);
+
   Send(new XWalkExtensionClientMsg_InstanceDestroyed(instance_id));
 }
 
@@ -314,8 +477,11 @@ void XWalkExtensionServer::OnGetExtensions(
     XWalkExtensionServerMsg_ExtensionRegisterParams extension_parameters;
     XWalkExtension* extension = it->second;
 
+    // Without JavaScript API code there's nothing to load in the renderer.
+    if (extension->javascript_api().empty())
+      continue;
+
     extension_parameters.name = extension->name();
-    extension_parameters.js_api = extension->javascript_api();
 
     const base::ListValue& entry_points = extension->entry_points();
     base::ListValue::const_iterator entry_it = entry_points.begin();
@@ -329,7 +495,20 @@ void XWalkExtensionServer::OnGetExtensions(
   }
 }
 
+void XWalkExtensionServer::OnGetExtensionAPI(
+    const std::string& extension_name, std::string* js_api) {
+  ExtensionMap::const_iterator it = extensions_.find(extension_name);
+  if (it == extensions_.end()) {
+    LOG(WARNING) << "Can't get the JavaScript API of inexistent extension: "
+                 << extension_name;
+    return;
+  }
+  *js_api = it->second->javascript_api();
+}
+
 void XWalkExtensionServer::Invalidate() {
+  post_message_batcher_->Invalidate();
+
   base::AutoLock l(sender_lock_);
   sender_ = NULL;
 }
@@ -346,17 +525,16 @@ base::FilePath::StringType GetNativeLibraryPattern() {
 }
 }  // namespace
 
-std::vector<std::string> RegisterExternalExtensionsInDirectory(
-    XWalkExtensionServer* server, const base::FilePath& dir,
-    const base::ValueMap& runtime_variables) {
-  CHECK(server);
-
-  std::vector<std::string> registered_extensions;
+void LoadExternalExtensionsInDirectory(
+    const base::FilePath& dir, const base::ValueMap& runtime_variables,
+    XWalkExtension::PermissionsDelegate* permissions_delegate,
+    ScopedVector<XWalkExternalExtension>* extensions) {
+  CHECK(extensions);
 
   if (!base::DirectoryExists(dir)) {
     LOG(WARNING) << "Couldn't load external extensions from non-existent"
                  << " directory " << dir.AsUTF8Unsafe();
-    return registered_extensions;
+    return;
   }
 
   base::FileEnumerator libraries(
@@ -367,16 +545,33 @@ std::vector<std::string> RegisterExternalExtensionsInDirectory(
     scoped_ptr<XWalkExternalExtension> extension(
         new XWalkExternalExtension(extension_path));
     extension->set_runtime_variables(runtime_variables);
-    if (server->permissions_delegate())
-      extension->set_permissions_delegate(server->permissions_delegate());
+    if (permissions_delegate)
+      extension->set_permissions_delegate(permissions_delegate);
     if (extension->Initialize()) {
-      registered_extensions.push_back(extension->name());
-      server->RegisterExtension(extension.PassAs<XWalkExtension>());
+      extensions->push_back(extension.release());
     } else {
       LOG(WARNING) << "Failed to initialize extension: "
                    << extension_path.AsUTF8Unsafe();
     }
   }
+}
+
+std::vector<std::string> RegisterExternalExtensionsInDirectory(
+    XWalkExtensionServer* server, const base::FilePath& dir,
+    const base::ValueMap& runtime_variables) {
+  CHECK(server);
+
+  ScopedVector<XWalkExternalExtension> extensions;
+  LoadExternalExtensionsInDirectory(dir, runtime_variables,
+                                    server->permissions_delegate(),
+                                    &extensions);
+
+  std::vector<std::string> registered_extensions;
+  for (size_t i = 0; i < extensions.size(); ++i) {
+    registered_extensions.push_back(extensions[i]->name());
+    server->RegisterExtension(scoped_ptr<XWalkExtension>(extensions[i]));
+  }
+  extensions.weak_clear();
 
   return registered_extensions;
 }
@@ -11,6 +11,8 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
 #include "base/memory/weak_ptr.h"
 #include "base/synchronization/lock.h"
 #include "base/values.h"
@@ -23,6 +25,7 @@ struct XWalkExtensionServerMsg_ExtensionRegisterParams;
 
 namespace base {
 class FilePath;
+class MessageLoopProxy;
 }
 
 namespace content {
@@ -36,7 +39,9 @@ class Sender;
 namespace xwalk {
 namespace extensions {
 
+class XWalkExtensionDirectChannel;
 class XWalkExtensionInstance;
+class XWalkExtensionMessageBatcher;
 
 // Manages the instances for a set of extensions. It communicates with one
 // XWalkExtensionClient by means of IPC channel.
@@ -73,11 +78,21 @@ class XWalkExtensionServer : public IPC::Listener,
     return permissions_delegate_;
   }
 
+  // The messages posted by the instances are moved through |channel| while
+  // its client side is connected, see XWalkExtensionDirectChannel.
+  void SetDirectChannel(XWalkExtensionDirectChannel* channel);
+
   // These Message Handlers can be accessed by a message filter when
   // running on the browser process.
   void OnCreateInstance(int64_t instance_id, std::string name);
   void OnGetExtensions(
       std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>* reply);
+  void OnGetExtensionAPI(const std::string& extension_name,
+                         std::string* js_api);
+
+  // Handles the messages for |instance_id| received through a direct channel.
+  void PostMessagesToNative(int64_t instance_id,
+                            scoped_ptr<base::ListValue> msgs);
 
  private:
   struct InstanceExecutionData {
@@ -88,15 +103,33 @@ class XWalkExtensionServer : public IPC::Listener,
   // Message Handlers
   void OnDestroyInstance(int64_t instance_id);
   void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessagesToNative(int64_t instance_id,
+                              const base::ListValue& msgs);
+  void OnPostBinaryMessageToNative(const IPC::Message& message);
   void OnSendSyncMessageToNative(int64_t instance_id,
       const base::ListValue& msg, IPC::Message* ipc_reply);
+  void OnSendAsyncRequestToNative(int64_t instance_id, int request_id,
+      const base::ListValue& msg);
 
   void PostMessageToJSCallback(int64_t instance_id,
                                scoped_ptr<base::Value> msg);
 
+  void PostBinaryMessageToJSCallback(int64_t instance_id, const char* data,
+                                     size_t size);
+
   void SendSyncReplyToJSCallback(int64_t instance_id,
                                  scoped_ptr<base::Value> reply);
 
+  static void PostAsyncReplyToJSCallback(
+      scoped_refptr<base::MessageLoopProxy> task_runner,
+      base::WeakPtr<XWalkExtensionServer> server,
+      int64_t instance_id, int request_id, scoped_ptr<base::Value> reply);
+
+  void SendAsyncReplyToJSCallback(int64_t instance_id, int request_id,
+                                  scoped_ptr<base::Value> reply);
+
+  void SendSyncReplyError(IPC::Message* ipc_reply);
+
   void DeleteInstanceMap();
 
   bool ValidateExtensionEntryPoints(const base::ListValue& entry_points);
@@ -104,6 +137,9 @@ class XWalkExtensionServer : public IPC::Listener,
   base::Lock sender_lock_;
   IPC::Sender* sender_;
 
+  // Coalesces the messages posted by the instances to the renderer.
+  scoped_refptr<XWalkExtensionMessageBatcher> post_message_batcher_;
+
   typedef std::map<std::string, XWalkExtension*> ExtensionMap;
   ExtensionMap extensions_;
 
@@ -117,6 +153,14 @@ class XWalkExtensionServer : public IPC::Listener,
   XWalkExtension::PermissionsDelegate* permissions_delegate_;
 };
 
+// Loads and initializes the external extensions found in |dir| without
+// registering them in a server. Used by the shared extension process, that
+// exposes the same extensions through the servers of several channels.
+void LoadExternalExtensionsInDirectory(
+    const base::FilePath& dir, const base::ValueMap& runtime_variables,
+    XWalkExtension::PermissionsDelegate* permissions_delegate,
+    ScopedVector<XWalkExternalExtension>* extensions);
+
 std::vector<std::string> RegisterExternalExtensionsInDirectory(
     XWalkExtensionServer* server, const base::FilePath& dir,
     const base::ValueMap& runtime_variables);
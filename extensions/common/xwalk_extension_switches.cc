@@ -23,4 +23,24 @@ const char kXWalkExternalExtensionsPath[] = "external-extensions-path";
 // Useful values might be "valgrind" or "xterm -e gdb --args".
 const char kXWalkExtensionCmdPrefix[] = "xwalk-extension-cmd-prefix";
 
+// Run the in process extensions of different render processes in a pool of
+// extension threads instead of a single one, so a slow extension doesn't
+// block the extensions of other applications. The pool has one thread per
+// core unless a size is given, e.g. "--xwalk-extension-thread-pool=2".
+const char kXWalkExtensionThreadPool[] = "xwalk-extension-thread-pool";
+
+// Share the extension processes between render processes instead of starting
+// one per render process, so the external extensions are loaded only once.
+// Each render process still gets its own channel and instances. One shared
+// process is used unless a size is given, e.g.
+// "--xwalk-extension-process-pool=2". Runtime variables read by extensions
+// while being initialized are empty in this mode.
+const char kXWalkExtensionProcessPool[] = "xwalk-extension-process-pool";
+
+// Keep an extension process launched in advance, with the external extensions
+// already loaded, and hand it to the next render process. With the process
+// pool, all the shared processes are launched in advance instead. Runtime
+// variables read by extensions while being initialized are empty in this mode.
+const char kXWalkPrelaunchExtensionProcess[] = "prelaunch-extension-process";
+
 }  // namespace switches
@@ -12,6 +12,9 @@ extern const char kXWalkDisableExtensionProcess[];
 extern const char kXWalkExtensionProcess[];
 extern const char kXWalkExternalExtensionsPath[];
 extern const char kXWalkExtensionCmdPrefix[];
+extern const char kXWalkExtensionThreadPool[];
+extern const char kXWalkExtensionProcessPool[];
+extern const char kXWalkPrelaunchExtensionProcess[];
 
 }  // namespace switches
 
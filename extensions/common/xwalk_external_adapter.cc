@@ -79,6 +79,14 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &messagingInterface1;
   }
 
+  if (!strcmp(name, XW_BINARY_MESSAGING_INTERFACE_1)) {
+    static const XW_BinaryMessagingInterface_1 binaryMessagingInterface1 = {
+      BinaryMessagingRegister,
+      BinaryMessagingPostMessage
+    };
+    return &binaryMessagingInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1)) {
     static const XW_Internal_SyncMessagingInterface_1
         syncMessagingInterface1 = {
@@ -88,6 +96,14 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &syncMessagingInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_ASYNC_REQUEST_INTERFACE_1)) {
+    static const XW_Internal_AsyncRequestInterface_1 asyncRequestInterface1 = {
+      AsyncRequestRegister,
+      AsyncRequestSendReply
+    };
+    return &asyncRequestInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_ENTRY_POINTS_INTERFACE_1)) {
     static const XW_Internal_EntryPointsInterface_1 entryPointsInterface1 = {
       EntryPointsSetExtraJSEntryPoints
@@ -102,6 +118,14 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &runtimeInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_RUNTIME_INTERFACE_2)) {
+    static const XW_Internal_RuntimeInterface_2 runtimeInterface2 = {
+      RuntimeGetStringVariable,
+      RuntimeGetInstanceStringVariable
+    };
+    return &runtimeInterface2;
+  }
+
   if (!strcmp(name, XW_INTERNAL_PERMISSIONS_INTERFACE_1)) {
     static const XW_Internal_PermissionsInterface_1 permissionsInterface1 = {
       PermissionsCheckAPIAccessControl,
@@ -110,6 +134,15 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &permissionsInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_PERMISSIONS_INTERFACE_2)) {
+    static const XW_Internal_PermissionsInterface_2 permissionsInterface2 = {
+      PermissionsCheckAPIAccessControl,
+      PermissionsRegisterPermissions,
+      PermissionsCheckInstanceAPIAccessControl
+    };
+    return &permissionsInterface2;
+  }
+
   LOG(WARNING) << "Interface '" << name << "' is not supported.";
   return NULL;
 }
@@ -150,22 +183,34 @@ void XWalkExternalAdapter::LogInvalidCall(
 
 int XWalkExternalAdapter::PermissionsCheckAPIAccessControl(XW_Extension xw,
     const char* api_name) {
-  XWalkExtension* ptr = GetExtension(xw);
+  XWalkExternalExtension* ptr = GetExtension(xw);
   if (!ptr) {
     LogInvalidCall(xw, "Extension", "Permissions", "CheckAPIAccessControl");
     return XW_ERROR;
   }
-  return ptr->CheckAPIAccessControl(api_name) ? XW_OK : XW_ERROR;
+  return ptr->PermissionsCheckAPIAccessControl(api_name) ? XW_OK : XW_ERROR;
 }
 
 int XWalkExternalAdapter::PermissionsRegisterPermissions(XW_Extension xw,
     const char* perm_table) {
-  XWalkExtension* ptr = GetExtension(xw);
+  XWalkExternalExtension* ptr = GetExtension(xw);
   if (!ptr) {
     LogInvalidCall(xw, "Extension", "Permissions", "RegisterPermissions");
     return XW_ERROR;
   }
-  return ptr->RegisterPermissions(perm_table) ? XW_OK : XW_ERROR;
+  return ptr->PermissionsRegisterPermissions(perm_table) ? XW_OK : XW_ERROR;
+}
+
+int XWalkExternalAdapter::PermissionsCheckInstanceAPIAccessControl(
+    XW_Instance xw, const char* api_name) {
+  XWalkExternalInstance* ptr = GetInstance(xw);
+  if (!ptr) {
+    LogInvalidCall(xw, "Instance", "Permissions",
+                   "CheckInstanceAPIAccessControl");
+    return XW_ERROR;
+  }
+  return ptr->PermissionsCheckInstanceAPIAccessControl(api_name) ?
+      XW_OK : XW_ERROR;
 }
 
 }  // namespace extensions
@@ -8,6 +8,8 @@
 #include <map>
 #include "base/memory/singleton.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_AsyncRequest.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessage.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
 #include "xwalk/extensions/public/XW_Extension_Permissions.h"
@@ -116,24 +118,39 @@ class XWalkExternalAdapter {
   DEFINE_FUNCTION_1(Extension, EntryPoints,
                     SetExtraJSEntryPoints, const char**);
 
-  // XW_Internal_PermissionsInterface_1 from XW_Extension_Permissions.h
+  // XW_Internal_PermissionsInterface_2 from XW_Extension_Permissions.h
   static int PermissionsCheckAPIAccessControl(XW_Extension xw,
       const char* api_name);
   static int PermissionsRegisterPermissions(XW_Extension xw,
       const char* perm_table);
+  static int PermissionsCheckInstanceAPIAccessControl(XW_Instance xw,
+      const char* api_name);
 
   // XW_MessagingInterface_1 from XW_Extension.h.
   DEFINE_FUNCTION_1(Extension, Messaging, Register, XW_HandleMessageCallback);
   DEFINE_FUNCTION_1(Instance, Messaging, PostMessage, const char*);
 
+  // XW_BinaryMessagingInterface_1 from XW_Extension_BinaryMessage.h.
+  DEFINE_FUNCTION_1(Extension, BinaryMessaging, Register,
+                    XW_HandleBinaryMessageCallback);
+  DEFINE_FUNCTION_2(Instance, BinaryMessaging, PostMessage, const char*,
+                    size_t);
+
   // XW_Internal_SyncMessaging_1 from XW_Extension_SyncMessage.h.
   DEFINE_FUNCTION_1(Extension, SyncMessaging, Register,
                     XW_HandleSyncMessageCallback);
   DEFINE_FUNCTION_1(Instance, SyncMessaging, SetSyncReply, const char*);
 
-  // XW_Internal_Runtime_1 from XW_Extension_Runtime.h
+  // XW_Internal_AsyncRequestInterface_1 from XW_Extension_AsyncRequest.h.
+  DEFINE_FUNCTION_1(Extension, AsyncRequest, Register,
+                    XW_HandleAsyncRequestCallback);
+  DEFINE_FUNCTION_2(Instance, AsyncRequest, SendReply, int32_t, const char*);
+
+  // XW_Internal_Runtime_2 from XW_Extension_Runtime.h
   DEFINE_FUNCTION_3(Extension, Runtime, GetStringVariable, const char *,
                     char*, size_t);
+  DEFINE_FUNCTION_3(Instance, Runtime, GetInstanceStringVariable,
+                    const char*, char*, size_t);
 
   typedef std::map<XW_Extension, XWalkExternalExtension*> ExtensionMap;
   ExtensionMap extension_map_;
@@ -22,7 +22,9 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       destroyed_instance_callback_(NULL),
       shutdown_callback_(NULL),
       handle_msg_callback_(NULL),
+      handle_binary_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
+      handle_async_request_callback_(NULL),
       initialized_(false),
       library_path_(path) {
 }
@@ -78,7 +80,14 @@ bool XWalkExternalExtension::Initialize() {
 XWalkExtensionInstance* XWalkExternalExtension::CreateInstance() {
   XW_Instance xw_instance =
       XWalkExternalAdapter::GetInstance()->GetNextXWInstance();
-  return new XWalkExternalInstance(this, xw_instance);
+  return new XWalkExternalInstance(this, xw_instance, NULL);
+}
+
+XWalkExtensionInstance* XWalkExternalExtension::CreateInstanceWithContext(
+    InstanceContext* context) {
+  XW_Instance xw_instance =
+      XWalkExternalAdapter::GetInstance()->GetNextXWInstance();
+  return new XWalkExternalInstance(this, xw_instance, context);
 }
 
 #define RETURN_IF_INITIALIZED(FUNCTION)                          \
@@ -119,12 +128,24 @@ void XWalkExternalExtension::MessagingRegister(
   handle_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::BinaryMessagingRegister(
+    XW_HandleBinaryMessageCallback callback) {
+  RETURN_IF_INITIALIZED("Register from BinaryMessagingInterface");
+  handle_binary_msg_callback_ = callback;
+}
+
 void XWalkExternalExtension::SyncMessagingRegister(
     XW_HandleSyncMessageCallback callback) {
   RETURN_IF_INITIALIZED("Register from Internal_SyncMessagingInterface");
   handle_sync_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::AsyncRequestRegister(
+    XW_HandleAsyncRequestCallback callback) {
+  RETURN_IF_INITIALIZED("Register from Internal_AsyncRequestInterface");
+  handle_async_request_callback_ = callback;
+}
+
 void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
     const char** entry_points) {
   RETURN_IF_INITIALIZED("SetExtraJSEntryPoints from EntryPoints");
@@ -138,10 +159,45 @@ void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
   set_entry_points(entries);
 }
 
+XWalkExternalInstance* XWalkExternalExtension::GetCurrentInstance() const {
+  XWalkExternalInstance* instance = XWalkExternalInstance::GetCurrent();
+  if (instance && instance->extension_ == this)
+    return instance;
+  return NULL;
+}
+
 void XWalkExternalExtension::RuntimeGetStringVariable(const char* key,
     char* value, size_t value_len) {
-  const base::ValueMap::const_iterator it = runtime_variables_.find(key);
-  if (it != runtime_variables_.end()) {
+  XWalkExternalInstance* instance = GetCurrentInstance();
+  if (instance) {
+    instance->RuntimeGetInstanceStringVariable(key, value, value_len);
+    return;
+  }
+  GetStringVariable(runtime_variables_, key, value, value_len);
+}
+
+bool XWalkExternalExtension::PermissionsCheckAPIAccessControl(
+    const char* api_name) {
+  XWalkExternalInstance* instance = GetCurrentInstance();
+  if (instance)
+    return instance->PermissionsCheckInstanceAPIAccessControl(api_name);
+  return CheckAPIAccessControl(api_name);
+}
+
+bool XWalkExternalExtension::PermissionsRegisterPermissions(
+    const char* perm_table) {
+  XWalkExternalInstance* instance = GetCurrentInstance();
+  if (instance)
+    return instance->RegisterPermissions(perm_table);
+  return RegisterPermissions(perm_table);
+}
+
+// static
+void XWalkExternalExtension::GetStringVariable(
+    const base::ValueMap& runtime_variables, const char* key, char* value,
+    size_t value_len) {
+  const base::ValueMap::const_iterator it = runtime_variables.find(key);
+  if (it != runtime_variables.end()) {
     std::string json;
     base::JSONWriter::Write(it->second, &json);
     strncpy(value, json.c_str(), value_len);
@@ -11,6 +11,8 @@
 #include "base/scoped_native_library.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_AsyncRequest.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessage.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace base {
@@ -32,6 +34,14 @@ class XWalkExternalInstance;
 // library.
 class XWalkExternalExtension : public XWalkExtension {
  public:
+  // The runtime variables and the permissions of the application an instance
+  // is created for. An extension shared by several applications resolves
+  // them per instance instead of using its own ones.
+  class InstanceContext : public XWalkExtension::PermissionsDelegate {
+   public:
+    virtual const base::ValueMap& runtime_variables() const = 0;
+  };
+
   explicit XWalkExternalExtension(const base::FilePath& path);
 
   virtual ~XWalkExternalExtension();
@@ -42,6 +52,10 @@ class XWalkExternalExtension : public XWalkExtension {
     runtime_variables_ = runtime_variables;
   }
 
+  // Creates an instance using the runtime variables and the permissions of
+  // |context|, which must outlive it.
+  XWalkExtensionInstance* CreateInstanceWithContext(InstanceContext* context);
+
  private:
   friend class XWalkExternalAdapter;
   friend class XWalkExternalInstance;
@@ -65,12 +79,34 @@ class XWalkExternalExtension : public XWalkExtension {
   // XW_MessagingInterface_1 (from XW_Extension.h) implementation.
   void MessagingRegister(XW_HandleMessageCallback callback);
 
+  // XW_BinaryMessagingInterface_1 (from XW_Extension_BinaryMessage.h)
+  // implementation.
+  void BinaryMessagingRegister(XW_HandleBinaryMessageCallback callback);
+
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
 
-  // XW_Internal_BrowserInterface_1 (from XW_Browser.h) implementation.
+  // XW_Internal_AsyncRequestInterface_1 (from XW_Extension_AsyncRequest.h)
+  // implementation.
+  void AsyncRequestRegister(XW_HandleAsyncRequestCallback callback);
+
+  // XW_Internal_RuntimeInterface_2 (from XW_Extension_Runtime.h)
+  // implementation.
   void RuntimeGetStringVariable(const char* key, char* value, size_t value_len);
 
+  // XW_Internal_PermissionsInterface_2 (from XW_Extension_Permissions.h)
+  // implementation.
+  bool PermissionsCheckAPIAccessControl(const char* api_name);
+  bool PermissionsRegisterPermissions(const char* perm_table);
+
+  // Returns the instance of this extension whose callback is running on the
+  // current thread, if any.
+  XWalkExternalInstance* GetCurrentInstance() const;
+
+  static void GetStringVariable(const base::ValueMap& runtime_variables,
+                                const char* key, char* value,
+                                size_t value_len);
+
   base::FilePath library_path_;
   base::ScopedNativeLibrary library_;
   XW_Extension xw_extension_;
@@ -79,7 +115,9 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_DestroyedInstanceCallback destroyed_instance_callback_;
   XW_ShutdownCallback shutdown_callback_;
   XW_HandleMessageCallback handle_msg_callback_;
+  XW_HandleBinaryMessageCallback handle_binary_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
+  XW_HandleAsyncRequestCallback handle_async_request_callback_;
 
   bool initialized_;
 
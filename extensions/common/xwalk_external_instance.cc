@@ -5,34 +5,80 @@
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
 #include <string>
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/threading/thread_local.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+base::LazyInstance<base::ThreadLocalPointer<XWalkExternalInstance> >::Leaky
+    g_current_instance = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// Makes an instance the current one while one of its callbacks runs, so the
+// calls the extension makes with its XW_Extension resolve the runtime
+// variables and the permissions of that instance.
+class XWalkExternalInstance::ScopedCallback {
+ public:
+  explicit ScopedCallback(XWalkExternalInstance* instance)
+      : previous_(g_current_instance.Get().Get()) {
+    g_current_instance.Get().Set(instance);
+  }
+
+  ~ScopedCallback() {
+    g_current_instance.Get().Set(previous_);
+  }
+
+ private:
+  XWalkExternalInstance* previous_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCallback);
+};
+
 XWalkExternalInstance::XWalkExternalInstance(
-    XWalkExternalExtension* extension, XW_Instance xw_instance)
+    XWalkExternalExtension* extension, XW_Instance xw_instance,
+    XWalkExternalExtension::InstanceContext* context)
     : xw_instance_(xw_instance),
       extension_(extension),
+      context_(context),
       instance_data_(NULL),
       is_handling_sync_msg_(false) {
   XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
   XW_CreatedInstanceCallback callback = extension_->created_instance_callback_;
-  if (callback)
+  if (callback) {
+    ScopedCallback scoped_callback(this);
     callback(xw_instance_);
+  }
 }
 
 XWalkExternalInstance::~XWalkExternalInstance() {
   XW_DestroyedInstanceCallback callback =
       extension_->destroyed_instance_callback_;
-  if (callback)
+  if (callback) {
+    ScopedCallback scoped_callback(this);
     callback(xw_instance_);
+  }
   XWalkExternalAdapter::GetInstance()->UnregisterInstance(this);
 }
 
+// static
+XWalkExternalInstance* XWalkExternalInstance::GetCurrent() {
+  return g_current_instance.Get().Get();
+}
+
 void XWalkExternalInstance::HandleMessage(scoped_ptr<base::Value> msg) {
+  if (msg->IsType(base::Value::TYPE_BINARY)) {
+    base::BinaryValue* binary_msg = static_cast<base::BinaryValue*>(msg.get());
+    HandleBinaryMessage(binary_msg->GetBuffer(), binary_msg->GetSize());
+    return;
+  }
+
   XW_HandleMessageCallback callback = extension_->handle_msg_callback_;
   if (!callback) {
     LOG(WARNING) << "Ignoring message sent for external extension '"
@@ -42,9 +88,26 @@ void XWalkExternalInstance::HandleMessage(scoped_ptr<base::Value> msg) {
 
   std::string string_msg;
   msg->GetAsString(&string_msg);
+  ScopedCallback scoped_callback(this);
   callback(xw_instance_, string_msg.c_str());
 }
 
+void XWalkExternalInstance::HandleBinaryMessage(const char* data,
+                                                size_t size) {
+  XW_HandleBinaryMessageCallback callback =
+      extension_->handle_binary_msg_callback_;
+  if (!callback) {
+    LOG(WARNING) << "Ignoring binary message sent for external extension '"
+                 << extension_->name() << "' which doesn't support it.";
+    return;
+  }
+
+  // The buffer is handed to the extension as is, usually it points inside the
+  // received IPC message and is only valid while the callback runs.
+  ScopedCallback scoped_callback(this);
+  callback(xw_instance_, data, size);
+}
+
 void XWalkExternalInstance::HandleSyncMessage(scoped_ptr<base::Value> msg) {
   XW_HandleSyncMessageCallback callback = extension_->handle_sync_msg_callback_;
   if (!callback) {
@@ -56,9 +119,25 @@ void XWalkExternalInstance::HandleSyncMessage(scoped_ptr<base::Value> msg) {
   std::string string_msg;
   msg->GetAsString(&string_msg);
 
+  ScopedCallback scoped_callback(this);
   callback(xw_instance_, string_msg.c_str());
 }
 
+void XWalkExternalInstance::HandleAsyncRequest(int request_id,
+                                               scoped_ptr<base::Value> msg) {
+  XW_HandleAsyncRequestCallback callback =
+      extension_->handle_async_request_callback_;
+  if (!callback) {
+    XWalkExtensionInstance::HandleAsyncRequest(request_id, msg.Pass());
+    return;
+  }
+
+  std::string string_msg;
+  msg->GetAsString(&string_msg);
+  ScopedCallback scoped_callback(this);
+  callback(xw_instance_, request_id, string_msg.c_str());
+}
+
 void XWalkExternalInstance::CoreSetInstanceData(void* data) {
   instance_data_ = data;
 }
@@ -71,9 +150,42 @@ void XWalkExternalInstance::MessagingPostMessage(const char* msg) {
   PostMessageToJS(scoped_ptr<base::Value>(new base::StringValue(msg)));
 }
 
+void XWalkExternalInstance::BinaryMessagingPostMessage(const char* data,
+                                                       size_t size) {
+  PostBinaryMessageToJS(data, size);
+}
+
 void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
   SendSyncReplyToJS(scoped_ptr<base::Value>(new base::StringValue(reply)));
 }
 
+void XWalkExternalInstance::AsyncRequestSendReply(int32_t request_id,
+                                                  const char* reply) {
+  scoped_ptr<base::Value> value;
+  if (reply)
+    value.reset(new base::StringValue(reply));
+  SendAsyncReplyToJS(request_id, value.Pass());
+}
+
+void XWalkExternalInstance::RuntimeGetInstanceStringVariable(
+    const char* key, char* value, size_t value_len) {
+  XWalkExternalExtension::GetStringVariable(
+      context_ ? context_->runtime_variables() : extension_->runtime_variables_,
+      key, value, value_len);
+}
+
+bool XWalkExternalInstance::PermissionsCheckInstanceAPIAccessControl(
+    const char* api_name) {
+  if (context_)
+    return context_->CheckAPIAccessControl(extension_->name(), api_name);
+  return extension_->CheckAPIAccessControl(api_name);
+}
+
+bool XWalkExternalInstance::RegisterPermissions(const char* perm_table) {
+  if (context_)
+    return context_->RegisterPermissions(extension_->name(), perm_table);
+  return extension_->RegisterPermissions(perm_table);
+}
+
 }  // namespace extensions
 }  // namespace xwalk
@@ -6,15 +6,18 @@
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_INSTANCE_H_
 
 #include <string>
+#include "base/values.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_AsyncRequest.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessage.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace xwalk {
 namespace extensions {
 
 class XWalkExternalAdapter;
-class XWalkExternalExtension;
 
 // XWalkExternalInstance implements the concrete context of execution of an
 // external extension.
@@ -23,18 +26,31 @@ class XWalkExternalExtension;
 // library, and with XWalkExternalExtension to get the appropriate
 // callbacks. The associated XW_Instance is used to identify this context when
 // calling the shared library.
+//
+// An instance created with a |context| resolves the runtime variables and the
+// permissions through it, otherwise through its extension.
 class XWalkExternalInstance : public XWalkExtensionInstance {
  public:
   XWalkExternalInstance(XWalkExternalExtension* extension,
-                        XW_Instance xw_instance);
+                        XW_Instance xw_instance,
+                        XWalkExternalExtension::InstanceContext* context);
   virtual ~XWalkExternalInstance();
 
  private:
   friend class XWalkExternalAdapter;
+  friend class XWalkExternalExtension;
+
+  class ScopedCallback;
+
+  // Returns the instance whose callback is running on the current thread.
+  static XWalkExternalInstance* GetCurrent();
 
   // XWalkExtensionInstance implementation.
   virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE;
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg) OVERRIDE;
+  virtual void HandleAsyncRequest(int request_id,
+                                  scoped_ptr<base::Value> msg) OVERRIDE;
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE;
 
   // XW_CoreInterface_1 (from XW_Extension.h) implementation.
   void CoreSetInstanceData(void* data);
@@ -43,13 +59,33 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // XW_MessagingInterface_1 (from XW_Extension.h) implementation.
   void MessagingPostMessage(const char* msg);
 
+  // XW_BinaryMessagingInterface_1 (from XW_Extension_BinaryMessage.h)
+  // implementation.
+  void BinaryMessagingPostMessage(const char* data, size_t size);
+
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension_SyncMessage.h)
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
 
+  // XW_Internal_AsyncRequestInterface_1 (from XW_Extension_AsyncRequest.h)
+  // implementation.
+  void AsyncRequestSendReply(int32_t request_id, const char* reply);
+
+  // XW_Internal_RuntimeInterface_2 (from XW_Extension_Runtime.h)
+  // implementation.
+  void RuntimeGetInstanceStringVariable(const char* key, char* value,
+                                        size_t value_len);
+
+  // XW_Internal_PermissionsInterface_2 (from XW_Extension_Permissions.h)
+  // implementation.
+  bool PermissionsCheckInstanceAPIAccessControl(const char* api_name);
+
+  bool RegisterPermissions(const char* perm_table);
+
   XW_Instance xw_instance_;
   std::string sync_reply_;
   XWalkExternalExtension* extension_;
+  XWalkExternalExtension::InstanceContext* context_;
   void* instance_data_;
   bool is_handling_sync_msg_;
 
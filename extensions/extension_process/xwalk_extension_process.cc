@@ -9,18 +9,139 @@
 #include "base/command_line.h"
 #include "base/files/file_path.h"
 #include "base/message_loop/message_loop.h"
+#include "base/stl_util.h"
 #include "ipc/ipc_switches.h"
 #include "ipc/ipc_message_macros.h"
 #include "ipc/ipc_sync_channel.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+#include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+// Exposes one of the extensions loaded by a shared extension process to the
+// server of a render process channel, its instances get the runtime variables
+// and the permissions of |context|. The wrapped extension is owned by
+// XWalkExtensionProcess and outlives the servers.
+class SharedExtension : public XWalkExtension {
+ public:
+  SharedExtension(XWalkExternalExtension* extension,
+                  XWalkExternalExtension::InstanceContext* context)
+      : extension_(extension),
+        context_(context) {
+    set_name(extension->name());
+    set_javascript_api(extension->javascript_api());
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return extension_->CreateInstanceWithContext(context_);
+  }
+
+  virtual const base::ListValue& entry_points() const OVERRIDE {
+    return extension_->entry_points();
+  }
+
+ private:
+  XWalkExternalExtension* extension_;
+  XWalkExternalExtension::InstanceContext* context_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedExtension);
+};
+
+void ToValueMap(base::ListValue* lv, base::ValueMap* vm) {
+  vm->clear();
+
+  for (base::ListValue::iterator it = lv->begin(); it != lv->end(); it++) {
+    base::DictionaryValue* dv;
+    if (!(*it)->GetAsDictionary(&dv))
+      continue;
+    for (base::DictionaryValue::Iterator dit(*dv);
+        !dit.IsAtEnd(); dit.Advance())
+      (*vm)[dit.key()] = dit.value().DeepCopy();
+  }
+}
+
+}  // namespace
+
+// The channel to one of the render processes served by a shared extension
+// process. Messages are dispatched to a server of its own, whose instances use
+// the runtime variables and the permissions of the render process.
+class XWalkExtensionProcess::RenderProcessChannel
+    : public IPC::Listener,
+      public XWalkExternalExtension::InstanceContext {
+ public:
+  RenderProcessChannel(XWalkExtensionProcess* process, int render_process_id,
+                       const base::ValueMap& runtime_variables)
+      : process_(process),
+        render_process_id_(render_process_id),
+        runtime_variables_(runtime_variables) {
+    server_.set_permissions_delegate(this);
+    ScopedVector<XWalkExternalExtension>::const_iterator it =
+        process->shared_extensions_.begin();
+    for (; it != process->shared_extensions_.end(); ++it) {
+      server_.RegisterExtension(
+          scoped_ptr<XWalkExtension>(new SharedExtension(*it, this)));
+    }
+  }
+
+  virtual ~RenderProcessChannel() {
+    server_.Invalidate();
+    channel_.reset();
+    STLDeleteValues(&runtime_variables_);
+  }
+
+  IPC::ChannelHandle Connect() {
+    IPC::ChannelHandle handle;
+    channel_ = process_->CreateChannelToRenderProcess(this, &handle);
+    server_.Initialize(channel_.get());
+    return handle;
+  }
+
+  int render_process_id() const { return render_process_id_; }
+  XWalkExtensionPermissionCache* permission_cache() {
+    return &permission_cache_;
+  }
+
+  // XWalkExternalExtension::InstanceContext implementation.
+  virtual const base::ValueMap& runtime_variables() const OVERRIDE {
+    return runtime_variables_;
+  }
+  virtual bool CheckAPIAccessControl(const std::string& extension_name,
+      const std::string& api_name) OVERRIDE {
+    return process_->CheckAPIAccessControlInCache(
+        &permission_cache_, render_process_id_, extension_name, api_name);
+  }
+  virtual bool RegisterPermissions(const std::string& extension_name,
+      const std::string& perm_table) OVERRIDE {
+    return process_->RegisterPermissionsForRenderProcess(
+        render_process_id_, extension_name, perm_table);
+  }
+
+ private:
+  // IPC::Listener implementation.
+  virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE {
+    return server_.OnMessageReceived(message);
+  }
+
+  XWalkExtensionProcess* process_;
+  int render_process_id_;
+  base::ValueMap runtime_variables_;
+  XWalkExtensionPermissionCache permission_cache_;
+  XWalkExtensionServer server_;
+  scoped_ptr<IPC::SyncChannel> channel_;
+
+  DISALLOW_COPY_AND_ASSIGN(RenderProcessChannel);
+};
+
 XWalkExtensionProcess::XWalkExtensionProcess(
     const IPC::ChannelHandle& channel_handle)
     : shutdown_event_(false, false),
-      io_thread_("XWalkExtensionProcess_IOThread") {
+      io_thread_("XWalkExtensionProcess_IOThread"),
+      is_shared_(CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkExtensionProcessPool)) {
   io_thread_.StartWithOptions(
       base::Thread::Options(base::MessageLoop::TYPE_IO, 0));
 
@@ -33,6 +154,11 @@ XWalkExtensionProcess::~XWalkExtensionProcess() {
   // our MessageFilter set.
   extensions_server_.Invalidate();
 
+  // The servers of the channels destroy their instances, so they must go
+  // before the shared extensions.
+  STLDeleteValues(&render_process_channels_);
+  shared_extensions_.clear();
+
   shutdown_event_.Signal();
   io_thread_.Stop();
 }
@@ -42,28 +168,19 @@ bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionProcess, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_RegisterExtensions,
                         OnRegisterExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CreateRenderProcessChannel,
+                        OnCreateRenderProcessChannel)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CloseRenderProcessChannel,
+                        OnCloseRenderProcessChannel)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CachePermissions,
+                        OnCachePermissions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_ClearPermissionCache,
+                        OnClearPermissionCache)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
 }
 
-namespace {
-
-void ToValueMap(base::ListValue* lv, base::ValueMap* vm) {
-  vm->clear();
-
-  for (base::ListValue::iterator it = lv->begin(); it != lv->end(); it++) {
-    base::DictionaryValue* dv;
-    if (!(*it)->GetAsDictionary(&dv))
-      continue;
-    for (base::DictionaryValue::Iterator dit(*dv);
-        !dit.IsAtEnd(); dit.Advance())
-      (*vm)[dit.key()] = dit.value().DeepCopy();
-  }
-}
-
-}  // namespace
-
 void XWalkExtensionProcess::OnRegisterExtensions(
     const base::FilePath& path, const base::ListValue& browser_variables_lv) {
   if (!path.empty()) {
@@ -72,10 +189,85 @@ void XWalkExtensionProcess::OnRegisterExtensions(
     ToValueMap(&const_cast<base::ListValue&>(browser_variables_lv),
           &browser_variables);
 
-    RegisterExternalExtensionsInDirectory(&extensions_server_, path,
-                                          browser_variables);
+    if (is_shared_) {
+      LoadExternalExtensionsInDirectory(path, browser_variables, this,
+                                        &shared_extensions_);
+    } else {
+      RegisterExternalExtensionsInDirectory(&extensions_server_, path,
+                                            browser_variables);
+    }
   }
-  CreateRenderProcessChannel();
+
+  // A shared process creates the channels as render processes are added.
+  if (!is_shared_)
+    CreateRenderProcessChannel();
+}
+
+void XWalkExtensionProcess::OnCreateRenderProcessChannel(
+    int render_process_id, const base::ListValue& runtime_variables_lv) {
+  if (!is_shared_ || ContainsKey(render_process_channels_, render_process_id))
+    return;
+
+  base::ValueMap runtime_variables;
+  ToValueMap(&const_cast<base::ListValue&>(runtime_variables_lv),
+             &runtime_variables);
+
+  RenderProcessChannel* channel =
+      new RenderProcessChannel(this, render_process_id, runtime_variables);
+  render_process_channels_[render_process_id] = channel;
+
+  std::vector<std::pair<std::string, std::string> >::const_iterator it =
+      shared_permissions_.begin();
+  for (; it != shared_permissions_.end(); ++it) {
+    if (!RegisterPermissionsForRenderProcess(render_process_id, it->first,
+                                             it->second)) {
+      LOG(WARNING) << "Couldn't register the permissions of extension '"
+                   << it->first << "' for render process "
+                   << render_process_id;
+    }
+  }
+
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_SharedRenderProcessChannelCreated(
+          render_process_id, channel->Connect()));
+}
+
+void XWalkExtensionProcess::OnCloseRenderProcessChannel(
+    int render_process_id) {
+  RenderProcessChannelMap::iterator it =
+      render_process_channels_.find(render_process_id);
+  if (it == render_process_channels_.end())
+    return;
+
+  delete it->second;
+  render_process_channels_.erase(it);
+}
+
+XWalkExtensionPermissionCache*
+XWalkExtensionProcess::GetPermissionCache(int render_process_id) {
+  if (!is_shared_)
+    return &permission_cache_;
+
+  RenderProcessChannelMap::iterator it =
+      render_process_channels_.find(render_process_id);
+  if (it == render_process_channels_.end())
+    return NULL;
+  return it->second->permission_cache();
+}
+
+void XWalkExtensionProcess::OnCachePermissions(
+    int render_process_id, const PermissionDecisions& decisions) {
+  XWalkExtensionPermissionCache* permission_cache =
+      GetPermissionCache(render_process_id);
+  if (permission_cache)
+    permission_cache->Add(decisions);
+}
+
+void XWalkExtensionProcess::OnClearPermissionCache(int render_process_id) {
+  XWalkExtensionPermissionCache* permission_cache =
+      GetPermissionCache(render_process_id);
+  if (permission_cache)
+    permission_cache->Clear();
 }
 
 void XWalkExtensionProcess::CreateBrowserProcessChannel(
@@ -96,24 +288,31 @@ void XWalkExtensionProcess::CreateBrowserProcessChannel(
   browser_process_channel_.reset(channel);
 }
 
-void XWalkExtensionProcess::CreateRenderProcessChannel() {
-  IPC::ChannelHandle handle(IPC::Channel::GenerateVerifiedChannelID(
+scoped_ptr<IPC::SyncChannel>
+XWalkExtensionProcess::CreateChannelToRenderProcess(
+    IPC::Listener* listener, IPC::ChannelHandle* handle) {
+  *handle = IPC::ChannelHandle(IPC::Channel::GenerateVerifiedChannelID(
       std::string()));
-  rp_channel_handle_ = handle;
 
-  render_process_channel_.reset(new IPC::SyncChannel(rp_channel_handle_,
-      IPC::Channel::MODE_SERVER, &extensions_server_,
+  scoped_ptr<IPC::SyncChannel> channel(new IPC::SyncChannel(*handle,
+      IPC::Channel::MODE_SERVER, listener,
       io_thread_.message_loop_proxy(), true, &shutdown_event_));
 
 #if defined(OS_POSIX)
     // On POSIX, pass the server-side file descriptor. We use
     // TakeClientFileDescriptor() instead of GetClientFileDescriptor()
     // since the client-side channel will take ownership of the fd.
-    rp_channel_handle_.socket =
-       base::FileDescriptor(render_process_channel_->TakeClientFileDescriptor(),
-          true);
+    handle->socket =
+       base::FileDescriptor(channel->TakeClientFileDescriptor(), true);
 #endif
 
+  return channel.Pass();
+}
+
+void XWalkExtensionProcess::CreateRenderProcessChannel() {
+  render_process_channel_ = CreateChannelToRenderProcess(&extensions_server_,
+                                                         &rp_channel_handle_);
+
   extensions_server_.Initialize(render_process_channel_.get());
 
   browser_process_channel_->Send(
@@ -124,21 +323,39 @@ void XWalkExtensionProcess::CreateRenderProcessChannel() {
 bool XWalkExtensionProcess::CheckAPIAccessControl(
     const std::string& extension_name,
     const std::string& api_name) {
-  PermissionCacheType::iterator iter =
-      permission_cache_.find(extension_name + api_name);
-  if (iter != permission_cache_.end())
-    return iter->second;
+  if (is_shared_) {
+    // The permissions depend on the application of the render process, only
+    // an instance knows which one it serves.
+    LOG(WARNING) << "Denying " << extension_name << "." << api_name
+                 << "(), access control can only be checked for an instance"
+                 << " in a shared extension process.";
+    return false;
+  }
+  return CheckAPIAccessControlInCache(&permission_cache_, 0, extension_name,
+                                      api_name);
+}
 
+bool XWalkExtensionProcess::CheckAPIAccessControlInCache(
+    XWalkExtensionPermissionCache* permission_cache,
+    int render_process_id,
+    const std::string& extension_name,
+    const std::string& api_name) {
   RuntimePermission result = UNDEFINED_RUNTIME_PERM;
-  browser_process_channel_->Send(
-      new XWalkExtensionProcessHostMsg_CheckAPIAccessControl(
-          extension_name, api_name, &result));
+  if (permission_cache->Lookup(extension_name, api_name, &result))
+    return result == ALLOW_SESSION || result == ALLOW_ALWAYS;
+
+  if (is_shared_) {
+    browser_process_channel_->Send(
+        new XWalkExtensionProcessHostMsg_CheckAPIAccessControlForRenderProcess(
+            render_process_id, extension_name, api_name, &result));
+  } else {
+    browser_process_channel_->Send(
+        new XWalkExtensionProcessHostMsg_CheckAPIAccessControl(
+            extension_name, api_name, &result));
+  }
   DLOG(INFO) << extension_name << "." << api_name << "() --> " << result;
-  if (result == ALLOW_SESSION ||
-      result == ALLOW_ALWAYS ||
-      result == DENY_SESSION ||
-      result == DENY_ALWAYS) {
-    permission_cache_[extension_name+api_name] = result;
+  if (IsCacheablePermission(result)) {
+    permission_cache->Set(extension_name, api_name, result);
     return (result == ALLOW_SESSION || result == ALLOW_ALWAYS);
   }
 
@@ -149,6 +366,21 @@ bool XWalkExtensionProcess::CheckAPIAccessControl(
 bool XWalkExtensionProcess::RegisterPermissions(
     const std::string& extension_name,
     const std::string& perm_table) {
+  if (is_shared_) {
+    // Called outside of an instance, usually while the extension is
+    // initialized. The table applies to every render process, including the
+    // ones served later on.
+    shared_permissions_.push_back(std::make_pair(extension_name, perm_table));
+    bool result = true;
+    RenderProcessChannelMap::const_iterator it =
+        render_process_channels_.begin();
+    for (; it != render_process_channels_.end(); ++it) {
+      result &= RegisterPermissionsForRenderProcess(it->first, extension_name,
+                                                    perm_table);
+    }
+    return result;
+  }
+
   bool result;
   browser_process_channel_->Send(
       new XWalkExtensionProcessHostMsg_RegisterPermissions(
@@ -156,5 +388,16 @@ bool XWalkExtensionProcess::RegisterPermissions(
   return result;
 }
 
+bool XWalkExtensionProcess::RegisterPermissionsForRenderProcess(
+    int render_process_id,
+    const std::string& extension_name,
+    const std::string& perm_table) {
+  bool result = false;
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_RegisterPermissionsForRenderProcess(
+          render_process_id, extension_name, perm_table, &result));
+  return result;
+}
+
 }  // namespace extensions
 }  // namespace xwalk
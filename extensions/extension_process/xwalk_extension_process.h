@@ -7,12 +7,16 @@
 
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "base/memory/scoped_vector.h"
 #include "base/values.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_listener.h"
+#include "xwalk/extensions/common/xwalk_extension_permission_cache.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
@@ -29,6 +33,7 @@ namespace extensions {
 
 class XWalkExtension;
 class XWalkExtensionRunner;
+class XWalkExternalExtension;
 
 
 // This class represents the Extension Process itself.
@@ -37,6 +42,10 @@ class XWalkExtensionRunner;
 // of the extension <-> render process channel.
 // It will be responsible for handling the native side (instances) of
 // External extensions through its XWalkExtensionServer.
+//
+// When launched with switches::kXWalkExtensionProcessPool the process is
+// shared by several render processes. The extensions are loaded once and each
+// render process gets its own channel and server, see RenderProcessChannel.
 class XWalkExtensionProcess : public IPC::Listener,
                               public XWalkExtension::PermissionsDelegate {
  public:
@@ -61,14 +70,60 @@ class XWalkExtensionProcess : public IPC::Listener,
 
   void CreateRenderProcessChannel();
 
+  // Handlers for IPC messages used when the process is shared.
+  void OnCreateRenderProcessChannel(int render_process_id,
+                                    const base::ListValue& runtime_variables);
+  void OnCloseRenderProcessChannel(int render_process_id);
+
+  // Handlers for the permissions pushed by the browser process.
+  void OnCachePermissions(int render_process_id,
+                          const PermissionDecisions& decisions);
+  void OnClearPermissionCache(int render_process_id);
+
+  // Creates the server side of a channel to a render process, and fills
+  // |handle| with what the render process needs to connect to it.
+  scoped_ptr<IPC::SyncChannel> CreateChannelToRenderProcess(
+      IPC::Listener* listener, IPC::ChannelHandle* handle);
+
+  class RenderProcessChannel;
+
+  // Looks |api_name| up in |permission_cache|, asking the browser process on
+  // a miss. |render_process_id| is only used by a shared process.
+  bool CheckAPIAccessControlInCache(
+      XWalkExtensionPermissionCache* permission_cache,
+      int render_process_id,
+      const std::string& extension_name,
+      const std::string& api_name);
+
+  bool RegisterPermissionsForRenderProcess(int render_process_id,
+                                           const std::string& extension_name,
+                                           const std::string& perm_table);
+
   base::WaitableEvent shutdown_event_;
   base::Thread io_thread_;
   scoped_ptr<IPC::SyncChannel> browser_process_channel_;
   XWalkExtensionServer extensions_server_;
   scoped_ptr<IPC::SyncChannel> render_process_channel_;
   IPC::ChannelHandle rp_channel_handle_;
-  typedef std::map<std::string, RuntimePermission> PermissionCacheType;
-  PermissionCacheType permission_cache_;
+  // The cached decisions of the application. Each render process served by a
+  // shared process has a cache of its own, see GetPermissionCache().
+  XWalkExtensionPermissionCache permission_cache_;
+
+  // Returns NULL if |render_process_id| isn't served by a shared process.
+  XWalkExtensionPermissionCache* GetPermissionCache(int render_process_id);
+
+  bool is_shared_;
+
+  // The extensions of a shared process, exposed by the server of each
+  // render process channel.
+  ScopedVector<XWalkExternalExtension> shared_extensions_;
+
+  // Permissions registered by the shared extensions outside of an instance,
+  // registered again for every render process.
+  std::vector<std::pair<std::string, std::string> > shared_permissions_;
+
+  typedef std::map<int, RenderProcessChannel*> RenderProcessChannelMap;
+  RenderProcessChannelMap render_process_channels_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionProcess);
 };
@@ -28,8 +28,14 @@
         'common/android/xwalk_extension_android.h',
         'common/xwalk_extension.cc',
         'common/xwalk_extension.h',
+        'common/xwalk_extension_binary_message.cc',
+        'common/xwalk_extension_binary_message.h',
+        'common/xwalk_extension_direct_channel.cc',
+        'common/xwalk_extension_direct_channel.h',
         'common/xwalk_extension_messages.cc',
         'common/xwalk_extension_messages.h',
+        'common/xwalk_extension_message_batcher.cc',
+        'common/xwalk_extension_message_batcher.h',
         'common/xwalk_extension_server.cc',
         'common/xwalk_extension_server.h',
         'common/xwalk_extension_switches.cc',
@@ -41,6 +47,8 @@
         'common/xwalk_external_extension.h',
         'common/xwalk_external_instance.cc',
         'common/xwalk_external_instance.h',
+        'common/xwalk_extension_permission_cache.cc',
+        'common/xwalk_extension_permission_cache.h',
         'common/xwalk_extension_permission_types.h',
         'extension_process/xwalk_extension_process_main.cc',
         'extension_process/xwalk_extension_process_main.h',
@@ -49,6 +57,8 @@
         'extension_process/xwalk_extension_process_main.cc',
         'extension_process/xwalk_extension_process_main.h',
         'public/XW_Extension.h',
+        'public/XW_Extension_AsyncRequest.h',
+        'public/XW_Extension_BinaryMessage.h',
         'public/XW_Extension_Permissions.h',
         'public/XW_Extension_SyncMessage.h',
         'renderer/xwalk_extension_client.cc',
@@ -6,11 +6,15 @@
       'dependencies': [
         '../../base/base.gyp:base',
         '../../base/base.gyp:run_all_unittests',
+        '../../ipc/ipc.gyp:ipc',
         '../../testing/gtest.gyp:gtest',
         'extensions.gyp:xwalk_extensions',
       ],
       'sources': [
         'browser/xwalk_extension_function_handler_unittest.cc',
+        'common/xwalk_extension_direct_channel_unittest.cc',
+        'common/xwalk_extension_message_batcher_unittest.cc',
+        'common/xwalk_extension_permission_cache_unittest.cc',
         'common/xwalk_extension_server_unittest.cc',
       ],
     },
@@ -0,0 +1,54 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_ASYNCREQUEST_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_ASYNCREQUEST_H_
+
+// NOTE: This file and interfaces marked as internal are not considered stable
+// and can be modified in incompatible ways between Crosswalk versions.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_INTERNAL_ASYNC_REQUEST_INTERFACE: allow JavaScript code to send a
+// request to extension code with extension.sendAsyncRequest(), that returns
+// a Promise settled when the extension replies. Unlike sync messages the
+// renderer doesn't block, many requests can be pending for the same instance
+// and they can be replied in any order, from any thread, by calling the
+// SendReply function with the request id received.
+//
+
+#define XW_INTERNAL_ASYNC_REQUEST_INTERFACE_1 \
+  "XW_InternalAsyncRequestInterface_1"
+#define XW_INTERNAL_ASYNC_REQUEST_INTERFACE \
+  XW_INTERNAL_ASYNC_REQUEST_INTERFACE_1
+
+typedef void (*XW_HandleAsyncRequestCallback)(XW_Instance instance,
+                                              int32_t request_id,
+                                              const char* message);
+
+struct XW_Internal_AsyncRequestInterface_1 {
+  void (*Register)(XW_Extension extension,
+                   XW_HandleAsyncRequestCallback handle_async_request);
+
+  // Resolves the Promise of the request with |reply|. Passing NULL as
+  // |reply| rejects the Promise instead.
+  void (*SendReply)(XW_Instance instance, int32_t request_id,
+                    const char* reply);
+};
+
+typedef struct XW_Internal_AsyncRequestInterface_1
+    XW_Internal_AsyncRequestInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_ASYNCREQUEST_H_
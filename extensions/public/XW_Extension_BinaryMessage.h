@@ -0,0 +1,60 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_BINARYMESSAGE_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_BINARYMESSAGE_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_BINARY_MESSAGING_INTERFACE: Exchange asynchronous messages carrying raw
+// bytes with JavaScript code provided by extension. Unlike the messages from
+// XW_MESSAGING_INTERFACE, binary messages are not required to be valid
+// NULL-terminated UTF-8 strings and are delivered to JavaScript as
+// ArrayBuffer objects.
+//
+
+#define XW_BINARY_MESSAGING_INTERFACE_1 "XW_BinaryMessagingInterface_1"
+#define XW_BINARY_MESSAGING_INTERFACE XW_BINARY_MESSAGING_INTERFACE_1
+
+typedef void (*XW_HandleBinaryMessageCallback)(XW_Instance instance,
+                                               const char* data,
+                                               size_t size);
+
+struct XW_BinaryMessagingInterface_1 {
+  // Register a callback to be called when the JavaScript code associated
+  // with the extension posts an ArrayBuffer or ArrayBufferView using
+  // extension.postMessage(). The buffer is only valid during the execution
+  // of the callback, the extension must copy the data if it needs to keep it.
+  //
+  // String messages are still delivered to the callback registered with
+  // XW_MESSAGING_INTERFACE.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleBinaryMessageCallback handle_message);
+
+  // Post |size| bytes starting at |data| to the web content associated with
+  // the instance. The listener set with extension.setMessageListener() will
+  // receive an ArrayBuffer with a copy of the data. The caller keeps the
+  // ownership of |data|, which can be released as soon as this returns.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostMessage)(XW_Instance instance, const char* data, size_t size);
+};
+
+typedef struct XW_BinaryMessagingInterface_1 XW_BinaryMessagingInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_BINARYMESSAGE_H_
@@ -18,8 +18,10 @@ extern "C" {
 
 #define XW_INTERNAL_PERMISSIONS_INTERFACE_1 \
     "XW_Internal_PermissionsInterface_1"
+#define XW_INTERNAL_PERMISSIONS_INTERFACE_2 \
+    "XW_Internal_PermissionsInterface_2"
 #define XW_INTERNAL_PERMISSIONS_INTERFACE \
-    XW_INTERNAL_PERMISSIONS_INTERFACE_1
+    XW_INTERNAL_PERMISSIONS_INTERFACE_2
 
 //
 // XW_INTERNAL_PERMISSIONS_INTERFACE: provides a way for extensions
@@ -31,7 +33,19 @@ struct XW_Internal_PermissionsInterface_1 {
   int (*RegisterPermissions)(XW_Extension extension, const char* perm_table);
 };
 
-typedef struct XW_Internal_PermissionsInterface_1
+// The permissions depend on the application of an instance when the extension
+// process is shared. CheckAPIAccessControl() and RegisterPermissions() then
+// apply to the instance whose callback is running, if any.
+// CheckInstanceAPIAccessControl() checks the permissions of |instance| and can
+// be called at any time.
+struct XW_Internal_PermissionsInterface_2 {
+  int (*CheckAPIAccessControl)(XW_Extension extension, const char* api_name);
+  int (*RegisterPermissions)(XW_Extension extension, const char* perm_table);
+  int (*CheckInstanceAPIAccessControl)(XW_Instance instance,
+                                       const char* api_name);
+};
+
+typedef struct XW_Internal_PermissionsInterface_2
     XW_Internal_PermissionsInterface;
 
 #ifdef __cplusplus
@@ -18,8 +18,10 @@ extern "C" {
 
 #define XW_INTERNAL_RUNTIME_INTERFACE_1 \
   "XW_Internal_RuntimeInterface_1"
+#define XW_INTERNAL_RUNTIME_INTERFACE_2 \
+  "XW_Internal_RuntimeInterface_2"
 #define XW_INTERNAL_RUNTIME_INTERFACE \
-  XW_INTERNAL_RUNTIME_INTERFACE_1
+  XW_INTERNAL_RUNTIME_INTERFACE_2
 
 //
 // XW_INTERNAL_RUNTIME_INTERFACE: allow extensions to gather information
@@ -33,7 +35,23 @@ struct XW_Internal_RuntimeInterface_1 {
                                    size_t value_len);
 };
 
-typedef struct XW_Internal_RuntimeInterface_1
+// An extension process may be shared by several applications, the variables
+// then depend on the instance. GetRuntimeVariableString() returns the ones of
+// the instance whose callback is running, if any, and the ones of the
+// extension otherwise. GetInstanceRuntimeVariableString() returns the ones of
+// |instance| and can be called at any time.
+struct XW_Internal_RuntimeInterface_2 {
+  void (*GetRuntimeVariableString)(XW_Extension extension,
+                                   const char* key,
+                                   char* value,
+                                   size_t value_len);
+  void (*GetInstanceRuntimeVariableString)(XW_Instance instance,
+                                           const char* key,
+                                           char* value,
+                                           size_t value_len);
+};
+
+typedef struct XW_Internal_RuntimeInterface_2
     XW_Internal_RuntimeInterface;
 
 #ifdef __cplusplus
@@ -4,9 +4,13 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 
+#include "base/message_loop/message_loop_proxy.h"
 #include "base/values.h"
 #include "base/stl_util.h"
+#include "base/strings/string_util.h"
 #include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 
 namespace xwalk {
@@ -15,15 +19,25 @@ namespace extensions {
 XWalkExtensionClient::XWalkExtensionClient()
     : sender_(0),
       next_instance_id_(1) {  // Zero is never used for a valid instance.
+  post_message_batcher_ = new XWalkExtensionMessageBatcher(
+      XWalkExtensionMessageBatcher::TO_NATIVE,
+      base::Bind(&XWalkExtensionClient::Send, base::Unretained(this)));
 }
 
 XWalkExtensionClient::~XWalkExtensionClient() {
+  if (direct_channel_)
+    direct_channel_->Disconnect(XWalkExtensionDirectChannel::CLIENT_SIDE);
+  post_message_batcher_->Invalidate();
   STLDeleteValues(&extension_apis_);
 }
 
 bool XWalkExtensionClient::Send(IPC::Message* msg) {
   DCHECK(sender_);
 
+  if (direct_channel_ && !msg->is_sync() &&
+      direct_channel_->Send(XWalkExtensionDirectChannel::CLIENT_SIDE, msg))
+    return true;
+
   return sender_->Send(msg);
 }
 
@@ -44,6 +58,12 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionClient, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageToJS,
         OnPostMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessagesToJS,
+        OnPostMessagesToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_AsyncReplyToJS,
+        OnAsyncReplyToJS)
+    IPC_MESSAGE_HANDLER_GENERIC(XWalkExtensionClientMsg_PostBinaryMessageToJS,
+        OnPostBinaryMessageToJS(message))
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_InstanceDestroyed,
         OnInstanceDestroyed)
     IPC_MESSAGE_UNHANDLED(handled = false)
@@ -52,7 +72,17 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   return handled;
 }
 
-XWalkExtensionClient::ExtensionCodePoints::ExtensionCodePoints() {
+void XWalkExtensionClient::OnDirectMessage(const IPC::Message& message) {
+  OnMessageReceived(message);
+}
+
+void XWalkExtensionClient::OnDirectPostMessages(
+    int64_t instance_id, scoped_ptr<base::ListValue> msgs) {
+  OnPostMessagesToJS(instance_id, *msgs);
+}
+
+XWalkExtensionClient::ExtensionCodePoints::ExtensionCodePoints()
+    : api_fetched(false) {
 }
 
 XWalkExtensionClient::ExtensionCodePoints::~ExtensionCodePoints() {
@@ -76,12 +106,79 @@ void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
   it->second->HandleMessageFromNative(*value);
 }
 
+void XWalkExtensionClient::OnPostMessagesToJS(int64_t instance_id,
+                                              const base::ListValue& msgs) {
+  base::ListValue::const_iterator msg_it = msgs.begin();
+  for (; msg_it != msgs.end(); ++msg_it) {
+    // The handler is looked up for every message because the listener may
+    // destroy the instance while handling one of them.
+    HandlerMap::const_iterator it = handlers_.find(instance_id);
+    if (it == handlers_.end()) {
+      LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
+
+    // See comment in DestroyInstance() about two step destruction.
+    if (!it->second)
+      return;
+
+    it->second->HandleMessageFromNative(**msg_it);
+  }
+}
+
+void XWalkExtensionClient::OnPostBinaryMessageToJS(
+    const IPC::Message& message) {
+  int64_t instance_id;
+  const char* data;
+  size_t size;
+  if (!ReadBinaryMessage(message, &instance_id, &data, &size)) {
+    LOG(WARNING) << "Invalid binary message received.";
+    return;
+  }
+
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  it->second->HandleBinaryMessageFromNative(data, size);
+}
+
+void XWalkExtensionClient::OnAsyncReplyToJS(int64_t instance_id,
+    int request_id, bool succeeded, const base::ListValue& reply) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't reply to request of invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  const base::Value* value = NULL;
+  if (succeeded)
+    reply.Get(0, &value);
+  it->second->HandleAsyncReplyFromNative(request_id, value);
+}
+
 void XWalkExtensionClient::DestroyInstance(int64_t instance_id) {
   HandlerMap::iterator it = handlers_.find(instance_id);
   if (it == handlers_.end() || !it->second) {
     LOG(WARNING) << "Can't Destroy invalid instance id: " << instance_id;
     return;
   }
+
+  // Messages posted before the destruction are still delivered.
+  post_message_batcher_->Flush();
   Send(new XWalkExtensionServerMsg_DestroyInstance(instance_id));
 
   // Destruction happens in two steps, first we nullify the handler in our map,
@@ -126,12 +223,25 @@ scoped_ptr<base::ListValue> WrapValueInList(scoped_ptr<base::Value> value) {
 
 void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
     scoped_ptr<base::Value> msg) {
-  scoped_ptr<base::ListValue> list_msg = WrapValueInList(msg.Pass());
-  Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
+  if (!msg)
+    return;
+  post_message_batcher_->Post(instance_id, msg.Pass());
+}
+
+void XWalkExtensionClient::PostBinaryMessageToNative(int64_t instance_id,
+    const char* data, size_t size) {
+  // Keep the order with the messages already queued.
+  post_message_batcher_->Flush();
+  Send(CreateBinaryMessage(
+      XWalkExtensionServerMsg_PostBinaryMessageToNative::ID,
+      instance_id, data, size));
 }
 
 scoped_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
+  // The messages posted before the sync message must be handled first.
+  post_message_batcher_->Flush();
+
   scoped_ptr<base::ListValue> wrapped_msg = WrapValueInList(msg.Pass());
   base::ListValue* wrapped_reply = new base::ListValue;
   Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
@@ -142,6 +252,57 @@ scoped_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
   return reply.Pass();
 }
 
+void XWalkExtensionClient::SendAsyncRequestToNative(int64_t instance_id,
+    int request_id, scoped_ptr<base::Value> msg) {
+  // The messages posted before the request must be handled first.
+  post_message_batcher_->Flush();
+
+  if (!msg)
+    msg.reset(base::Value::CreateNullValue());
+  scoped_ptr<base::ListValue> wrapped_msg = WrapValueInList(msg.Pass());
+  Send(new XWalkExtensionServerMsg_SendAsyncRequestToNative(
+      instance_id, request_id, *wrapped_msg));
+}
+
+const std::string& XWalkExtensionClient::GetExtensionAPI(
+    const std::string& extension_name) {
+  ExtensionAPIMap::iterator it = extension_apis_.find(extension_name);
+  if (it == extension_apis_.end())
+    return base::EmptyString();
+
+  ExtensionCodePoints* codepoint = it->second;
+  if (!codepoint->api_fetched) {
+    codepoint->api_fetched = Send(
+        new XWalkExtensionServerMsg_GetExtensionAPI(extension_name,
+                                                    &codepoint->api));
+  }
+  return codepoint->api;
+}
+
+const std::string* XWalkExtensionClient::GetExtensionParseData(
+    const std::string& extension_name, const std::string& key) {
+  ExtensionAPIMap::const_iterator it = extension_apis_.find(extension_name);
+  if (it == extension_apis_.end())
+    return NULL;
+
+  ExtensionCodePoints* codepoint = it->second;
+  if (codepoint->parse_data.empty() || codepoint->parse_data_key != key)
+    return NULL;
+  return &codepoint->parse_data;
+}
+
+void XWalkExtensionClient::SetExtensionParseData(
+    const std::string& extension_name, const std::string& key,
+    const std::string& data) {
+  ExtensionAPIMap::iterator it = extension_apis_.find(extension_name);
+  if (it == extension_apis_.end() || data.empty())
+    return;
+
+  ExtensionCodePoints* codepoint = it->second;
+  codepoint->parse_data_key = key;
+  codepoint->parse_data = data;
+}
+
 void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
   sender_ = sender;
 
@@ -155,8 +316,6 @@ void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
       extensions.begin();
   for (; it != extensions.end(); ++it) {
     ExtensionCodePoints* codepoint = new ExtensionCodePoints;
-    codepoint->api = (*it).js_api;
-
     codepoint->entry_points = (*it).entry_points;
 
     std::string name = (*it).name;
@@ -164,5 +323,23 @@ void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
   }
 }
 
+void XWalkExtensionClient::ConnectDirectChannel() {
+  DCHECK(handlers_.empty());
+
+  int token = 0;
+  if (!Send(new XWalkExtensionServerMsg_GetDirectChannel(&token)) || !token)
+    return;
+
+  direct_channel_ = XWalkExtensionDirectChannel::Take(token);
+  if (!direct_channel_)
+    return;
+
+  direct_channel_->Connect(XWalkExtensionDirectChannel::CLIENT_SIDE, this,
+                           base::MessageLoopProxy::current());
+  post_message_batcher_->SetPostCallback(
+      base::Bind(&XWalkExtensionDirectChannel::PostMessages, direct_channel_,
+                 XWalkExtensionDirectChannel::CLIENT_SIDE));
+}
+
 }  // namespace extensions
 }  // namespace xwalk
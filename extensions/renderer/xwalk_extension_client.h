@@ -10,9 +10,11 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/values.h"
 #include "ipc/ipc_listener.h"
+#include "xwalk/extensions/common/xwalk_extension_direct_channel.h"
 
 namespace base {
 class Value;
@@ -25,6 +27,8 @@ class Sender;
 namespace xwalk {
 namespace extensions {
 
+class XWalkExtensionMessageBatcher;
+
 // This class holds the JavaScript context of Extensions. It lives in the
 // Render Process and communicates directly with its associated
 // XWalkExtensionServer through an IPC channel.
@@ -32,10 +36,17 @@ namespace extensions {
 // Users of this class post (and send sync) messages to specific instances and
 // are able to handle messages from instances by implementing the
 // InstanceHandler interface.
-class XWalkExtensionClient : public IPC::Listener {
+class XWalkExtensionClient : public IPC::Listener,
+                             public XWalkExtensionDirectChannel::Listener {
  public:
   struct InstanceHandler {
     virtual void HandleMessageFromNative(const base::Value& msg) = 0;
+    // |reply| is NULL when the request wasn't succeeded.
+    virtual void HandleAsyncReplyFromNative(int request_id,
+                                            const base::Value* reply) = 0;
+    // |data| points inside the received message, only valid during the call.
+    virtual void HandleBinaryMessageFromNative(const char* data,
+                                               size_t size) = 0;
    protected:
     ~InstanceHandler() {}
   };
@@ -48,18 +59,38 @@ class XWalkExtensionClient : public IPC::Listener {
   void DestroyInstance(int64_t instance_id);
 
   void PostMessageToNative(int64_t instance_id, scoped_ptr<base::Value> msg);
+  // Sends the bytes of an ArrayBuffer without wrapping them in a base::Value,
+  // see xwalk_extension_binary_message.h.
+  void PostBinaryMessageToNative(int64_t instance_id, const char* data,
+                                 size_t size);
   scoped_ptr<base::Value> SendSyncMessageToNative(int64_t instance_id,
       scoped_ptr<base::Value> msg);
+  void SendAsyncRequestToNative(int64_t instance_id, int request_id,
+                                scoped_ptr<base::Value> msg);
 
   void Initialize(IPC::Sender* sender);
 
+  // Asks the server for its direct channel, and uses it for the asynchronous
+  // messages if there's one. Must be called after Initialize(), before any
+  // instance is created.
+  void ConnectDirectChannel();
+
   // IPC::Listener Implementation.
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
 
+  // XWalkExtensionDirectChannel::Listener Implementation.
+  virtual void OnDirectMessage(const IPC::Message& message) OVERRIDE;
+  virtual void OnDirectPostMessages(int64_t instance_id,
+                                    scoped_ptr<base::ListValue> msgs) OVERRIDE;
+
   struct ExtensionCodePoints {
     ExtensionCodePoints();
     ~ExtensionCodePoints();
+    // Only valid once |api_fetched|, see GetExtensionAPI().
     std::string api;
+    bool api_fetched;
+    std::string parse_data_key;
+    std::string parse_data;
     std::vector<std::string> entry_points;
   };
 
@@ -67,14 +98,44 @@ class XWalkExtensionClient : public IPC::Listener {
 
   const ExtensionAPIMap& extension_apis() const { return extension_apis_; }
 
+  // Returns the JavaScript API code of the extension. Only the names and
+  // entry points of the extensions are received by Initialize(), the code is
+  // fetched from the server the first time it is needed and kept for the
+  // other frames.
+  const std::string& GetExtensionAPI(const std::string& extension_name);
+
+  // Returns the preparse data V8 produced when compiling the JavaScript API
+  // of the extension before, or NULL if there's none matching |key|. The key
+  // identifies the compiled code and the V8 version. It only spares the
+  // parsing of the lazy functions, the code is still compiled in each
+  // context.
+  const std::string* GetExtensionParseData(const std::string& extension_name,
+                                           const std::string& key);
+
+  // Keeps |data| in memory for the other frames of this render process. It
+  // never leaves the process: data produced by a renderer can't be trusted
+  // by the others, so nothing is kept across runs either.
+  void SetExtensionParseData(const std::string& extension_name,
+                             const std::string& key,
+                             const std::string& data);
+
  private:
   bool Send(IPC::Message* msg);
 
   // Message Handlers.
   void OnInstanceDestroyed(int64_t instance_id);
   void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessagesToJS(int64_t instance_id, const base::ListValue& msgs);
+  void OnAsyncReplyToJS(int64_t instance_id, int request_id, bool succeeded,
+                        const base::ListValue& reply);
+  void OnPostBinaryMessageToJS(const IPC::Message& message);
 
   IPC::Sender* sender_;
+  scoped_refptr<XWalkExtensionDirectChannel> direct_channel_;
+
+  // Coalesces the messages posted to native during a task, see
+  // XWalkExtensionMessageBatcher.
+  scoped_refptr<XWalkExtensionMessageBatcher> post_message_batcher_;
   ExtensionAPIMap extension_apis_;
 
   typedef std::map<int64_t, InstanceHandler*> HandlerMap;
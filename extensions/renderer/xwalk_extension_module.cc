@@ -5,10 +5,14 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 
+#include <string.h>
+
+#include "base/hash.h"
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "content/public/renderer/v8_value_converter.h"
+#include "third_party/WebKit/public/web/WebArrayBuffer.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
 #include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
@@ -23,18 +27,50 @@ namespace {
 // pointer back to XWalkExtensionModule.
 const char* kXWalkExtensionModule = "kXWalkExtensionModule";
 
+// Finds the bytes of an ArrayBuffer or of the range of its buffer viewed by
+// an ArrayBufferView (typed arrays and DataView). Nothing is copied, |data|
+// is valid while |value| is alive.
+bool GetArrayBufferData(v8::Handle<v8::Value> value, const char** data,
+                        size_t* size) {
+  size_t offset = 0;
+  v8::Handle<v8::Value> buffer_value = value;
+  if (value->IsArrayBufferView()) {
+    v8::Handle<v8::ArrayBufferView> view = value.As<v8::ArrayBufferView>();
+    offset = view->ByteOffset();
+    *size = view->ByteLength();
+    buffer_value = view->Buffer();
+  } else if (!value->IsArrayBuffer()) {
+    return false;
+  }
+
+  scoped_ptr<blink::WebArrayBuffer> buffer(
+      blink::WebArrayBuffer::createFromV8Value(buffer_value));
+  if (!buffer)
+    return false;
+
+  if (value->IsArrayBuffer())
+    *size = buffer->byteLength();
+  *data = static_cast<const char*>(buffer->data()) + offset;
+  return true;
+}
+
+v8::Handle<v8::Value> CreateArrayBuffer(const char* data, size_t size) {
+  blink::WebArrayBuffer buffer = blink::WebArrayBuffer::create(size, 1);
+  memcpy(buffer.data(), data, size);
+  return buffer.toV8Value();
+}
+
 }  // namespace
 
 XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
                                            XWalkModuleSystem* module_system,
-                                           const std::string& extension_name,
-                                           const std::string& extension_code)
+                                           const std::string& extension_name)
     : extension_name_(extension_name),
-      extension_code_(extension_code),
       converter_(content::V8ValueConverter::create()),
       client_(client),
       module_system_(module_system),
-      instance_id_(0) {
+      instance_id_(0),
+      next_request_id_(0) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
   v8::Handle<v8::Object> function_data = v8::Object::New(isolate);
@@ -56,6 +92,14 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
       v8::String::NewFromUtf8(isolate, "setMessageListener"),
       v8::FunctionTemplate::New(
           isolate, SetMessageListenerCallback, function_data));
+  object_template->Set(
+      v8::String::NewFromUtf8(isolate, "postAsyncRequest"),
+      v8::FunctionTemplate::New(
+          isolate, PostAsyncRequestCallback, function_data));
+  object_template->Set(
+      v8::String::NewFromUtf8(isolate, "setAsyncReplyListener"),
+      v8::FunctionTemplate::New(
+          isolate, SetAsyncReplyListenerCallback, function_data));
 
   function_data_.Reset(isolate, function_data);
   object_template_.Reset(isolate, object_template);
@@ -77,6 +121,7 @@ XWalkExtensionModule::~XWalkExtensionModule() {
   object_template_.Reset();
   function_data_.Reset();
   message_listener_.Reset();
+  async_reply_listener_.Reset();
 
   if (instance_id_)
     client_->DestroyInstance(instance_id_);
@@ -101,6 +146,10 @@ std::string CodeToEnsureNamespace(const std::string& extension_name) {
 }
 
 // Wrap API code into a callable form that takes extension object as parameter.
+//
+// The wrapper also implements 'extension.sendAsyncRequest()' on top of the
+// native 'postAsyncRequest' and 'setAsyncReplyListener' functions, keeping the
+// Promises of the pending requests indexed by request id.
 std::string WrapAPICode(const std::string& extension_code,
                         const std::string& extension_name) {
   // We take care here to make sure that line numbering for api_code after
@@ -110,6 +159,23 @@ std::string WrapAPICode(const std::string& extension_code,
       "extension.internal = {};"
       "extension.internal.sendSyncMessage = extension.sendSyncMessage;"
       "delete extension.sendSyncMessage;"
+      "(function(postAsyncRequest, setAsyncReplyListener) {"
+      "var pending = {};"
+      "setAsyncReplyListener(function(id, succeeded, reply) {"
+      "var request = pending[id]; if (!request) return; delete pending[id];"
+      "if (succeeded) request.resolve(reply);"
+      "else request.reject(new Error('Request failed'));"
+      "});"
+      "extension.sendAsyncRequest = function(msg) {"
+      "return new Promise(function(resolve, reject) {"
+      "var id = postAsyncRequest(msg);"
+      "if (typeof id !== 'number') {"
+      "reject(new Error('Could not send request')); return; }"
+      "pending[id] = { resolve: resolve, reject: reject };"
+      "}); };"
+      "})(extension.postAsyncRequest, extension.setAsyncReplyListener);"
+      "delete extension.postAsyncRequest;"
+      "delete extension.setAsyncReplyListener;"
       "var exports = {}; (function() {'use strict'; %s\n})();"
       "%s = exports; });",
       CodeToEnsureNamespace(extension_name).c_str(),
@@ -117,7 +183,20 @@ std::string WrapAPICode(const std::string& extension_code,
       extension_name.c_str());
 }
 
+// Identifies what V8 compiled to produce preparse data, the data is only
+// valid for the same code and the same V8 version.
+std::string GetParseDataKey(const std::string& code) {
+  return base::StringPrintf("%s-%08x", v8::V8::GetVersion(),
+                            base::Hash(code));
+}
+
+// Compiles |code| using the preparse data |parse_data| if not NULL.
+// Otherwise, when |produced_parse_data| is not NULL, it is filled with the
+// preparse data V8 produces for compiling the same code later. This V8 only
+// produces preparse data, not compiled code.
 v8::Handle<v8::Value> RunString(const std::string& code,
+                                const std::string* parse_data,
+                                std::string* produced_parse_data,
                                 std::string* exception) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::EscapableHandleScope handle_scope(isolate);
@@ -128,13 +207,34 @@ v8::Handle<v8::Value> RunString(const std::string& code,
   v8::TryCatch try_catch;
   try_catch.SetVerbose(true);
 
-  v8::Handle<v8::Script> script(v8::Script::Compile(v8_code));
+  v8::ScriptCompiler::CompileOptions options =
+      v8::ScriptCompiler::kNoCompileOptions;
+  v8::ScriptCompiler::CachedData* cached_data = NULL;
+  if (parse_data) {
+    cached_data = new v8::ScriptCompiler::CachedData(
+        reinterpret_cast<const uint8_t*>(parse_data->data()),
+        static_cast<int>(parse_data->size()));
+  } else if (produced_parse_data) {
+    options = v8::ScriptCompiler::kProduceDataToCache;
+  }
+
+  // The source takes the ownership of |cached_data|.
+  v8::ScriptCompiler::Source source(v8_code, cached_data);
+  v8::Handle<v8::Script> script(
+      v8::ScriptCompiler::Compile(isolate, &source, options));
   if (try_catch.HasCaught()) {
     *exception = ExceptionToString(try_catch);
     return handle_scope.Escape(
         v8::Local<v8::Primitive>(v8::Undefined(isolate)));
   }
 
+  if (options == v8::ScriptCompiler::kProduceDataToCache &&
+      source.GetCachedData()) {
+    const v8::ScriptCompiler::CachedData* produced = source.GetCachedData();
+    produced_parse_data->assign(reinterpret_cast<const char*>(produced->data),
+                                produced->length);
+  }
+
   v8::Local<v8::Value> result = script->Run();
   if (try_catch.HasCaught()) {
     *exception = ExceptionToString(try_catch);
@@ -150,12 +250,31 @@ v8::Handle<v8::Value> RunString(const std::string& code,
 void XWalkExtensionModule::LoadExtensionCode(
     v8::Handle<v8::Context> context, v8::Handle<v8::Function> requireNative) {
   CHECK(!instance_id_);
+
+  // The code is fetched only now, when the extension is actually used.
+  const std::string& extension_code = client_->GetExtensionAPI(extension_name_);
+  if (extension_code.empty()) {
+    LOG(WARNING) << "Couldn't get JS API code for " << extension_name_;
+    return;
+  }
+
   instance_id_ = client_->CreateInstance(extension_name_, this);
 
   std::string exception;
-  std::string wrapped_api_code = WrapAPICode(extension_code_, extension_name_);
+  std::string wrapped_api_code = WrapAPICode(extension_code, extension_name_);
+
+  // The preparse data is produced by the first context loading the code in
+  // this render process, and reused by the later ones.
+  std::string parse_data_key = GetParseDataKey(wrapped_api_code);
+  const std::string* parse_data =
+      client_->GetExtensionParseData(extension_name_, parse_data_key);
+  std::string produced_parse_data;
   v8::Handle<v8::Value> result =
-      RunString(wrapped_api_code, &exception);
+      RunString(wrapped_api_code, parse_data, &produced_parse_data, &exception);
+  if (!produced_parse_data.empty()) {
+    client_->SetExtensionParseData(extension_name_, parse_data_key,
+                                   produced_parse_data);
+  }
   if (!result->IsFunction()) {
     LOG(WARNING) << "Couldn't load JS API code for " << extension_name_
       << ": " << exception;
@@ -192,7 +311,7 @@ void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
   v8::Handle<v8::Context> context = module_system_->GetV8Context();
   v8::Context::Scope context_scope(context);
 
-  v8::Handle<v8::Value> v8_value(converter_->ToV8Value(&msg, context));
+  v8::Handle<v8::Value> v8_value(ToV8Value(&msg, context));
   v8::Handle<v8::Function> message_listener =
       v8::Local<v8::Function>::New(isolate, message_listener_);;
 
@@ -204,6 +323,99 @@ void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
         << ExceptionToString(try_catch);
 }
 
+void XWalkExtensionModule::HandleAsyncReplyFromNative(
+    int request_id, const base::Value* reply) {
+  if (async_reply_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  const int argc = 3;
+  v8::Handle<v8::Value> argv[argc] = {
+    v8::Integer::New(isolate, request_id),
+    v8::Boolean::New(isolate, reply != NULL),
+    reply ? ToV8Value(reply, context)
+          : v8::Handle<v8::Value>(v8::Undefined(isolate))
+  };
+  v8::Handle<v8::Function> async_reply_listener =
+      v8::Local<v8::Function>::New(isolate, async_reply_listener_);
+
+  // Settling the Promise only queues its reactions as microtasks, they will
+  // run when the current task finishes.
+  blink::WebScopedMicrotaskSuppression suppression;
+  v8::TryCatch try_catch;
+  async_reply_listener->Call(context->Global(), argc, argv);
+  if (try_catch.HasCaught())
+    LOG(WARNING) << "Exception when running async reply listener: "
+        << ExceptionToString(try_catch);
+}
+
+void XWalkExtensionModule::HandleBinaryMessageFromNative(const char* data,
+                                                         size_t size) {
+  if (message_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  v8::Handle<v8::Value> v8_value(CreateArrayBuffer(data, size));
+  v8::Handle<v8::Function> message_listener =
+      v8::Local<v8::Function>::New(isolate, message_listener_);
+
+  blink::WebScopedMicrotaskSuppression suppression;
+  v8::TryCatch try_catch;
+  message_listener->Call(context->Global(), 1, &v8_value);
+  if (try_catch.HasCaught())
+    LOG(WARNING) << "Exception when running message listener: "
+        << ExceptionToString(try_catch);
+}
+
+scoped_ptr<base::Value> XWalkExtensionModule::FromV8Value(
+    v8::Handle<v8::Value> value, v8::Handle<v8::Context> context) const {
+  // Strings, by far the most common messages, and buffers don't need the
+  // bookkeeping V8ValueConverter does for objects. Buffers are copied at
+  // once instead of having their elements converted.
+  if (value->IsString()) {
+    v8::String::Utf8Value utf8(value);
+    return scoped_ptr<base::Value>(
+        new base::StringValue(std::string(*utf8, utf8.length())));
+  }
+
+  const char* data;
+  size_t size;
+  if (GetArrayBufferData(value, &data, &size)) {
+    return scoped_ptr<base::Value>(
+        base::BinaryValue::CreateWithCopiedBuffer(data, size));
+  }
+
+  return make_scoped_ptr(converter_->FromV8Value(value, context));
+}
+
+v8::Handle<v8::Value> XWalkExtensionModule::ToV8Value(
+    const base::Value* value, v8::Handle<v8::Context> context) const {
+  if (value->IsType(base::Value::TYPE_STRING)) {
+    const base::StringValue* string_value =
+        static_cast<const base::StringValue*>(value);
+    const std::string& str = string_value->GetString();
+    return v8::String::NewFromUtf8(context->GetIsolate(), str.data(),
+                                   v8::String::kNormalString, str.size());
+  }
+
+  if (value->IsType(base::Value::TYPE_BINARY)) {
+    const base::BinaryValue* binary_value =
+        static_cast<const base::BinaryValue*>(value);
+    return CreateArrayBuffer(binary_value->GetBuffer(),
+                             binary_value->GetSize());
+  }
+
+  return converter_->ToV8Value(value, context);
+}
+
 // static
 void XWalkExtensionModule::PostMessageCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -214,11 +426,20 @@ void XWalkExtensionModule::PostMessageCallback(
     return;
   }
 
-  v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
-  scoped_ptr<base::Value> value(
-      module->converter_->FromV8Value(info[0], context));
-
   CHECK(module->instance_id_);
+
+  // Buffers are written straight to the IPC message.
+  const char* data;
+  size_t size;
+  if (GetArrayBufferData(info[0], &data, &size)) {
+    module->client_->PostBinaryMessageToNative(module->instance_id_, data,
+                                               size);
+    result.Set(true);
+    return;
+  }
+
+  v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
+  scoped_ptr<base::Value> value(module->FromV8Value(info[0], context));
   module->client_->PostMessageToNative(module->instance_id_, value.Pass());
   result.Set(true);
 }
@@ -234,8 +455,7 @@ void XWalkExtensionModule::SendSyncMessageCallback(
   }
 
   v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
-  scoped_ptr<base::Value> value(
-      module->converter_->FromV8Value(info[0], context));
+  scoped_ptr<base::Value> value(module->FromV8Value(info[0], context));
 
   CHECK(module->instance_id_);
   scoped_ptr<base::Value> reply(
@@ -245,7 +465,7 @@ void XWalkExtensionModule::SendSyncMessageCallback(
   // If we tried to send a message to an instance that became invalid,
   // then reply will be NULL.
   if (reply)
-    result.Set(module->converter_->ToV8Value(reply.get(), context));
+    result.Set(module->ToV8Value(reply.get(), context));
 }
 
 // static
@@ -273,6 +493,41 @@ void XWalkExtensionModule::SetMessageListenerCallback(
   result.Set(true);
 }
 
+// static
+void XWalkExtensionModule::PostAsyncRequestCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1) {
+    result.Set(false);
+    return;
+  }
+
+  v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
+  scoped_ptr<base::Value> value(module->FromV8Value(info[0], context));
+
+  CHECK(module->instance_id_);
+  int request_id = module->next_request_id_++;
+  module->client_->SendAsyncRequestToNative(module->instance_id_, request_id,
+                                            value.Pass());
+  result.Set(request_id);
+}
+
+// static
+void XWalkExtensionModule::SetAsyncReplyListenerCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1 || !info[0]->IsFunction()) {
+    result.Set(false);
+    return;
+  }
+
+  module->async_reply_listener_.Reset(info.GetIsolate(),
+                                      info[0].As<v8::Function>());
+  result.Set(true);
+}
+
 // static
 XWalkExtensionModule* XWalkExtensionModule::GetExtensionModule(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -33,8 +33,7 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
  public:
   XWalkExtensionModule(XWalkExtensionClient* client,
                        XWalkModuleSystem* module_system,
-                       const std::string& extension_name,
-                       const std::string& extension_code);
+                       const std::string& extension_name);
   virtual ~XWalkExtensionModule();
 
   // TODO(cmarcelo): Make this return a v8::Handle<v8::Object>, and
@@ -47,6 +46,17 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
  private:
   // XWalkExtensionClient::InstanceHandler implementation.
   virtual void HandleMessageFromNative(const base::Value& msg) OVERRIDE;
+  virtual void HandleAsyncReplyFromNative(int request_id,
+                                          const base::Value* reply) OVERRIDE;
+  virtual void HandleBinaryMessageFromNative(const char* data,
+                                             size_t size) OVERRIDE;
+
+  // Convert the messages exchanged with the extension, using converter_ only
+  // for the values that need to be walked, like objects and arrays.
+  scoped_ptr<base::Value> FromV8Value(v8::Handle<v8::Value> value,
+                                      v8::Handle<v8::Context> context) const;
+  v8::Handle<v8::Value> ToV8Value(const base::Value* value,
+                                  v8::Handle<v8::Context> context) const;
 
   // Callbacks for JS functions available in 'extension' object.
   static void PostMessageCallback(
@@ -55,6 +65,10 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
       const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SetMessageListenerCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void PostAsyncRequestCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void SetAsyncReplyListenerCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
 
   static XWalkExtensionModule* GetExtensionModule(
       const v8::FunctionCallbackInfo<v8::Value>& info);
@@ -70,8 +84,12 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   // This value is registered by using 'extension.setMessageListener()'.
   v8::Persistent<v8::Function> message_listener_;
 
+  // Function called with (request id, succeeded, reply) when the extension
+  // replies to a request. It is set by the wrapper code that implements
+  // 'extension.sendAsyncRequest()' and keeps track of the pending Promises.
+  v8::Persistent<v8::Function> async_reply_listener_;
+
   std::string extension_name_;
-  std::string extension_code_;
 
   // TODO(cmarcelo): Move to a single converter, since we always use same
   // parameters.
@@ -80,6 +98,7 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   XWalkExtensionClient* client_;
   XWalkModuleSystem* module_system_;
   int64_t instance_id_;
+  int next_request_id_;
 };
 
 }  // namespace extensions
@@ -6,6 +6,7 @@
 
 #include "base/command_line.h"
 #include "base/values.h"
+#include "content/public/common/content_switches.h"
 #include "content/public/renderer/render_thread.h"
 #include "content/public/renderer/v8_value_converter.h"
 #include "grit/xwalk_extensions_resources.h"
@@ -60,11 +61,8 @@ void CreateExtensionModules(XWalkExtensionClient* client,
   XWalkExtensionClient::ExtensionAPIMap::const_iterator it = extensions.begin();
   for (; it != extensions.end(); ++it) {
     XWalkExtensionClient::ExtensionCodePoints* codepoint = it->second;
-    if (codepoint->api.empty())
-      continue;
     scoped_ptr<XWalkExtensionModule> module(
-        new XWalkExtensionModule(client, module_system,
-                                 it->first, codepoint->api));
+        new XWalkExtensionModule(client, module_system, it->first));
     module_system->RegisterExtensionModule(module.Pass(),
                                            codepoint->entry_points);
   }
@@ -116,6 +114,11 @@ void XWalkExtensionRendererController::SetupBrowserProcessClient(
     IPC::SyncChannel* browser_channel) {
   in_browser_process_extensions_client_.reset(new XWalkExtensionClient);
   in_browser_process_extensions_client_->Initialize(browser_channel);
+
+  // In single process mode the in-process servers share our address space,
+  // their messages don't need to be serialized.
+  if (CommandLine::ForCurrentProcess()->HasSwitch(switches::kSingleProcess))
+    in_browser_process_extensions_client_->ConnectDirectChannel();
 }
 
 void XWalkExtensionRendererController::SetupExtensionProcessClient(
@@ -6,18 +6,45 @@ var callback_listeners = {};
 var callback_id = 0;
 var extension_object;
 
-function wrapCallback(args, callback) {
-  if (callback) {
-    var id = (callback_id++).toString();
-    callback_listeners[id] = callback;
-    args.unshift(id);
-  } else {
-    // The function name and the callback ID are prepended before
-    // the arguments. If there is no callback, an empty string is
-    // should be used. This will be sorted out by the InternalInstance
-    // message handler.
-    args.unshift("");
-  }
+// Functions are called by name until their ID is known. The ID of a name
+// is requested on its first call, native sides that don't know the request
+// never reply to it, so the name keeps being used.
+var GET_FUNCTION_IDS = "internal.getFunctionIds";
+var NO_CALLBACK_ID = -1;
+
+var function_ids = {};
+var requested_function_names = {};
+
+function getFunctionId(name) {
+  if (name in function_ids)
+    return function_ids[name];
+
+  if (name in requested_function_names)
+    return undefined;
+
+  requested_function_names[name] = true;
+  postMessageByName(GET_FUNCTION_IDS, [[name]], function(ids) {
+    if (ids[0] >= 0)
+      function_ids[name] = ids[0];
+  });
+
+  return undefined;
+}
+
+function addCallback(callback) {
+  var id = callback_id++;
+  callback_listeners[id] = callback;
+  return id;
+}
+
+function postMessageByName(function_name, args, callback) {
+  // The function name and the callback ID are prepended before
+  // the arguments. If there is no callback, an empty string is
+  // should be used. This will be sorted out by the InternalInstance
+  // message handler.
+  var id = callback ? addCallback(callback) : undefined;
+  args.unshift(function_name, callback ? id.toString() : "");
+  extension_object.postMessage(args);
 
   return id;
 }
@@ -33,23 +60,40 @@ exports.setupInternalExtension = function(extension_obj) {
     var id = args.shift();
     var listener = callback_listeners[id];
 
-    if (listener !== undefined) {
-      if (!listener.apply(null, args))
-        delete callback_listeners[id];
-    }
+    if (listener === undefined)
+      return;
+
+    // The results of the calls made by ID are wrapped in a list.
+    if (typeof id === "number")
+      args = args[0];
+
+    if (!listener.apply(null, args))
+      delete callback_listeners[id];
   });
 };
 
 exports.postMessage = function(function_name, args, callback) {
-  var id = wrapCallback(args, callback);
-  args.unshift(function_name);
-  extension_object.postMessage(args);
+  if (function_name === GET_FUNCTION_IDS)
+    return postMessageByName(function_name, args, callback);
 
-  return id;
+  var function_id = getFunctionId(function_name);
+  if (function_id === undefined)
+    return postMessageByName(function_name, args, callback);
+
+  var id = callback ? addCallback(callback) : NO_CALLBACK_ID;
+  extension_object.postMessage([function_id, id, args]);
+
+  return callback ? id : undefined;
+};
+
+// Requests the ids of all the |names| at once, |callback| gets the list of
+// ids, -1 for the names without a handler.
+exports.getFunctionIds = function(names, callback) {
+  postMessageByName(GET_FUNCTION_IDS, [names], callback);
 };
 
 exports.removeCallback = function(id) {
-  if (!id in callback_listeners)
+  if (!(id in callback_listeners))
     return;
 
   delete callback_listeners[id];
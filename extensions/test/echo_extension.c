@@ -9,12 +9,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_AsyncRequest.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessage.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 XW_Extension g_extension = 0;
 const XW_CoreInterface* g_core = NULL;
 const XW_MessagingInterface* g_messaging = NULL;
+const XW_BinaryMessagingInterface* g_binary_messaging = NULL;
 const XW_Internal_SyncMessagingInterface* g_sync_messaging = NULL;
+const XW_Internal_AsyncRequestInterface* g_async_request = NULL;
 
 void instance_created(XW_Instance instance) {
   printf("Instance %d created!\n", instance);
@@ -28,10 +32,20 @@ void handle_message(XW_Instance instance, const char* message) {
   g_messaging->PostMessage(instance, message);
 }
 
+void handle_binary_message(XW_Instance instance, const char* data,
+                           size_t size) {
+  g_binary_messaging->PostMessage(instance, data, size);
+}
+
 void handle_sync_message(XW_Instance instance, const char* message) {
   g_sync_messaging->SetSyncReply(instance, message);
 }
 
+void handle_async_request(XW_Instance instance, int32_t request_id,
+                          const char* message) {
+  g_async_request->SendReply(instance, request_id, message);
+}
+
 void shutdown(XW_Extension extension) {
   printf("Shutdown\n");
 }
@@ -50,6 +64,9 @@ int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
       "};"
       "exports.syncEcho = function(msg) {"
       "  return extension.internal.sendSyncMessage(msg);"
+      "};"
+      "exports.asyncEcho = function(msg) {"
+      "  return extension.sendAsyncRequest(msg);"
       "};";
 
   g_extension = extension;
@@ -63,8 +80,14 @@ int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
   g_messaging = get_interface(XW_MESSAGING_INTERFACE);
   g_messaging->Register(extension, handle_message);
 
+  g_binary_messaging = get_interface(XW_BINARY_MESSAGING_INTERFACE);
+  g_binary_messaging->Register(extension, handle_binary_message);
+
   g_sync_messaging = get_interface(XW_INTERNAL_SYNC_MESSAGING_INTERFACE);
   g_sync_messaging->Register(extension, handle_sync_message);
 
+  g_async_request = get_interface(XW_INTERNAL_ASYNC_REQUEST_INTERFACE);
+  g_async_request->Register(extension, handle_async_request);
+
   return XW_OK;
 }
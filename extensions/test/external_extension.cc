@@ -2,16 +2,21 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/command_line.h"
 #include "base/native_library.h"
 #include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/test/xwalk_extensions_test_base.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/test/base/xwalk_test_utils.h"
+#include "content/public/browser/render_process_host.h"
+#include "content/public/browser/web_contents.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
 
+using xwalk::Runtime;
 using xwalk::extensions::XWalkExtensionService;
 
 class ExternalExtensionTest : public XWalkExtensionsTestBase {
@@ -23,6 +28,55 @@ class ExternalExtensionTest : public XWalkExtensionsTestBase {
   }
 };
 
+// Base for the tests of the different ways of providing extension processes
+// to the render processes.
+class ExtensionProcessModeTest : public ExternalExtensionTest {
+ public:
+  void TestEchoInTwoRenderProcesses() {
+    CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+    if (cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess)) {
+      LOG(INFO) << "--disable-extension-process not supported by "
+                   "ExtensionProcessModeTest. Skipping test.";
+      return;
+    }
+
+    content::RunAllPendingInMessageLoop();
+    GURL url = GetExtensionsTestURL(base::FilePath(),
+                                    base::FilePath().AppendASCII("echo.html"));
+    content::TitleWatcher title_watcher(runtime()->web_contents(),
+                                        kPassString);
+    title_watcher.AlsoWaitForTitle(kFailString);
+    xwalk_test_utils::NavigateToURL(runtime(), url);
+    EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+
+    Runtime* second = Runtime::CreateWithDefaultWindow(
+        runtime()->runtime_context(), GURL(), runtime_registry());
+    content::TitleWatcher second_title_watcher(second->web_contents(),
+                                               kPassString);
+    second_title_watcher.AlsoWaitForTitle(kFailString);
+    xwalk_test_utils::NavigateToURL(second, url);
+    EXPECT_EQ(kPassString, second_title_watcher.WaitAndGetTitle());
+    EXPECT_NE(runtime()->web_contents()->GetRenderProcessHost(),
+              second->web_contents()->GetRenderProcessHost());
+  }
+};
+
+class SharedExtensionProcessTest : public ExtensionProcessModeTest {
+ public:
+  virtual void SetUpCommandLine(CommandLine* command_line) OVERRIDE {
+    ExtensionProcessModeTest::SetUpCommandLine(command_line);
+    command_line->AppendSwitch(switches::kXWalkExtensionProcessPool);
+  }
+};
+
+class PrelaunchedExtensionProcessTest : public ExtensionProcessModeTest {
+ public:
+  virtual void SetUpCommandLine(CommandLine* command_line) OVERRIDE {
+    ExtensionProcessModeTest::SetUpCommandLine(command_line);
+    command_line->AppendSwitch(switches::kXWalkPrelaunchExtensionProcess);
+  }
+};
+
 class RuntimeInterfaceTest : public XWalkExtensionsTestBase {
  public:
   virtual void SetUp() OVERRIDE {
@@ -77,6 +131,40 @@ IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionSync) {
   EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
 }
 
+IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionAsyncRequest) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("async_echo.html"));
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionBinary) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("binary_echo.html"));
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+// The second render process is served by the same extension process through
+// another channel.
+IN_PROC_BROWSER_TEST_F(SharedExtensionProcessTest, TwoRenderProcesses) {
+  TestEchoInTwoRenderProcesses();
+}
+
+// Each render process takes a prelaunched extension process, the second one
+// is launched when the first is taken.
+IN_PROC_BROWSER_TEST_F(PrelaunchedExtensionProcessTest, TwoRenderProcesses) {
+  TestEchoInTwoRenderProcesses();
+}
+
 IN_PROC_BROWSER_TEST_F(RuntimeInterfaceTest, GetRuntimeVariable) {
   content::RunAllPendingInMessageLoop();
   GURL url = GetExtensionsTestURL(
@@ -211,11 +211,8 @@ void XEShV8Runner::CreateExtensionModules(XWalkModuleSystem* module_system) {
       extensions.begin();
   for (; it != extensions.end(); ++it) {
     XWalkExtensionClient::ExtensionCodePoints* codepoint = it->second;
-    if (codepoint->api.empty())
-      continue;
     scoped_ptr<XWalkExtensionModule> module(
-        new XWalkExtensionModule(&client_, module_system, it->first,
-                                 codepoint->api));
+        new XWalkExtensionModule(&client_, module_system, it->first));
     module_system->RegisterExtensionModule(module.Pass(),
                                            codepoint->entry_points);
   }
@@ -19,11 +19,21 @@
 namespace xwalk {
 
 XWalkAppExtensionBridge::XWalkAppExtensionBridge()
-    : app_system_(NULL) {
+    : app_system_(NULL),
+      extension_service_(NULL) {
 }
 
 XWalkAppExtensionBridge::~XWalkAppExtensionBridge() {}
 
+void XWalkAppExtensionBridge::SetApplicationSystem(
+    application::ApplicationSystem* app_system) {
+  if (app_system_)
+    app_system_->application_service()->RemoveObserver(this);
+  app_system_ = app_system;
+  if (app_system_)
+    app_system_->application_service()->AddObserver(this);
+}
+
 void XWalkAppExtensionBridge::CheckAPIAccessControl(
     int render_process_id,
     const std::string& extension_name,
@@ -60,6 +70,40 @@ bool XWalkAppExtensionBridge::RegisterPermissions(
   return service->RegisterPermissions(app->id(), extension_name, perm_table);
 }
 
+void XWalkAppExtensionBridge::GetPermissionDecisions(
+    int render_process_id,
+    const std::string& extension_name,
+    extensions::PermissionDecisions* decisions) {
+  CHECK(app_system_);
+  application::ApplicationService* service =
+      app_system_->application_service();
+  application::Application* app =
+      service->GetApplicationByRenderHostID(render_process_id);
+  if (!app)
+    return;
+
+  application::ApplicationService::APIPermissionMap permissions;
+  service->GetSessionAPIPermissions(app->id(), extension_name, &permissions);
+
+  application::ApplicationService::APIPermissionMap::const_iterator it =
+      permissions.begin();
+  for (; it != permissions.end(); ++it) {
+    extensions::PermissionDecision decision;
+    decision.extension_name = it->first.first;
+    decision.api_name = it->first.second;
+    // Both enums have the same values, see CheckAPIAccessControl().
+    decision.permission =
+        static_cast<extensions::RuntimePermission>(it->second);
+    decisions->push_back(decision);
+  }
+}
+
+void XWalkAppExtensionBridge::OnApplicationPermissionsChanged(
+    application::Application* app) {
+  if (extension_service_)
+    extension_service_->OnPermissionsChanged(app->GetRenderProcessHostID());
+}
+
 void XWalkAppExtensionBridge::ExtensionProcessCreated(
     int render_process_id,
     const IPC::ChannelHandle& channel_handle) {
@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/browser/application_system.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
@@ -21,14 +22,17 @@ namespace xwalk {
 // between application and extension takes place, just like a 'bridge'.
 // The class instance will be owned by xwalk_runner.
 class XWalkAppExtensionBridge
-    : public extensions::XWalkExtensionService::Delegate {
+    : public extensions::XWalkExtensionService::Delegate,
+      public application::ApplicationService::Observer {
  public:
   XWalkAppExtensionBridge();
   virtual ~XWalkAppExtensionBridge();
 
-  void SetApplicationSystem(application::ApplicationSystem* app_system) {
-    app_system_ = app_system;
+  void SetApplicationSystem(application::ApplicationSystem* app_system);
+  void SetExtensionService(extensions::XWalkExtensionService* service) {
+    extension_service_ = service;
   }
+
   // XWalkExtensionService::Delegate implementation
   virtual void CheckAPIAccessControl(
       int render_process_id,
@@ -42,9 +46,18 @@ class XWalkAppExtensionBridge
   virtual void ExtensionProcessCreated(
       int render_process_id,
       const IPC::ChannelHandle& channel_handle) OVERRIDE;
+  virtual void GetPermissionDecisions(
+      int render_process_id,
+      const std::string& extension_name,
+      extensions::PermissionDecisions* decisions) OVERRIDE;
+
+  // ApplicationService::Observer implementation
+  virtual void OnApplicationPermissionsChanged(
+      application::Application* app) OVERRIDE;
 
  private:
   application::ApplicationSystem* app_system_;
+  extensions::XWalkExtensionService* extension_service_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkAppExtensionBridge);
 };
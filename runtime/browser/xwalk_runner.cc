@@ -78,9 +78,11 @@ void XWalkRunner::PreMainMessageLoopRun() {
         app_extension_bridge_.get()));
   CreateComponents();
   app_extension_bridge_->SetApplicationSystem(app_component_->app_system());
+  app_extension_bridge_->SetExtensionService(extension_service_.get());
 }
 
 void XWalkRunner::PostMainMessageLoopRun() {
+  app_extension_bridge_->SetApplicationSystem(NULL);
   DestroyComponents();
   extension_service_.reset();
   runtime_context_.reset();
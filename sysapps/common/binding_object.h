@@ -29,6 +29,14 @@ class BindingObject {
     return handler_.HandleFunction(info.Pass());
   }
 
+  bool HandleFunction(
+      int function_id,
+      scoped_ptr<base::ListValue> arguments,
+      const XWalkExtensionFunctionInfo::PostResultCallback& post_result_cb) {
+    return handler_.HandleFunction(function_id, arguments.Pass(),
+                                   post_result_cb);
+  }
+
  protected:
   XWalkExtensionFunctionHandler handler_;
 };
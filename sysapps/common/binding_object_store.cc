@@ -13,7 +13,8 @@ namespace xwalk {
 namespace sysapps {
 
 BindingObjectStore::BindingObjectStore(XWalkExtensionFunctionHandler* handler)
-    : objects_deleter_(&objects_) {
+    : objects_deleter_(&objects_),
+      next_native_object_id_(-1) {
   handler->Register("JSObjectCollected",
       base::Bind(&BindingObjectStore::OnJSObjectCollected,
                  base::Unretained(this)));
@@ -24,7 +25,7 @@ BindingObjectStore::BindingObjectStore(XWalkExtensionFunctionHandler* handler)
 
 BindingObjectStore::~BindingObjectStore() {}
 
-void BindingObjectStore::AddBindingObject(const std::string& id,
+void BindingObjectStore::AddBindingObject(int id,
                                           scoped_ptr<BindingObject> obj) {
   if (ContainsKey(objects_, id)) {
     LOG(WARNING) << "The object with the ID " << id << " already exists.";
@@ -34,7 +35,13 @@ void BindingObjectStore::AddBindingObject(const std::string& id,
   objects_[id] = obj.release();
 }
 
-bool BindingObjectStore::HasObjectForTesting(const std::string& id) const {
+int BindingObjectStore::AddNativeBindingObject(scoped_ptr<BindingObject> obj) {
+  int id = next_native_object_id_--;
+  AddBindingObject(id, obj.Pass());
+  return id;
+}
+
+bool BindingObjectStore::HasObjectForTesting(int id) const {
   return ContainsKey(objects_, id);
 }
 
@@ -61,36 +68,50 @@ void BindingObjectStore::OnJSObjectCollected(
 
 void BindingObjectStore::OnPostMessageToObject(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  scoped_ptr<PostMessageToObject::Params>
-      params(PostMessageToObject::Params::Create(*info->arguments()));
-
-  if (!params) {
+  // The arguments are parsed by hand instead of using PostMessageToObject,
+  // which would make a deep copy of the arguments of every call.
+  base::ListValue* args = info->arguments();
+  int object_id;
+  base::Value* function;
+  if (args->GetSize() != 3 || !args->GetInteger(0, &object_id) ||
+      !args->Get(1, &function)) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  BindingObjectMap::iterator it = objects_.find(params->object_id);
+  BindingObjectMap::iterator it = objects_.find(object_id);
   if (it == objects_.end())
     return;
 
-  if (!params->arguments->IsType(base::Value::TYPE_LIST)) {
+  scoped_ptr<base::Value> arguments;
+  args->Remove(2, &arguments);
+  if (!arguments->IsType(base::Value::TYPE_LIST)) {
     LOG(WARNING) << "Malformed message sent to the object with the ID "
-        << params->object_id << ".";
+        << object_id << ".";
     return;
   }
 
   scoped_ptr<base::ListValue> new_args(
-      static_cast<base::ListValue*>(params->arguments.release()));
-
-  scoped_ptr<XWalkExtensionFunctionInfo> new_info(
-      new XWalkExtensionFunctionInfo(
-          params->name,
-          new_args.Pass(),
-          info->post_result_cb()));
+      static_cast<base::ListValue*>(arguments.release()));
+
+  int function_id;
+  std::string function_name;
+  bool handled = false;
+  if (function->GetAsInteger(&function_id)) {
+    handled = it->second->HandleFunction(
+        function_id, new_args.Pass(), info->post_result_cb());
+  } else if (function->GetAsString(&function_name)) {
+    scoped_ptr<XWalkExtensionFunctionInfo> new_info(
+        new XWalkExtensionFunctionInfo(
+            function_name,
+            new_args.Pass(),
+            info->post_result_cb()));
+    handled = it->second->HandleFunction(new_info.Pass());
+  }
 
-  if (!it->second->HandleFunction(new_info.Pass())) {
-    LOG(WARNING) << "The object with the ID " << params->object_id << " has no "
-        "handler for the function " << params->name << ".";
+  if (!handled) {
+    LOG(WARNING) << "The object with the ID " << object_id << " has no "
+        "handler for the function " << *function << ".";
     return;
   }
 }
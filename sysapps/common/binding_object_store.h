@@ -5,8 +5,8 @@
 #ifndef XWALK_SYSAPPS_COMMON_BINDING_OBJECT_STORE_H_
 #define XWALK_SYSAPPS_COMMON_BINDING_OBJECT_STORE_H_
 
-#include <map>
 #include <string>
+#include "base/containers/hash_tables.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stl_util.h"
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
@@ -22,15 +22,26 @@ using extensions::XWalkExtensionFunctionInfo;
 
 // This class acts likes a container of objects that have a counterpart in
 // the JavaScript context. It handles the dispatching of messages to the
-// destination object based on a unique identifier associated to every
+// destination object based on a unique integer identifier associated to every
 // BindingObject. This class owns the BindingObjects it is managing.
+//
+// The messages name the target function either by its name or by the id
+// returned by XWalkExtensionFunctionHandler::GetFunctionId(), which the
+// JavaScript side gets once for every name with the kGetFunctionIdsName
+// function of the extension's handler.
 class BindingObjectStore {
  public:
   explicit BindingObjectStore(XWalkExtensionFunctionHandler* handler);
   virtual ~BindingObjectStore();
 
-  void AddBindingObject(const std::string& id, scoped_ptr<BindingObject> obj);
-  bool HasObjectForTesting(const std::string& id) const;
+  // Adds an object created by the JavaScript side, which chose its |id|.
+  void AddBindingObject(int id, scoped_ptr<BindingObject> obj);
+
+  // Adds an object created by the native side and returns its ID. These IDs
+  // are negative, so they never clash with the ones chosen by JavaScript.
+  int AddNativeBindingObject(scoped_ptr<BindingObject> obj);
+
+  bool HasObjectForTesting(int id) const;
 
  private:
   // This method is invoked every time a JavaScript Binding object is collected
@@ -38,9 +49,11 @@ class BindingObjectStore {
   void OnJSObjectCollected(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnPostMessageToObject(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
-  typedef std::map<std::string, BindingObject*> BindingObjectMap;
+  typedef base::hash_map<int, BindingObject*> BindingObjectMap;
   BindingObjectMap objects_;
   STLValueDeleter<BindingObjectMap> objects_deleter_;
+
+  int next_native_object_id_;
 };
 
 }  // namespace sysapps
@@ -5,10 +5,12 @@
 #include "xwalk/sysapps/common/binding_object_store.h"
 
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 using xwalk::extensions::XWalkExtensionFunctionHandler;
 using xwalk::extensions::XWalkExtensionFunctionInfo;
+using xwalk::extensions::XWalkExtensionInstance;
 using xwalk::sysapps::BindingObject;
 using xwalk::sysapps::BindingObjectStore;
 
@@ -18,10 +20,15 @@ const char kTestString[] = "crosswalk1234567890";
 
 void DummyCallback(scoped_ptr<base::ListValue> result) {}
 
+void StoreResult(scoped_ptr<base::ListValue>* result_ptr,
+                 scoped_ptr<base::ListValue> result) {
+  *result_ptr = result.Pass();
+}
+
 scoped_ptr<XWalkExtensionFunctionInfo> CreateFunctionInfo(
-    const std::string& name, const std::string& str_argument) {
+    const std::string& name, int int_argument) {
   scoped_ptr<base::ListValue> arguments(new base::ListValue);
-  arguments->AppendString(str_argument);
+  arguments->AppendInteger(int_argument);
 
   return make_scoped_ptr(new XWalkExtensionFunctionInfo(
       name,
@@ -71,6 +78,11 @@ class BindingObjectTest : public BindingObject {
 
 int BindingObjectTest::instance_count_ = 0;
 
+class TestExtensionInstance : public XWalkExtensionInstance {
+ public:
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {}
+};
+
 }  // namespace
 
 TEST(XWalkSysAppsBindingObjectStoreTest, AddBindingObject) {
@@ -78,20 +90,20 @@ TEST(XWalkSysAppsBindingObjectStoreTest, AddBindingObject) {
       new XWalkExtensionFunctionHandler(NULL));
   scoped_ptr<BindingObjectStore> store(new BindingObjectStore(handler.get()));
 
-  EXPECT_FALSE(store->HasObjectForTesting("foobar1"));
-  EXPECT_FALSE(store->HasObjectForTesting("foobar2"));
-  EXPECT_FALSE(store->HasObjectForTesting("foobar3"));
-  EXPECT_FALSE(store->HasObjectForTesting("foobar4"));
+  EXPECT_FALSE(store->HasObjectForTesting(1));
+  EXPECT_FALSE(store->HasObjectForTesting(2));
+  EXPECT_FALSE(store->HasObjectForTesting(3));
+  EXPECT_FALSE(store->HasObjectForTesting(4));
 
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar2", BindingObjectTest::Create());
-  store->AddBindingObject("foobar3", BindingObjectTest::Create());
-  store->AddBindingObject("foobar4", BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(2, BindingObjectTest::Create());
+  store->AddBindingObject(3, BindingObjectTest::Create());
+  store->AddBindingObject(4, BindingObjectTest::Create());
 
-  EXPECT_TRUE(store->HasObjectForTesting("foobar1"));
-  EXPECT_TRUE(store->HasObjectForTesting("foobar2"));
-  EXPECT_TRUE(store->HasObjectForTesting("foobar3"));
-  EXPECT_TRUE(store->HasObjectForTesting("foobar4"));
+  EXPECT_TRUE(store->HasObjectForTesting(1));
+  EXPECT_TRUE(store->HasObjectForTesting(2));
+  EXPECT_TRUE(store->HasObjectForTesting(3));
+  EXPECT_TRUE(store->HasObjectForTesting(4));
 
   EXPECT_EQ(BindingObjectTest::instance_count(), 4);
 
@@ -102,38 +114,58 @@ TEST(XWalkSysAppsBindingObjectStoreTest, AddBindingObject) {
   // Same ID, should discard the object. If this is happening in
   // real life, there is something wrong with the code (and that is
   // why we print a warning).
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
   EXPECT_EQ(BindingObjectTest::instance_count(), 1);
 
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
 
+TEST(XWalkSysAppsBindingObjectStoreTest, AddNativeBindingObject) {
+  XWalkExtensionFunctionHandler handler(NULL);
+  scoped_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
+
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  int id1 = store->AddNativeBindingObject(BindingObjectTest::Create());
+  int id2 = store->AddNativeBindingObject(BindingObjectTest::Create());
+
+  // Never clashes with the IDs chosen by JavaScript.
+  EXPECT_LT(id1, 0);
+  EXPECT_LT(id2, 0);
+  EXPECT_NE(id1, id2);
+  EXPECT_TRUE(store->HasObjectForTesting(id1));
+  EXPECT_TRUE(store->HasObjectForTesting(id2));
+  EXPECT_EQ(BindingObjectTest::instance_count(), 3);
+
+  store.reset();
+  EXPECT_EQ(BindingObjectTest::instance_count(), 0);
+}
+
 TEST(XWalkSysAppsBindingObjectStoreTest, OnJSObjectCollected) {
   XWalkExtensionFunctionHandler handler(NULL);
   scoped_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
 
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar2", BindingObjectTest::Create());
-  store->AddBindingObject("foobar3", BindingObjectTest::Create());
-  store->AddBindingObject("foobar4", BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(2, BindingObjectTest::Create());
+  store->AddBindingObject(3, BindingObjectTest::Create());
+  store->AddBindingObject(4, BindingObjectTest::Create());
   EXPECT_EQ(BindingObjectTest::instance_count(), 4);
 
   EXPECT_TRUE(handler.HandleFunction(
-          CreateFunctionInfo("JSObjectCollected", "foobar1")));
+          CreateFunctionInfo("JSObjectCollected", 1)));
   EXPECT_EQ(BindingObjectTest::instance_count(), 3);
 
   EXPECT_TRUE(handler.HandleFunction(
-          CreateFunctionInfo("JSObjectCollected", "foobar2")));
+          CreateFunctionInfo("JSObjectCollected", 2)));
   EXPECT_EQ(BindingObjectTest::instance_count(), 2);
 
   // Attempt to destroy an object that doesn't exist
   // on the store.
   EXPECT_TRUE(handler.HandleFunction(
-          CreateFunctionInfo("JSObjectCollected", "foobar2")));
+          CreateFunctionInfo("JSObjectCollected", 2)));
   EXPECT_EQ(BindingObjectTest::instance_count(), 2);
 
   store.reset();
@@ -149,15 +181,15 @@ TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObject) {
   scoped_ptr<BindingObject> binding_object_ptr1(binding_object1);
   scoped_ptr<BindingObject> binding_object_ptr2(binding_object2);
 
-  store->AddBindingObject("foobar1", binding_object_ptr1.Pass());
-  store->AddBindingObject("foobar2", binding_object_ptr2.Pass());
+  store->AddBindingObject(1, binding_object_ptr1.Pass());
+  store->AddBindingObject(2, binding_object_ptr2.Pass());
   EXPECT_EQ(BindingObjectTest::instance_count(), 2);
 
   for (unsigned i = 0; i < 1000; ++i) {
     scoped_ptr<base::ListValue> arguments(new base::ListValue);
 
     // Object ID.
-    arguments->AppendString("foobar1");
+    arguments->AppendInteger(1);
 
     // Function name on the target object.
     arguments->AppendString("test");
@@ -182,3 +214,59 @@ TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObject) {
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
+
+TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObjectWithMethodId) {
+  TestExtensionInstance instance;
+  XWalkExtensionFunctionHandler handler(&instance);
+  scoped_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
+
+  BindingObjectTest* binding_object(new BindingObjectTest());
+  store->AddBindingObject(1, make_scoped_ptr<BindingObject>(binding_object));
+
+  // The JavaScript side gets the IDs of the method names first.
+  scoped_ptr<base::ListValue> names(new base::ListValue);
+  names->AppendString("test");
+  names->AppendString("unknownMethod");
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->Append(names.release());
+
+  scoped_ptr<base::ListValue> result;
+  EXPECT_TRUE(handler.HandleFunction(make_scoped_ptr(
+      new XWalkExtensionFunctionInfo(
+          xwalk::extensions::kGetFunctionIdsName, arguments.Pass(),
+          base::Bind(&StoreResult, &result)))));
+
+  base::ListValue* ids;
+  ASSERT_TRUE(result);
+  ASSERT_TRUE(result->GetList(0, &ids));
+  ASSERT_EQ(2u, ids->GetSize());
+
+  int test_id;
+  ASSERT_TRUE(ids->GetInteger(0, &test_id));
+  EXPECT_EQ(XWalkExtensionFunctionHandler::GetFunctionId("test"), test_id);
+
+  // Unknown names aren't added to the process-wide table.
+  int unknown_id;
+  ASSERT_TRUE(ids->GetInteger(1, &unknown_id));
+  EXPECT_EQ(-1, unknown_id);
+  EXPECT_EQ(-1,
+            XWalkExtensionFunctionHandler::FindFunctionId("unknownMethod"));
+
+  for (unsigned i = 0; i < 1000; ++i) {
+    scoped_ptr<base::ListValue> arguments(new base::ListValue);
+    arguments->AppendInteger(1);
+    arguments->AppendInteger(test_id);
+
+    base::ListValue* targetArguments(new base::ListValue());
+    targetArguments->AppendString(kTestString);
+    arguments->Append(targetArguments);
+
+    EXPECT_TRUE(handler.HandleFunction(make_scoped_ptr(
+        new XWalkExtensionFunctionInfo("postMessageToObject", arguments.Pass(),
+                                       base::Bind(&DummyCallback)))));
+    EXPECT_EQ(binding_object->call_count(), i + 1);
+  }
+
+  store.reset();
+  EXPECT_EQ(BindingObjectTest::instance_count(), 0);
+}
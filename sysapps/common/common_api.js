@@ -9,8 +9,48 @@ var v8tools;
 
 var unique_id = 0;
 
+// The IDs of the objects created by the native side are negative, so these
+// never clash with them.
 function getUniqueId() {
-  return (unique_id++).toString();
+  return unique_id++;
+}
+
+// The native side dispatches calls faster when the method is identified by
+// an integer instead of its name. The IDs are the same for every object, and
+// are requested once for all the names not resolved yet, on the first call
+// of a method without an ID. Until the reply comes the name is used.
+var method_ids = {};
+var requested_method_names = {};
+var unresolved_method_names = [];
+
+function addMethodName(name) {
+  if (name in method_ids || name in requested_method_names)
+    return;
+
+  requested_method_names[name] = true;
+  unresolved_method_names.push(name);
+}
+
+function getMethodId(name) {
+  if (name in method_ids)
+    return method_ids[name];
+
+  addMethodName(name);
+  if (!unresolved_method_names.length)
+    return name;
+
+  var names = unresolved_method_names;
+  unresolved_method_names = [];
+
+  internal.getFunctionIds(names, function(ids) {
+    // Names without a handler get -1, these keep being sent as is.
+    for (var i = 0; i < names.length; ++i) {
+      if (ids[i] >= 0)
+        method_ids[names[i]] = ids[i];
+    }
+  });
+
+  return name;
 }
 
 function wrapPromiseAsCallback(promise) {
@@ -58,7 +98,7 @@ function wrapPromiseAsCallback(promise) {
 var BindingObjectPrototype = function() {
   function postMessage(name, args, callback) {
     return internal.postMessage("postMessageToObject",
-        [this._id, name, args], callback);
+        [this._id, getMethodId(name), args], callback);
   };
 
   function isEnumerable(method_name) {
@@ -66,6 +106,8 @@ var BindingObjectPrototype = function() {
   };
 
   function addMethod(name, has_callback) {
+    addMethodName(name);
+
     Object.defineProperty(this, name, {
       value: function() {
         var args = Array.prototype.slice.call(arguments);
@@ -81,6 +123,8 @@ var BindingObjectPrototype = function() {
   };
 
   function addMethodWithPromise(name, Promise) {
+    addMethodName(name);
+
     Object.defineProperty(this, name, {
       value: function() {
         var promise_instance = new Promise();
@@ -140,12 +184,24 @@ var BindingObject = function(object_id) {
 //
 // The following method is available for internal usage only:
 //
-// _addEvent(event_name, EventSynthesizer?):
+// _addEvent(event_name, EventSynthesizer?, options?):
 //     Convenience function for declaring the events available for the
 //     EventTarget. It will also declare a functional on[type] EventHandler.
 //     The optional EventSynthesizer, if supplied, will be used for create
 //     the event, if not supplied, a default MessageEvent is created (the data
-//     is simply associated to event.data).
+//     is simply associated to event.data). The optional |options| object
+//     can have the following members:
+//       is_batched: the native side always sends an array with the data of
+//           many events at once, one event is dispatched for each element.
+//       on_dispatched: called with each event after its listeners ran, even
+//           if one of them threw.
+//       max_rate: the events are delivered at most this number of times
+//           per second, the ones in between wait.
+//       coalesce: only the latest of the waiting events is delivered, for
+//           events that report a state.
+//       batch: all the waiting events are delivered in one message.
+//     The last three are applied by the native EventTarget, so events of
+//     different types can be delivered out of order when they are used.
 //
 // Important considerations:
 //    - Objects with message listeners attached are never going to be collected
@@ -161,7 +217,7 @@ var EventTargetPrototype = function() {
       this.data = data;
   };
 
-  function addEvent(type, event) {
+  function addEvent(type, event, options) {
     Object.defineProperty(this, "_on" + type, {
       writable : true,
     });
@@ -188,6 +244,32 @@ var EventTargetPrototype = function() {
       this._event_synthesizers[type] = event;
     else
       this._event_synthesizers[type] = DefaultEvent;
+
+    if (!options)
+      return;
+
+    if (options.is_batched)
+      this._batched_events[type] = true;
+    if (options.on_dispatched)
+      this._event_dispatched_callbacks[type] = options.on_dispatched;
+
+    var listener_options = {};
+    var has_listener_options = false;
+    if (options.max_rate) {
+      listener_options.maxRate = options.max_rate;
+      has_listener_options = true;
+    }
+    if (options.coalesce) {
+      listener_options.coalesce = true;
+      has_listener_options = true;
+    }
+    if (options.batch) {
+      listener_options.batch = true;
+      has_listener_options = true;
+    }
+
+    if (has_listener_options)
+      this._event_listener_options[type] = listener_options;
   };
 
   function dispatchEvent(event) {
@@ -201,17 +283,50 @@ var EventTargetPrototype = function() {
       listeners[i](event);
   };
 
+  // Like in the DOM, all the listeners get the same event object, so the
+  // EventSynthesizer runs once per event.
   function dispatchEventFromExtension(type, data) {
-    var listeners = this._event_listeners[type];
+    if (!this._batched_events[type]) {
+      dispatchSynthesizedEvent(this, type, data);
+      return;
+    }
 
-    for (var i in listeners)
-      listeners[i](new this._event_synthesizers[type](type, data));
+    for (var i = 0; i < data.length; ++i)
+      dispatchSynthesizedEvent(this, type, data[i]);
+  };
+
+  function dispatchSynthesizedEvent(obj, type, data) {
+    var listeners = obj._event_listeners[type];
+    var event = new obj._event_synthesizers[type](type, data);
+    var on_dispatched = obj._event_dispatched_callbacks[type];
+
+    if (!on_dispatched) {
+      for (var i in listeners)
+        listeners[i](event);
+      return;
+    }
+
+    try {
+      for (var i in listeners)
+        listeners[i](event);
+    } finally {
+      on_dispatched(event);
+    }
   };
 
   // We need a reference to the calling object because
   // this function is called by the renderer process with
   // "this" equals to the global object.
   function makeCallbackListener(obj, type) {
+    var options = obj._event_listener_options[type];
+    if (options && options.batch) {
+      return function(events) {
+        for (var i = 0; i < events.length; ++i)
+          obj._dispatchEventFromExtension(type, events[i]);
+        return true;
+      };
+    }
+
     return function(data) {
       obj._dispatchEventFromExtension(type, data);
       return true;
@@ -231,8 +346,11 @@ var EventTargetPrototype = function() {
         listeners.push(listener);
     } else {
       this._event_listeners[type] = [listener];
+      var args = [type];
+      if (type in this._event_listener_options)
+        args.push(this._event_listener_options[type]);
       var id = this._postMessage("addEventListener",
-          [type], makeCallbackListener(this, type));
+          args, makeCallbackListener(this, type));
       this._callback_listeners_id[type] = id;
     }
   };
@@ -292,6 +410,15 @@ var EventTarget = function(object_id) {
     "_event_synthesizers": {
       value: {},
     },
+    "_batched_events": {
+      value: {},
+    },
+    "_event_listener_options": {
+      value: {},
+    },
+    "_event_dispatched_callbacks": {
+      value: {},
+    },
   });
 };
 
@@ -75,8 +75,8 @@ void SysAppsTestExtensionInstance::HandleMessage(scoped_ptr<base::Value> msg) {
 
 void SysAppsTestExtensionInstance::OnSysAppsTestObjectContructor(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  std::string object_id;
-  ASSERT_TRUE(info->arguments()->GetString(0, &object_id));
+  int object_id;
+  ASSERT_TRUE(info->arguments()->GetInteger(0, &object_id));
 
   scoped_ptr<BindingObject> obj(new SysAppsTestObject);
   store_.AddBindingObject(object_id, obj.Pass());
@@ -84,8 +84,8 @@ void SysAppsTestExtensionInstance::OnSysAppsTestObjectContructor(
 
 void SysAppsTestExtensionInstance::OnHasObject(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  std::string object_id;
-  ASSERT_TRUE(info->arguments()->GetString(0, &object_id));
+  int object_id;
+  ASSERT_TRUE(info->arguments()->GetInteger(0, &object_id));
 
   scoped_ptr<base::ListValue> result(new base::ListValue());
   result->AppendBoolean(store_.HasObjectForTesting(object_id));
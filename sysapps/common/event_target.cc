@@ -4,6 +4,9 @@
 
 #include "xwalk/sysapps/common/event_target.h"
 
+#include "base/location.h"
+#include "base/message_loop/message_loop.h"
+#include "base/stl_util.h"
 #include "xwalk/sysapps/common/common.h"
 
 using namespace xwalk::jsapi::common; // NOLINT
@@ -11,14 +14,32 @@ using namespace xwalk::jsapi::common; // NOLINT
 namespace xwalk {
 namespace sysapps {
 
-EventTarget::EventTarget() {
+namespace {
+
+// Events waiting to be sent while throttled, the oldest ones are dropped
+// past this, so a flood can't grow the queue unbounded.
+const size_t kMaxPendingEvents = 1024;
+
+}  // namespace
+
+EventTarget::Event::Event()
+    : coalesce(false),
+      batch(false),
+      flush_scheduled(false) {}
+
+EventTarget::Event::~Event() {}
+
+EventTarget::EventTarget()
+    : weak_factory_(this) {
   handler_.Register("addEventListener",
       base::Bind(&EventTarget::OnAddEventListener, base::Unretained(this)));
   handler_.Register("removeEventListener",
       base::Bind(&EventTarget::OnRemoveEventListener, base::Unretained(this)));
 }
 
-EventTarget::~EventTarget() {}
+EventTarget::~EventTarget() {
+  STLDeleteValues(&events_);
+}
 
 void EventTarget::DispatchEvent(const std::string& type) {
   DispatchEvent(type, make_scoped_ptr(new base::ListValue));
@@ -30,7 +51,87 @@ void EventTarget::DispatchEvent(const std::string& type,
   if (it == events_.end())
     return;
 
-  it->second.Run(data.Pass());
+  Event* event = it->second;
+  if (!event->is_throttled()) {
+    event->callback.Run(data.Pass());
+    return;
+  }
+
+  // Only rate limited, and the limit isn't hit.
+  if (!event->coalesce && !event->batch && event->pending.empty() &&
+      base::TimeTicks::Now() - event->last_dispatch >= event->min_interval) {
+    event->last_dispatch = base::TimeTicks::Now();
+    event->callback.Run(data.Pass());
+    return;
+  }
+
+  if (event->coalesce) {
+    event->pending.clear();
+  } else if (event->pending.size() >= kMaxPendingEvents) {
+    LOG(WARNING) << "Too many '" << type << "' events waiting to be sent, "
+        "dropping the oldest one.";
+    event->pending.erase(event->pending.begin());
+  }
+
+  event->pending.push_back(data.release());
+  ScheduleFlush(type, event);
+}
+
+void EventTarget::ScheduleFlush(const std::string& type, Event* event) {
+  if (event->flush_scheduled)
+    return;
+
+  base::TimeDelta delay =
+      event->last_dispatch + event->min_interval - base::TimeTicks::Now();
+  if (delay < base::TimeDelta())
+    delay = base::TimeDelta();
+
+  event->flush_scheduled = true;
+  base::MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      base::Bind(&EventTarget::FlushEvent, weak_factory_.GetWeakPtr(), type),
+      delay);
+}
+
+void EventTarget::FlushEvent(const std::string& type) {
+  EventMap::iterator it = events_.find(type);
+  if (it == events_.end())
+    return;
+
+  // The listener could have been removed and added again since the flush
+  // was scheduled, this is fine as long as nothing is flushed twice.
+  Event* event = it->second;
+  if (!event->flush_scheduled)
+    return;
+
+  event->flush_scheduled = false;
+  if (event->pending.empty())
+    return;
+
+  event->last_dispatch = base::TimeTicks::Now();
+
+  if (!event->batch) {
+    scoped_ptr<base::ListValue> data(event->pending.front());
+    event->pending.weak_erase(event->pending.begin());
+    event->callback.Run(data.Pass());
+  } else {
+    // Events are sent with their data as the first argument, so the batch
+    // is a list of these.
+    scoped_ptr<base::ListValue> events(new base::ListValue);
+    for (size_t i = 0; i < event->pending.size(); ++i) {
+      scoped_ptr<base::Value> event_data;
+      if (!event->pending[i]->Remove(0, &event_data))
+        event_data.reset(base::Value::CreateNullValue());
+      events->Append(event_data.release());
+    }
+    event->pending.clear();
+
+    scoped_ptr<base::ListValue> data(new base::ListValue);
+    data->Append(events.release());
+    event->callback.Run(data.Pass());
+  }
+
+  if (!event->pending.empty())
+    ScheduleFlush(type, event);
 }
 
 bool EventTarget::IsEventActive(const std::string& type) const {
@@ -54,7 +155,19 @@ void EventTarget::OnAddEventListener(
     return;
   }
 
-  events_[params->type] = info->post_result_cb();
+  Event* event = new Event;
+  event->callback = info->post_result_cb();
+  if (params->options) {
+    const EventListenerOptions& options = *params->options;
+    if (options.max_rate && *options.max_rate > 0) {
+      event->min_interval = base::TimeDelta::FromMicroseconds(
+          base::Time::kMicrosecondsPerSecond / *options.max_rate);
+    }
+    event->coalesce = options.coalesce && *options.coalesce;
+    event->batch = options.batch && *options.batch;
+  }
+
+  events_[params->type] = event;
   StartEvent(params->type);
 }
 
@@ -75,6 +188,7 @@ void EventTarget::OnRemoveEventListener(
     return;
   }
 
+  delete it->second;
   events_.erase(it);
   StopEvent(params->type);
 }
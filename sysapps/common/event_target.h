@@ -7,6 +7,9 @@
 
 #include <map>
 #include <string>
+#include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "xwalk/sysapps/common/binding_object.h"
 
 namespace xwalk {
@@ -17,6 +20,13 @@ using extensions::XWalkExtensionFunctionInfo;
 // The EventTarget class is the native implementation of the W3C standard
 // EventTarget (http://www.w3.org/TR/DOM-Level-3-Events/#interface-EventTarget).
 // It has convenience methods and signals to make dispatching of events simple.
+//
+// The JavaScript side can ask for the events of a type to be throttled when
+// adding its listener: sent at most |maxRate| times per second, coalesced so
+// only the latest event waiting is delivered, or batched so all the events
+// waiting are delivered in one message, as a list of their data. Events are
+// waiting while the rate limit is hit, and also until the task dispatching
+// them returns when they are coalesced or batched.
 class EventTarget : public BindingObject {
  public:
   EventTarget();
@@ -33,7 +43,8 @@ class EventTarget : public BindingObject {
   // DispatchEvent will send an event to the JavaScript counterpart of this
   // object and invoke its listeners. The message is only sent if there is at
   // least one listener, so it is safe to call this method without concerning
-  // about performance issues.
+  // about performance issues. The event might be delayed, merged with others
+  // or dropped if the listener asked for it, see above.
   void DispatchEvent(const std::string& type);
   void DispatchEvent(const std::string& type, scoped_ptr<base::ListValue> data);
 
@@ -43,10 +54,32 @@ class EventTarget : public BindingObject {
   void OnAddEventListener(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnRemoveEventListener(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
-  typedef std::map<std::string,
-      XWalkExtensionFunctionInfo::PostResultCallback> EventMap;
+  struct Event {
+    Event();
+    ~Event();
+
+    bool is_throttled() const {
+      return min_interval > base::TimeDelta() || coalesce || batch;
+    }
+
+    XWalkExtensionFunctionInfo::PostResultCallback callback;
+    base::TimeDelta min_interval;
+    bool coalesce;
+    bool batch;
+
+    base::TimeTicks last_dispatch;
+    ScopedVector<base::ListValue> pending;
+    bool flush_scheduled;
+  };
+
+  void ScheduleFlush(const std::string& type, Event* event);
+  void FlushEvent(const std::string& type);
+
+  typedef std::map<std::string, Event*> EventMap;
 
   EventMap events_;
+
+  base::WeakPtrFactory<EventTarget> weak_factory_;
 };
 
 }  // namespace sysapps
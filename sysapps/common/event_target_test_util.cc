@@ -0,0 +1,54 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/common/event_target_test_util.h"
+
+#include "base/bind.h"
+
+using xwalk::extensions::XWalkExtensionFunctionInfo;
+
+namespace xwalk {
+namespace sysapps {
+
+namespace {
+
+scoped_ptr<XWalkExtensionFunctionInfo> CreateListenerInfo(
+    scoped_ptr<base::ListValue> arguments,
+    ScopedVector<base::ListValue>* results) {
+  return make_scoped_ptr(new XWalkExtensionFunctionInfo(
+      "addEventListener",
+      arguments.Pass(),
+      base::Bind(&StoreResult, results)));
+}
+
+}  // namespace
+
+void StoreResult(ScopedVector<base::ListValue>* results,
+                 scoped_ptr<base::ListValue> result) {
+  results->push_back(result.release());
+}
+
+scoped_ptr<XWalkExtensionFunctionInfo> CreateAddEventListenerInfo(
+    const std::string& type, ScopedVector<base::ListValue>* results) {
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->AppendString(type);
+
+  return CreateListenerInfo(arguments.Pass(), results);
+}
+
+scoped_ptr<XWalkExtensionFunctionInfo> CreateAddEventListenerInfo(
+    const std::string& type, const std::string& option,
+    ScopedVector<base::ListValue>* results) {
+  scoped_ptr<base::DictionaryValue> options(new base::DictionaryValue);
+  options->SetBoolean(option, true);
+
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->AppendString(type);
+  arguments->Append(options.release());
+
+  return CreateListenerInfo(arguments.Pass(), results);
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
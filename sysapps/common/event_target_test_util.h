@@ -0,0 +1,35 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_COMMON_EVENT_TARGET_TEST_UTIL_H_
+#define XWALK_SYSAPPS_COMMON_EVENT_TARGET_TEST_UTIL_H_
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/values.h"
+#include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Appends |result| to |results|, used as the callback of the listeners.
+void StoreResult(ScopedVector<base::ListValue>* results,
+                 scoped_ptr<base::ListValue> result);
+
+// Returns the addEventListener() call of a listener of |type| events, which
+// are appended to |results| as they are dispatched.
+scoped_ptr<extensions::XWalkExtensionFunctionInfo> CreateAddEventListenerInfo(
+    const std::string& type, ScopedVector<base::ListValue>* results);
+
+// Same as above, with the boolean |option| of the listener set.
+scoped_ptr<extensions::XWalkExtensionFunctionInfo> CreateAddEventListenerInfo(
+    const std::string& type, const std::string& option,
+    ScopedVector<base::ListValue>* results);
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_COMMON_EVENT_TARGET_TEST_UTIL_H_
@@ -4,11 +4,14 @@
 
 #include "xwalk/sysapps/common/event_target.h"
 
+#include "base/message_loop/message_loop.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
+#include "xwalk/sysapps/common/event_target_test_util.h"
 
 using xwalk::extensions::XWalkExtensionFunctionInfo;
 using xwalk::sysapps::BindingObject;
+using xwalk::sysapps::CreateAddEventListenerInfo;
 using xwalk::sysapps::EventTarget;
 
 namespace {
@@ -49,6 +52,13 @@ class EventTargetTest : public EventTarget {
     DispatchEvent(type, data.Pass());
   }
 
+  void InjectEvent(const std::string& type, int value) {
+    scoped_ptr<base::ListValue> data(new base::ListValue());
+    data->AppendInteger(value);
+
+    DispatchEvent(type, data.Pass());
+  }
+
   bool is_event1_active() const {
     return event1_count_ == 1;
   }
@@ -162,3 +172,57 @@ TEST(XWalkSysAppsEventTargetTest, DispatchEvent) {
     EXPECT_EQ(message_count, i + 1);
   }
 }
+
+TEST(XWalkSysAppsEventTargetTest, CoalesceEvents) {
+  base::MessageLoop loop;
+  scoped_ptr<EventTargetTest> target(new EventTargetTest());
+
+  ScopedVector<base::ListValue> results;
+  EXPECT_TRUE(target->HandleFunction(
+      CreateAddEventListenerInfo("event1", "coalesce", &results)));
+
+  for (int i = 0; i < 10; ++i)
+    target->InjectEvent("event1", i);
+  EXPECT_TRUE(results.empty());
+
+  // Only the latest event is delivered, when the task returns.
+  loop.RunUntilIdle();
+  ASSERT_EQ(1u, results.size());
+
+  int value;
+  ASSERT_TRUE(results[0]->GetInteger(0, &value));
+  EXPECT_EQ(9, value);
+}
+
+TEST(XWalkSysAppsEventTargetTest, BatchEvents) {
+  base::MessageLoop loop;
+  scoped_ptr<EventTargetTest> target(new EventTargetTest());
+
+  ScopedVector<base::ListValue> results;
+  EXPECT_TRUE(target->HandleFunction(
+      CreateAddEventListenerInfo("event1", "batch", &results)));
+
+  for (int i = 0; i < 10; ++i)
+    target->InjectEvent("event1", i);
+  EXPECT_TRUE(results.empty());
+
+  loop.RunUntilIdle();
+  ASSERT_EQ(1u, results.size());
+
+  // The data of all the events, in order.
+  base::ListValue* events;
+  ASSERT_TRUE(results[0]->GetList(0, &events));
+  ASSERT_EQ(10u, events->GetSize());
+  for (int i = 0; i < 10; ++i) {
+    int value;
+    ASSERT_TRUE(events->GetInteger(i, &value));
+    EXPECT_EQ(i, value);
+  }
+
+  // Events waiting are dropped with the listener.
+  target->InjectEvent("event1", 42);
+  EXPECT_TRUE(target->HandleFunction(
+      CreateFunctionInfo("removeEventListener", "event1")));
+  loop.RunUntilIdle();
+  EXPECT_EQ(1u, results.size());
+}
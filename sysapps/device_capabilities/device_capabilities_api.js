@@ -20,10 +20,13 @@ var DeviceCapabilities = function() {
 
   internal.postMessage("deviceCapabilitiesConstructor", [this._id]);
 
-  this._addEvent("displayconnect");
-  this._addEvent("displaydisconnect");
-  this._addEvent("storageattach");
-  this._addEvent("storagedetach");
+  // Plugging hardware can produce bursts of these, they are delivered
+  // together a few times per second at most.
+  var hotplug_options = { batch: true, max_rate: 10 };
+  this._addEvent("displayconnect", undefined, hotplug_options);
+  this._addEvent("displaydisconnect", undefined, hotplug_options);
+  this._addEvent("storageattach", undefined, hotplug_options);
+  this._addEvent("storagedetach", undefined, hotplug_options);
 
   this._addMethodWithPromise("getAVCodecs", Promise);
   this._addMethodWithPromise("getCPUInfo", Promise);
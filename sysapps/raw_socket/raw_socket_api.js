@@ -37,15 +37,77 @@ var ReadyStateObserver = function(object_id, initial_state) {
 
 ReadyStateObserver.prototype = new common.EventTargetPrototype();
 
+// send() returns false when more than this amount of bytes is buffered, and
+// asks the native side for a "drain" event once the buffer is mostly written.
+var kSendHighWaterMark = 1024 * 1024;
+
+// Counts the bytes of |string| once encoded as UTF-8, which is how strings
+// are written to the socket.
+function getUTF8Length(string) {
+  var length = 0;
+
+  for (var i = 0; i < string.length; ++i) {
+    var code = string.charCodeAt(i);
+    if (code < 0x80) {
+      length += 1;
+    } else if (code < 0x800) {
+      length += 2;
+    } else if (code >= 0xD800 && code <= 0xDBFF && i + 1 < string.length &&
+               (string.charCodeAt(i + 1) & 0xFC00) == 0xDC00) {
+      // Surrogate pair.
+      length += 4;
+      ++i;
+    } else {
+      length += 3;
+    }
+  }
+
+  return length;
+};
+
+// ArrayBuffers and ArrayBufferViews are sent as binary data, anything else is
+// sent as a string.
+function isBinaryData(data) {
+  return data instanceof ArrayBuffer ||
+      (data != null && data.buffer instanceof ArrayBuffer);
+};
+
+// The BufferedAmountObserver is a proxy object like the
+// ReadyStateObserver. It keeps track of the bytes sent
+// and not yet written by subscribing to the parent's
+// |written| event.
+//
+var BufferedAmountObserver = function(object_id) {
+  common.BindingObject.call(this, object_id);
+  common.EventTarget.call(this);
+
+  this._addEvent("written");
+  this.bufferedAmount = 0;
+
+  var that = this;
+  this.onwritten = function(event) {
+    that.bufferedAmount = Math.max(0, that.bufferedAmount - event.data);
+  };
+
+  this.destructor = function() {
+    this.onwritten = null;
+  };
+};
+
+BufferedAmountObserver.prototype = new common.EventTargetPrototype();
+
+// Amount of bytes received and not handled yet after which the native side
+// stops reading from the socket, until the data is acknowledged.
+var kReceiveHighWaterMark = 1024 * 1024;
+
 // TCPSocket interface.
 //
 // TODO(tmpsantos): We are currently not throwing any exceptions
 // neither validating the input parameters.
 //
-// TODO(tmpsantos): TCPOptions argument is being ignored by now.
-//
 var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
-  common.BindingObject.call(this, object_id ? object_id : common.getUniqueId());
+  common.BindingObject.call(this,
+      object_id != undefined ? object_id : common.getUniqueId());
   common.EventTarget.call(this);
 
   if (object_id == undefined)
@@ -63,28 +125,59 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     options.noDelay = true;
   if (!options.useSecureTransport)
     options.useSecureTransport = false;
+  if (!options.receiveHighWaterMark)
+    options.receiveHighWaterMark = kReceiveHighWaterMark;
 
   this._addMethod("_close");
   this._addMethod("_halfclose");
   this._addMethod("suspend");
   this._addMethod("resume");
   this._addMethod("_sendString");
+  this._addMethod("_sendArrayBuffer");
+  this._addMethod("_requestDrain");
+  this._addMethod("_acknowledgeData");
+
+  // The data is acknowledged once the listeners handled it, so the native
+  // side stops reading while they can't keep up.
+  var that = this;
+  function DataEvent(type, data) {
+    this.type = type;
+    this.data = data;
+  }
+
+  function acknowledgeDataEvent(event) {
+    that._acknowledgeData(event.data.byteLength);
+  }
 
   this._addEvent("drain");
   this._addEvent("open");
   this._addEvent("close");
   this._addEvent("error");
-  this._addEvent("data");
+  this._addEvent("data", DataEvent, { on_dispatched: acknowledgeDataEvent });
 
+  // ArrayBufferViews are sent as ArrayBuffers, only the viewed bytes are
+  // copied when converting them to the message.
+  //
+  // TODO(tmpsantos): Blobs are not supported yet.
   function sendWrapper(data) {
-    this._sendString(data);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    var readyState = this._readyStateObserver.readyState;
+    if (readyState != "opening" && readyState != "open")
+      return false;
+
+    if (isBinaryData(data)) {
+      this._bufferedAmountObserver.bufferedAmount += data.byteLength;
+      this._sendArrayBuffer(data);
+    } else {
+      data = String(data);
+      this._bufferedAmountObserver.bufferedAmount += getUTF8Length(data);
+      this._sendString(data);
+    }
+
+    if (this._bufferedAmountObserver.bufferedAmount <= kSendHighWaterMark)
+      return true;
+
+    this._requestDrain();
+    return false;
   };
 
   function closeWrapper(data) {
@@ -92,6 +185,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       return;
 
     this._readyStateObserver.readyState = "closing";
+    this._bufferedAmountObserver.bufferedAmount = 0;
     this._close();
   };
 
@@ -108,6 +202,9 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       value: new ReadyStateObserver(
           this._id, object_id ? "open" : "opening"),
     },
+    "_bufferedAmountObserver": {
+      value: new BufferedAmountObserver(this._id),
+    },
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
@@ -148,7 +245,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       enumerable: true,
     },
     "bufferedAmount": {
-      value: 0,
+      get: function() { return this._bufferedAmountObserver.bufferedAmount; },
       enumerable: true,
     },
     "readyState": {
@@ -158,8 +255,10 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   });
 
   var watcher = this._readyStateObserver;
+  var bufferedAmountWatcher = this._bufferedAmountObserver;
   this._readyStateObserverDeleter.destructor = function() {
     watcher.destructor();
+    bufferedAmountWatcher.destructor();
   };
 
   // This is needed, otherwise events like "error" can get fired before
@@ -203,6 +302,8 @@ var TCPServerSocket = function(options) {
 
   // FIXME(tmpsantos): Get the real remote IP and port
   // from the native backend.
+  //
+  // The connections accepted together come in a single message.
   function ConnectEvent(type, data) {
     var object_id = data[0];
     var options = data[1];
@@ -213,7 +314,7 @@ var TCPServerSocket = function(options) {
   }
 
   this._addEvent("open");
-  this._addEvent("connect", ConnectEvent);
+  this._addEvent("connect", ConnectEvent, { is_batched: true });
   this._addEvent("error");
   this._addEvent("connecterror");
 
@@ -295,6 +396,8 @@ var UDPSocket = function(options) {
     options.addressReuse = true;
   if (!options.loopback)
     options.loopback = false;
+  if (!options.receiveHighWaterMark)
+    options.receiveHighWaterMark = kReceiveHighWaterMark;
 
   this._addMethod("_close");
   this._addMethod("suspend");
@@ -302,7 +405,12 @@ var UDPSocket = function(options) {
   this._addMethod("joinMulticast");
   this._addMethod("leaveMulticast");
   this._addMethod("_sendString");
+  this._addMethod("_sendDatagrams");
+  this._addMethod("_requestDrain");
+  this._addMethod("_acknowledgeData");
 
+  // Acknowledged like the TCPSocket "data" event.
+  var that = this;
   function MessageEvent(type, data) {
     this.type = type;
     this.data = data.data;
@@ -310,20 +418,78 @@ var UDPSocket = function(options) {
     this.remoteAddress = data.remoteAddress;
   }
 
+  function acknowledgeMessageEvent(event) {
+    that._acknowledgeData(event.data.byteLength);
+  }
+
   this._addEvent("open");
   this._addEvent("drain");
   this._addEvent("error");
-  this._addEvent("message", MessageEvent);
+  this._addEvent("message", MessageEvent,
+                 { on_dispatched: acknowledgeMessageEvent });
+
+  // Returns the datagram as expected by _sendDatagrams(), adding its size to
+  // the buffered amount.
+  function createDatagram(obj, data, remoteAddress, remotePort) {
+    var datagram = {
+      remoteAddress: remoteAddress,
+      remotePort: remotePort,
+    };
+
+    if (isBinaryData(data)) {
+      datagram.binaryData = data;
+      obj._bufferedAmountObserver.bufferedAmount += data.byteLength;
+    } else {
+      datagram.data = String(data);
+      obj._bufferedAmountObserver.bufferedAmount +=
+          getUTF8Length(datagram.data);
+    }
+
+    return datagram;
+  };
+
+  function canSend(obj) {
+    var readyState = obj._readyStateObserver.readyState;
+    return readyState == "opening" || readyState == "open";
+  };
+
+  function checkBufferedAmount(obj) {
+    if (obj._bufferedAmountObserver.bufferedAmount <= kSendHighWaterMark)
+      return true;
+
+    obj._requestDrain();
+    return false;
+  };
 
   function sendWrapper(data, remoteAddress, remotePort) {
-    this._sendString(data, remoteAddress, remotePort);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    if (!canSend(this))
+      return false;
+
+    var datagram = createDatagram(this, data, remoteAddress, remotePort);
+    if (datagram.data != undefined)
+      this._sendString(datagram.data, remoteAddress, remotePort);
+    else
+      this._sendDatagrams([datagram]);
+
+    return checkBufferedAmount(this);
+  };
+
+  function sendBatchWrapper(datagrams) {
+    if (!canSend(this))
+      return false;
+
+    var batch = [];
+    for (var i = 0; i < datagrams.length; ++i) {
+      var datagram = datagrams[i];
+      if (isBinaryData(datagram) || typeof datagram != "object")
+        batch.push(createDatagram(this, datagram));
+      else
+        batch.push(createDatagram(this, datagram.data,
+            datagram.remoteAddress, datagram.remotePort));
+    }
+
+    this._sendDatagrams(batch);
+    return checkBufferedAmount(this);
   };
 
   function closeWrapper(data) {
@@ -331,6 +497,7 @@ var UDPSocket = function(options) {
       return;
 
     this._readyStateObserver.readyState = "closing";
+    this._bufferedAmountObserver.bufferedAmount = 0;
     this._close();
   };
 
@@ -338,6 +505,9 @@ var UDPSocket = function(options) {
     "_readyStateObserver": {
       value: new ReadyStateObserver(this._id, "opening"),
     },
+    "_bufferedAmountObserver": {
+      value: new BufferedAmountObserver(this._id),
+    },
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
@@ -345,6 +515,10 @@ var UDPSocket = function(options) {
       value: sendWrapper,
       enumerable: true,
     },
+    "sendBatch": {
+      value: sendBatchWrapper,
+      enumerable: true,
+    },
     "close": {
       value: closeWrapper,
       enumerable: true,
@@ -374,7 +548,7 @@ var UDPSocket = function(options) {
       enumerable: true,
     },
     "bufferedAmount": {
-      value: 0,
+      get: function() { return this._bufferedAmountObserver.bufferedAmount; },
       enumerable: true,
     },
     "readyState": {
@@ -384,8 +558,10 @@ var UDPSocket = function(options) {
   });
 
   var watcher = this._readyStateObserver;
+  var bufferedAmountWatcher = this._bufferedAmountObserver;
   this._readyStateObserverDeleter.destructor = function() {
     watcher.destructor();
+    bufferedAmountWatcher.destructor();
   };
 
   // This is needed, otherwise events like "error" can get fired before
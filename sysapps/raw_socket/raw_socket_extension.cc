@@ -5,6 +5,7 @@
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
 
 #include "grit/xwalk_sysapps_resources.h"
+#include "net/dns/host_resolver.h"
 #include "ui/base/resource/resource_bundle.h"
 #include "xwalk/sysapps/raw_socket/raw_socket.h"
 #include "xwalk/sysapps/raw_socket/tcp_server_socket_object.h"
@@ -25,11 +26,15 @@ RawSocketExtension::RawSocketExtension() {
 RawSocketExtension::~RawSocketExtension() {}
 
 XWalkExtensionInstance* RawSocketExtension::CreateInstance() {
-  return new RawSocketInstance();
+  if (!resolver_)
+    resolver_ = net::HostResolver::CreateDefaultResolver(NULL);
+
+  return new RawSocketInstance(resolver_.get());
 }
 
-RawSocketInstance::RawSocketInstance()
-  : handler_(this),
+RawSocketInstance::RawSocketInstance(net::HostResolver* resolver)
+  : resolver_(resolver),
+    handler_(this),
     store_(&handler_) {
   handler_.Register("TCPServerSocketConstructor",
       base::Bind(&RawSocketInstance::OnTCPServerSocketConstructor,
@@ -46,9 +51,8 @@ void RawSocketInstance::HandleMessage(scoped_ptr<base::Value> msg) {
   handler_.HandleMessage(msg.Pass());
 }
 
-void RawSocketInstance::AddBindingObject(const std::string& object_id,
-                                         scoped_ptr<BindingObject> obj) {
-  store_.AddBindingObject(object_id, obj.Pass());
+int RawSocketInstance::AddBindingObject(scoped_ptr<BindingObject> obj) {
+  return store_.AddNativeBindingObject(obj.Pass());
 }
 
 void RawSocketInstance::OnTCPServerSocketConstructor(
@@ -75,7 +79,7 @@ void RawSocketInstance::OnTCPSocketConstructor(
     return;
   }
 
-  scoped_ptr<BindingObject> obj(new TCPSocketObject);
+  scoped_ptr<BindingObject> obj(new TCPSocketObject(resolver_));
   store_.AddBindingObject(params->object_id, obj.Pass());
 }
 
@@ -89,7 +93,7 @@ void RawSocketInstance::OnUDPSocketConstructor(
     return;
   }
 
-  scoped_ptr<BindingObject> obj(new UDPSocketObject);
+  scoped_ptr<BindingObject> obj(new UDPSocketObject(resolver_));
   store_.AddBindingObject(params->object_id, obj.Pass());
 }
 
@@ -9,6 +9,10 @@
 #include "base/values.h"
 #include "xwalk/sysapps/common/binding_object_store.h"
 
+namespace net {
+class HostResolver;
+}
+
 namespace xwalk {
 namespace sysapps {
 
@@ -24,17 +28,23 @@ class RawSocketExtension : public XWalkExtension {
 
   // XWalkExtension implementation.
   virtual XWalkExtensionInstance* CreateInstance() OVERRIDE;
+
+ private:
+  // Shared by the sockets of all the instances, so they share its host cache
+  // and concurrent resolutions of the same host. Created on the thread
+  // running the instances when the first one is created.
+  scoped_ptr<net::HostResolver> resolver_;
 };
 
 class RawSocketInstance : public XWalkExtensionInstance {
  public:
-  RawSocketInstance();
+  explicit RawSocketInstance(net::HostResolver* resolver);
 
   // XWalkExtensionInstance implementation.
   virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE;
 
-  void AddBindingObject(const std::string& object_id,
-                        scoped_ptr<BindingObject> obj);
+  // Adds an object created by the native side, returns its ID.
+  int AddBindingObject(scoped_ptr<BindingObject> obj);
 
  private:
   void OnTCPServerSocketConstructor(
@@ -42,6 +52,7 @@ class RawSocketInstance : public XWalkExtensionInstance {
   void OnTCPSocketConstructor(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnUDPSocketConstructor(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
+  net::HostResolver* resolver_;
   XWalkExtensionFunctionHandler handler_;
   BindingObjectStore store_;
 };
@@ -4,22 +4,102 @@
 
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
 
+#include "base/bind.h"
+#include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop.h"
 #include "base/values.h"
 
+namespace {
+
+// A requested "drain" is dispatched when the buffered amount is back under
+// this, a quarter of the high-water mark used by send() in raw_socket_api.js,
+// so the queue doesn't run dry while JavaScript refills it.
+const size_t kWriteLowWaterMark = 256 * 1024;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
-RawSocketObject::RawSocketObject() {}
+RawSocketObject::RawSocketObject()
+    : ready_state_(jsapi::raw_socket::READY_STATE_OPENING),
+      buffered_amount_(0),
+      is_drain_requested_(false),
+      unreported_written_bytes_(0),
+      is_written_scheduled_(false),
+      weak_factory_(this) {
+  handler_.Register("_requestDrain",
+      base::Bind(&RawSocketObject::OnRequestDrain, base::Unretained(this)));
+}
 
 RawSocketObject::~RawSocketObject() {}
 
 void RawSocketObject::setReadyState(ReadyState state) {
+  ready_state_ = state;
+
   scoped_ptr<base::ListValue> eventData(new base::ListValue);
   eventData->AppendString(ToString(state));
 
   DispatchEvent("readystate", eventData.Pass());
 }
 
+void RawSocketObject::IncreaseBufferedAmount(size_t bytes) {
+  buffered_amount_ += bytes;
+}
+
+void RawSocketObject::DecreaseBufferedAmount(size_t bytes) {
+  DCHECK_LE(bytes, buffered_amount_);
+  buffered_amount_ -= bytes;
+  unreported_written_bytes_ += bytes;
+
+  if (!is_written_scheduled_) {
+    is_written_scheduled_ = true;
+    base::MessageLoop::current()->PostTask(FROM_HERE,
+        base::Bind(&RawSocketObject::DispatchWritten,
+                   weak_factory_.GetWeakPtr()));
+  }
+
+  MaybeDispatchDrain();
+}
+
+void RawSocketObject::ResetBufferedAmount() {
+  // JavaScript resets |bufferedAmount| itself when the socket is closed.
+  buffered_amount_ = 0;
+  unreported_written_bytes_ = 0;
+  is_drain_requested_ = false;
+}
+
+void RawSocketObject::DispatchWritten() {
+  is_written_scheduled_ = false;
+  if (!unreported_written_bytes_)
+    return;
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendInteger(unreported_written_bytes_);
+  unreported_written_bytes_ = 0;
+  DispatchEvent("written", eventData.Pass());
+}
+
+void RawSocketObject::MaybeDispatchDrain() {
+  if (!is_drain_requested_ || buffered_amount_ > kWriteLowWaterMark)
+    return;
+
+  // JavaScript gets the written bytes first, so |bufferedAmount| is up to
+  // date in the "drain" listeners.
+  DispatchWritten();
+
+  is_drain_requested_ = false;
+  DispatchEvent("drain");
+}
+
+void RawSocketObject::OnRequestDrain(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // The queue might be written already, the request is answered right away
+  // in this case.
+  is_drain_requested_ = true;
+  MaybeDispatchDrain();
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
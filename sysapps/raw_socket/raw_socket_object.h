@@ -5,6 +5,7 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 
+#include "base/memory/weak_ptr.h"
 #include "xwalk/sysapps/raw_socket/raw_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 
@@ -14,6 +15,13 @@ namespace xwalk {
 namespace sysapps {
 
 // Base class for the objects of the RawSocket API.
+// Besides the ready state, keeps the amount of bytes accepted by send() and
+// not written yet. Written bytes are reported to JavaScript as "written"
+// events, so it can keep |bufferedAmount| up to date. All the bytes written
+// in a task, e.g. a whole batch of datagrams, are reported by a single
+// event, dispatched when the task returns. When send() returns
+// false JavaScript requests a "drain" event, dispatched once the buffered
+// amount is back under a low-water mark.
 class RawSocketObject : public EventTarget {
  public:
   virtual ~RawSocketObject();
@@ -22,6 +30,30 @@ class RawSocketObject : public EventTarget {
   RawSocketObject();
 
   void setReadyState(ReadyState state);
+  ReadyState ready_state() const { return ready_state_; }
+
+  size_t buffered_amount() const { return buffered_amount_; }
+  void IncreaseBufferedAmount(size_t bytes);
+  void DecreaseBufferedAmount(size_t bytes);
+  void ResetBufferedAmount();
+
+ private:
+  void DispatchWritten();
+  void MaybeDispatchDrain();
+
+  // JavaScript function handlers.
+  void OnRequestDrain(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  ReadyState ready_state_;
+
+  size_t buffered_amount_;
+  bool is_drain_requested_;
+
+  // Written bytes not reported yet, see DispatchWritten().
+  size_t unreported_written_bytes_;
+  bool is_written_scheduled_;
+
+  base::WeakPtrFactory<RawSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -5,8 +5,11 @@
 #include "xwalk/sysapps/raw_socket/tcp_server_socket_object.h"
 
 #include <string.h>
-#include "base/guid.h"
+#include "base/bind.h"
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_util.h"
@@ -19,13 +22,30 @@
 using namespace xwalk::jsapi::tcp_server_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
+namespace {
+
+// Used when the JavaScript side doesn't set TCPServerOptions.backlog.
+const int kDefaultBacklog = 128;
+
+// Bounds the work done in a single wakeup, so a flood of clients doesn't
+// starve the other sockets. The loop continues in a new task.
+const int kMaxAcceptsPerWakeup = 64;
+
+// Errors like running out of file descriptors are reported again on every
+// accept until the pending connection goes away, so we back off for a while.
+const int kAcceptRetryDelayMs = 100;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
 TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
   : is_suspended_(false),
     is_accepting_(false),
-    instance_(instance) {
+    has_accept_pending_(false),
+    instance_(instance),
+    weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&TCPServerSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -39,9 +59,100 @@ TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
 TCPServerSocketObject::~TCPServerSocketObject() {}
 
 void TCPServerSocketObject::DoAccept() {
-  socket_->Accept(&accepted_socket_,
-                  base::Bind(&TCPServerSocketObject::OnAccept,
-                             base::Unretained(this)));
+  int accepted = 0;
+
+  while (socket_ && !is_suspended_ && !has_accept_pending_) {
+    if (accepted == kMaxAcceptsPerWakeup) {
+      base::MessageLoop::current()->PostTask(FROM_HERE,
+          base::Bind(&TCPServerSocketObject::DoAccept,
+                     weak_factory_.GetWeakPtr()));
+      break;
+    }
+
+    int ret = socket_->Accept(&accepted_socket_,
+                              base::Bind(&TCPServerSocketObject::OnAccept,
+                                         base::Unretained(this)));
+    if (ret == net::ERR_IO_PENDING) {
+      has_accept_pending_ = true;
+      break;
+    }
+
+    if (!DidAccept(ret))
+      break;
+
+    ++accepted;
+  }
+
+  DispatchConnections();
+}
+
+bool TCPServerSocketObject::DidAccept(int status) {
+  if (status == net::OK) {
+    connections_.push_back(accepted_socket_.release());
+    return true;
+  }
+
+  accepted_socket_.reset();
+  DispatchEvent("connecterror");
+
+  // The client gave up before we got to its connection, nothing wrong with
+  // the listening socket.
+  if (status == net::ERR_CONNECTION_ABORTED)
+    return true;
+
+  LOG(WARNING) << "Failed to accept a connection: "
+      << net::ErrorToString(status);
+  base::MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      base::Bind(&TCPServerSocketObject::DoAccept, weak_factory_.GetWeakPtr()),
+      base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs));
+  return false;
+}
+
+void TCPServerSocketObject::DispatchConnections() {
+  if (connections_.empty() || is_suspended_)
+    return;
+
+  // The spec is not really clear about what to do when we get a incoming
+  // connection but nobody is listening. We are just closing the socket in
+  // this case.
+  if (!is_accepting_) {
+    connections_.clear();
+    return;
+  }
+
+  // Every connection is a [object_id, options] pair, the JavaScript side
+  // dispatches one "connect" event for each.
+  scoped_ptr<base::ListValue> connections(new base::ListValue);
+
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    scoped_ptr<net::StreamSocket> socket(connections_[i]);
+    connections_[i] = NULL;
+
+    net::IPEndPoint local_address;
+    socket->GetLocalAddress(&local_address);
+
+    jsapi::tcp_socket::TCPOptions options;
+    options.local_address = local_address.ToStringWithoutPort();
+    options.local_port = local_address.port();
+    options.address_reuse = false;
+    options.no_delay = true;
+    options.use_secure_transport = false;
+
+    scoped_ptr<BindingObject> obj(new TCPSocketObject(socket.Pass()));
+    int object_id = instance_->AddBindingObject(obj.Pass());
+
+    scoped_ptr<base::ListValue> connection(new base::ListValue);
+    connection->AppendInteger(object_id);
+    connection->Append(options.ToValue().release());
+    connections->Append(connection.release());
+  }
+
+  connections_.clear();
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(connections.release());
+
+  DispatchEvent("connect", eventData.Pass());
 }
 
 void TCPServerSocketObject::StartEvent(const std::string& type) {
@@ -75,7 +186,11 @@ void TCPServerSocketObject::OnInit(
   socket_.reset(new net::TCPServerSocket(NULL, net::NetLog::Source()));
   net::IPEndPoint address(ip_number, params->options.local_port);
 
-  if (socket_->Listen(address, 5) != net::OK) {
+  int backlog = kDefaultBacklog;
+  if (params->options.backlog && *params->options.backlog > 0)
+    backlog = *params->options.backlog;
+
+  if (socket_->Listen(address, backlog) != net::OK) {
     LOG(WARNING) << "Failed to listen on " << params->options.local_address
         << " port " << params->options.local_port;
     setReadyState(READY_STATE_CLOSED);
@@ -93,6 +208,10 @@ void TCPServerSocketObject::OnClose(
   if (socket_)
     socket_.reset();
 
+  has_accept_pending_ = false;
+  accepted_socket_.reset();
+  connections_.clear();
+
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
 }
@@ -104,41 +223,21 @@ void TCPServerSocketObject::OnSuspend(
 
 void TCPServerSocketObject::OnResume(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
+  // Connections that arrived while suspended waited in the listen backlog.
   is_suspended_ = false;
+  DoAccept();
 }
 
 void TCPServerSocketObject::OnAccept(int status) {
-  if (is_accepting_ && !is_suspended_) {
-    net::IPEndPoint local_address;
-    accepted_socket_->GetLocalAddress(&local_address);
+  has_accept_pending_ = false;
 
-    jsapi::tcp_socket::TCPOptions options;
-    options.local_address = local_address.ToStringWithoutPort();
-    options.local_port = local_address.port();
-    options.address_reuse = false;
-    options.no_delay = true;
-    options.use_secure_transport = false;
-
-    std::string object_id = base::GenerateGUID();
-    scoped_ptr<BindingObject> obj(new TCPSocketObject(accepted_socket_.Pass()));
-    instance_->AddBindingObject(object_id, obj.Pass());
-
-    scoped_ptr<base::ListValue> dataList(new base::ListValue);
-    dataList->AppendString(object_id);
-    dataList->Append(options.ToValue().release());
-
-    scoped_ptr<base::ListValue> eventData(new base::ListValue);
-    eventData->Append(dataList.release());
-
-    DispatchEvent("connect", eventData.Pass());
-  } else {
-    // The spec is not really clear about what to do when we get a incoming
-    // connection but nobody is listening. We are just closing the socket in
-    // this case.
-    accepted_socket_.reset();
-  }
-
-  DoAccept();
+  if (DidAccept(status))
+    DoAccept();
+  else
+    DispatchConnections();
 }
 
 }  // namespace sysapps
@@ -6,6 +6,8 @@
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 
 #include <string>
+#include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
 #include "net/socket/tcp_server_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
@@ -22,7 +24,13 @@ class TCPServerSocketObject : public RawSocketObject {
   virtual ~TCPServerSocketObject();
 
  private:
+  // Accepts connections until the socket has none pending, so a burst of
+  // clients is handled in a single wakeup.
   void DoAccept();
+  // Returns false when the accept loop must stop.
+  bool DidAccept(int status);
+  // Sends all the connections accepted so far in a single "connect" message.
+  void DispatchConnections();
 
   // EventTarget implementation.
   virtual void StartEvent(const std::string& type) OVERRIDE;
@@ -39,11 +47,17 @@ class TCPServerSocketObject : public RawSocketObject {
 
   bool is_suspended_;
   bool is_accepting_;
+  bool has_accept_pending_;
 
   scoped_ptr<net::TCPServerSocket> socket_;
   scoped_ptr<net::StreamSocket> accepted_socket_;
 
+  // Accepted and not yet dispatched to JavaScript.
+  ScopedVector<net::StreamSocket> connections_;
+
   RawSocketInstance* instance_;
+
+  base::WeakPtrFactory<TCPServerSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -5,7 +5,9 @@
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
 #include <string.h>
+#include <algorithm>
 #include "base/logging.h"
+#include "base/values.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_util.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket.h"
@@ -15,21 +17,37 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const unsigned kBufferSize = 4096;
+// Reads start with the smallest size and double while they fill the whole
+// buffer, so sustained transfers are read in big chunks.
+const size_t kMinReadSize = 4096;
+const size_t kMaxReadSize = 256 * 1024;
+
+// Used when the JavaScript side doesn't set TCPOptions.receiveHighWaterMark.
+const int kDefaultReceiveHighWaterMark = 1024 * 1024;
+
+// Biggest chunk handed to the socket in a single write.
+const size_t kWriteChunkSize = 64 * 1024;
 
 }  // namespace
 
 namespace xwalk {
 namespace sysapps {
 
-TCPSocketObject::TCPSocketObject()
+TCPSocketObject::TCPSocketObject(net::HostResolver* resolver)
     : has_write_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
-      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
+      has_read_pending_(false),
+      has_pending_end_of_stream_(false),
+      unacknowledged_bytes_(0),
+      receive_high_water_mark_(kDefaultReceiveHighWaterMark),
+      read_size_(kMinReadSize),
+      read_data_size_(0),
+      read_request_size_(0),
+      received_size_(0),
+      received_capacity_(0),
+      write_queue_offset_(0),
+      single_resolver_(new net::SingleRequestHostResolver(resolver)) {
   RegisterHandlers();
 }
 
@@ -37,10 +55,19 @@ TCPSocketObject::TCPSocketObject(scoped_ptr<net::StreamSocket> socket)
     : has_write_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      socket_(socket.release()) {
+      has_read_pending_(false),
+      has_pending_end_of_stream_(false),
+      unacknowledged_bytes_(0),
+      receive_high_water_mark_(kDefaultReceiveHighWaterMark),
+      read_size_(kMinReadSize),
+      read_data_size_(0),
+      read_request_size_(0),
+      received_size_(0),
+      received_capacity_(0),
+      socket_(socket.release()),
+      write_queue_offset_(0) {
   RegisterHandlers();
+  setReadyState(READY_STATE_OPEN);
 }
 
 TCPSocketObject::~TCPSocketObject() {}
@@ -58,28 +85,145 @@ void TCPSocketObject::RegisterHandlers() {
       base::Bind(&TCPSocketObject::OnResume, base::Unretained(this)));
   handler_.Register("_sendString",
       base::Bind(&TCPSocketObject::OnSendString, base::Unretained(this)));
+  handler_.Register("_sendArrayBuffer",
+      base::Bind(&TCPSocketObject::OnSendArrayBuffer, base::Unretained(this)));
+  handler_.Register("_acknowledgeData",
+      base::Bind(&TCPSocketObject::OnAcknowledgeData, base::Unretained(this)));
+}
+
+bool TCPSocketObject::CanRead() const {
+  if (!socket_ || !socket_->IsConnected() || has_read_pending_ ||
+      has_pending_end_of_stream_)
+    return false;
+
+  if (ready_state() == READY_STATE_CLOSED)
+    return false;
+
+  // Not reading leaves the data in the kernel, so the receive window fills
+  // up and the peer slows down instead of data being dropped.
+  return !is_suspended_ && unacknowledged_bytes_ < receive_high_water_mark_;
 }
 
 void TCPSocketObject::DoRead() {
-  if (!socket_->IsConnected())
+  while (CanRead()) {
+    // A "data" event never carries more than kMaxReadSize bytes, the reads
+    // are clamped to what is left of it.
+    if (received_size_ >= kMaxReadSize)
+      DispatchReceivedData();
+
+    if (!read_data_ || read_data_size_ != read_size_) {
+      read_data_.reset(new char[read_size_]);
+      read_data_size_ = read_size_;
+      read_buffer_ = new net::WrappedIOBuffer(read_data_.get());
+    }
+    read_request_size_ = std::min(read_data_size_,
+                                  kMaxReadSize - received_size_);
+
+    int ret = socket_->Read(read_buffer_,
+                            read_request_size_,
+                            base::Bind(&TCPSocketObject::OnRead,
+                                       base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      break;
+    }
+
+    DidRead(ret);
+  }
+
+  // Everything read in this task goes in a single event.
+  if (!is_suspended_)
+    DispatchReceivedData();
+}
+
+void TCPSocketObject::DoWrite() {
+  while (!has_write_pending_ && socket_ && socket_->IsConnected()) {
+    if (!write_buffer_ || !write_buffer_->BytesRemaining()) {
+      if (write_queue_.empty())
+        return;
+      FillWriteBuffer();
+    }
+
+    int ret = socket_->Write(write_buffer_,
+                             write_buffer_->BytesRemaining(),
+                             base::Bind(&TCPSocketObject::OnWrite,
+                                        base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      return;
+    }
+
+    if (ret < 0) {
+      OnWrite(ret);
+      return;
+    }
+
+    DidWrite(ret);
+  }
+}
+
+void TCPSocketObject::QueueWrite(std::string* data) {
+  if (is_half_closed_ || ready_state() == READY_STATE_CLOSED || data->empty())
     return;
 
-  int ret = socket_->Read(read_buffer_,
-                          kBufferSize,
-                          base::Bind(&TCPSocketObject::OnRead,
-                                     base::Unretained(this)));
+  IncreaseBufferedAmount(data->size());
+
+  // Big payloads are not copied here, only when filling the write buffer.
+  write_queue_.push_back(std::string());
+  write_queue_.back().swap(*data);
+
+  DoWrite();
+}
+
+void TCPSocketObject::FillWriteBuffer() {
+  // The buffered amount is all in |write_queue_| when |write_buffer_| is done.
+  size_t size = std::min(kWriteChunkSize, buffered_amount());
+  scoped_refptr<net::IOBuffer> chunk(new net::IOBuffer(size));
+
+  size_t offset = 0;
+  while (offset < size) {
+    const std::string& front = write_queue_.front();
+    size_t count = std::min(size - offset, front.size() - write_queue_offset_);
+    memcpy(chunk->data() + offset, front.data() + write_queue_offset_, count);
+
+    offset += count;
+    write_queue_offset_ += count;
+    if (write_queue_offset_ == front.size()) {
+      write_queue_.pop_front();
+      write_queue_offset_ = 0;
+    }
+  }
+
+  write_buffer_ = new net::DrainableIOBuffer(chunk.get(), size);
+}
 
-  if (ret > 0)
-    OnRead(ret);
+void TCPSocketObject::DidWrite(int bytes) {
+  write_buffer_->DidConsume(bytes);
+  DecreaseBufferedAmount(bytes);
+}
+
+void TCPSocketObject::ClearWriteQueue() {
+  write_buffer_ = NULL;
+  write_queue_.clear();
+  write_queue_offset_ = 0;
+  ResetBufferedAmount();
 }
 
 void TCPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
+  if (params && params->options && params->options->receive_high_water_mark &&
+      *params->options->receive_high_water_mark > 0) {
+    receive_high_water_mark_ = *params->options->receive_high_water_mark;
+  }
+
+  // Sockets created by a TCPServerSocket are connected already.
   if (socket_) {
     DoRead();
     return;
   }
 
-  scoped_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
   if (!params) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     setReadyState(READY_STATE_CLOSED);
@@ -104,6 +248,13 @@ void TCPSocketObject::OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
   if (socket_)
     socket_->Disconnect();
 
+  has_write_pending_ = false;
+  has_pending_end_of_stream_ = false;
+  ClearWriteQueue();
+  received_data_.reset();
+  received_size_ = 0;
+  received_capacity_ = 0;
+
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
 }
@@ -117,21 +268,22 @@ void TCPSocketObject::OnHalfClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void TCPSocketObject::OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // A read already issued can't be canceled, its data is held until resume.
   is_suspended_ = true;
 }
 
 void TCPSocketObject::OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info) {
   is_suspended_ = false;
+  if (has_pending_end_of_stream_) {
+    has_pending_end_of_stream_ = false;
+    DidReadEndOfStream();
+    return;
+  }
+  DoRead();
 }
 
 void TCPSocketObject::OnSendString(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  if (is_half_closed_ || has_write_pending_)
-    return;
-
-  if (!socket_ || !socket_->IsConnected())
-    return;
-
   scoped_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
 
@@ -140,24 +292,47 @@ void TCPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  QueueWrite(&params->data);
+}
+
+void TCPSocketObject::OnSendArrayBuffer(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // ArrayBufferViews are converted to the bytes they view before reaching
+  // here, so both are handled as an ArrayBuffer.
+  scoped_ptr<SendArrayBuffer::Params>
+      params(SendArrayBuffer::Params::Create(*info->arguments()));
+
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  memcpy(write_buffer_->data(), params->data.data(), params->data.size());
+  QueueWrite(&params->data);
+}
 
-  int ret = socket_->Write(write_buffer_,
-                           params->data.size(),
-                           base::Bind(&TCPSocketObject::OnWrite,
-                                      base::Unretained(this)));
+void TCPSocketObject::StopEvent(const std::string& type) {
+  if (type != "data")
+    return;
 
-  if (ret == net::ERR_IO_PENDING)
-    has_write_pending_ = true;
-  else if (ret == static_cast<int>(params->data.size()))
+  // The events already dispatched may never be acknowledged now, reading
+  // must not stay stopped waiting for them.
+  unacknowledged_bytes_ = 0;
+  DoRead();
+}
+
+void TCPSocketObject::OnAcknowledgeData(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<AcknowledgeData::Params>
+      params(AcknowledgeData::Params::Create(*info->arguments()));
+
+  if (!params || params->bytes < 0) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
-  else
-    socket_->Disconnect();
+  }
+
+  unacknowledged_bytes_ -=
+      std::min(unacknowledged_bytes_, static_cast<size_t>(params->bytes));
+  DoRead();
 }
 
 void TCPSocketObject::OnConnect(int status) {
@@ -169,41 +344,110 @@ void TCPSocketObject::OnConnect(int status) {
 
     DispatchEvent("open");
     DoRead();
+    DoWrite();
   } else {
+    ClearWriteQueue();
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
   }
 }
 
 void TCPSocketObject::OnRead(int status) {
-  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  has_read_pending_ = false;
+  DidRead(status);
+  DoRead();
+}
 
+void TCPSocketObject::DidRead(int status) {
   // No data means the other side has
   // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close", eventData.Pass());
+  if (status <= 0) {
+    if (status < 0) {
+      LOG(WARNING) << "Failed to read from the socket: "
+                   << net::ErrorToString(status);
+    }
+
+    // The data held and the close wait for the socket to be resumed.
+    if (is_suspended_)
+      has_pending_end_of_stream_ = true;
+    else
+      DidReadEndOfStream();
     return;
   }
 
-  scoped_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
+  // Without a listener the data is dropped, there is nobody to acknowledge
+  // it either.
+  if (!IsEventActive("data"))
+    return;
 
-  eventData->Append(data.release());
+  size_t size = status;
+  unacknowledged_bytes_ += size;
 
-  if (!is_suspended_)
-    DispatchEvent("data", eventData.Pass());
+  // The first read of an event is handed off as is, the following ones are
+  // appended to it.
+  if (!received_data_) {
+    received_data_ = read_data_.Pass();
+    received_size_ = size;
+    received_capacity_ = read_data_size_;
+  } else {
+    if (received_capacity_ - received_size_ < size) {
+      size_t capacity = std::max(received_capacity_ * 2, received_size_ + size);
+      scoped_ptr<char[]> data(new char[capacity]);
+      memcpy(data.get(), received_data_.get(), received_size_);
+      received_data_.swap(data);
+      received_capacity_ = capacity;
+    }
+
+    memcpy(received_data_.get() + received_size_, read_data_.get(), size);
+    received_size_ += size;
+  }
 
-  DoRead();
+  if (size == read_data_size_)
+    read_size_ = std::min(read_size_ * 2, kMaxReadSize);
+  else if (size < read_request_size_ / 4)
+    read_size_ = std::max(read_size_ / 2, kMinReadSize);
+}
+
+void TCPSocketObject::DidReadEndOfStream() {
+  DispatchReceivedData();
+  ClearWriteQueue();
+  setReadyState(READY_STATE_CLOSED);
+  DispatchEvent("close");
+}
+
+void TCPSocketObject::DispatchReceivedData() {
+  if (!received_data_)
+    return;
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(new base::BinaryValue(received_data_.Pass(),
+                                          received_size_));
+  received_size_ = 0;
+  received_capacity_ = 0;
+
+  DispatchEvent("data", eventData.Pass());
 }
 
 void TCPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+
+  if (status < 0) {
+    LOG(WARNING) << "Failed to write to the socket: "
+                 << net::ErrorToString(status);
+    socket_->Disconnect();
+    ClearWriteQueue();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return;
+  }
+
+  DidWrite(status);
+  DoWrite();
 }
 
 void TCPSocketObject::OnResolved(int status) {
   if (status != net::OK) {
+    ClearWriteQueue();
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
     return;
@@ -5,6 +5,7 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 
+#include <deque>
 #include <string>
 #include "net/dns/single_request_host_resolver.h"
 #include "net/base/io_buffer.h"
@@ -14,15 +15,34 @@
 namespace xwalk {
 namespace sysapps {
 
+// Data passed to send() is never dropped while the socket is usable: it is
+// appended to a write queue and written in chunks, coalescing small sends.
+//
+// Reading from the socket stops while it is suspended or while too much data
+// was dispatched and not acknowledged by JavaScript yet, leaving the data in
+// the kernel so TCP flow control slows down the peer. The size of the reads
+// adapts to the incoming traffic, up to 256 KB.
 class TCPSocketObject : public RawSocketObject {
  public:
-  TCPSocketObject();
+  explicit TCPSocketObject(net::HostResolver* resolver);
   explicit TCPSocketObject(scoped_ptr<net::StreamSocket> socket);
   virtual ~TCPSocketObject();
 
  private:
+  // EventTarget implementation.
+  virtual void StopEvent(const std::string& type) OVERRIDE;
+
   void RegisterHandlers();
+  bool CanRead() const;
   void DoRead();
+  void DidRead(int status);
+  void DidReadEndOfStream();
+  void DispatchReceivedData();
+  void DoWrite();
+  void QueueWrite(std::string* data);
+  void FillWriteBuffer();
+  void DidWrite(int bytes);
+  void ClearWriteQueue();
 
   // JavaScript function handlers.
   void OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info);
@@ -31,6 +51,8 @@ class TCPSocketObject : public RawSocketObject {
   void OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnSendString(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSendArrayBuffer(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnAcknowledgeData(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::TCPClientSocket callbacks.
   void OnConnect(int status);
@@ -43,12 +65,42 @@ class TCPSocketObject : public RawSocketObject {
   bool has_write_pending_;
   bool is_suspended_;
   bool is_half_closed_;
+  bool has_read_pending_;
+  // The peer closed the socket or a read failed while it was suspended.
+  bool has_pending_end_of_stream_;
+
+  // Bytes dispatched in "data" events that the JavaScript side didn't
+  // acknowledge yet. Reading stops while it is over
+  // |receive_high_water_mark_|, so a busy renderer isn't flooded.
+  size_t unacknowledged_bytes_;
+  size_t receive_high_water_mark_;
+
+  // Size of the next read, adapted to how much data each read gets.
+  size_t read_size_;
+  scoped_ptr<char[]> read_data_;
+  size_t read_data_size_;
+  // Size passed to the last read, clamped so a "data" event doesn't carry
+  // more than 256 KB.
+  size_t read_request_size_;
+  scoped_refptr<net::WrappedIOBuffer> read_buffer_;
 
-  scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  // Data read and not dispatched yet. The reads completed in a task are
+  // merged and dispatched as a single "data" event, and held while the
+  // socket is suspended.
+  scoped_ptr<char[]> received_data_;
+  size_t received_size_;
+  size_t received_capacity_;
   scoped_ptr<net::StreamSocket> socket_;
 
-  scoped_ptr<net::HostResolver> resolver_;
+  // Chunk being written to the socket.
+  scoped_refptr<net::DrainableIOBuffer> write_buffer_;
+
+  // Sent data not copied to |write_buffer_| yet. The first
+  // |write_queue_offset_| bytes of the front element are already copied.
+  std::deque<std::string> write_queue_;
+  size_t write_queue_offset_;
+
+  // Uses the resolver shared by all the sockets.
   scoped_ptr<net::SingleRequestHostResolver> single_resolver_;
   net::AddressList addresses_;
 };
@@ -0,0 +1,161 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
+
+#include <string>
+
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/values.h"
+#include "net/base/net_errors.h"
+#include "net/socket/socket_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/sysapps/common/event_target_test_util.h"
+
+using xwalk::extensions::XWalkExtensionFunctionInfo;
+using xwalk::sysapps::CreateAddEventListenerInfo;
+using xwalk::sysapps::TCPSocketObject;
+
+namespace {
+
+const size_t kMaxDataEventSize = 256 * 1024;
+
+void DummyCallback(scoped_ptr<base::ListValue> result) {}
+
+scoped_ptr<XWalkExtensionFunctionInfo> CreateFunctionInfo(
+    const std::string& name) {
+  return make_scoped_ptr(new XWalkExtensionFunctionInfo(
+      name,
+      make_scoped_ptr(new base::ListValue),
+      base::Bind(&DummyCallback)));
+}
+
+size_t GetDataEventSize(const base::ListValue& event) {
+  const base::Value* value;
+  if (!event.Get(0, &value) || !value->IsType(base::Value::TYPE_BINARY))
+    return 0;
+  return static_cast<const base::BinaryValue*>(value)->GetSize();
+}
+
+class TCPSocketObjectTest : public testing::Test {
+ protected:
+  // Creates a socket reading |reads|, with listeners for its "data" and
+  // "close" events.
+  void CreateSocket(net::MockRead* reads, size_t reads_count) {
+    data_.reset(new net::StaticSocketDataProvider(reads, reads_count,
+                                                  NULL, 0));
+    data_->set_connect_data(net::MockConnect(net::SYNCHRONOUS, net::OK));
+
+    scoped_ptr<net::StreamSocket> socket(
+        new net::MockTCPClientSocket(net::AddressList(), NULL, data_.get()));
+    ASSERT_EQ(net::OK, socket->Connect(net::CompletionCallback()));
+
+    socket_object_.reset(new TCPSocketObject(socket.Pass()));
+    EXPECT_TRUE(socket_object_->HandleFunction(
+        CreateAddEventListenerInfo("data", &data_events_)));
+    EXPECT_TRUE(socket_object_->HandleFunction(
+        CreateAddEventListenerInfo("close", &close_events_)));
+  }
+
+  bool CallFunction(const std::string& name) {
+    return socket_object_->HandleFunction(CreateFunctionInfo(name));
+  }
+
+  base::MessageLoop loop_;
+  scoped_ptr<net::StaticSocketDataProvider> data_;
+  scoped_ptr<TCPSocketObject> socket_object_;
+  ScopedVector<base::ListValue> data_events_;
+  ScopedVector<base::ListValue> close_events_;
+};
+
+}  // namespace
+
+TEST_F(TCPSocketObjectTest, DataEventSizeIsCapped) {
+  std::string payload(600 * 1024, 'x');
+  net::MockRead reads[] = {
+    net::MockRead(net::SYNCHRONOUS, payload.data(),
+                  static_cast<int>(payload.size())),
+    net::MockRead(net::SYNCHRONOUS, net::ERR_IO_PENDING),
+  };
+  CreateSocket(reads, arraysize(reads));
+
+  EXPECT_TRUE(CallFunction("init"));
+
+  size_t total = 0;
+  ASSERT_LE(3u, data_events_.size());
+  for (size_t i = 0; i < data_events_.size(); ++i) {
+    size_t size = GetDataEventSize(*data_events_[i]);
+    EXPECT_LT(0u, size);
+    EXPECT_GE(kMaxDataEventSize, size);
+    total += size;
+  }
+  EXPECT_EQ(payload.size(), total);
+}
+
+TEST_F(TCPSocketObjectTest, SuspendHoldsData) {
+  net::MockRead reads[] = {
+    net::MockRead(net::ASYNC, "hello", 5),
+    net::MockRead(net::SYNCHRONOUS, net::ERR_IO_PENDING),
+  };
+  CreateSocket(reads, arraysize(reads));
+
+  // The read issued by init() completes while the socket is suspended.
+  EXPECT_TRUE(CallFunction("init"));
+  EXPECT_TRUE(CallFunction("suspend"));
+  loop_.RunUntilIdle();
+  EXPECT_TRUE(data_events_.empty());
+
+  EXPECT_TRUE(CallFunction("resume"));
+  ASSERT_EQ(1u, data_events_.size());
+  EXPECT_EQ(5u, GetDataEventSize(*data_events_[0]));
+}
+
+TEST_F(TCPSocketObjectTest, EndOfStreamWaitsForResume) {
+  net::MockRead reads[] = {
+    net::MockRead(net::SYNCHRONOUS, "hello", 5),
+    net::MockRead(net::ASYNC, 0),
+  };
+  CreateSocket(reads, arraysize(reads));
+
+  EXPECT_TRUE(CallFunction("init"));
+  ASSERT_EQ(1u, data_events_.size());
+
+  // The peer closes the socket while it is suspended.
+  EXPECT_TRUE(CallFunction("suspend"));
+  loop_.RunUntilIdle();
+  EXPECT_TRUE(close_events_.empty());
+
+  EXPECT_TRUE(CallFunction("resume"));
+  EXPECT_EQ(1u, data_events_.size());
+  EXPECT_EQ(1u, close_events_.size());
+}
+
+TEST_F(TCPSocketObjectTest, RemovingDataListenerResumesReading) {
+  const size_t kReceiveHighWaterMark = 1024 * 1024;
+  std::string payload(kReceiveHighWaterMark + 512 * 1024, 'x');
+  net::MockRead reads[] = {
+    net::MockRead(net::SYNCHRONOUS, payload.data(),
+                  static_cast<int>(payload.size())),
+    net::MockRead(net::SYNCHRONOUS, net::ERR_IO_PENDING),
+  };
+  CreateSocket(reads, arraysize(reads));
+
+  // Reading stops until the data is acknowledged.
+  EXPECT_TRUE(CallFunction("init"));
+  size_t total = 0;
+  for (size_t i = 0; i < data_events_.size(); ++i)
+    total += GetDataEventSize(*data_events_[i]);
+  EXPECT_LE(kReceiveHighWaterMark, total);
+  EXPECT_GT(payload.size(), total);
+
+  // Nobody is left to acknowledge it once the listener is removed.
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->AppendString("data");
+  EXPECT_TRUE(socket_object_->HandleFunction(
+      make_scoped_ptr(new XWalkExtensionFunctionInfo(
+          "removeEventListener", arguments.Pass(),
+          base::Bind(&DummyCallback)))));
+  EXPECT_TRUE(data_->at_read_eof());
+}
@@ -5,9 +5,12 @@
 #include "xwalk/sysapps/raw_socket/udp_socket_object.h"
 
 #include <string.h>
+#include <algorithm>
 
 #include "base/logging.h"
+#include "base/values.h"
 #include "net/base/net_errors.h"
+#include "net/base/net_util.h"
 #include "xwalk/sysapps/raw_socket/udp_socket.h"
 
 using namespace xwalk::jsapi::udp_socket; // NOLINT
@@ -15,21 +18,30 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const unsigned kBufferSize = 4096;
+// Reads must fit any datagram, the smaller ones are copied to an event of
+// their exact size.
+const unsigned kMaxDatagramSize = 64 * 1024;
+
+// Used when the JavaScript side doesn't set UDPOptions.receiveHighWaterMark.
+const int kDefaultReceiveHighWaterMark = 1024 * 1024;
 
 }  // namespace
 
 namespace xwalk {
 namespace sysapps {
 
-UDPSocketObject::UDPSocketObject()
+UDPSocketObject::UDPSocketObject(net::HostResolver* resolver)
     : has_write_pending_(false),
+      is_resolving_destination_(false),
       is_suspended_(false),
       is_reading_(false),
-      resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
+      has_read_pending_(false),
+      unacknowledged_bytes_(0),
+      receive_high_water_mark_(kDefaultReceiveHighWaterMark),
+      read_buffer_(new net::IOBuffer(kMaxDatagramSize)),
+      has_destination_(false),
+      resolver_(resolver),
+      single_resolver_(new net::SingleRequestHostResolver(resolver)) {
   handler_.Register("init",
       base::Bind(&UDPSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -44,24 +56,166 @@ UDPSocketObject::UDPSocketObject()
       base::Bind(&UDPSocketObject::OnLeaveMulticast, base::Unretained(this)));
   handler_.Register("_sendString",
       base::Bind(&UDPSocketObject::OnSendString, base::Unretained(this)));
+  handler_.Register("_sendDatagrams",
+      base::Bind(&UDPSocketObject::OnSendDatagrams, base::Unretained(this)));
+  handler_.Register("_acknowledgeData",
+      base::Bind(&UDPSocketObject::OnAcknowledgeData, base::Unretained(this)));
 }
 
 UDPSocketObject::~UDPSocketObject() {}
 
+bool UDPSocketObject::CanRead() const {
+  if (!socket_ || !socket_->is_connected() || has_read_pending_)
+    return false;
+
+  if (ready_state() == READY_STATE_CLOSED)
+    return false;
+
+  // Not reading leaves the datagrams in the kernel, which drops the new ones
+  // when its buffer is full, instead of us dropping the ones we read.
+  return !is_suspended_ && unacknowledged_bytes_ < receive_high_water_mark_;
+}
+
 void UDPSocketObject::DoRead() {
-  if (!socket_->is_connected())
+  if (!socket_ || !socket_->is_connected())
     return;
 
   is_reading_ = true;
 
-  int ret = socket_->RecvFrom(read_buffer_,
-                              kBufferSize,
-                              &from_,
-                              base::Bind(&UDPSocketObject::OnRead,
-                                         base::Unretained(this)));
+  while (CanRead()) {
+    int ret = socket_->RecvFrom(read_buffer_,
+                                kMaxDatagramSize,
+                                &from_,
+                                base::Bind(&UDPSocketObject::OnRead,
+                                           base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      return;
+    }
+
+    DidRead(ret);
+  }
+}
+
+void UDPSocketObject::QueueDatagram(const std::string& data,
+                                    const std::string* remote_address,
+                                    const int* remote_port) {
+  // Datagrams sent while opening are kept until the socket is open.
+  if (ready_state() == READY_STATE_CLOSED)
+    return;
+
+  PendingDatagram datagram;
+  datagram.remote_port = 0;
+  if (remote_address && remote_port && *remote_port) {
+    datagram.remote_address = *remote_address;
+    datagram.remote_port = *remote_port;
+  }
+
+  IncreaseBufferedAmount(data.size());
+  datagram.data = new net::StringIOBuffer(data);
+  send_queue_.push_back(datagram);
+}
+
+void UDPSocketObject::DoSend() {
+  // The resolver is busy while opening the socket.
+  if (!socket_ || ready_state() != READY_STATE_OPEN)
+    return;
+
+  while (!has_write_pending_ && !is_resolving_destination_ &&
+         !send_queue_.empty()) {
+    if (!has_destination_) {
+      int ret = ResolveDestination();
+      if (ret == net::ERR_IO_PENDING) {
+        is_resolving_destination_ = true;
+        return;
+      }
+
+      if (ret != net::OK || destination_.empty()) {
+        DidSend(ret == net::OK ? net::ERR_ADDRESS_INVALID : ret);
+        continue;
+      }
+
+      has_destination_ = true;
+    }
+
+    if (!socket_->is_connected()) {
+      // If we are waiting for reads and the socket is not connect,
+      // it means the connection was closed.
+      if (is_reading_ || socket_->Connect(destination_[0]) != net::OK) {
+        ClearSendQueue();
+        setReadyState(READY_STATE_CLOSED);
+        DispatchEvent("error");
+        return;
+      }
+    }
+
+    const PendingDatagram& datagram = send_queue_.front();
+    int ret = socket_->SendTo(
+        datagram.data,
+        datagram.data->size(),
+        destination_[0],
+        base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      break;
+    }
 
-  if (ret > 0)
-    OnRead(ret);
+    DidSend(ret);
+  }
+
+  if (!is_reading_ && socket_->is_connected())
+    DoRead();
+}
+
+int UDPSocketObject::ResolveDestination() {
+  const PendingDatagram& datagram = send_queue_.front();
+  if (datagram.remote_address.empty()) {
+    destination_ = addresses_;
+    return net::OK;
+  }
+
+  net::HostResolver::RequestInfo request_info(net::HostPortPair(
+      datagram.remote_address, datagram.remote_port));
+
+  // Sending a datagram per sample to the same host is common, only go
+  // through a resolver job (and its thread) on cache misses or expired
+  // entries.
+  if (resolver_->ResolveFromCache(request_info, &destination_,
+                                  net::BoundNetLog()) == net::OK)
+    return net::OK;
+
+  return single_resolver_->Resolve(
+      request_info,
+      net::DEFAULT_PRIORITY,
+      &destination_,
+      base::Bind(&UDPSocketObject::OnDestinationResolved,
+                 base::Unretained(this)),
+      net::BoundNetLog());
+}
+
+void UDPSocketObject::DidSend(int status) {
+  // The datagram is done with, sent or not.
+  size_t size = send_queue_.front().data->size();
+  send_queue_.pop_front();
+  has_destination_ = false;
+
+  if (status < 0) {
+    LOG(WARNING) << "Failed to send a datagram: " << net::ErrorToString(status);
+    DispatchEvent("error");
+  }
+
+  DecreaseBufferedAmount(size);
+}
+
+void UDPSocketObject::ClearSendQueue() {
+  single_resolver_->Cancel();
+  is_resolving_destination_ = false;
+  has_write_pending_ = false;
+  has_destination_ = false;
+  send_queue_.clear();
+  ResetBufferedAmount();
 }
 
 void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
@@ -73,6 +227,11 @@ void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
+  if (params->options && params->options->receive_high_water_mark &&
+      *params->options->receive_high_water_mark > 0) {
+    receive_high_water_mark_ = *params->options->receive_high_water_mark;
+  }
+
   socket_.reset(new net::UDPSocket(net::DatagramSocket::DEFAULT_BIND,
                                    net::RandIntCallback(),
                                    NULL,
@@ -83,6 +242,14 @@ void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
+  // The multicast options can only be set before binding or connecting.
+  socket_->SetMulticastLoopbackMode(params->options->loopback);
+  if (params->options->multicast_ttl &&
+      socket_->SetMulticastTimeToLive(*params->options->multicast_ttl) !=
+          net::OK) {
+    LOG(WARNING) << "Invalid multicast TTL " << *params->options->multicast_ttl;
+  }
+
   if (!params->options->local_address.empty()) {
     net::IPAddressNumber ip_number;
     if (!net::ParseIPLiteralToNumber(params->options->local_address,
@@ -131,30 +298,79 @@ void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void UDPSocketObject::OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  ClearSendQueue();
   socket_.reset();
 }
 
 void UDPSocketObject::OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // A read already issued can't be canceled, its data is held until resume.
   is_suspended_ = true;
 }
 
 void UDPSocketObject::OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info) {
   is_suspended_ = false;
+  if (suspended_event_)
+    DispatchEvent("message", suspended_event_.Pass());
+
+  if (is_reading_)
+    DoRead();
 }
 
 void UDPSocketObject::OnJoinMulticast(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<JoinMulticast::Params>
+      params(JoinMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  net::IPAddressNumber group;
+  if (!socket_ || !net::ParseIPLiteralToNumber(
+          params->multicast_group_address, &group)) {
+    LOG(WARNING) << "Invalid multicast group "
+                 << params->multicast_group_address;
+    DispatchEvent("error");
+    return;
+  }
+
+  // Only works on sockets bound to a local address.
+  int ret = socket_->JoinGroup(group);
+  if (ret != net::OK) {
+    LOG(WARNING) << "Can't join the multicast group "
+                 << params->multicast_group_address << ": "
+                 << net::ErrorToString(ret);
+    DispatchEvent("error");
+  }
 }
 
 void UDPSocketObject::OnLeaveMulticast(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<LeaveMulticast::Params>
+      params(LeaveMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  net::IPAddressNumber group;
+  if (!socket_ || !net::ParseIPLiteralToNumber(
+          params->multicast_group_address, &group)) {
+    LOG(WARNING) << "Invalid multicast group "
+                 << params->multicast_group_address;
+    return;
+  }
+
+  int ret = socket_->LeaveGroup(group);
+  if (ret != net::OK) {
+    LOG(WARNING) << "Can't leave the multicast group "
+                 << params->multicast_group_address << ": "
+                 << net::ErrorToString(ret);
+  }
 }
 
 void UDPSocketObject::OnSendString(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  if (!socket_ || has_write_pending_)
-    return;
-
   scoped_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
   if (!params) {
@@ -162,69 +378,118 @@ void UDPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  QueueDatagram(params->data, params->remote_address.get(),
+                params->remote_port.get());
+  DoSend();
+}
+
+void UDPSocketObject::OnSendDatagrams(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<SendDatagrams::Params>
+      params(SendDatagrams::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  write_buffer_size_ = params->data.size();
-  memcpy(write_buffer_->data(), params->data.data(), write_buffer_size_);
+  // The whole batch is queued before sending, so it is written back to back.
+  for (size_t i = 0; i < params->datagrams.size(); ++i) {
+    Datagram* datagram = params->datagrams[i].get();
+    std::string* data = datagram->binary_data ?
+        datagram->binary_data.get() : datagram->data.get();
+    if (!data) {
+      LOG(WARNING) << "Datagram without data passed to " << info->name();
+      continue;
+    }
 
-  if (!params->remote_address || !*params->remote_port) {
-    OnSend(net::OK);
-    return;
+    QueueDatagram(*data, datagram->remote_address.get(),
+                  datagram->remote_port.get());
   }
 
-  net::HostResolver::RequestInfo request_info(net::HostPortPair(
-      *params->remote_address, *params->remote_port));
+  DoSend();
+}
 
-  int ret = single_resolver_->Resolve(
-      request_info,
-      net::DEFAULT_PRIORITY,
-      &addresses_,
-      base::Bind(&UDPSocketObject::OnSend,
-                 base::Unretained(this)),
-      net::BoundNetLog());
+void UDPSocketObject::StopEvent(const std::string& type) {
+  if (type != "message")
+    return;
 
-  if (ret != net::ERR_IO_PENDING)
-    OnSend(ret);
-  else
-    has_write_pending_ = true;
+  // The events already dispatched may never be acknowledged now, reading
+  // must not stay stopped waiting for them.
+  unacknowledged_bytes_ = 0;
+  if (is_reading_)
+    DoRead();
+}
+
+void UDPSocketObject::OnAcknowledgeData(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<AcknowledgeData::Params>
+      params(AcknowledgeData::Params::Create(*info->arguments()));
+
+  if (!params || params->bytes < 0) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  unacknowledged_bytes_ -=
+      std::min(unacknowledged_bytes_, static_cast<size_t>(params->bytes));
+  if (is_reading_)
+    DoRead();
 }
 
 void UDPSocketObject::OnRead(int status) {
+  has_read_pending_ = false;
+  DidRead(status);
+  DoRead();
+}
+
+void UDPSocketObject::DidRead(int status) {
   // No data means the other side has
   // disconnected the socket.
-  if (status == 0) {
+  if (status <= 0) {
+    if (status < 0) {
+      LOG(WARNING) << "Failed to read from the socket: "
+                   << net::ErrorToString(status);
+    }
+
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("close");
     return;
   }
 
-  scoped_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
+  // Without a listener the datagram is dropped, there is nobody to
+  // acknowledge it either.
+  if (!IsEventActive("message"))
+    return;
 
   UDPMessageEvent event;
-  event.data = std::string(read_buffer_->data(), status);
   event.remote_port = from_.port();
   event.remote_address = from_.ToStringWithoutPort();
 
+  // The datagram is copied once, straight to the event, instead of going
+  // through |event.data|.
+  scoped_ptr<base::DictionaryValue> value(event.ToValue());
+  value->Set("data", base::BinaryValue::CreateWithCopiedBuffer(
+      read_buffer_->data(), status));
+
   scoped_ptr<base::ListValue> eventData(new base::ListValue);
-  eventData->Append(event.ToValue().release());
+  eventData->Append(value.release());
 
-  if (!is_suspended_)
+  unacknowledged_bytes_ += status;
+  if (is_suspended_)
+    suspended_event_ = eventData.Pass();
+  else
     DispatchEvent("message", eventData.Pass());
-
-  DoRead();
 }
 
 void UDPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+  DidSend(status);
+  DoSend();
 }
 
 void UDPSocketObject::OnConnectionOpen(int status) {
   if (status != net::OK) {
+    ClearSendQueue();
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
     return;
@@ -232,44 +497,20 @@ void UDPSocketObject::OnConnectionOpen(int status) {
 
   setReadyState(READY_STATE_OPEN);
   DispatchEvent("open");
-}
 
-void UDPSocketObject::OnSend(int status) {
-  if (status != net::OK || addresses_.empty()) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("error");
-    return;
-  }
+  // Sends queued while opening.
+  DoSend();
+}
 
-  if (!socket_->is_connected()) {
-    // If we are waiting for reads and the socket is not connect,
-    // it means the connection was closed.
-    if (is_reading_ || socket_->Connect(addresses_[0]) != net::OK) {
-      setReadyState(READY_STATE_CLOSED);
-      DispatchEvent("error");
-      return;
-    }
-  }
+void UDPSocketObject::OnDestinationResolved(int status) {
+  is_resolving_destination_ = false;
 
-  int ret = socket_->SendTo(
-      write_buffer_,
-      write_buffer_size_,
-      addresses_[0],
-      base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
-
-  if (ret == net::ERR_IO_PENDING) {
-    has_write_pending_ = true;
-  } else if (ret == write_buffer_size_) {
-    has_write_pending_ = false;
-  } else {
-    socket_->Close();
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close");
-    return;
-  }
+  if (status != net::OK || destination_.empty())
+    DidSend(status == net::OK ? net::ERR_ADDRESS_INVALID : status);
+  else
+    has_destination_ = true;
 
-  if (!is_reading_ && socket_->is_connected())
-    DoRead();
+  DoSend();
 }
 
 }  // namespace sysapps
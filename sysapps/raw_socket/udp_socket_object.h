@@ -5,6 +5,7 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 
+#include <deque>
 #include <string>
 
 #include "net/base/address_list.h"
@@ -16,13 +17,28 @@
 namespace xwalk {
 namespace sysapps {
 
+// Sent datagrams are queued and written back to back, in order, resolving
+// their destination when needed. A batch of datagrams sent from JavaScript
+// with sendBatch() is queued by a single message.
 class UDPSocketObject : public RawSocketObject {
  public:
-  UDPSocketObject();
+  explicit UDPSocketObject(net::HostResolver* resolver);
   virtual ~UDPSocketObject();
 
  private:
+  // EventTarget implementation.
+  virtual void StopEvent(const std::string& type) OVERRIDE;
+
+  bool CanRead() const;
   void DoRead();
+  void DidRead(int status);
+  void QueueDatagram(const std::string& data,
+                     const std::string* remote_address,
+                     const int* remote_port);
+  void DoSend();
+  int ResolveDestination();
+  void DidSend(int status);
+  void ClearSendQueue();
 
   // JavaScript function handlers.
   void OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info);
@@ -32,6 +48,8 @@ class UDPSocketObject : public RawSocketObject {
   void OnJoinMulticast(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnLeaveMulticast(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnSendString(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSendDatagrams(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnAcknowledgeData(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::UDPSocket callbacks.
   void OnRead(int status);
@@ -39,20 +57,42 @@ class UDPSocketObject : public RawSocketObject {
 
   // net::SingleRequestHostResolver callbacks.
   void OnConnectionOpen(int status);
-  void OnSend(int status);
+  void OnDestinationResolved(int status);
 
   bool has_write_pending_;
+  bool is_resolving_destination_;
   bool is_suspended_;
   bool is_reading_;
+  bool has_read_pending_;
+
+  // Bytes dispatched in "message" events that the JavaScript side didn't
+  // acknowledge yet. Reading stops while it is over
+  // |receive_high_water_mark_|.
+  size_t unacknowledged_bytes_;
+  size_t receive_high_water_mark_;
+
+  // Read completed after suspend(), dispatched on resume().
+  scoped_ptr<base::ListValue> suspended_event_;
 
   scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
   scoped_ptr<net::UDPSocket> socket_;
 
-  unsigned write_buffer_size_;
+  struct PendingDatagram {
+    scoped_refptr<net::StringIOBuffer> data;
+    // Empty when sent to the remote address of the socket.
+    std::string remote_address;
+    int remote_port;
+  };
+  std::deque<PendingDatagram> send_queue_;
+
+  // Destination of the front of |send_queue_|, when |has_destination_|.
+  net::AddressList destination_;
+  bool has_destination_;
 
-  scoped_ptr<net::HostResolver> resolver_;
+  // Shared by all the sockets, owned by the RawSocketExtension.
+  net::HostResolver* resolver_;
   scoped_ptr<net::SingleRequestHostResolver> single_resolver_;
+  // Remote address set when opening the socket.
   net::AddressList addresses_;
   net::IPEndPoint from_;
 };
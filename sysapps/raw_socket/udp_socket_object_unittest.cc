@@ -0,0 +1,152 @@
+// Copyright (c) 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/udp_socket_object.h"
+
+#include <string>
+
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/values.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/dns/mock_host_resolver.h"
+#include "net/udp/udp_server_socket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/sysapps/common/event_target_test_util.h"
+
+using xwalk::extensions::XWalkExtensionFunctionInfo;
+using xwalk::sysapps::CreateAddEventListenerInfo;
+using xwalk::sysapps::UDPSocketObject;
+
+namespace {
+
+const char kMulticastGroup[] = "237.132.100.17";
+
+void DummyCallback(scoped_ptr<base::ListValue> result) {}
+
+base::DictionaryValue* CreateDatagram(const std::string& data, int port) {
+  base::DictionaryValue* datagram = new base::DictionaryValue;
+  datagram->SetString("data", data);
+  datagram->SetString("remoteAddress", "127.0.0.1");
+  datagram->SetInteger("remotePort", port);
+  return datagram;
+}
+
+class UDPSocketObjectTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    resolver_.set_synchronous_mode(true);
+    socket_object_.reset(new UDPSocketObject(&resolver_));
+    EXPECT_TRUE(socket_object_->HandleFunction(
+        CreateAddEventListenerInfo("error", &error_events_)));
+    EXPECT_TRUE(socket_object_->HandleFunction(
+        CreateAddEventListenerInfo("written", &written_events_)));
+  }
+
+  bool CallFunction(const std::string& name,
+                    scoped_ptr<base::ListValue> arguments) {
+    return socket_object_->HandleFunction(make_scoped_ptr(
+        new XWalkExtensionFunctionInfo(name, arguments.Pass(),
+                                       base::Bind(&DummyCallback))));
+  }
+
+  bool CallFunction(const std::string& name, const std::string& argument) {
+    scoped_ptr<base::ListValue> arguments(new base::ListValue);
+    arguments->AppendString(argument);
+    return CallFunction(name, arguments.Pass());
+  }
+
+  // Opens the socket bound to any local address when |bind| is true, not
+  // bound otherwise.
+  bool Init(bool bind) {
+    scoped_ptr<base::ListValue> arguments(new base::ListValue);
+    if (bind) {
+      base::DictionaryValue* options = new base::DictionaryValue;
+      options->SetString("localAddress", "0.0.0.0");
+      options->SetInteger("localPort", 0);
+      arguments->Append(options);
+    }
+    return CallFunction("init", arguments.Pass());
+  }
+
+  base::MessageLoopForIO loop_;
+  net::MockHostResolver resolver_;
+  scoped_ptr<UDPSocketObject> socket_object_;
+  ScopedVector<base::ListValue> error_events_;
+  ScopedVector<base::ListValue> written_events_;
+};
+
+}  // namespace
+
+TEST_F(UDPSocketObjectTest, JoinAndLeaveMulticast) {
+  ASSERT_TRUE(Init(true));
+  ASSERT_TRUE(error_events_.empty());
+
+  EXPECT_TRUE(CallFunction("joinMulticast", kMulticastGroup));
+  EXPECT_TRUE(error_events_.empty());
+
+  // The group was joined already.
+  EXPECT_TRUE(CallFunction("joinMulticast", kMulticastGroup));
+  EXPECT_EQ(1u, error_events_.size());
+
+  EXPECT_TRUE(CallFunction("leaveMulticast", kMulticastGroup));
+  EXPECT_TRUE(CallFunction("joinMulticast", kMulticastGroup));
+  EXPECT_EQ(1u, error_events_.size());
+
+  // Leaving a group that wasn't joined isn't reported.
+  EXPECT_TRUE(CallFunction("leaveMulticast", "237.132.100.18"));
+  EXPECT_EQ(1u, error_events_.size());
+}
+
+TEST_F(UDPSocketObjectTest, JoinMulticastFailures) {
+  // The socket isn't open yet.
+  EXPECT_TRUE(CallFunction("joinMulticast", kMulticastGroup));
+  EXPECT_EQ(1u, error_events_.size());
+
+  // Multicast only works on bound sockets.
+  ASSERT_TRUE(Init(false));
+  EXPECT_TRUE(CallFunction("joinMulticast", kMulticastGroup));
+  EXPECT_EQ(2u, error_events_.size());
+
+  EXPECT_TRUE(CallFunction("joinMulticast", "not an address"));
+  EXPECT_EQ(3u, error_events_.size());
+
+  EXPECT_TRUE(CallFunction("leaveMulticast", "not an address"));
+  EXPECT_EQ(3u, error_events_.size());
+
+  // Malformed arguments are ignored.
+  EXPECT_TRUE(CallFunction("joinMulticast",
+                           make_scoped_ptr(new base::ListValue)));
+  EXPECT_EQ(3u, error_events_.size());
+}
+
+TEST_F(UDPSocketObjectTest, BatchWrittenReportedOnce) {
+  net::UDPServerSocket server(NULL, net::NetLog::Source());
+  net::IPAddressNumber localhost;
+  ASSERT_TRUE(net::ParseIPLiteralToNumber("127.0.0.1", &localhost));
+  ASSERT_EQ(net::OK, server.Listen(net::IPEndPoint(localhost, 0)));
+  net::IPEndPoint server_address;
+  ASSERT_EQ(net::OK, server.GetLocalAddress(&server_address));
+
+  ASSERT_TRUE(Init(false));
+
+  scoped_ptr<base::ListValue> datagrams(new base::ListValue);
+  datagrams->Append(CreateDatagram("abc", server_address.port()));
+  datagrams->Append(CreateDatagram("defg", server_address.port()));
+  datagrams->Append(CreateDatagram("hijkl", server_address.port()));
+  scoped_ptr<base::ListValue> arguments(new base::ListValue);
+  arguments->Append(datagrams.release());
+  EXPECT_TRUE(CallFunction("_sendDatagrams", arguments.Pass()));
+
+  // The written bytes are reported once the task returns.
+  EXPECT_TRUE(written_events_.empty());
+  loop_.RunUntilIdle();
+
+  EXPECT_TRUE(error_events_.empty());
+  ASSERT_EQ(1u, written_events_.size());
+  int written = 0;
+  EXPECT_TRUE(written_events_[0]->GetInteger(0, &written));
+  EXPECT_EQ(12, written);
+}
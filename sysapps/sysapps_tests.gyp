@@ -7,12 +7,16 @@
         '../../base/base.gyp:base',
         '../../base/base.gyp:run_all_unittests',
         '../../content/content_shell_and_tests.gyp:test_support_content',
+        '../../net/net.gyp:net',
+        '../../net/net.gyp:net_test_support',
         '../../testing/gtest.gyp:gtest',
         '../extensions/extensions.gyp:xwalk_extensions',
         'sysapps.gyp:sysapps',
       ],
       'sources': [
         'common/binding_object_store_unittest.cc',
+        'common/event_target_test_util.cc',
+        'common/event_target_test_util.h',
         'common/event_target_unittest.cc',
         'common/sysapps_manager_unittest.cc',
         'device_capabilities/av_codecs_provider_unittest.cc',
@@ -20,6 +24,8 @@
         'device_capabilities/display_info_provider_unittest.cc',
         'device_capabilities/memory_info_provider_unittest.cc',
         'device_capabilities/storage_info_provider_unittest.cc',
+        'raw_socket/tcp_socket_object_unittest.cc',
+        'raw_socket/udp_socket_object_unittest.cc',
       ],
       'conditions': [
         ['OS=="linux"', {